@@ -111,13 +111,17 @@ int main()
 
 	// ============ Mesh Instances ============
 	
+	// The cube spans [-1, 1] on every axis, so a sphere of radius sqrt(3) at the origin bounds it.
+	const glm::vec4 cubeBounds = glm::vec4(0.0f, 0.0f, 0.0f, 1.7320508f);
+
 	gal::MeshInstance instances[] =
 	{
-		{ vao, gal::Transform({ 0.0f, 2.2f, -1.0f }, gal::Rotation(glm::vec3(1.0f, 0.3f, 0.0f)), { 0.5f, 0.5f, 0.5f })},
-		{ vao, gal::Transform({ -1.0f, 1.8f, -2.0f }, gal::Rotation(glm::vec3(1.0f, 0.3f, 2.0f)), { 0.3f, 0.3f, 0.3f }) },
-		{ vao, gal::Transform({ 1.0f, 1.0f, -4.5f }, gal::Rotation(glm::vec3(0.2f, 1.2f, 0.4f)), { 1.2f, 1.2f, 1.2f }) },
-		{ vao, gal::Transform({ 0.0f, 0.0f, -1.0f }) }
+		{ vao, gal::Transform({ 0.0f, 2.2f, -1.0f }, gal::Rotation(glm::vec3(1.0f, 0.3f, 0.0f)), { 0.5f, 0.5f, 0.5f }), cubeBounds },
+		{ vao, gal::Transform({ -1.0f, 1.8f, -2.0f }, gal::Rotation(glm::vec3(1.0f, 0.3f, 2.0f)), { 0.3f, 0.3f, 0.3f }), cubeBounds },
+		{ vao, gal::Transform({ 1.0f, 1.0f, -4.5f }, gal::Rotation(glm::vec3(0.2f, 1.2f, 0.4f)), { 1.2f, 1.2f, 1.2f }), cubeBounds },
+		{ vao, gal::Transform({ 0.0f, 0.0f, -1.0f }), cubeBounds }
 	};
+	std::vector<uint32_t> visibleInstances;
 
 	// ============ Texture ============
 
@@ -134,9 +138,13 @@ int main()
 
 	unsigned char* data = stbi_load("resources/noelle.png", &width, &height, &channels, 0);
 
-	tex.imageAB(0, GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE, data, width, height);
+	// Convert to the layout the driver wants, whatever the channel count, so the upload takes its fast path.
+	gal::IngestSettings ingestSettings;
+	ingestSettings.srgb = false;
+	gal::TextureUpload upload = gal::ingestPixels(data, width, height, gal::pixelLayoutFromChannels(channels), ingestSettings);
 	stbi_image_free(data);
-	
+
+	gal::uploadTexture(tex, upload, static_cast<GLint>(std::log2(std::max(width, height))) + 1);
 	tex.generateMipmapAB();
 	tex.bindTextureUnit(0);
 
@@ -144,10 +152,9 @@ int main()
 
 	shader.setUniform("texture1", 0);
 
-	glm::mat4 projection;
-	projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+	camera.setPerspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
 
-	shader.setUniform("projection", projection);
+	shader.setUniform("projection", camera.getProjectionMatrix());
 
 	shader.setUniform("ambientLight", 0.1f);
 
@@ -166,10 +173,12 @@ int main()
 		shader.setUniform("view", camera.getViewMatrix());
 
 		for (auto& instance : instances)
-		{
 			instance.transform.applyRotationLocal({ { 0.0f, 1.0f, 0.0f }, 0.6f * gal::getDeltaTime<float>() });
-			instance.drawNB(shader, "model");
-		}
+
+		// Only submit the instances the camera can see.
+		gal::cullMeshInstances(camera.getFrustum(), instances, std::size(instances), visibleInstances);
+		for (uint32_t index : visibleInstances)
+			instances[index].drawNB(shader, "model");
 
 		vao.drawNB();
 
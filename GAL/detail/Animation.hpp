@@ -0,0 +1,716 @@
+#ifndef GAL_ANIMATION_HPP
+#define GAL_ANIMATION_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "attributes.hpp"
+#include "enums.hpp"
+#include "GALException.hpp"
+#include "simd.hpp"
+#include "Transform.hpp"
+#include "TransformArray.hpp"
+
+namespace gal
+{
+	/// @brief The value of an animated property at a point in time, in seconds.
+	template<typename T>
+	struct AnimationKey
+	{
+		float time;
+		T value;
+	};
+
+	/// @brief How far a compressed clip may stray from the keys it was made from. Keys that interpolating between their
+	/// neighbors, as stored after quantization, reproduces within these tolerances are dropped. The keys that are kept
+	/// are only off by their quantization error: at most 1/131070 of the track's range per component for positions and
+	/// scales, and up to about 0.00015 radians for rotations, so tolerances tighter than that keep every key without
+	/// reaching them.
+	struct AnimationCompressionSettings
+	{
+		float positionTolerance = 0.0001f; // In the units of the positions.
+		float rotationTolerance = 0.0001f; // In radians.
+		float scaleTolerance = 0.0001f;
+	};
+
+	/// @brief How sampled clips are combined with the transforms they're written into.
+	enum class AnimationBlendMode
+	{
+		Override, // Move the transform towards the sampled pose by the weight, replacing it at a weight of 1.
+		Additive, // Apply an additive clip's offset from its reference pose on top of the transform, scaled by the weight.
+	};
+
+	/// @brief How rotations are interpolated between keys.
+	enum class AnimationInterpolation
+	{
+		Nlerp, // Normalized linear interpolation. Cheapest, but speeds up through the middle of large rotations.
+		Slerp, // Nlerp with a polynomial correction of the interpolation factor, within about 0.0005 radians of a true slerp.
+	};
+
+	/// @brief The position, rotation and scale tracks of one animated transform, stored compressed.
+	///
+	/// Keys that the track's own interpolation reproduces within the compression tolerances are dropped, and a track that
+	/// never moves keeps a single key. Times are stored as 16 bit fractions of the duration, positions and scales as 16 bit
+	/// fractions of their track's range, and rotations as the three smallest quaternion components in 15 bits each, so a
+	/// key takes 8 bytes. Every track lives in one array, each as its times followed by its values.
+	class AnimationClip
+	{
+	public:
+		/// @brief Compress a clip from its keys. Each track's keys must be sorted by time and lie within [0, duration].
+		/// An empty track holds the identity: no translation, no rotation or a scale of 1.
+		GAL_INLINE AnimationClip(float duration, const std::vector<AnimationKey<glm::vec3>>& positions,
+			const std::vector<AnimationKey<Rotation>>& rotations, const std::vector<AnimationKey<glm::vec3>>& scales,
+			const AnimationCompressionSettings& settings = AnimationCompressionSettings())
+			: duration(duration)
+		{
+			init(positions, rotations, scales, settings);
+		}
+
+		/// @brief Compress an additive clip, which stores each key as its offset from the reference pose. Apply it with
+		/// AnimationBlendMode::Additive.
+		GAL_INLINE AnimationClip(float duration, std::vector<AnimationKey<glm::vec3>> positions,
+			std::vector<AnimationKey<Rotation>> rotations, std::vector<AnimationKey<glm::vec3>> scales,
+			const Transform& reference, const AnimationCompressionSettings& settings = AnimationCompressionSettings())
+			: duration(duration), additive(true)
+		{
+			const Rotation inverseRotation = reference.getRotation().inverse();
+
+			for (AnimationKey<glm::vec3>& key : positions)
+				key.value -= reference.getPosition();
+			for (AnimationKey<Rotation>& key : rotations)
+				key.value = inverseRotation.rotatedLocal(key.value);
+			for (AnimationKey<glm::vec3>& key : scales)
+				key.value /= reference.getScale();
+
+			init(positions, rotations, scales, settings);
+		}
+
+		GAL_NODISCARD GAL_INLINE float getDuration() const noexcept { return duration; }
+		GAL_NODISCARD GAL_INLINE bool isAdditive() const noexcept { return additive; }
+
+		/// @brief Get how many keys were kept across all tracks.
+		GAL_NODISCARD GAL_INLINE size_t getKeyCount() const noexcept
+		{
+			return tracks[PositionTrack].keyCount + tracks[RotationTrack].keyCount + tracks[ScaleTrack].keyCount;
+		}
+
+		/// @brief Get the size of the compressed keys in bytes.
+		GAL_NODISCARD GAL_INLINE size_t getByteSize() const noexcept { return data.size() * sizeof(uint16_t); }
+
+		/// @brief Sample the clip at a time clamped to [0, duration], with an exact slerp between rotations. For an additive
+		/// clip this is the offset from the reference pose. Use AnimationSampler to sample many clips at once.
+		GAL_NODISCARD GAL_INLINE Transform sample(float time) const
+		{
+			std::array<float, ValueCount> from;
+			std::array<float, ValueCount> to;
+			std::array<float, TrackCount> fractions;
+			decodeKeys(time, from.data(), to.data(), fractions.data());
+
+			const glm::vec3 position = glm::mix(glm::vec3(from[0], from[1], from[2]), glm::vec3(to[0], to[1], to[2]), fractions[PositionTrack]);
+			const Rotation fromRotation(glm::quat(from[6], from[3], from[4], from[5]));
+			const Rotation toRotation(glm::quat(to[6], to[3], to[4], to[5]));
+			const glm::vec3 scale = glm::mix(glm::vec3(from[7], from[8], from[9]), glm::vec3(to[7], to[8], to[9]), fractions[ScaleTrack]);
+
+			return Transform(position, fromRotation.slerp(toRotation, fractions[RotationTrack]), scale);
+		}
+
+	private:
+		friend class AnimationSampler;
+
+		enum TrackIndex { PositionTrack, RotationTrack, ScaleTrack, TrackCount };
+
+		struct Track
+		{
+			uint32_t keyCount = 0;
+			uint32_t offset = 0; // Where the track's times start in data. Its values follow them.
+			glm::vec3 min = glm::vec3(0.0f); // The range positions and scales are quantized to. Unused by rotations.
+			glm::vec3 extent = glm::vec3(0.0f);
+		};
+
+		GAL_STATIC GAL_CONSTEXPR size_t ValueCount = 10; // Position xyz, rotation xyzw and scale xyz.
+		GAL_STATIC GAL_CONSTEXPR float TimeScale = 65535.0f;
+		GAL_STATIC GAL_CONSTEXPR float ComponentRange = 0.70710678f; // The three smallest quaternion components lie within +-1/sqrt(2).
+
+		float duration;
+		bool additive = false;
+		std::array<Track, TrackCount> tracks;
+		std::vector<uint16_t> data;
+
+		GAL_INLINE void init(const std::vector<AnimationKey<glm::vec3>>& positions, const std::vector<AnimationKey<Rotation>>& rotations,
+			const std::vector<AnimationKey<glm::vec3>>& scales, const AnimationCompressionSettings& settings)
+		{
+			if (!(duration > 0.0f) || !std::isfinite(duration))
+				detail::throwErr(ErrCode::InvalidAnimationKeys, "Attempted to create an animation clip without a positive duration.");
+
+			checkKeys(positions);
+			checkKeys(rotations);
+			checkKeys(scales);
+
+			const auto vectorError = [](const glm::vec3& a, const glm::vec3& b) { return glm::length(a - b); };
+			// From the chord between the quaternions rather than the acos of their dot product, which can't resolve angles
+			// much below 0.001 radians in single precision.
+			const auto rotationError = [](const Rotation& a, const Rotation& b)
+			{
+				const glm::quat qa = a.asQuat();
+				const glm::quat qb = b.asQuat();
+				const float sign = glm::dot(qa, qb) < 0.0f ? -1.0f : 1.0f;
+				const glm::vec4 chord(qa.x - sign * qb.x, qa.y - sign * qb.y, qa.z - sign * qb.z, qa.w - sign * qb.w);
+				return 4.0f * std::asin(std::min(glm::length(chord) * 0.5f, 1.0f));
+			};
+			const auto vectorMix = [](const glm::vec3& a, const glm::vec3& b, float t) { return glm::mix(a, b, t); };
+			const auto rotationMix = [](const Rotation& a, const Rotation& b, float t) { return a.slerp(b, t); };
+
+			// Quantization ranges come from every key, so keys can be quantized before deciding which to keep.
+			setVectorRange(tracks[PositionTrack], positions, glm::vec3(0.0f));
+			setVectorRange(tracks[ScaleTrack], scales, glm::vec3(1.0f));
+
+			const auto quantizePosition = [this](const glm::vec3& value) { return quantizeVector(tracks[PositionTrack], value); };
+			const auto quantizeScale = [this](const glm::vec3& value) { return quantizeVector(tracks[ScaleTrack], value); };
+
+			writeVectorTrack(tracks[PositionTrack],
+				reduceKeys(positions, glm::vec3(0.0f), settings.positionTolerance, vectorMix, vectorError, quantizePosition));
+			writeRotationTrack(tracks[RotationTrack],
+				reduceKeys(rotations, Rotation(), settings.rotationTolerance, rotationMix, rotationError, quantizeRotation));
+			writeVectorTrack(tracks[ScaleTrack],
+				reduceKeys(scales, glm::vec3(1.0f), settings.scaleTolerance, vectorMix, vectorError, quantizeScale));
+
+			data.shrink_to_fit();
+		}
+
+		template<typename T>
+		GAL_INLINE void checkKeys(const std::vector<AnimationKey<T>>& keys) const
+		{
+			for (size_t i = 0; i < keys.size(); ++i)
+			{
+				if (!(keys[i].time >= 0.0f && keys[i].time <= duration) || (i > 0 && keys[i].time < keys[i - 1].time))
+					detail::throwErr(ErrCode::InvalidAnimationKeys, "Animation keys weren't sorted by time or lay outside the clip's duration.");
+			}
+		}
+
+		/// @brief Keep the first and last key, and any key in between that interpolating from the last kept key to the
+		/// key after it misses (or misses one of the keys it would drop) by more than the tolerance. Interpolation is
+		/// between the values and times as they'll be decoded, so quantization error counts against the tolerance too.
+		template<typename T, typename Mix, typename Error, typename Quantize>
+		GAL_NODISCARD GAL_INLINE std::vector<AnimationKey<T>> reduceKeys(const std::vector<AnimationKey<T>>& keys,
+			const T& identity, float tolerance, Mix mix, Error error, Quantize quantize) const
+		{
+			if (keys.empty())
+				return { { 0.0f, identity } };
+
+			std::vector<AnimationKey<T>> kept = { keys.front() };
+			size_t anchor = 0;
+
+			for (size_t next = 2; next < keys.size(); ++next)
+			{
+				const T from = quantize(keys[anchor].value);
+				const T to = quantize(keys[next].value);
+				const float fromTime = quantizeTime(keys[anchor].time);
+				const float span = quantizeTime(keys[next].time) - fromTime;
+
+				bool fits = true;
+				for (size_t k = anchor + 1; k < next && fits; ++k)
+				{
+					const float t = span > 0.0f ? std::clamp((keys[k].time / duration * TimeScale - fromTime) / span, 0.0f, 1.0f) : 0.0f;
+					fits = error(mix(from, to, t), keys[k].value) <= tolerance;
+				}
+
+				if (!fits)
+				{
+					anchor = next - 1;
+					kept.push_back(keys[anchor]);
+				}
+			}
+
+			if (keys.size() > 1)
+				kept.push_back(keys.back());
+
+			// A track that never moves needs only one key.
+			const T first = quantize(keys.front().value);
+			const bool constant = std::all_of(keys.begin(), keys.end(),
+				[&](const AnimationKey<T>& key) { return error(first, key.value) <= tolerance; });
+			if (constant)
+				kept.resize(1);
+
+			return kept;
+		}
+
+		template<typename T>
+		GAL_INLINE void beginTrack(Track& track, const std::vector<AnimationKey<T>>& keys)
+		{
+			track.keyCount = static_cast<uint32_t>(keys.size());
+			track.offset = static_cast<uint32_t>(data.size());
+
+			for (const AnimationKey<T>& key : keys)
+				data.push_back(static_cast<uint16_t>(quantizeTime(key.time)));
+		}
+
+		/// @brief Get a time in the units it's stored in, rounded as it will be.
+		GAL_NODISCARD GAL_INLINE float quantizeTime(float time) const noexcept
+		{
+			return static_cast<float>(std::lround(time / duration * TimeScale));
+		}
+
+		GAL_STATIC GAL_INLINE void setVectorRange(Track& track, const std::vector<AnimationKey<glm::vec3>>& keys,
+			const glm::vec3& identity) noexcept
+		{
+			glm::vec3 min = keys.empty() ? identity : keys.front().value;
+			glm::vec3 max = min;
+			for (const AnimationKey<glm::vec3>& key : keys)
+			{
+				min = glm::min(min, key.value);
+				max = glm::max(max, key.value);
+			}
+
+			track.min = min;
+			track.extent = max - min;
+		}
+
+		GAL_STATIC GAL_INLINE void encodeVector(const Track& track, const glm::vec3& value, uint16_t* words) noexcept
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				const float fraction = track.extent[c] > 0.0f ? (value[c] - track.min[c]) / track.extent[c] : 0.0f;
+				words[c] = static_cast<uint16_t>(std::lround(std::clamp(fraction, 0.0f, 1.0f) * 65535.0f));
+			}
+		}
+
+		GAL_STATIC GAL_INLINE void decodeVector(const Track& track, const uint16_t* words, float* out) noexcept
+		{
+			for (int c = 0; c < 3; ++c)
+				out[c] = track.min[c] + track.extent[c] * (words[c] * (1.0f / 65535.0f));
+		}
+
+		/// @brief Get a value as it will be decoded from the track.
+		GAL_NODISCARD GAL_STATIC GAL_INLINE glm::vec3 quantizeVector(const Track& track, const glm::vec3& value) noexcept
+		{
+			std::array<uint16_t, 3> words;
+			encodeVector(track, value, words.data());
+
+			glm::vec3 decoded;
+			decodeVector(track, words.data(), &decoded.x);
+			return decoded;
+		}
+
+		GAL_STATIC GAL_INLINE void encodeRotation(const Rotation& rotation, uint16_t* words) noexcept
+		{
+			const glm::quat quat = rotation.asQuat();
+			std::array<float, 4> components = { quat.x, quat.y, quat.z, quat.w };
+
+			int largest = 0;
+			for (int c = 1; c < 4; ++c)
+			{
+				if (std::abs(components[c]) > std::abs(components[largest]))
+					largest = c;
+			}
+
+			// q and -q are the same rotation, so pick the one whose largest component is positive and leave it out.
+			const float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+
+			for (int c = 0, word = 0; c < 4; ++c)
+			{
+				if (c == largest)
+					continue;
+
+				const float fraction = (components[c] * sign / ComponentRange + 1.0f) * 0.5f;
+				words[word++] = static_cast<uint16_t>(std::lround(std::clamp(fraction, 0.0f, 1.0f) * 32767.0f));
+			}
+
+			// The index of the left out component goes in the spare top bits of the first two words.
+			words[0] |= static_cast<uint16_t>((largest & 1) << 15);
+			words[1] |= static_cast<uint16_t>((largest >> 1) << 15);
+		}
+
+		/// @brief Decode a rotation into out as xyzw.
+		GAL_STATIC GAL_INLINE void decodeRotation(const uint16_t* words, float* out) noexcept
+		{
+			const int largest = (words[0] >> 15) | ((words[1] >> 15) << 1);
+
+			float sumOfSquares = 0.0f;
+			for (int c = 0, word = 0; c < 4; ++c)
+			{
+				if (c == largest)
+					continue;
+
+				out[c] = ((words[word++] & 0x7FFF) * (2.0f / 32767.0f) - 1.0f) * ComponentRange;
+				sumOfSquares += out[c] * out[c];
+			}
+
+			out[largest] = std::sqrt(std::max(1.0f - sumOfSquares, 0.0f));
+		}
+
+		/// @brief Get a rotation as it will be decoded from the track.
+		GAL_NODISCARD GAL_STATIC GAL_INLINE Rotation quantizeRotation(const Rotation& rotation) noexcept
+		{
+			std::array<uint16_t, 3> words;
+			encodeRotation(rotation, words.data());
+
+			std::array<float, 4> decoded;
+			decodeRotation(words.data(), decoded.data());
+			return Rotation(glm::quat(decoded[3], decoded[0], decoded[1], decoded[2]));
+		}
+
+		GAL_INLINE void writeVectorTrack(Track& track, const std::vector<AnimationKey<glm::vec3>>& keys)
+		{
+			beginTrack(track, keys);
+
+			for (const AnimationKey<glm::vec3>& key : keys)
+			{
+				std::array<uint16_t, 3> words;
+				encodeVector(track, key.value, words.data());
+				data.insert(data.end(), words.begin(), words.end());
+			}
+		}
+
+		GAL_INLINE void writeRotationTrack(Track& track, const std::vector<AnimationKey<Rotation>>& keys)
+		{
+			beginTrack(track, keys);
+
+			for (const AnimationKey<Rotation>& key : keys)
+			{
+				std::array<uint16_t, 3> words;
+				encodeRotation(key.value, words.data());
+				data.insert(data.end(), words.begin(), words.end());
+			}
+		}
+
+		/// @brief Find the keys around a time and how far between them it is.
+		GAL_INLINE void findKeys(const Track& track, float time, uint32_t& from, uint32_t& to, float& fraction) const noexcept
+		{
+			const uint16_t* times = data.data() + track.offset;
+			const float scaledTime = std::clamp(time / duration, 0.0f, 1.0f) * TimeScale;
+
+			const uint32_t next = static_cast<uint32_t>(std::upper_bound(times, times + track.keyCount, scaledTime) - times);
+			if (next == 0 || next == track.keyCount)
+			{
+				from = to = next == 0 ? 0 : track.keyCount - 1;
+				fraction = 0.0f;
+				return;
+			}
+
+			from = next - 1;
+			to = next;
+			fraction = (scaledTime - times[from]) / static_cast<float>(times[to] - times[from]);
+		}
+
+		GAL_INLINE void decodeVector(const Track& track, uint32_t key, float* out) const noexcept
+		{
+			decodeVector(track, data.data() + track.offset + track.keyCount + key * 3, out);
+		}
+
+		GAL_INLINE void decodeRotation(const Track& track, uint32_t key, float* out) const noexcept
+		{
+			decodeRotation(data.data() + track.offset + track.keyCount + key * 3, out);
+		}
+
+		/// @brief Decode the keys around a time into from and to, as position xyz, rotation xyzw and scale xyz, and write
+		/// how far between them the time is for each track into fractions.
+		GAL_INLINE void decodeKeys(float time, float* from, float* to, float* fractions) const noexcept
+		{
+			uint32_t fromKey, toKey;
+
+			findKeys(tracks[PositionTrack], time, fromKey, toKey, fractions[PositionTrack]);
+			decodeVector(tracks[PositionTrack], fromKey, from);
+			decodeVector(tracks[PositionTrack], toKey, to);
+
+			findKeys(tracks[RotationTrack], time, fromKey, toKey, fractions[RotationTrack]);
+			decodeRotation(tracks[RotationTrack], fromKey, from + 3);
+			decodeRotation(tracks[RotationTrack], toKey, to + 3);
+
+			findKeys(tracks[ScaleTrack], time, fromKey, toKey, fractions[ScaleTrack]);
+			decodeVector(tracks[ScaleTrack], fromKey, from + 7);
+			decodeVector(tracks[ScaleTrack], toKey, to + 7);
+		}
+	};
+
+	/// @brief Samples many clips at once and blends the results into transforms.
+	///
+	/// Keys are found and decoded one clip at a time into structure of arrays scratch space, then interpolated and blended
+	/// 8 (AVX2) or 4 (SSE2) clips at a time (see simd.hpp). Sampling into a TransformArray writes its component arrays
+	/// directly. Layer animations by sampling into the same transforms several times: an Override pass at full weight,
+	/// then weighted Override passes to blend towards other clips, then Additive passes for additive clips.
+	class AnimationSampler
+	{
+	public:
+		GAL_EXPLICIT GAL_INLINE AnimationSampler(AnimationInterpolation interpolation = AnimationInterpolation::Slerp) noexcept
+			: interpolation(interpolation) { }
+
+		GAL_INLINE void setInterpolation(AnimationInterpolation interpolation) noexcept { this->interpolation = interpolation; }
+		GAL_NODISCARD GAL_INLINE AnimationInterpolation getInterpolation() const noexcept { return interpolation; }
+
+		/// @brief Sample clips[i] at times[i] into out[first + i], blended by weights[i] (1 for every clip if weights is
+		/// null). Times are clamped to each clip's duration. Stops at the end of out.
+		GAL_INLINE void sample(const AnimationClip* const* clips, const float* times, size_t count, TransformArray& out,
+			size_t first = 0, AnimationBlendMode mode = AnimationBlendMode::Override, const float* weights = nullptr)
+		{
+			first = std::min(first, out.size());
+			count = std::min(count, out.size() - first);
+
+			decode(clips, times, weights, count);
+
+			const std::array<float*, ComponentCount> destination = {
+				out.positionsX() + first, out.positionsY() + first, out.positionsZ() + first,
+				out.rotationsX() + first, out.rotationsY() + first, out.rotationsZ() + first, out.rotationsW() + first,
+				out.scalesX() + first, out.scalesY() + first, out.scalesZ() + first
+			};
+
+			blend(destination, count, mode, weights != nullptr);
+		}
+
+		/// @brief Sample clips[i] at times[i] into out[i], blended by weights[i] (1 for every clip if weights is null).
+		/// Times are clamped to each clip's duration.
+		GAL_INLINE void sample(const AnimationClip* const* clips, const float* times, size_t count, Transform* out,
+			AnimationBlendMode mode = AnimationBlendMode::Override, const float* weights = nullptr)
+		{
+			decode(clips, times, weights, count);
+
+			std::array<float*, ComponentCount> destination;
+			for (size_t c = 0; c < ComponentCount; ++c)
+				destination[c] = scratch[Destination + c].data();
+
+			// A full weight override never reads what it replaces.
+			const bool replace = mode == AnimationBlendMode::Override && weights == nullptr;
+			for (size_t i = 0; i < count && !replace; ++i)
+			{
+				const glm::vec3 position = out[i].getPosition();
+				const glm::quat rotation = out[i].getRotation().asQuat();
+				const glm::vec3 scale = out[i].getScale();
+
+				const std::array<float, ComponentCount> values = {
+					position.x, position.y, position.z,
+					rotation.x, rotation.y, rotation.z, rotation.w,
+					scale.x, scale.y, scale.z
+				};
+
+				for (size_t c = 0; c < ComponentCount; ++c)
+					destination[c][i] = values[c];
+			}
+
+			blend(destination, count, mode, weights != nullptr);
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				out[i].set(glm::vec3(destination[PX][i], destination[PY][i], destination[PZ][i]),
+					Rotation(glm::quat(destination[QW][i], destination[QX][i], destination[QY][i], destination[QZ][i])),
+					glm::vec3(destination[SX][i], destination[SY][i], destination[SZ][i]));
+			}
+		}
+
+	private:
+		using AlignedFloats = std::vector<float, detail::AlignedAllocator<float>>;
+
+		enum Component { PX, PY, PZ, QX, QY, QZ, QW, SX, SY, SZ, ComponentCount };
+
+		enum ScratchArray
+		{
+			From = 0,
+			To = From + ComponentCount,
+			PositionFraction = To + ComponentCount,
+			RotationFraction,
+			ScaleFraction,
+			Weight,
+			Destination,
+			ScratchCount = Destination + ComponentCount
+		};
+
+		template<typename L>
+		struct QuatLanes
+		{
+			typename L::Type x, y, z, w;
+		};
+
+		AnimationInterpolation interpolation;
+		std::array<AlignedFloats, ScratchCount> scratch;
+
+		GAL_INLINE void decode(const AnimationClip* const* clips, const float* times, const float* weights, size_t count)
+		{
+			for (AlignedFloats& array : scratch)
+			{
+				if (array.size() < count)
+					array.resize(count);
+			}
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				std::array<float, ComponentCount> from;
+				std::array<float, ComponentCount> to;
+				std::array<float, AnimationClip::TrackCount> fractions;
+				clips[i]->decodeKeys(times[i], from.data(), to.data(), fractions.data());
+
+				for (size_t c = 0; c < ComponentCount; ++c)
+				{
+					scratch[From + c][i] = from[c];
+					scratch[To + c][i] = to[c];
+				}
+
+				scratch[PositionFraction][i] = fractions[AnimationClip::PositionTrack];
+				scratch[RotationFraction][i] = fractions[AnimationClip::RotationTrack];
+				scratch[ScaleFraction][i] = fractions[AnimationClip::ScaleTrack];
+				scratch[Weight][i] = weights != nullptr ? weights[i] : 1.0f;
+			}
+		}
+
+		GAL_INLINE void blend(const std::array<float*, ComponentCount>& destination, size_t count, AnimationBlendMode mode, bool weighted) noexcept
+		{
+			const bool slerp = interpolation == AnimationInterpolation::Slerp;
+
+			if (mode == AnimationBlendMode::Additive)
+			{
+				if (slerp)
+					blendRange<AnimationBlendMode::Additive, true, true>(destination, count);
+				else
+					blendRange<AnimationBlendMode::Additive, true, false>(destination, count);
+			}
+			else if (weighted)
+			{
+				if (slerp)
+					blendRange<AnimationBlendMode::Override, true, true>(destination, count);
+				else
+					blendRange<AnimationBlendMode::Override, true, false>(destination, count);
+			}
+			else
+			{
+				if (slerp)
+					blendRange<AnimationBlendMode::Override, false, true>(destination, count);
+				else
+					blendRange<AnimationBlendMode::Override, false, false>(destination, count);
+			}
+		}
+
+		template<AnimationBlendMode Mode, bool Weighted, bool Slerp>
+		GAL_INLINE void blendRange(const std::array<float*, ComponentCount>& destination, size_t count) noexcept
+		{
+			const size_t done = blendLanes<detail::WideFloatLanes, Mode, Weighted, Slerp>(0, count, destination);
+			blendLanes<detail::FloatLanes1, Mode, Weighted, Slerp>(done, count, destination);
+		}
+
+		/// @brief Interpolate the decoded keys and blend them into destination for [begin, end) in steps of Lanes::Width,
+		/// stopping before a partial step. Returns where it stopped.
+		template<typename Lanes, AnimationBlendMode Mode, bool Weighted, bool Slerp>
+		GAL_INLINE size_t blendLanes(size_t begin, size_t end, const std::array<float*, ComponentCount>& destination) noexcept
+		{
+			using L = Lanes;
+			using V = typename L::Type;
+
+			const V one = L::set1(1.0f);
+			const V zero = L::set1(0.0f);
+
+			size_t i = begin;
+			for (; i + L::Width <= end; i += L::Width)
+			{
+				V pose[ComponentCount];
+
+				const V positionFraction = L::load(&scratch[PositionFraction][i]);
+				const V scaleFraction = L::load(&scratch[ScaleFraction][i]);
+				for (size_t c = PX; c <= PZ; ++c)
+					pose[c] = lerp<L>(L::load(&scratch[From + c][i]), L::load(&scratch[To + c][i]), positionFraction);
+				for (size_t c = SX; c <= SZ; ++c)
+					pose[c] = lerp<L>(L::load(&scratch[From + c][i]), L::load(&scratch[To + c][i]), scaleFraction);
+
+				const QuatLanes<L> rotation = nlerp<L, Slerp>(loadQuat<L>(From, i), loadQuat<L>(To, i), L::load(&scratch[RotationFraction][i]));
+
+				const V weight = L::load(&scratch[Weight][i]);
+				QuatLanes<L> result = rotation;
+
+				if (Mode == AnimationBlendMode::Override && Weighted)
+				{
+					for (size_t c : { PX, PY, PZ, SX, SY, SZ })
+						pose[c] = lerp<L>(L::load(destination[c] + i), pose[c], weight);
+
+					const QuatLanes<L> current = { L::load(destination[QX] + i), L::load(destination[QY] + i),
+						L::load(destination[QZ] + i), L::load(destination[QW] + i) };
+					result = nlerp<L, false>(current, rotation, weight);
+				}
+				else if (Mode == AnimationBlendMode::Additive)
+				{
+					for (size_t c = PX; c <= PZ; ++c)
+						pose[c] = L::add(L::load(destination[c] + i), L::mul(pose[c], weight));
+					for (size_t c = SX; c <= SZ; ++c)
+						pose[c] = L::mul(L::load(destination[c] + i), lerp<L>(one, pose[c], weight));
+
+					// Scale the offset rotation by the weight towards the identity, then apply it in local space.
+					const QuatLanes<L> identity = { zero, zero, zero, one };
+					const QuatLanes<L> offset = nlerp<L, false>(identity, rotation, weight);
+					const QuatLanes<L> current = { L::load(destination[QX] + i), L::load(destination[QY] + i),
+						L::load(destination[QZ] + i), L::load(destination[QW] + i) };
+					result = normalize<L>(multiply<L>(current, offset));
+				}
+
+				pose[QX] = result.x;
+				pose[QY] = result.y;
+				pose[QZ] = result.z;
+				pose[QW] = result.w;
+
+				for (size_t c = 0; c < ComponentCount; ++c)
+					L::store(destination[c] + i, pose[c]);
+			}
+
+			return i;
+		}
+
+		template<typename L>
+		GAL_NODISCARD GAL_INLINE QuatLanes<L> loadQuat(size_t first, size_t i) const noexcept
+		{
+			return { L::load(&scratch[first + QX][i]), L::load(&scratch[first + QY][i]),
+				L::load(&scratch[first + QZ][i]), L::load(&scratch[first + QW][i]) };
+		}
+
+		template<typename L>
+		GAL_NODISCARD GAL_STATIC GAL_INLINE typename L::Type lerp(typename L::Type a, typename L::Type b, typename L::Type t) noexcept
+		{
+			return L::add(a, L::mul(L::sub(b, a), t));
+		}
+
+		template<typename L>
+		GAL_NODISCARD GAL_STATIC GAL_INLINE QuatLanes<L> normalize(const QuatLanes<L>& q) noexcept
+		{
+			using V = typename L::Type;
+
+			const V lengthSquared = L::add(L::add(L::mul(q.x, q.x), L::mul(q.y, q.y)), L::add(L::mul(q.z, q.z), L::mul(q.w, q.w)));
+			const V inverseLength = L::div(L::set1(1.0f), L::sqrt(lengthSquared));
+
+			return { L::mul(q.x, inverseLength), L::mul(q.y, inverseLength), L::mul(q.z, inverseLength), L::mul(q.w, inverseLength) };
+		}
+
+		/// @brief a * b.
+		template<typename L>
+		GAL_NODISCARD GAL_STATIC GAL_INLINE QuatLanes<L> multiply(const QuatLanes<L>& a, const QuatLanes<L>& b) noexcept
+		{
+			return {
+				L::add(L::add(L::mul(a.w, b.x), L::mul(a.x, b.w)), L::sub(L::mul(a.y, b.z), L::mul(a.z, b.y))),
+				L::add(L::sub(L::mul(a.w, b.y), L::mul(a.x, b.z)), L::add(L::mul(a.y, b.w), L::mul(a.z, b.x))),
+				L::add(L::add(L::mul(a.w, b.z), L::mul(a.x, b.y)), L::sub(L::mul(a.z, b.w), L::mul(a.y, b.x))),
+				L::sub(L::sub(L::mul(a.w, b.w), L::mul(a.x, b.x)), L::add(L::mul(a.y, b.y), L::mul(a.z, b.z)))
+			};
+		}
+
+		/// @brief Interpolate along the shorter arc from a to b. With CorrectFactor, t is first adjusted by a polynomial in
+		/// t and the cosine of the angle between them so the result stays close to a slerp (from "Approximating slerp",
+		/// A. Kapoulkine).
+		template<typename L, bool CorrectFactor>
+		GAL_NODISCARD GAL_STATIC GAL_INLINE QuatLanes<L> nlerp(const QuatLanes<L>& a, QuatLanes<L> b, typename L::Type t) noexcept
+		{
+			using V = typename L::Type;
+
+			const V cosine = L::add(L::add(L::mul(a.x, b.x), L::mul(a.y, b.y)), L::add(L::mul(a.z, b.z), L::mul(a.w, b.w)));
+			b = { L::flipSign(b.x, cosine), L::flipSign(b.y, cosine), L::flipSign(b.z, cosine), L::flipSign(b.w, cosine) };
+
+			if (CorrectFactor)
+			{
+				const V d = L::flipSign(cosine, cosine);
+				const V A = L::add(L::set1(1.0904f), L::mul(d, L::add(L::set1(-3.2452f), L::mul(d, L::sub(L::set1(3.55645f), L::mul(d, L::set1(1.43519f)))))));
+				const V B = L::add(L::set1(0.848013f), L::mul(d, L::add(L::set1(-1.06021f), L::mul(d, L::set1(0.215638f)))));
+
+				const V centered = L::sub(t, L::set1(0.5f));
+				const V k = L::add(L::mul(A, L::mul(centered, centered)), B);
+				t = L::add(t, L::mul(L::mul(t, centered), L::mul(L::sub(t, L::set1(1.0f)), k)));
+			}
+
+			return normalize<L>({ lerp<L>(a.x, b.x, t), lerp<L>(a.y, b.y, t), lerp<L>(a.z, b.z, t), lerp<L>(a.w, b.w, t) });
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,489 @@
+#ifndef GAL_BCN_ENCODER_HPP
+#define GAL_BCN_ENCODER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "attributes.hpp"
+
+namespace gal
+{
+	/// @brief Block compressed formats GAL can encode. Every format stores 4x4 texel blocks.
+	enum class BCFormat
+	{
+		BC1, // RGB, 8 bytes per block. Opaque color textures.
+		BC3, // RGBA, 16 bytes per block. BC1 color plus a separately interpolated alpha channel.
+		BC4, // R, 8 bytes per block. Single channel masks, roughness, heightmaps. Reads the red channel.
+		BC5, // RG, 16 bytes per block. Tangent space normal maps. Reads the red and green channels.
+		BC7 // RGBA, 16 bytes per block. Higher quality color and alpha than BC1/BC3.
+	};
+
+	/// @brief Get the size in bytes of one 4x4 block of the given format.
+	GAL_NODISCARD GAL_CONSTEXPR GAL_INLINE size_t bcBlockSize(BCFormat format) noexcept
+	{
+		return format == BCFormat::BC1 || format == BCFormat::BC4 ? 8 : 16;
+	}
+
+	/// @brief Get the size in bytes of a width x height image in the given format.
+	GAL_NODISCARD GAL_CONSTEXPR GAL_INLINE size_t bcImageSize(BCFormat format, int width, int height) noexcept
+	{
+		return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * bcBlockSize(format);
+	}
+
+	namespace detail
+	{
+		/// @brief Writes fields of a compressed block least significant bit first.
+		class BlockBitWriter
+		{
+		public:
+			GAL_INLINE BlockBitWriter(unsigned char* out, size_t size) noexcept
+				: out(out)
+			{
+				std::fill(out, out + size, static_cast<unsigned char>(0));
+			}
+
+			GAL_INLINE void write(uint32_t value, int bits) noexcept
+			{
+				for (int i = 0; i < bits; ++i, ++position)
+				{
+					if ((value >> i) & 1u)
+						out[position / 8] |= static_cast<unsigned char>(1u << (position % 8));
+				}
+			}
+
+		private:
+			unsigned char* out;
+			int position = 0;
+		};
+
+		/// @brief Fit a line through the points with principal component analysis and return the two endpoints
+		/// spanning them along it. N is the number of channels used.
+		template<int N>
+		GAL_INLINE void fitEndpoints(const float (&points)[16][4], float (&start)[4], float (&end)[4]) noexcept
+		{
+			float mean[4] = {};
+			for (const float* point : points)
+			{
+				for (int c = 0; c < N; ++c)
+					mean[c] += point[c] / 16.0f;
+			}
+
+			float covariance[4][4] = {};
+			for (const float* point : points)
+			{
+				for (int a = 0; a < N; ++a)
+				{
+					for (int b = 0; b < N; ++b)
+						covariance[a][b] += (point[a] - mean[a]) * (point[b] - mean[b]);
+				}
+			}
+
+			// Power iteration for the dominant eigenvector, seeded with the covariance row of the channel that varies most.
+			// A fixed seed such as (1, 1, 1, 1) can be at right angles to the main axis (a red to green gradient is), and
+			// the iteration then collapses to nothing.
+			int seed = 0;
+			for (int c = 1; c < N; ++c)
+			{
+				if (covariance[c][c] > covariance[seed][seed])
+					seed = c;
+			}
+
+			float axis[4] = {};
+			for (int c = 0; c < N; ++c)
+				axis[c] = covariance[seed][c];
+
+			bool collapsed = false;
+			for (int iteration = 0; iteration < 8; ++iteration)
+			{
+				float next[4] = {};
+				float length = 0.0f;
+
+				for (int a = 0; a < N; ++a)
+				{
+					for (int b = 0; b < N; ++b)
+						next[a] += covariance[a][b] * axis[b];
+
+					length = std::max(length, std::abs(next[a]));
+				}
+
+				if (length == 0.0f)
+				{
+					collapsed = true;
+					break;
+				}
+
+				for (int a = 0; a < N; ++a)
+					axis[a] = next[a] / length;
+			}
+
+			// Fall back to the corners of the bounding box, which at least span every channel's range.
+			if (collapsed)
+			{
+				for (int c = 0; c < N; ++c)
+				{
+					start[c] = points[0][c];
+					end[c] = points[0][c];
+				}
+
+				for (const float* point : points)
+				{
+					for (int c = 0; c < N; ++c)
+					{
+						start[c] = std::max(start[c], point[c]);
+						end[c] = std::min(end[c], point[c]);
+					}
+				}
+
+				return;
+			}
+
+			float minT = 0.0f;
+			float maxT = 0.0f;
+			for (const float* point : points)
+			{
+				float t = 0.0f;
+				for (int c = 0; c < N; ++c)
+					t += (point[c] - mean[c]) * axis[c];
+
+				minT = std::min(minT, t);
+				maxT = std::max(maxT, t);
+			}
+
+			float lengthSquared = 0.0f;
+			for (int c = 0; c < N; ++c)
+				lengthSquared += axis[c] * axis[c];
+
+			for (int c = 0; c < N; ++c)
+			{
+				start[c] = std::clamp(mean[c] + axis[c] * maxT / lengthSquared, 0.0f, 255.0f);
+				end[c] = std::clamp(mean[c] + axis[c] * minT / lengthSquared, 0.0f, 255.0f);
+			}
+		}
+
+		GAL_NODISCARD GAL_INLINE uint16_t packRGB565(const float (&color)[4]) noexcept
+		{
+			const auto quantize = [](float value, float max) { return static_cast<uint16_t>(value * max / 255.0f + 0.5f); };
+			return static_cast<uint16_t>(quantize(color[0], 31.0f) << 11 | quantize(color[1], 63.0f) << 5 | quantize(color[2], 31.0f));
+		}
+
+		GAL_INLINE void unpackRGB565(uint16_t packed, int (&color)[3]) noexcept
+		{
+			const int r = packed >> 11, g = (packed >> 5) & 63, b = packed & 31;
+			color[0] = r << 3 | r >> 2;
+			color[1] = g << 2 | g >> 4;
+			color[2] = b << 3 | b >> 2;
+		}
+
+		/// @brief Choose the nearest of the four BC1 palette entries for every texel. Returns the total squared error.
+		GAL_INLINE int bc1Indices(const float (&texels)[16][4], uint16_t color0, uint16_t color1, uint32_t& indices) noexcept
+		{
+			int palette[4][3];
+			unpackRGB565(color0, palette[0]);
+			unpackRGB565(color1, palette[1]);
+			for (int c = 0; c < 3; ++c)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+
+			indices = 0;
+			int totalError = 0;
+
+			for (int i = 0; i < 16; ++i)
+			{
+				int bestError = 1 << 30;
+				uint32_t best = 0;
+
+				for (uint32_t p = 0; p < 4; ++p)
+				{
+					int error = 0;
+					for (int c = 0; c < 3; ++c)
+					{
+						const int difference = static_cast<int>(texels[i][c]) - palette[p][c];
+						error += difference * difference;
+					}
+
+					if (error < bestError)
+					{
+						bestError = error;
+						best = p;
+					}
+				}
+
+				indices |= best << (i * 2);
+				totalError += bestError;
+			}
+
+			return totalError;
+		}
+
+		/// @brief Encode a BC1 block (also the color half of BC3) from 16 RGBA texels in row order.
+		GAL_INLINE void encodeBC1Block(const float (&texels)[16][4], unsigned char* out) noexcept
+		{
+			float start[4], end[4];
+			fitEndpoints<3>(texels, start, end);
+
+			uint16_t color0 = packRGB565(start);
+			uint16_t color1 = packRGB565(end);
+
+			// color0 > color1 selects the four color mode. Equal endpoints mean a flat block, where index 0 is exact.
+			if (color0 < color1)
+				std::swap(color0, color1);
+
+			uint32_t indices = 0;
+			if (color0 != color1)
+			{
+				int error = bc1Indices(texels, color0, color1, indices);
+
+				// Refit the endpoints to the chosen indices with least squares, and keep the result if it's better.
+				static constexpr float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+				float aa = 0.0f, ab = 0.0f, bb = 0.0f, ax[3] = {}, bx[3] = {};
+
+				for (int i = 0; i < 16; ++i)
+				{
+					const float a = weights[(indices >> (i * 2)) & 3];
+					const float b = 1.0f - a;
+					aa += a * a;
+					ab += a * b;
+					bb += b * b;
+
+					for (int c = 0; c < 3; ++c)
+					{
+						ax[c] += a * texels[i][c];
+						bx[c] += b * texels[i][c];
+					}
+				}
+
+				const float determinant = aa * bb - ab * ab;
+				if (determinant > 1e-6f)
+				{
+					float refitStart[4], refitEnd[4];
+					for (int c = 0; c < 3; ++c)
+					{
+						refitStart[c] = std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.0f, 255.0f);
+						refitEnd[c] = std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.0f, 255.0f);
+					}
+
+					uint16_t refit0 = packRGB565(refitStart);
+					uint16_t refit1 = packRGB565(refitEnd);
+					if (refit0 < refit1)
+						std::swap(refit0, refit1);
+
+					uint32_t refitIndices;
+					if (refit0 != refit1 && bc1Indices(texels, refit0, refit1, refitIndices) < error)
+					{
+						color0 = refit0;
+						color1 = refit1;
+						indices = refitIndices;
+					}
+				}
+			}
+
+			BlockBitWriter writer(out, 8);
+			writer.write(color0, 16);
+			writer.write(color1, 16);
+			writer.write(indices, 32);
+		}
+
+		/// @brief Encode a BC4 block (also the alpha half of BC3 and each half of BC5) from channel c of 16 texels.
+		GAL_INLINE void encodeBC4Block(const float (&texels)[16][4], int channel, unsigned char* out) noexcept
+		{
+			int low = 255, high = 0;
+			for (const float* texel : texels)
+			{
+				low = std::min(low, static_cast<int>(texel[channel]));
+				high = std::max(high, static_cast<int>(texel[channel]));
+			}
+
+			BlockBitWriter writer(out, 8);
+			writer.write(static_cast<uint32_t>(high), 8);
+			writer.write(static_cast<uint32_t>(low), 8);
+
+			if (high == low)
+				return; // Every index 0.
+
+			// high > low selects the eight value mode: index 0 and 1 are the endpoints, 2-7 interpolate between them.
+			int palette[8] = { high, low };
+			for (int i = 2; i < 8; ++i)
+				palette[i] = ((8 - i) * high + (i - 1) * low) / 7;
+
+			for (const float* texel : texels)
+			{
+				const int value = static_cast<int>(texel[channel]);
+				uint32_t best = 0;
+
+				for (uint32_t i = 1; i < 8; ++i)
+				{
+					if (std::abs(value - palette[i]) < std::abs(value - palette[best]))
+						best = i;
+				}
+
+				writer.write(best, 3);
+			}
+		}
+
+		/// @brief Encode a BC7 block from 16 RGBA texels using mode 6: one subset, 7-bit RGBA endpoints with a p-bit each
+		/// and 4-bit indices. Mode 6 handles smooth color and alpha well and is the usual choice for a fast encoder.
+		GAL_INLINE void encodeBC7Block(const float (&texels)[16][4], unsigned char* out) noexcept
+		{
+			float start[4], end[4];
+			fitEndpoints<4>(texels, start, end);
+
+			// Quantize each endpoint to 7 bits plus a p-bit shared by its four channels, picking the p-bit that fits best.
+			int endpoints[2][4];
+			uint32_t pBits[2];
+			const float* fitted[2] = { start, end };
+
+			for (int e = 0; e < 2; ++e)
+			{
+				int bestError = 1 << 30;
+				for (uint32_t p = 0; p < 2; ++p)
+				{
+					int quantized[4];
+					int error = 0;
+
+					for (int c = 0; c < 4; ++c)
+					{
+						quantized[c] = std::clamp(static_cast<int>((fitted[e][c] - p) / 2.0f + 0.5f), 0, 127);
+						const int difference = (quantized[c] << 1 | static_cast<int>(p)) - static_cast<int>(fitted[e][c] + 0.5f);
+						error += difference * difference;
+					}
+
+					if (error < bestError)
+					{
+						bestError = error;
+						pBits[e] = p;
+						std::copy(quantized, quantized + 4, endpoints[e]);
+					}
+				}
+			}
+
+			static constexpr int weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+			int palette[16][4];
+			for (int i = 0; i < 16; ++i)
+			{
+				for (int c = 0; c < 4; ++c)
+				{
+					const int e0 = endpoints[0][c] << 1 | static_cast<int>(pBits[0]);
+					const int e1 = endpoints[1][c] << 1 | static_cast<int>(pBits[1]);
+					palette[i][c] = ((64 - weights[i]) * e0 + weights[i] * e1 + 32) >> 6;
+				}
+			}
+
+			uint32_t indices[16];
+			for (int t = 0; t < 16; ++t)
+			{
+				int bestError = 1 << 30;
+				for (uint32_t i = 0; i < 16; ++i)
+				{
+					int error = 0;
+					for (int c = 0; c < 4; ++c)
+					{
+						const int difference = static_cast<int>(texels[t][c] + 0.5f) - palette[i][c];
+						error += difference * difference;
+					}
+
+					if (error < bestError)
+					{
+						bestError = error;
+						indices[t] = i;
+					}
+				}
+			}
+
+			// The first index is stored with its top bit implied zero, so swap the endpoints if it's set.
+			if (indices[0] >= 8)
+			{
+				std::swap(endpoints[0], endpoints[1]);
+				std::swap(pBits[0], pBits[1]);
+				for (uint32_t& index : indices)
+					index = 15 - index;
+			}
+
+			BlockBitWriter writer(out, 16);
+			writer.write(1u << 6, 7); // Mode 6.
+			for (int c = 0; c < 4; ++c)
+			{
+				writer.write(static_cast<uint32_t>(endpoints[0][c]), 7);
+				writer.write(static_cast<uint32_t>(endpoints[1][c]), 7);
+			}
+			writer.write(pBits[0], 1);
+			writer.write(pBits[1], 1);
+
+			writer.write(indices[0], 3);
+			for (int t = 1; t < 16; ++t)
+				writer.write(indices[t], 4);
+		}
+
+		GAL_INLINE void encodeBlock(BCFormat format, const float (&texels)[16][4], unsigned char* out) noexcept
+		{
+			switch (format)
+			{
+				case BCFormat::BC1: encodeBC1Block(texels, out); break;
+				case BCFormat::BC3: encodeBC4Block(texels, 3, out); encodeBC1Block(texels, out + 8); break;
+				case BCFormat::BC4: encodeBC4Block(texels, 0, out); break;
+				case BCFormat::BC5: encodeBC4Block(texels, 0, out); encodeBC4Block(texels, 1, out + 8); break;
+				case BCFormat::BC7: encodeBC7Block(texels, out); break;
+			}
+		}
+	}
+
+	/// @brief Compress an 8-bit RGBA image into the given block format. Blocks are shared out between worker threads.
+	/// Dimensions don't need to be multiples of 4; edge blocks repeat the last row and column.
+	/// @param pixels: width * height * 4 bytes, first row first.
+	/// @param threadCount: Number of threads to encode with. 0 uses every hardware thread.
+	/// @return bcImageSize(format, width, height) bytes of blocks in row order.
+	GAL_NODISCARD GAL_INLINE std::vector<unsigned char> compressBCn(BCFormat format, const unsigned char* pixels, int width, int height,
+		unsigned threadCount = 0)
+	{
+		const int blocksX = (width + 3) / 4;
+		const int blocksY = (height + 3) / 4;
+		const size_t blockSize = bcBlockSize(format);
+
+		std::vector<unsigned char> blocks(bcImageSize(format, width, height));
+		std::atomic<int> nextRow{ 0 };
+
+		const auto encodeRows = [&]
+		{
+			for (int by = nextRow++; by < blocksY; by = nextRow++)
+			{
+				for (int bx = 0; bx < blocksX; ++bx)
+				{
+					float texels[16][4];
+					for (int i = 0; i < 16; ++i)
+					{
+						const int x = std::min(bx * 4 + i % 4, width - 1);
+						const int y = std::min(by * 4 + i / 4, height - 1);
+						const unsigned char* pixel = pixels + (static_cast<size_t>(y) * width + x) * 4;
+
+						for (int c = 0; c < 4; ++c)
+							texels[i][c] = pixel[c];
+					}
+
+					detail::encodeBlock(format, texels, blocks.data() + (static_cast<size_t>(by) * blocksX + bx) * blockSize);
+				}
+			}
+		};
+
+		if (threadCount == 0)
+			threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+		threadCount = std::min(threadCount, static_cast<unsigned>(blocksY));
+
+		std::vector<std::thread> threads;
+		for (unsigned i = 1; i < threadCount; ++i)
+			threads.emplace_back(encodeRows);
+
+		encodeRows();
+		for (std::thread& thread : threads)
+			thread.join();
+
+		return blocks;
+	}
+}
+
+#endif
@@ -0,0 +1,822 @@
+#ifndef GAL_BVH_HPP
+#define GAL_BVH_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "attributes.hpp"
+#include "enums.hpp"
+#include "Frustum.hpp"
+#include "GALException.hpp"
+#include "MeshInstance.hpp"
+#include "parallel.hpp"
+
+namespace gal
+{
+	/// @brief Identifies an item inserted into a BVH.
+	using BVHHandle = uint32_t;
+
+	struct BVHSettings
+	{
+		uint32_t maxLeafSize = 4; // Leaves hold at most this many items.
+
+		// refit() rebuilds the tree once the summed surface area of its nodes has grown by this factor since the last
+		// build, as moving items makes nodes overlap more and queries slower.
+		float rebuildAreaRatio = 2.0f;
+
+		// refit() rebuilds the tree once the items inserted or removed since the last build exceed this fraction of the
+		// items in it. Until then, items inserted since the last build are tested one by one by every query.
+		float rebuildChangeFraction = 0.1f;
+
+		unsigned threadCount = 0; // Threads used to build large trees. 0 uses every hardware thread.
+	};
+
+	struct BVHRaycastHit
+	{
+		BVHHandle handle;
+		float distance; // Along the ray, in multiples of the direction's length.
+	};
+
+	/// @brief A dynamic bounding volume hierarchy over axis aligned boxes, e.g. the world bounds of MeshInstances, for
+	/// culling, picking and overlap queries that only visit the parts of the scene near what they look for.
+	///
+	/// The tree is built top down with the binned surface area heuristic, in parallel for large scenes, into a flat array
+	/// of 32 byte nodes with both children of a node next to each other. When items move, update() their bounds and call
+	/// refit() once per frame, which grows the boxes of their leaves and ancestors rather than rebuilding. Once refitting
+	/// has degraded the tree too much, or enough items were inserted or removed, refit() rebuilds it (see BVHSettings).
+	///
+	/// Items with infinite bounds, such as MeshInstances that are never culled, are kept out of the tree, where they
+	/// would cover everything, and are tested by every query instead.
+	class BVH
+	{
+	public:
+		GAL_STATIC GAL_CONSTEXPR BVHHandle NullHandle = UINT32_MAX;
+
+		GAL_INLINE BVH(const BVHSettings& settings = BVHSettings())
+			: settings(settings) {}
+
+		/// @brief Add an item with the given bounds. It is found by queries straight away, but only enters the tree at
+		/// the next rebuild. Bounds may be infinite.
+		GAL_NODISCARD GAL_INLINE BVHHandle insert(const glm::vec3& min, const glm::vec3& max)
+		{
+			BVHHandle handle;
+			if (!freeHandles.empty())
+			{
+				handle = freeHandles.back();
+				freeHandles.pop_back();
+			}
+			else
+			{
+				handle = static_cast<BVHHandle>(items.size());
+				items.emplace_back();
+			}
+
+			Item& item = items[handle];
+			item.min = min;
+			item.max = max;
+			item.alive = true;
+
+			attach(handle);
+			return handle;
+		}
+
+		/// @brief Add a MeshInstance by the box around its world space bounding sphere. Instances without a bounding
+		/// sphere, which are never culled, get an infinite box.
+		GAL_NODISCARD GAL_INLINE BVHHandle insert(const MeshInstance& instance)
+		{
+			glm::vec3 min, max;
+			getBounds(instance, min, max);
+			return insert(min, max);
+		}
+
+		/// @brief Change an item's bounds. The tree catches up at the next refit().
+		GAL_INLINE void update(BVHHandle handle, const glm::vec3& min, const glm::vec3& max)
+		{
+			Item& item = getItem(handle);
+
+			// Items moving into or out of the tree start over as if newly inserted.
+			if (item.unbounded != isUnbounded(min, max))
+			{
+				detach(handle);
+				item.min = min;
+				item.max = max;
+				attach(handle);
+				return;
+			}
+
+			item.min = min;
+			item.max = max;
+
+			if (item.leaf != NoIndex)
+				markLeafDirty(item.leaf);
+		}
+
+		GAL_INLINE void update(BVHHandle handle, const MeshInstance& instance)
+		{
+			glm::vec3 min, max;
+			getBounds(instance, min, max);
+			update(handle, min, max);
+		}
+
+		/// @brief Remove an item. Its handle may be reused by later inserts.
+		GAL_INLINE void remove(BVHHandle handle)
+		{
+			Item& item = getItem(handle);
+			detach(handle);
+
+			item.alive = false;
+			freeHandles.push_back(handle);
+		}
+
+		GAL_NODISCARD GAL_INLINE bool contains(BVHHandle handle) const noexcept
+		{
+			return handle < items.size() && items[handle].alive;
+		}
+
+		GAL_NODISCARD GAL_INLINE size_t size() const noexcept { return items.size() - freeHandles.size(); }
+		GAL_NODISCARD GAL_INLINE size_t getNodeCount() const noexcept { return nodes.size(); }
+
+		/// @brief Rebuild the whole tree from every item's current bounds.
+		GAL_INLINE void build()
+		{
+			// Building partitions copies of the bounds rather than handles into items, so every pass reads memory in order.
+			std::vector<BuildPrimitive> primitives;
+			primitives.reserve(size());
+			for (BVHHandle handle = 0; handle < static_cast<BVHHandle>(items.size()); ++handle)
+			{
+				const Item& item = items[handle];
+				if (item.alive && !item.unbounded)
+					primitives.push_back({ item.min, item.max, (item.min + item.max) * 0.5f, handle });
+			}
+
+			nodes.clear();
+			pendingItems.clear();
+			dirtyLeaves.clear();
+			removedSinceBuild = 0;
+
+			if (!primitives.empty())
+			{
+				unsigned threadCount = settings.threadCount;
+				if (threadCount == 0)
+					threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+				// Build the top of the tree here, handing subtrees small enough to balance across threads to the workers.
+				const size_t taskSize = threadCount > 1 ? std::max<size_t>(primitives.size() / (threadCount * 4), 4096) : primitives.size();
+
+				std::vector<BuildTask> tasks;
+				nodes.emplace_back();
+				buildNode(nodes, 0, primitives, 0, primitives.size(), taskSize, &tasks);
+
+				std::vector<std::vector<Node>> subtrees(tasks.size());
+				detail::parallelFor(tasks.size(), threadCount, [&](size_t begin, size_t end)
+					{
+						for (size_t t = begin; t < end; ++t)
+						{
+							subtrees[t].emplace_back();
+							buildNode(subtrees[t], 0, primitives, tasks[t].begin, tasks[t].end, primitives.size(), nullptr);
+						}
+					}, 1);
+
+				// Each subtree's root replaces its placeholder, the rest go at the back with child indices shifted to match.
+				for (size_t t = 0; t < tasks.size(); ++t)
+				{
+					const uint32_t base = static_cast<uint32_t>(nodes.size()) - 1;
+					for (Node& node : subtrees[t])
+					{
+						if (node.count == 0)
+							node.offset += base;
+					}
+
+					nodes[tasks[t].node] = subtrees[t][0];
+					nodes.insert(nodes.end(), subtrees[t].begin() + 1, subtrees[t].end());
+				}
+			}
+
+			leafItems.resize(primitives.size());
+			for (size_t i = 0; i < primitives.size(); ++i)
+				leafItems[i] = primitives[i].handle;
+
+			parents.assign(nodes.size(), NoIndex);
+			leafDirtyFlags.assign(nodes.size(), 0);
+
+			for (uint32_t i = 0; i < static_cast<uint32_t>(nodes.size()); ++i)
+			{
+				const Node& node = nodes[i];
+				if (node.count == 0)
+				{
+					parents[node.offset] = i;
+					parents[node.offset + 1] = i;
+				}
+				else
+				{
+					for (uint32_t slot = node.offset; slot < node.offset + node.count; ++slot)
+					{
+						items[leafItems[slot]].leaf = i;
+						items[leafItems[slot]].slot = slot;
+					}
+				}
+			}
+
+			builtArea = 0.0f;
+			for (const Node& node : nodes)
+				builtArea += surfaceArea(node.min, node.max);
+
+			currentArea = builtArea;
+		}
+
+		/// @brief Bring the tree up to date with the bounds given to update() and remove(), or rebuild it if it has
+		/// degraded too far. Call once per frame before querying.
+		GAL_INLINE void refit()
+		{
+			const size_t indexed = leafItems.size() - removedSinceBuild;
+			const size_t changed = pendingItems.size() + removedSinceBuild;
+
+			if (changed > 0 && static_cast<float>(changed) > settings.rebuildChangeFraction * static_cast<float>(indexed))
+			{
+				build();
+				return;
+			}
+
+			for (uint32_t leaf : dirtyLeaves)
+			{
+				leafDirtyFlags[leaf] = 0;
+
+				glm::vec3 min(std::numeric_limits<float>::max());
+				glm::vec3 max(std::numeric_limits<float>::lowest());
+
+				for (uint32_t slot = nodes[leaf].offset; slot < nodes[leaf].offset + nodes[leaf].count; ++slot)
+				{
+					if (leafItems[slot] != NullHandle)
+					{
+						min = glm::min(min, items[leafItems[slot]].min);
+						max = glm::max(max, items[leafItems[slot]].max);
+					}
+				}
+
+				// Walk up while the boxes keep changing. An ancestor that didn't change has nothing new to pass on.
+				for (uint32_t node = leaf; setBounds(node, min, max) && parents[node] != NoIndex;)
+				{
+					node = parents[node];
+					const Node& first = nodes[nodes[node].offset];
+					const Node& second = nodes[nodes[node].offset + 1];
+					min = glm::min(first.min, second.min);
+					max = glm::max(first.max, second.max);
+				}
+			}
+
+			dirtyLeaves.clear();
+
+			if (builtArea > 0.0f && currentArea > builtArea * settings.rebuildAreaRatio)
+				build();
+		}
+
+		/// @brief Append the handles of every item whose bounds intersect the frustum to out.
+		GAL_INLINE void queryFrustum(const Frustum& frustum, std::vector<BVHHandle>& out) const
+		{
+			if (!nodes.empty())
+			{
+				struct Entry
+				{
+					uint32_t node;
+					uint32_t planeMask; // Planes the node's parent wasn't entirely inside of.
+				};
+
+				std::vector<Entry> stack;
+				stack.push_back({ 0, (1u << 6) - 1 });
+
+				while (!stack.empty())
+				{
+					const Entry entry = stack.back();
+					stack.pop_back();
+
+					const Node& node = nodes[entry.node];
+					const uint32_t mask = classify(frustum, node.min, node.max, entry.planeMask);
+
+					if (mask == Outside)
+						continue;
+
+					// Entirely inside: everything below is visible without further tests.
+					if (mask == 0)
+					{
+						appendSubtree(entry.node, out);
+						continue;
+					}
+
+					if (node.count != 0)
+					{
+						for (uint32_t slot = node.offset; slot < node.offset + node.count; ++slot)
+						{
+							const BVHHandle handle = leafItems[slot];
+							if (handle != NullHandle && classify(frustum, items[handle].min, items[handle].max, mask) != Outside)
+								out.push_back(handle);
+						}
+					}
+					else
+					{
+						stack.push_back({ node.offset, mask });
+						stack.push_back({ node.offset + 1, mask });
+					}
+				}
+			}
+
+			for (BVHHandle handle : pendingItems)
+			{
+				if (frustum.intersectsAABB(items[handle].min, items[handle].max))
+					out.push_back(handle);
+			}
+
+			out.insert(out.end(), unboundedItems.begin(), unboundedItems.end());
+		}
+
+		/// @brief Append the handles of every item whose bounds overlap the box to out.
+		GAL_INLINE void queryAABB(const glm::vec3& min, const glm::vec3& max, std::vector<BVHHandle>& out) const
+		{
+			query([&](const glm::vec3& boxMin, const glm::vec3& boxMax)
+				{
+					return boxMin.x <= max.x && boxMin.y <= max.y && boxMin.z <= max.z
+						&& boxMax.x >= min.x && boxMax.y >= min.y && boxMax.z >= min.z;
+				}, out);
+		}
+
+		/// @brief Append the handles of every item whose bounds overlap the sphere to out.
+		GAL_INLINE void querySphere(const glm::vec3& center, float radius, std::vector<BVHHandle>& out) const
+		{
+			query([&](const glm::vec3& boxMin, const glm::vec3& boxMax)
+				{
+					const glm::vec3 closest = glm::clamp(center, boxMin, boxMax);
+					const glm::vec3 offset = closest - center;
+					return glm::dot(offset, offset) <= radius * radius;
+				}, out);
+		}
+
+		/// @brief Find the nearest item whose bounds the ray hits closer than maxDistance. Items with infinite bounds are
+		/// skipped, as every ray would hit them at its origin.
+		GAL_NODISCARD GAL_INLINE std::optional<BVHRaycastHit> raycast(const glm::vec3& origin, const glm::vec3& direction,
+			float maxDistance = std::numeric_limits<float>::infinity()) const
+		{
+			return raycastItems(origin, direction, maxDistance, [](BVHHandle, float boxDistance) { return boxDistance; }, false);
+		}
+
+		/// @brief Find the nearest item the ray hits closer than maxDistance, with an exact test for items whose bounds it hits,
+		/// e.g. against the mesh's triangles. Items are tested roughly front to back, and subtrees further away than the
+		/// nearest hit so far are skipped. Items with infinite bounds are always tested, with a boxDistance of 0.
+		/// @param intersect: float(BVHHandle handle, float boxDistance), returning the distance along the ray the item is
+		/// hit at, or a negative value if it's missed. boxDistance is where the ray enters the item's bounds.
+		template<typename Intersector>
+		GAL_NODISCARD GAL_INLINE std::optional<BVHRaycastHit> raycast(const glm::vec3& origin, const glm::vec3& direction,
+			float maxDistance, Intersector&& intersect) const
+		{
+			return raycastItems(origin, direction, maxDistance, intersect, true);
+		}
+
+	private:
+		GAL_STATIC GAL_CONSTEXPR uint32_t NoIndex = UINT32_MAX;
+		GAL_STATIC GAL_CONSTEXPR uint32_t Outside = UINT32_MAX;
+		GAL_STATIC GAL_CONSTEXPR int BinCount = 16;
+
+		template<typename Intersector>
+		GAL_NODISCARD GAL_INLINE std::optional<BVHRaycastHit> raycastItems(const glm::vec3& origin, const glm::vec3& direction,
+			float maxDistance, Intersector&& intersect, bool testUnbounded) const
+		{
+			const glm::vec3 inverseDirection = 1.0f / direction;
+			BVHRaycastHit nearest = { NullHandle, maxDistance };
+
+			const auto testItem = [&](BVHHandle handle)
+			{
+				const float boxDistance = rayBoxDistance(origin, inverseDirection, items[handle].min, items[handle].max);
+				if (boxDistance < nearest.distance)
+				{
+					const float distance = intersect(handle, boxDistance);
+					if (distance >= 0.0f && distance < nearest.distance)
+						nearest = { handle, distance };
+				}
+			};
+
+			if (!nodes.empty())
+			{
+				struct Entry
+				{
+					uint32_t node;
+					float distance;
+				};
+
+				std::vector<Entry> stack;
+				const float rootDistance = rayBoxDistance(origin, inverseDirection, nodes[0].min, nodes[0].max);
+				if (rootDistance < nearest.distance)
+					stack.push_back({ 0, rootDistance });
+
+				while (!stack.empty())
+				{
+					const Entry entry = stack.back();
+					stack.pop_back();
+
+					if (entry.distance >= nearest.distance)
+						continue;
+
+					const Node& node = nodes[entry.node];
+					if (node.count != 0)
+					{
+						for (uint32_t slot = node.offset; slot < node.offset + node.count; ++slot)
+						{
+							if (leafItems[slot] != NullHandle)
+								testItem(leafItems[slot]);
+						}
+
+						continue;
+					}
+
+					Entry first = { node.offset, rayBoxDistance(origin, inverseDirection, nodes[node.offset].min, nodes[node.offset].max) };
+					Entry second = { node.offset + 1, rayBoxDistance(origin, inverseDirection, nodes[node.offset + 1].min, nodes[node.offset + 1].max) };
+
+					// Push the far child first so the near one is visited next.
+					if (first.distance < second.distance)
+						std::swap(first, second);
+
+					if (first.distance < nearest.distance)
+						stack.push_back(first);
+					if (second.distance < nearest.distance)
+						stack.push_back(second);
+				}
+			}
+
+			for (BVHHandle handle : pendingItems)
+				testItem(handle);
+			if (testUnbounded)
+			{
+				for (BVHHandle handle : unboundedItems)
+					testItem(handle);
+			}
+
+			if (nearest.handle == NullHandle)
+				return std::nullopt;
+
+			return nearest;
+		}
+
+		/// @brief 32 bytes, so two nodes (a pair of siblings) share a cache line.
+		struct Node
+		{
+			glm::vec3 min = glm::vec3(0.0f);
+			uint32_t offset = 0; // Interior nodes: index of the first child, the second being right after it. Leaves: first slot in leafItems.
+			glm::vec3 max = glm::vec3(0.0f);
+			uint32_t count = 0; // Slots in leafItems for leaves, 0 for interior nodes.
+		};
+
+		struct Item
+		{
+			glm::vec3 min;
+			glm::vec3 max;
+			uint32_t leaf = NoIndex; // Leaf node the item is in, or NoIndex if it was inserted since the last build or is unbounded.
+			uint32_t slot = 0; // Index in leafItems, or in pendingItems or unboundedItems if not in a leaf.
+			bool alive = false;
+			bool unbounded = false;
+		};
+
+		struct BuildPrimitive
+		{
+			glm::vec3 min;
+			glm::vec3 max;
+			glm::vec3 centroid;
+			BVHHandle handle;
+		};
+
+		struct BuildTask
+		{
+			uint32_t node;
+			size_t begin;
+			size_t end;
+		};
+
+		BVHSettings settings;
+
+		std::vector<Item> items;
+		std::vector<BVHHandle> freeHandles;
+
+		std::vector<Node> nodes;
+		std::vector<uint32_t> parents;
+		std::vector<BVHHandle> leafItems; // Items of each leaf, one range per leaf. NullHandle where an item was removed.
+		std::vector<BVHHandle> pendingItems; // Inserted since the last build.
+		std::vector<BVHHandle> unboundedItems; // Never in the tree.
+
+		std::vector<uint32_t> dirtyLeaves;
+		std::vector<uint8_t> leafDirtyFlags;
+
+		size_t removedSinceBuild = 0;
+		float builtArea = 0.0f;
+		float currentArea = 0.0f;
+
+		GAL_NODISCARD GAL_INLINE Item& getItem(BVHHandle handle)
+		{
+			if (!contains(handle))
+				detail::throwErr(ErrCode::InvalidBVHHandle, "Used a BVH handle that was never inserted or has been removed.");
+
+			return items[handle];
+		}
+
+		GAL_NODISCARD GAL_STATIC GAL_INLINE bool isUnbounded(const glm::vec3& min, const glm::vec3& max) noexcept
+		{
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				if (std::isinf(min[axis]) || std::isinf(max[axis]))
+					return true;
+			}
+
+			return false;
+		}
+
+		GAL_STATIC GAL_INLINE void getBounds(const MeshInstance& instance, glm::vec3& min, glm::vec3& max) noexcept
+		{
+			const glm::vec4 sphere = instance.getWorldBoundingSphere();
+			const glm::vec3 extent(sphere.w < 0.0f ? std::numeric_limits<float>::infinity() : sphere.w);
+			min = glm::vec3(sphere) - extent;
+			max = glm::vec3(sphere) + extent;
+		}
+
+		/// @brief Make an item found by queries again after its bounds were set: pending until the next rebuild, or
+		/// unbounded.
+		GAL_INLINE void attach(BVHHandle handle)
+		{
+			Item& item = items[handle];
+			item.leaf = NoIndex;
+			item.unbounded = isUnbounded(item.min, item.max);
+
+			std::vector<BVHHandle>& list = item.unbounded ? unboundedItems : pendingItems;
+			item.slot = static_cast<uint32_t>(list.size());
+			list.push_back(handle);
+		}
+
+		/// @brief Take an item out of its leaf or list.
+		GAL_INLINE void detach(BVHHandle handle)
+		{
+			const Item& item = items[handle];
+
+			if (item.leaf != NoIndex)
+			{
+				leafItems[item.slot] = NullHandle;
+				markLeafDirty(item.leaf);
+				removedSinceBuild++;
+				return;
+			}
+
+			std::vector<BVHHandle>& list = item.unbounded ? unboundedItems : pendingItems;
+			const BVHHandle moved = list.back();
+			list[item.slot] = moved;
+			items[moved].slot = item.slot;
+			list.pop_back();
+		}
+
+		GAL_INLINE void markLeafDirty(uint32_t leaf)
+		{
+			if (!leafDirtyFlags[leaf])
+			{
+				leafDirtyFlags[leaf] = 1;
+				dirtyLeaves.push_back(leaf);
+			}
+		}
+
+		/// @brief Returns whether the node's bounds changed.
+		GAL_INLINE bool setBounds(uint32_t index, const glm::vec3& min, const glm::vec3& max) noexcept
+		{
+			Node& node = nodes[index];
+			if (node.min == min && node.max == max)
+				return false;
+
+			currentArea += surfaceArea(min, max) - surfaceArea(node.min, node.max);
+			node.min = min;
+			node.max = max;
+			return true;
+		}
+
+		GAL_NODISCARD GAL_STATIC GAL_INLINE float surfaceArea(const glm::vec3& min, const glm::vec3& max) noexcept
+		{
+			const glm::vec3 size = max - min;
+			if (size.x < 0.0f || size.y < 0.0f || size.z < 0.0f)
+				return 0.0f;
+
+			return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+		}
+
+		/// @brief Build the subtree for primitives[begin, end) into out[nodeIndex], appending its descendants to out. With
+		/// tasks, ranges no larger than taskSize are left for later and recorded there instead.
+		GAL_INLINE void buildNode(std::vector<Node>& out, uint32_t nodeIndex, std::vector<BuildPrimitive>& primitives, size_t begin,
+			size_t end, size_t taskSize, std::vector<BuildTask>* tasks) const
+		{
+			if (tasks != nullptr && end - begin <= taskSize)
+			{
+				tasks->push_back({ nodeIndex, begin, end });
+				return;
+			}
+
+			glm::vec3 min(std::numeric_limits<float>::max());
+			glm::vec3 max(std::numeric_limits<float>::lowest());
+			glm::vec3 centroidMin = min;
+			glm::vec3 centroidMax = max;
+
+			for (size_t i = begin; i < end; ++i)
+			{
+				const BuildPrimitive& primitive = primitives[i];
+				min = glm::min(min, primitive.min);
+				max = glm::max(max, primitive.max);
+				centroidMin = glm::min(centroidMin, primitive.centroid);
+				centroidMax = glm::max(centroidMax, primitive.centroid);
+			}
+
+			out[nodeIndex].min = min;
+			out[nodeIndex].max = max;
+
+			const size_t count = end - begin;
+			if (count <= settings.maxLeafSize)
+			{
+				out[nodeIndex].offset = static_cast<uint32_t>(begin);
+				out[nodeIndex].count = static_cast<uint32_t>(count);
+				return;
+			}
+
+			const glm::vec3 extent = centroidMax - centroidMin;
+			const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+			size_t middle;
+			if (extent[axis] <= 0.0f)
+			{
+				// Every centroid is in the same place, so no plane can separate them. Split the range in half instead.
+				middle = begin + count / 2;
+			}
+			else
+			{
+				const float binScale = BinCount / extent[axis];
+				const auto binOf = [&](const BuildPrimitive& primitive)
+				{
+					return std::min(static_cast<int>((primitive.centroid[axis] - centroidMin[axis]) * binScale), BinCount - 1);
+				};
+
+				struct Bin
+				{
+					glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+					glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
+					size_t count = 0;
+				};
+
+				std::array<Bin, BinCount> bins;
+				for (size_t i = begin; i < end; ++i)
+				{
+					Bin& bin = bins[binOf(primitives[i])];
+					bin.min = glm::min(bin.min, primitives[i].min);
+					bin.max = glm::max(bin.max, primitives[i].max);
+					bin.count++;
+				}
+
+				// Cost of splitting after each bin is areaLeft * countLeft + areaRight * countRight, from sweeps both ways.
+				std::array<float, BinCount - 1> costs;
+				Bin sweep;
+				for (int b = 0; b < BinCount - 1; ++b)
+				{
+					sweep.min = glm::min(sweep.min, bins[b].min);
+					sweep.max = glm::max(sweep.max, bins[b].max);
+					sweep.count += bins[b].count;
+					costs[b] = surfaceArea(sweep.min, sweep.max) * sweep.count;
+				}
+
+				sweep = Bin();
+				for (int b = BinCount - 1; b > 0; --b)
+				{
+					sweep.min = glm::min(sweep.min, bins[b].min);
+					sweep.max = glm::max(sweep.max, bins[b].max);
+					sweep.count += bins[b].count;
+					costs[b - 1] += surfaceArea(sweep.min, sweep.max) * sweep.count;
+				}
+
+				const int split = static_cast<int>(std::min_element(costs.begin(), costs.end()) - costs.begin());
+				middle = std::partition(primitives.begin() + begin, primitives.begin() + end,
+					[&](const BuildPrimitive& primitive) { return binOf(primitive) <= split; }) - primitives.begin();
+
+				// The cheapest split may still leave one side empty when the cost ties, e.g. with zero area boxes.
+				if (middle == begin || middle == end)
+					middle = begin + count / 2;
+			}
+
+			const uint32_t firstChild = static_cast<uint32_t>(out.size());
+			out[nodeIndex].offset = firstChild;
+			out[nodeIndex].count = 0;
+			out.emplace_back();
+			out.emplace_back();
+
+			buildNode(out, firstChild, primitives, begin, middle, taskSize, tasks);
+			buildNode(out, firstChild + 1, primitives, middle, end, taskSize, tasks);
+		}
+
+		/// @brief Test a box against the planes in planeMask. Returns Outside if it's entirely outside one of them,
+		/// otherwise the planes it's not entirely inside of.
+		GAL_NODISCARD GAL_STATIC GAL_INLINE uint32_t classify(const Frustum& frustum, const glm::vec3& min, const glm::vec3& max,
+			uint32_t planeMask) noexcept
+		{
+			uint32_t remaining = planeMask;
+			for (uint32_t p = 0; p < 6; ++p)
+			{
+				if (!(planeMask & (1u << p)))
+					continue;
+
+				const glm::vec4& plane = frustum.planes[p];
+				const glm::vec3 normal(plane);
+
+				const glm::vec3 farCorner(plane.x >= 0.0f ? max.x : min.x, plane.y >= 0.0f ? max.y : min.y, plane.z >= 0.0f ? max.z : min.z);
+				if (glm::dot(normal, farCorner) + plane.w < 0.0f)
+					return Outside;
+
+				const glm::vec3 nearCorner(plane.x >= 0.0f ? min.x : max.x, plane.y >= 0.0f ? min.y : max.y, plane.z >= 0.0f ? min.z : max.z);
+				if (glm::dot(normal, nearCorner) + plane.w >= 0.0f)
+					remaining &= ~(1u << p);
+			}
+
+			return remaining;
+		}
+
+		GAL_INLINE void appendSubtree(uint32_t root, std::vector<BVHHandle>& out) const
+		{
+			std::vector<uint32_t> stack = { root };
+			while (!stack.empty())
+			{
+				const Node& node = nodes[stack.back()];
+				stack.pop_back();
+
+				if (node.count != 0)
+				{
+					for (uint32_t slot = node.offset; slot < node.offset + node.count; ++slot)
+					{
+						if (leafItems[slot] != NullHandle)
+							out.push_back(leafItems[slot]);
+					}
+				}
+				else
+				{
+					stack.push_back(node.offset);
+					stack.push_back(node.offset + 1);
+				}
+			}
+		}
+
+		/// @brief Append every item whose bounds pass overlaps(min, max), descending into nodes whose bounds pass it too.
+		template<typename Overlaps>
+		GAL_INLINE void query(Overlaps&& overlaps, std::vector<BVHHandle>& out) const
+		{
+			if (!nodes.empty())
+			{
+				std::vector<uint32_t> stack = { 0 };
+				while (!stack.empty())
+				{
+					const Node& node = nodes[stack.back()];
+					stack.pop_back();
+
+					if (!overlaps(node.min, node.max))
+						continue;
+
+					if (node.count != 0)
+					{
+						for (uint32_t slot = node.offset; slot < node.offset + node.count; ++slot)
+						{
+							const BVHHandle handle = leafItems[slot];
+							if (handle != NullHandle && overlaps(items[handle].min, items[handle].max))
+								out.push_back(handle);
+						}
+					}
+					else
+					{
+						stack.push_back(node.offset);
+						stack.push_back(node.offset + 1);
+					}
+				}
+			}
+
+			for (const std::vector<BVHHandle>* list : { &pendingItems, &unboundedItems })
+			{
+				for (BVHHandle handle : *list)
+				{
+					if (overlaps(items[handle].min, items[handle].max))
+						out.push_back(handle);
+				}
+			}
+		}
+
+		/// @brief Distance along the ray to where it enters the box (0 if it starts inside), or infinity if it misses.
+		GAL_NODISCARD GAL_STATIC GAL_INLINE float rayBoxDistance(const glm::vec3& origin, const glm::vec3& inverseDirection,
+			const glm::vec3& min, const glm::vec3& max) noexcept
+		{
+			const glm::vec3 t0 = (min - origin) * inverseDirection;
+			const glm::vec3 t1 = (max - origin) * inverseDirection;
+			const glm::vec3 tNear = glm::min(t0, t1);
+			const glm::vec3 tFar = glm::max(t0, t1);
+
+			const float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+			const float exit = std::min(std::min(tFar.x, tFar.y), tFar.z);
+
+			return enter <= exit ? enter : std::numeric_limits<float>::infinity();
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,642 @@
+#ifndef GAL_BRICKED_VOLUME_HPP
+#define GAL_BRICKED_VOLUME_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "attributes.hpp"
+#include "Buffer.hpp"
+#include "enums.hpp"
+#include "Frustum.hpp"
+#include "GALException.hpp"
+#include "glParams.hpp"
+#include "logging.hpp"
+#include "StreamingCache.hpp"
+#include "Texture.hpp"
+
+namespace gal
+{
+	/// @brief Settings for a BrickedVolume.
+	struct BrickedVolumeSettings
+	{
+		glm::ivec3 volumeSize{ 512 }; // Voxels in each direction.
+		GLsizei brickSize = 64; // Voxels along each side of a brick, excluding its border.
+		GLsizei border = 1; // Voxels around every brick copied from its neighbors, so trilinear filtering stays inside the brick.
+
+		// Brick slots in the resident brick pool. At most 256 in each direction, and each side of the pool texture,
+		// poolBricks * (brickSize + 2 * border) voxels, must fit in GL_MAX_3D_TEXTURE_SIZE. The pool takes that many
+		// voxels cubed times bytesPerVoxel of video memory, so the defaults allocate a 528^3 R16 texture of about 294 MB.
+		glm::ivec3 poolBricks{ 8, 8, 8 };
+
+		// Voxel format of the brick pool and of the data the loader writes.
+		GLenum internalFormat = GL_R16;
+		GLenum format = GL_RED;
+		GLenum type = GL_UNSIGNED_SHORT;
+		GLsizei bytesPerVoxel = 2;
+
+		float maxVoxelPixels = 1.0f; // Bricks are refined while their voxels would cover more pixels than this on screen.
+		int maxUploadsPerFrame = 8; // Bricks copied into the pool by each call to update().
+		unsigned workerCount = 0; // Brick loading threads. 0 picks one less than the number of hardware threads.
+
+		// Binding points used by the shader code from BrickedVolume::getShaderSource().
+		GLuint indirectionUnit = 11;
+		GLuint poolUnit = 12;
+		GLuint rangeUnit = 13;
+		GLuint uniformBinding = 13;
+	};
+
+	/// @brief Snapshot of what a BrickedVolume has resident and how busy its streaming is.
+	struct BrickedVolumeStats
+	{
+		size_t residentBricks = 0;
+		size_t poolBricks = 0;
+		size_t pendingBricks = 0; // Queued for or being loaded by the workers, or loaded and waiting to be uploaded.
+
+		size_t wantedLastUpdate = 0; // Bricks selected for the current view, at every level.
+		size_t uploadsLastUpdate = 0;
+		size_t evictionsLastUpdate = 0;
+
+		size_t totalUploads = 0;
+		size_t totalEvictions = 0;
+		size_t failedBricks = 0; // Bricks the loader failed to load. They're never requested again.
+	};
+
+	namespace detail
+	{
+		/// @brief Uniform block used by the BrickedVolume shader code, laid out to match it under std140.
+		struct BrickedVolumeParams
+		{
+			glm::vec4 volumeSize;
+			glm::vec4 brickSize;
+			glm::vec4 poolSize;
+			glm::vec4 visibleRange;
+		};
+
+		GAL_INLINE const char* const brickedVolumeShaderSource = R"(
+layout(std140, binding = BV_UNIFORM_BINDING) uniform BrickedVolumeParams
+{
+	vec4 bvVolumeSize; // Voxels.
+	vec4 bvBrickSize; // Voxels per brick side (x) and border voxels (y).
+	vec4 bvPoolSize; // Texels of the brick pool.
+	vec4 bvVisibleRange; // Values outside [x, y] are treated as empty space.
+};
+
+layout(binding = BV_INDIRECTION_UNIT) uniform usampler3D bvIndirection;
+layout(binding = BV_POOL_UNIT) uniform sampler3D bvPool;
+layout(binding = BV_RANGE_UNIT) uniform sampler3D bvBrickRanges;
+
+// Sample the volume at uvw, which is clamped to [0, 1], from the most detailed resident brick containing it.
+float bvSample(vec3 uvw)
+{
+	vec3 voxel = min(clamp(uvw, 0.0, 1.0) * bvVolumeSize.xyz, bvVolumeSize.xyz - 0.5);
+	uvec4 entry = texelFetch(bvIndirection, ivec3(voxel / bvBrickSize.x), 0);
+
+	vec3 brick = voxel / (bvBrickSize.x * exp2(float(entry.a)));
+	vec3 texel = vec3(entry.rgb) * (bvBrickSize.x + 2.0 * bvBrickSize.y) + bvBrickSize.y + fract(brick) * bvBrickSize.x;
+
+	return textureLod(bvPool, texel / bvPoolSize.xyz, 0.0).r;
+}
+
+// Whether the brick at the given level containing uvw holds no values in the visible range. Coarser levels skip more.
+bool bvBrickEmpty(vec3 uvw, int level)
+{
+	vec3 voxel = min(clamp(uvw, 0.0, 1.0) * bvVolumeSize.xyz, bvVolumeSize.xyz - 0.5);
+	vec2 range = texelFetch(bvBrickRanges, ivec3(voxel / (bvBrickSize.x * exp2(float(level)))), level).rg;
+
+	return range.y < bvVisibleRange.x || range.x > bvVisibleRange.y;
+}
+
+// Distance along dir (in uvw units) from uvw to where the ray leaves the brick at the given level containing uvw.
+float bvBrickExit(vec3 uvw, vec3 dir, int level)
+{
+	vec3 brickUVW = bvBrickSize.x * exp2(float(level)) / bvVolumeSize.xyz;
+	vec3 low = floor(uvw / brickUVW) * brickUVW;
+	vec3 exitPlane = mix(low, low + brickUVW, greaterThan(dir, vec3(0.0)));
+	vec3 safeDir = mix(vec3(1e-8), dir, greaterThan(abs(dir), vec3(1e-8)));
+	vec3 t = (exitPlane - uvw) / safeDir;
+
+	return max(min(t.x, min(t.y, t.z)), 0.0);
+}
+)";
+	}
+
+	/// @brief A 3D texture too large for video memory, split into bricks that are streamed in as the view needs them,
+	/// for raymarching data sets like CT scans of any size.
+	///
+	/// The volume is divided into cubic bricks at every level of a mip pyramid, each level's bricks covering twice the
+	/// voxels of the one below. Resident bricks live in slots of a fixed size brick pool 3D texture, and an integer
+	/// indirection 3D texture, one texel per level 0 brick, points each position at the most detailed resident brick
+	/// covering it. The single brick of the coarsest level is loaded up front and never evicted.
+	///
+	/// Each update() walks the brick hierarchy from the top, skipping bricks outside the frustum or holding no values in
+	/// the visible range, and refines the bricks whose voxels look largest on screen first until their voxels are small
+	/// enough or the pool would overflow. Missing bricks are loaded coarsest first on worker threads, and uploaded into
+	/// the least recently wanted slots.
+	///
+	/// Per-brick value ranges, if given, also go into a 3D texture with a mip level per brick level, so a raymarcher
+	/// can jump over empty bricks with bvBrickEmpty() and bvBrickExit().
+	class BrickedVolume
+	{
+	public:
+		/// @brief Load one brick into out, which holds (brickSize + 2 * border)^3 voxels in the settings' format, x
+		/// fastest then y then z. The brick covers voxels [x * size - border, (x + 1) * size + border) of the given
+		/// level, where size is brickSize and each level is the one below downsampled by 2, so the border repeats its
+		/// neighbors' voxels. Voxels outside the volume should repeat its edge. Returns false on failure.
+		/// Called from worker threads, and once from the constructor for the coarsest level.
+		using BrickLoader = std::function<bool(GLint level, GLint x, GLint y, GLint z, unsigned char* out)>;
+
+		/// @brief Create the brick pool, indirection and range textures, load the coarsest brick and start the workers.
+		/// Requires a current OpenGL context.
+		/// @param brickRanges: Optional minimum and maximum value of every level 0 brick, in the normalized units the
+		/// shader samples, x fastest then y then z. Without them no brick counts as empty.
+		GAL_INLINE BrickedVolume(BrickLoader loader, const BrickedVolumeSettings& settings = {},
+			const std::vector<glm::vec2>& brickRanges = {})
+			: loader(std::move(loader)), settings(settings)
+		{
+			if (settings.brickSize <= 0 || settings.border < 0 || settings.bytesPerVoxel <= 0
+				|| glm::any(glm::lessThan(settings.volumeSize, glm::ivec3(1)))
+				|| glm::any(glm::lessThan(settings.poolBricks, glm::ivec3(1)))
+				|| glm::any(glm::greaterThan(settings.poolBricks, glm::ivec3(256))))
+			{
+				detail::throwErr(ErrCode::InvalidBrickedVolumeSettings,
+					"Bricked volumes need a positive size and brick size and at most 256 pool bricks per side.");
+			}
+
+			// Pad the brick grid to powers of two so every level has exactly half the bricks of the one below.
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				const GLsizei bricks = (settings.volumeSize[axis] + settings.brickSize - 1) / settings.brickSize;
+				gridSize[axis] = 1;
+				while (gridSize[axis] < bricks)
+					gridSize[axis] *= 2;
+			}
+
+			while ((std::max({ gridSize.x, gridSize.y, gridSize.z }) >> levelCount) != 0)
+				++levelCount;
+
+			if (levelCount > static_cast<GLint>(levelOffsets.size()))
+			{
+				detail::throwErr(ErrCode::InvalidBrickedVolumeSettings,
+					"Bricked volumes can have at most 16 brick levels. Use larger bricks.");
+			}
+
+			totalBricks = 0;
+			for (GLint level = 0; level < levelCount; ++level)
+			{
+				const glm::ivec3 count = brickCount(level);
+				levelOffsets[level] = totalBricks;
+				totalBricks += static_cast<uint32_t>(count.x) * count.y * count.z;
+			}
+
+			slotSize = settings.brickSize + 2 * settings.border;
+			brickBytes = static_cast<size_t>(slotSize) * slotSize * slotSize * settings.bytesPerVoxel;
+
+			const GLint maxPoolSize = glParams::queryGLParamInt(GL_MAX_3D_TEXTURE_SIZE);
+			const int64_t poolSize = static_cast<int64_t>(slotSize)
+				* std::max({ settings.poolBricks.x, settings.poolBricks.y, settings.poolBricks.z });
+			if (poolSize > maxPoolSize)
+			{
+				detail::throwErr(ErrCode::InvalidBrickedVolumeSettings,
+					"The brick pool, poolBricks * (brickSize + 2 * border) voxels on a side, exceeds GL_MAX_3D_TEXTURE_SIZE.");
+			}
+
+			pool.storage(1, settings.internalFormat, slotSize * settings.poolBricks.x, slotSize * settings.poolBricks.y,
+				slotSize * settings.poolBricks.z);
+			pool.setParameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			pool.setParameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			for (GLenum wrap : { GL_TEXTURE_WRAP_S, GL_TEXTURE_WRAP_T, GL_TEXTURE_WRAP_R })
+				pool.setParameter(wrap, GL_CLAMP_TO_EDGE);
+
+			indirection.storage(levelCount, GL_RGBA8UI, gridSize.x, gridSize.y, gridSize.z);
+			detail::setIntegerTextureFiltering(indirection);
+
+			buildRanges(brickRanges);
+
+			tableEntries.assign(totalBricks, 0);
+			dirtySlices.assign(levelCount, { gridSize.z, -1 });
+
+			streaming = std::make_unique<detail::StreamingCache>(totalBricks,
+				static_cast<size_t>(settings.poolBricks.x) * settings.poolBricks.y * settings.poolBricks.z, brickBytes);
+
+			params.volumeSize = glm::vec4(glm::vec3(settings.volumeSize), 0.0f);
+			params.brickSize = glm::vec4(static_cast<float>(settings.brickSize), static_cast<float>(settings.border),
+				static_cast<float>(levelCount), 0.0f);
+			params.poolSize = glm::vec4(pool.getWidth(), pool.getHeight(), pool.getDepth(), 0.0f);
+			params.visibleRange = glm::vec4(0.0f, 1.0f, 0.0f, 0.0f);
+			uniformBuffer.allocateImmutable(sizeof(params), &params, GL_DYNAMIC_STORAGE_BIT);
+
+			// The coarsest brick is the fallback for everything, so it's loaded synchronously and pinned.
+			std::vector<unsigned char> voxels(brickBytes, 0);
+			if (!this->loader(levelCount - 1, 0, 0, 0, voxels.data()))
+			{
+				detail::logErr("BrickedVolume failed to load its coarsest brick.");
+				std::fill(voxels.begin(), voxels.end(), static_cast<unsigned char>(0));
+			}
+
+			mapBrick(totalBricks - 1, voxels.data());
+			uploadIndirection();
+
+			streaming->start([this](uint32_t brick, unsigned char* out)
+				{
+					GLint level;
+					glm::ivec3 position;
+					decodeBrick(brick, level, position);
+					return this->loader(level, position.x, position.y, position.z, out);
+				}, settings.workerCount);
+		}
+
+		// Forbid copying and moving, as the loading threads call back into the volume.
+		GAL_INLINE BrickedVolume(const BrickedVolume&) = delete;
+		GAL_INLINE BrickedVolume& operator=(const BrickedVolume&) = delete;
+
+		/// @brief Shader code declaring bvSample(), bvBrickEmpty() and bvBrickExit(), set up for this volume's bindings.
+		/// Insert it after the #version directive (4.50 or later) of the raymarching shader.
+		GAL_NODISCARD GAL_INLINE std::string getShaderSource() const
+		{
+			std::string source;
+			source += "#define BV_INDIRECTION_UNIT " + std::to_string(settings.indirectionUnit) + '\n';
+			source += "#define BV_POOL_UNIT " + std::to_string(settings.poolUnit) + '\n';
+			source += "#define BV_RANGE_UNIT " + std::to_string(settings.rangeUnit) + '\n';
+			source += "#define BV_UNIFORM_BINDING " + std::to_string(settings.uniformBinding) + '\n';
+
+			return source + detail::brickedVolumeShaderSource;
+		}
+
+		/// @brief Bind the indirection, pool and range textures and the uniform block for shaders using bvSample().
+		GAL_INLINE void bind() const noexcept
+		{
+			indirection.bindTextureUnit(static_cast<int>(settings.indirectionUnit));
+			pool.bindTextureUnit(static_cast<int>(settings.poolUnit));
+			ranges.bindTextureUnit(static_cast<int>(settings.rangeUnit));
+			uniformBuffer.bindBase(BufferType::Uniform, settings.uniformBinding);
+		}
+
+		/// @brief Set the range of values the transfer function shows. Bricks entirely outside it are treated as empty:
+		/// never loaded, and reported by bvBrickEmpty().
+		GAL_INLINE void setVisibleRange(float min, float max)
+		{
+			params.visibleRange = glm::vec4(min, max, 0.0f, 0.0f);
+			uniformBuffer.writeSub(offsetof(detail::BrickedVolumeParams, visibleRange), sizeof(glm::vec4), &params.visibleRange);
+		}
+
+		/// @brief Choose the bricks the view needs, queue the missing ones for loading and upload loaded ones into the
+		/// pool. Call once per frame on the render thread, before raymarching.
+		/// @param model: Transform from the volume's [0, 1] texture coordinates to world space.
+		/// @param view, projection: The camera's matrices.
+		/// @param viewportHeight: Height in pixels of the image being rendered.
+		GAL_INLINE void update(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection, GLsizei viewportHeight)
+		{
+			streaming->beginFrame();
+
+			selectBricks(model, view, projection, viewportHeight);
+			streaming->uploadLoaded(settings.maxUploadsPerFrame, "BrickedVolume failed to load a brick.",
+				[this](uint32_t brick, const unsigned char* voxels) { return mapBrick(brick, voxels); });
+			uploadIndirection();
+		}
+
+		GAL_NODISCARD GAL_INLINE const Texture& getIndirectionTexture() const noexcept { return indirection; }
+		GAL_NODISCARD GAL_INLINE const Texture& getPoolTexture() const noexcept { return pool; }
+		GAL_NODISCARD GAL_INLINE const Texture& getRangeTexture() const noexcept { return ranges; }
+		GAL_NODISCARD GAL_INLINE const BrickedVolumeSettings& getSettings() const noexcept { return settings; }
+
+		/// @brief Number of brick levels, down to a single brick.
+		GAL_NODISCARD GAL_INLINE GLint getLevelCount() const noexcept { return levelCount; }
+
+		GAL_NODISCARD GAL_INLINE BrickedVolumeStats getStats()
+		{
+			const detail::StreamingCache::Stats& streamingStats = streaming->getStats();
+
+			BrickedVolumeStats result = stats;
+			result.poolBricks = streaming->getSlotCount();
+			result.residentBricks = streaming->getResidentCount();
+			result.pendingBricks = streaming->getPendingCount();
+			result.uploadsLastUpdate = streamingStats.uploadsLastUpdate;
+			result.evictionsLastUpdate = streamingStats.evictionsLastUpdate;
+			result.totalUploads = streamingStats.totalUploads;
+			result.totalEvictions = streamingStats.totalEvictions;
+			result.failedBricks = streamingStats.failedItems;
+
+			return result;
+		}
+
+	private:
+		struct Candidate
+		{
+			uint32_t brick;
+			GLint level;
+			float voxelPixels; // Projected size of one of the brick's voxels.
+
+			GAL_NODISCARD GAL_INLINE bool operator<(const Candidate& other) const noexcept { return voxelPixels < other.voxelPixels; }
+		};
+
+		BrickLoader loader;
+		BrickedVolumeSettings settings;
+
+		glm::ivec3 gridSize{ 1 }; // Level 0 bricks in each direction, padded to powers of two.
+		GLint levelCount = 0;
+		std::array<uint32_t, 16> levelOffsets{}; // Index of each level's first brick. Bricks are numbered x fastest.
+		uint32_t totalBricks = 0;
+		GLsizei slotSize = 0;
+		size_t brickBytes = 0;
+
+		Texture pool{ TextureType::ThreeD };
+		Texture indirection{ TextureType::ThreeD };
+		Texture ranges{ TextureType::ThreeD };
+		Buffer uniformBuffer{ BufferType::Uniform };
+		detail::BrickedVolumeParams params{};
+
+		std::vector<glm::vec2> brickRanges; // Per brick, its minimum and maximum value.
+		std::vector<uint32_t> tableEntries; // Per brick, its indirection texel packed as RGBA8.
+		std::vector<std::pair<GLsizei, GLsizei>> dirtySlices; // Per level, the range of indirection z slices to upload.
+		std::unique_ptr<detail::StreamingCache> streaming;
+		BrickedVolumeStats stats;
+
+		GAL_NODISCARD GAL_INLINE glm::ivec3 brickCount(GLint level) const noexcept
+		{
+			return glm::max(gridSize >> level, glm::ivec3(1));
+		}
+
+		GAL_INLINE void decodeBrick(uint32_t brick, GLint& level, glm::ivec3& position) const noexcept
+		{
+			level = static_cast<GLint>(std::upper_bound(levelOffsets.begin(), levelOffsets.begin() + levelCount, brick)
+				- levelOffsets.begin()) - 1;
+
+			const glm::ivec3 count = brickCount(level);
+			const uint32_t local = brick - levelOffsets[level];
+			position.x = static_cast<GLint>(local % count.x);
+			position.y = static_cast<GLint>(local / count.x % count.y);
+			position.z = static_cast<GLint>(local / count.x / count.y);
+		}
+
+		GAL_NODISCARD GAL_INLINE uint32_t encodeBrick(GLint level, const glm::ivec3& position) const noexcept
+		{
+			const glm::ivec3 count = brickCount(level);
+			return levelOffsets[level] + (static_cast<uint32_t>(position.z) * count.y + position.y) * count.x + position.x;
+		}
+
+		GAL_NODISCARD GAL_INLINE bool isEmpty(uint32_t brick) const noexcept
+		{
+			return brickRanges[brick].y < params.visibleRange.x || brickRanges[brick].x > params.visibleRange.y;
+		}
+
+		/// @brief Fill in every brick's value range from the level 0 ones, and upload them as a mipmapped RG16F texture.
+		GAL_INLINE void buildRanges(const std::vector<glm::vec2>& levelZeroRanges)
+		{
+			// Bricks wholly in the padding are always empty. Half floats can't hold FLT_MAX.
+			const glm::vec2 emptyRange(60000.0f, -60000.0f);
+			brickRanges.assign(totalBricks, emptyRange);
+
+			const glm::ivec3 realBricks = (settings.volumeSize + settings.brickSize - 1) / settings.brickSize;
+			const bool hasRanges = levelZeroRanges.size() >= static_cast<size_t>(realBricks.x) * realBricks.y * realBricks.z;
+
+			glm::ivec3 position;
+			for (position.z = 0; position.z < realBricks.z; ++position.z)
+			{
+				for (position.y = 0; position.y < realBricks.y; ++position.y)
+				{
+					for (position.x = 0; position.x < realBricks.x; ++position.x)
+					{
+						const size_t source = (static_cast<size_t>(position.z) * realBricks.y + position.y) * realBricks.x + position.x;
+						brickRanges[encodeBrick(0, position)] = hasRanges ? levelZeroRanges[source] : glm::vec2(0.0f, 1.0f);
+					}
+				}
+			}
+
+			for (GLint level = 1; level < levelCount; ++level)
+			{
+				for (uint32_t brick = levelOffsets[level - 1]; brick < levelOffsets[level]; ++brick)
+				{
+					GLint childLevel;
+					decodeBrick(brick, childLevel, position);
+
+					glm::vec2& parent = brickRanges[encodeBrick(level, position / 2)];
+					parent.x = std::min(parent.x, brickRanges[brick].x);
+					parent.y = std::max(parent.y, brickRanges[brick].y);
+				}
+			}
+
+			ranges.storage(levelCount, GL_RG16F, gridSize.x, gridSize.y, gridSize.z);
+			ranges.setParameter(GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+			ranges.setParameter(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+			for (GLint level = 0; level < levelCount; ++level)
+			{
+				const glm::ivec3 count = brickCount(level);
+				ranges.subImage(level, GL_RG, GL_FLOAT, &brickRanges[levelOffsets[level]], count.x, count.y, count.z);
+			}
+		}
+
+		/// @brief Walk the brick hierarchy, refining the bricks that look coarsest on screen first, then mark the
+		/// chosen bricks as wanted and queue the missing ones.
+		GAL_INLINE void selectBricks(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection,
+			GLsizei viewportHeight)
+		{
+			glm::vec4 planes[6];
+			detail::extractFrustumPlanes(projection * view * model, planes);
+
+			const glm::vec3 camera = glm::vec3(glm::inverse(view)[3]);
+			const float pixelsPerRadian = projection[1][1] * static_cast<float>(viewportHeight) * 0.5f;
+			const glm::mat3 linear(model);
+
+			// Test and measure a brick. Frustum planes are in [0, 1] texture space, so the test uses the brick's box.
+			auto evaluate = [&](GLint level, const glm::ivec3& position, Candidate& candidate)
+			{
+				const uint32_t brick = encodeBrick(level, position);
+				if (isEmpty(brick))
+					return false;
+
+				const glm::vec3 brickUVW = glm::vec3(static_cast<float>(settings.brickSize << level)) / glm::vec3(settings.volumeSize);
+				const glm::vec3 low = glm::vec3(position) * brickUVW;
+				const glm::vec3 high = glm::min(low + brickUVW, glm::vec3(1.0f));
+				const glm::vec3 center = (low + high) * 0.5f;
+				const glm::vec3 half = (high - low) * 0.5f;
+
+				for (const glm::vec4& plane : planes)
+				{
+					const glm::vec3 normal(plane);
+					if (glm::dot(normal, center) + plane.w + glm::dot(glm::abs(normal), half) < 0.0f)
+						return false;
+				}
+
+				// Bounding sphere in world space, from the longest of the box's diagonals.
+				float radius = 0.0f;
+				for (const glm::vec3& sign : { glm::vec3(1, 1, 1), glm::vec3(-1, 1, 1), glm::vec3(1, -1, 1), glm::vec3(1, 1, -1) })
+					radius = std::max(radius, glm::length(linear * (half * sign)));
+
+				const glm::vec3 worldCenter = glm::vec3(model * glm::vec4(center, 1.0f));
+				const float distance = std::max(glm::length(worldCenter - camera) - radius, 1e-4f);
+				const float voxelSize = glm::length(linear * (brickUVW / static_cast<float>(settings.brickSize))) / std::sqrt(3.0f);
+
+				candidate = { brick, level, voxelSize / distance * pixelsPerRadian };
+				return true;
+			};
+
+			std::vector<Candidate> wanted;
+			std::priority_queue<Candidate> refinable;
+
+			// The top brick is always wanted, whatever the view, since everything falls back to it.
+			Candidate root;
+			if (!evaluate(levelCount - 1, glm::ivec3(0), root))
+				root = { totalBricks - 1, levelCount - 1, 0.0f };
+
+			wanted.push_back(root);
+			refinable.push(root);
+
+			while (!refinable.empty())
+			{
+				const Candidate parent = refinable.top();
+				refinable.pop();
+
+				if (parent.level == 0 || parent.voxelPixels <= settings.maxVoxelPixels)
+					continue;
+
+				glm::ivec3 parentPosition;
+				GLint parentLevel;
+				decodeBrick(parent.brick, parentLevel, parentPosition);
+
+				const glm::ivec3 count = brickCount(parent.level - 1);
+				Candidate children[8];
+				size_t childCount = 0;
+
+				for (int i = 0; i < 8; ++i)
+				{
+					const glm::ivec3 child = parentPosition * 2 + glm::ivec3(i & 1, (i >> 1) & 1, i >> 2);
+					if (glm::all(glm::lessThan(child, count)) && evaluate(parent.level - 1, child, children[childCount]))
+						childCount++;
+				}
+
+				// Leave the brick coarse if its children won't fit in the pool alongside everything already chosen.
+				if (wanted.size() + childCount > streaming->getSlotCount())
+					continue;
+
+				for (size_t i = 0; i < childCount; ++i)
+				{
+					wanted.push_back(children[i]);
+					refinable.push(children[i]);
+				}
+			}
+
+			stats.wantedLastUpdate = wanted.size();
+
+			std::vector<Candidate> missing;
+			for (const Candidate& candidate : wanted)
+			{
+				if (streaming->getSlot(candidate.brick) != 0)
+					streaming->markWanted(candidate.brick);
+				else
+					missing.push_back(candidate);
+			}
+
+			// Coarsest first, as finer bricks fall back to them, then the ones that look coarsest on screen.
+			std::sort(missing.begin(), missing.end(), [](const Candidate& a, const Candidate& b)
+				{ return a.level != b.level ? a.level > b.level : a.voxelPixels > b.voxelPixels; });
+
+			std::vector<uint32_t> missingBricks;
+			for (const Candidate& candidate : missing)
+				missingBricks.push_back(candidate.brick);
+
+			streaming->request(missingBricks);
+		}
+
+		/// @brief Copy a brick into a free or evicted slot and point the indirection texture at it.
+		/// @return Whether a slot could be found.
+		GAL_INLINE bool mapBrick(uint32_t brick, const unsigned char* voxels)
+		{
+			uint32_t slot, evicted;
+			if (!streaming->insert(brick, slot, evicted))
+				return false;
+
+			if (evicted != detail::StreamingCache::NoItem)
+				refreshIndirection(evicted);
+
+			const glm::ivec3 slotPosition = slotCoordinates(slot);
+
+			GLint unpackAlignment;
+			glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+			pool.subImage(0, settings.format, settings.type, voxels, slotSize, slotSize, slotSize,
+				slotPosition.x * slotSize, slotPosition.y * slotSize, slotPosition.z * slotSize);
+
+			glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+
+			refreshIndirection(brick);
+
+			return true;
+		}
+
+		GAL_NODISCARD GAL_INLINE glm::ivec3 slotCoordinates(uint32_t slot) const noexcept
+		{
+			const uint32_t perLayer = static_cast<uint32_t>(settings.poolBricks.x) * settings.poolBricks.y;
+			return glm::ivec3(slot % settings.poolBricks.x, slot % perLayer / settings.poolBricks.x, slot / perLayer);
+		}
+
+		/// @brief Recompute the indirection entries of a brick and every brick under it at finer levels, after it became
+		/// resident or was evicted. Non-resident entries copy their parent's, which is already up to date.
+		GAL_INLINE void refreshIndirection(uint32_t brick)
+		{
+			GLint brickLevel;
+			glm::ivec3 brickPosition;
+			decodeBrick(brick, brickLevel, brickPosition);
+
+			for (GLint level = brickLevel; level >= 0; --level)
+			{
+				const glm::ivec3 low = brickPosition * (1 << (brickLevel - level));
+				const glm::ivec3 high = glm::min(low + (1 << (brickLevel - level)), brickCount(level));
+
+				glm::ivec3 position;
+				for (position.z = low.z; position.z < high.z; ++position.z)
+				{
+					for (position.y = low.y; position.y < high.y; ++position.y)
+					{
+						for (position.x = low.x; position.x < high.x; ++position.x)
+						{
+							const uint32_t index = encodeBrick(level, position);
+
+							if (streaming->getSlot(index) != 0)
+							{
+								const glm::uvec3 slot(slotCoordinates(streaming->getSlot(index) - 1));
+								tableEntries[index] = slot.x | (slot.y << 8) | (slot.z << 16) | (static_cast<uint32_t>(level) << 24);
+							}
+							else
+							{
+								tableEntries[index] = tableEntries[encodeBrick(level + 1, position / 2)];
+							}
+						}
+					}
+				}
+
+				dirtySlices[level].first = std::min(dirtySlices[level].first, low.z);
+				dirtySlices[level].second = std::max(dirtySlices[level].second, high.z - 1);
+			}
+		}
+
+		/// @brief Upload the z slices of each indirection level changed since the last upload.
+		GAL_INLINE void uploadIndirection()
+		{
+			for (GLint level = 0; level < levelCount; ++level)
+			{
+				auto& [first, last] = dirtySlices[level];
+				if (first > last)
+					continue;
+
+				const glm::ivec3 count = brickCount(level);
+				indirection.subImage(level, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, &tableEntries[encodeBrick(level, glm::ivec3(0, 0, first))],
+					count.x, count.y, last - first + 1, 0, 0, first);
+
+				first = gridSize.z;
+				last = -1;
+			}
+		}
+	};
+}
+
+#endif
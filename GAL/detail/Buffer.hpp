@@ -71,6 +71,32 @@ namespace gal
 			glBindBuffer(type, bufferID);
 		}
 
+		/// @brief Bind this buffer to the given index of its own binding target.
+		/// Only valid for indexed targets (atomic counter, shader storage, transform feedback and uniform buffers).
+		GAL_INLINE void bindBase(GLuint index) const noexcept
+		{
+			glBindBufferBase(type, index, bufferID);
+		}
+
+		/// @brief Bind this buffer to the given index of an indexed binding target other than its own,
+		/// e.g. to write to a draw indirect buffer from a compute shader as shader storage.
+		GAL_INLINE void bindBase(BufferType target, GLuint index) const noexcept
+		{
+			glBindBufferBase(static_cast<GLenum>(target), index, bufferID);
+		}
+
+		/// @brief Bind a subsection of this buffer to the given index of its own binding target.
+		GAL_INLINE void bindRange(GLuint index, GLintptr offset, GLsizeiptr size) const noexcept
+		{
+			glBindBufferRange(type, index, bufferID, offset, size);
+		}
+
+		/// @brief Bind a subsection of this buffer to the given index of an indexed binding target other than its own.
+		GAL_INLINE void bindRange(BufferType target, GLuint index, GLintptr offset, GLsizeiptr size) const noexcept
+		{
+			glBindBufferRange(static_cast<GLenum>(target), index, bufferID, offset, size);
+		}
+
 		/// @brief Allocate given space in VRAM for this buffer immutably, meaning it cannot be reallocated.
 		GAL_INLINE void allocateImmutable(GLsizeiptr size, GLbitfield flags)
 		{
@@ -78,6 +104,7 @@ namespace gal
 
 			this->size = size;
 			this->flags = flags;
+			allocated = true;
 		}
 
 		/// @brief Allocate and write to given space in VRAM for this buffer immutably, meaning it cannot be reallocated.
@@ -87,6 +114,7 @@ namespace gal
 
 			this->size = size;
 			this->flags = flags;
+			allocated = true;
 		}
 
 		/// @brief Allocate given space in VRAM for this buffer with the given usage hint but don't fill it,
@@ -159,7 +187,58 @@ namespace gal
 			glNamedBufferSubData(bufferID, startIndex, endIndex - startIndex, data);
 		}
 
-		// TODO: Clearing and mapping functions.
+		/// @brief Read the entire contents of the buffer back into the given memory, which must be at least getSize() bytes.
+		/// Stalls until the GPU has finished writing to the buffer.
+		GAL_INLINE void readAll(void* data) const
+		{
+			throwIfUnallocated();
+			glGetNamedBufferSubData(bufferID, 0, size, data);
+		}
+
+		/// @brief Read a subsection of the buffer back into the given memory.
+		/// Stalls until the GPU has finished writing to the buffer.
+		GAL_INLINE void readSub(GLintptr offset, GLsizeiptr size, void* data) const
+		{
+			throwIfUnallocated();
+			glGetNamedBufferSubData(bufferID, offset, size, data);
+		}
+
+		/// @brief Copy a subsection of another buffer into this one without going through the CPU.
+		GAL_INLINE void copySub(const Buffer& source, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size) noexcept
+		{
+			glCopyNamedBufferSubData(source.bufferID, bufferID, readOffset, writeOffset, size);
+		}
+
+		/// @brief Map a subsection of the buffer into client memory with the given access flags (GL_MAP_WRITE_BIT etc.).
+		/// Returns nullptr on failure. With GL_MAP_PERSISTENT_BIT (which requires the buffer to have been allocated
+		/// immutably with the same bit) the pointer stays valid while the GPU uses the buffer.
+		GAL_NODISCARD GAL_INLINE void* mapRange(GLintptr offset, GLsizeiptr length, GLbitfield access)
+		{
+			throwIfUnallocated();
+			return glMapNamedBufferRange(bufferID, offset, length, access);
+		}
+
+		/// @brief Unmap the buffer after mapRange(). Returns false if the contents became corrupt while mapped.
+		GAL_INLINE bool unmap() noexcept
+		{
+			return glUnmapNamedBuffer(bufferID) == GL_TRUE;
+		}
+
+		/// @brief Fill the whole buffer with a single value. internalFormat describes how the value is stored in the buffer
+		/// (e.g. GL_R32UI), format and type how data is laid out. A null data pointer fills with zeros.
+		GAL_INLINE void clearAll(GLenum internalFormat, GLenum format, GLenum type, const void* data = nullptr)
+		{
+			throwIfUnallocated();
+			glClearNamedBufferData(bufferID, internalFormat, format, type, data);
+		}
+
+		/// @brief Fill a subsection of the buffer with a single value. See Buffer::clearAll.
+		GAL_INLINE void clearSub(GLintptr offset, GLsizeiptr size, GLenum internalFormat, GLenum format, GLenum type,
+			const void* data = nullptr)
+		{
+			throwIfUnallocated();
+			glClearNamedBufferSubData(bufferID, internalFormat, offset, size, format, type, data);
+		}
 
 		/// @brief Invalidate all contents of the buffer, leaving them undefined. 
 		GAL_INLINE void invalidateAll() noexcept
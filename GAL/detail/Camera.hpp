@@ -1,16 +1,17 @@
 #ifndef GAL_CAMERA_HPP
 #define GAL_CAMERA_HPP
 
+#include "Frustum.hpp"
 #include "Rotation.hpp"
 
 namespace gal
 {
-	/// @brief Camera struct.
+	/// @brief Camera struct. Holds a projection along with the position and rotation, and caches the view, projection
+	/// and view-projection matrices and the frustum until something they depend on changes.
+	/// Defaults to a 45 degree vertical field of view perspective projection with an aspect ratio of 1.
 	struct Camera
 	{
-		glm::vec3 position;
-		Rotation rotation;
-
+	public:
 		/// @brief Initialize with a position and default direction (towards -Z).
 		GAL_INLINE Camera(const glm::vec3& position)
 			: position(position), rotation() { }
@@ -22,45 +23,159 @@ namespace gal
 		/// @brief Initialize with a position and direction. Direction is automatically normalized.
 		GAL_INLINE Camera(const glm::vec3& position, const glm::vec3& direction)
 			: position(position), rotation(glm::vec3(0.0f, 0.0f, -1.0f), direction) { }
-		
-		/// @brief Move the camera in global space. 
-		GAL_INLINE void moveGlobal(const glm::vec3& delta) noexcept { position += delta; }
 
-		/// @brief Move the camera in local space. 
+		/// @brief Move the camera in global space.
+		GAL_INLINE void moveGlobal(const glm::vec3& delta) noexcept { position += delta; viewDirty = true; }
+
+		/// @brief Move the camera in local space.
 		GAL_INLINE void moveLocal(const glm::vec3& delta) noexcept
 		{
 			position += getRight() * delta.x;
 			position += getUp() * delta.y;
 			position += getForward() * delta.z;
+			viewDirty = true;
 		}
 
-		/// @brief Rotate the camera in global space. 
-		GAL_INLINE void rotateGlobal(const Rotation& delta) noexcept { rotation.rotateGlobal(delta); }
+		/// @brief Rotate the camera in global space.
+		GAL_INLINE void rotateGlobal(const Rotation& delta) noexcept { rotation.rotateGlobal(delta); viewDirty = true; }
+
+		/// @brief Rotate the camera in local space.
+		GAL_INLINE void rotateLocal(const Rotation& delta) noexcept { rotation.rotateLocal(delta); viewDirty = true; }
 
-		/// @brief Rotate the camera in local space. 
-		GAL_INLINE void rotateLocal(const Rotation& delta) noexcept { rotation.rotateLocal(delta); }
+		GAL_INLINE void setPosition(const glm::vec3& position) noexcept { this->position = position; viewDirty = true; }
+		GAL_INLINE void setRotation(const Rotation& rotation) noexcept { this->rotation = rotation; viewDirty = true; }
+
+		GAL_NODISCARD GAL_INLINE glm::vec3 getPosition() const noexcept { return position; }
+		GAL_NODISCARD GAL_INLINE Rotation getRotation() const noexcept { return rotation; }
 
 		GAL_NODISCARD GAL_INLINE glm::vec3 getForward() const noexcept { return rotation.rotate(glm::vec3(0.0f, 0.0f, -1.0f)); }
 		GAL_NODISCARD GAL_INLINE glm::vec3 getRight() const noexcept { return rotation.rotate(glm::vec3(1.0f, 0.0f, 0.0f)); }
 		GAL_NODISCARD GAL_INLINE glm::vec3 getUp() const noexcept { return rotation.rotate(glm::vec3(0.0f, 1.0f, 0.0f)); }
 
-		/// @brief Make the camera look at a target point in world space, with the given up vector. 
+		/// @brief Make the camera look at a target point in world space, with the given up vector.
 		GAL_INLINE void lookAt(const glm::vec3& target, const glm::vec3& up) noexcept
 		{
 			rotation = glm::quatLookAt(glm::normalize(target - position), up);
+			viewDirty = true;
 		}
 
-		/// @brief  Make the camera look at a target point in world space, with the camera's current up vector. 
+		/// @brief  Make the camera look at a target point in world space, with the camera's current up vector.
 		GAL_INLINE void lookAt(const glm::vec3& target) { lookAt(target, getUp()); }
 
+		/// @brief Use a perspective projection. fovY is the vertical field of view in radians.
+		GAL_INLINE void setPerspective(float fovY, float aspectRatio, float nearPlane, float farPlane) noexcept
+		{
+			orthographic = false;
+			this->fovY = fovY;
+			this->aspectRatio = aspectRatio;
+			this->nearPlane = nearPlane;
+			this->farPlane = farPlane;
+			projectionDirty = true;
+		}
+
+		/// @brief Use an orthographic projection of the given view volume, in view space.
+		GAL_INLINE void setOrthographic(float left, float right, float bottom, float top, float nearPlane, float farPlane) noexcept
+		{
+			orthographic = true;
+			orthoLeft = left;
+			orthoRight = right;
+			orthoBottom = bottom;
+			orthoTop = top;
+			this->nearPlane = nearPlane;
+			this->farPlane = farPlane;
+			projectionDirty = true;
+		}
+
+		/// @brief Change the aspect ratio of a perspective projection, e.g. when the window is resized.
+		GAL_INLINE void setAspectRatio(float aspectRatio) noexcept
+		{
+			this->aspectRatio = aspectRatio;
+			projectionDirty = projectionDirty || !orthographic;
+		}
+
+		GAL_NODISCARD GAL_INLINE bool isOrthographic() const noexcept { return orthographic; }
+		GAL_NODISCARD GAL_INLINE float getFovY() const noexcept { return fovY; }
+		GAL_NODISCARD GAL_INLINE float getAspectRatio() const noexcept { return aspectRatio; }
+		GAL_NODISCARD GAL_INLINE float getNearPlane() const noexcept { return nearPlane; }
+		GAL_NODISCARD GAL_INLINE float getFarPlane() const noexcept { return farPlane; }
+
 		/// @brief Get the view matrix for this camera.
-		GAL_NODISCARD GAL_INLINE glm::mat4 getViewMatrix() const noexcept
+		GAL_NODISCARD GAL_INLINE const glm::mat4& getViewMatrix() const noexcept
+		{
+			if (viewDirty)
+			{
+				// The inverse of the camera's transform: the transposed rotation, then the position rotated back.
+				const Rotation inverse = rotation.inverse();
+				viewMatrix = inverse.asMat4();
+				viewMatrix[3] = glm::vec4(inverse.rotate(-position), 1.0f);
+
+				viewDirty = false;
+				viewProjectionDirty = true;
+			}
+
+			return viewMatrix;
+		}
+
+		GAL_NODISCARD GAL_INLINE const glm::mat4& getProjectionMatrix() const noexcept
 		{
-			const glm::mat4 rotationMatrix = rotation.inverse().asMat4();
-			const glm::mat4 translationMatrix = glm::translate(glm::mat4(1.0f), -position);
+			if (projectionDirty)
+			{
+				projectionMatrix = orthographic
+					? glm::ortho(orthoLeft, orthoRight, orthoBottom, orthoTop, nearPlane, farPlane)
+					: glm::perspective(fovY, aspectRatio, nearPlane, farPlane);
+
+				projectionDirty = false;
+				viewProjectionDirty = true;
+			}
+
+			return projectionMatrix;
+		}
+
+		/// @brief Get projection * view.
+		GAL_NODISCARD GAL_INLINE const glm::mat4& getViewProjectionMatrix() const noexcept
+		{
+			const glm::mat4& view = getViewMatrix();
+			const glm::mat4& projection = getProjectionMatrix();
+
+			if (viewProjectionDirty)
+			{
+				viewProjectionMatrix = projection * view;
+				frustum = Frustum(viewProjectionMatrix);
+				viewProjectionDirty = false;
+			}
 
-			return rotationMatrix * translationMatrix;
+			return viewProjectionMatrix;
 		}
+
+		/// @brief Get the camera's view frustum in world space, e.g. to cull bounding volumes before drawing.
+		GAL_NODISCARD GAL_INLINE const Frustum& getFrustum() const noexcept
+		{
+			(void)getViewProjectionMatrix();
+			return frustum;
+		}
+
+	private:
+		glm::vec3 position;
+		Rotation rotation;
+
+		bool orthographic = false;
+		float fovY = glm::radians(45.0f);
+		float aspectRatio = 1.0f;
+		float orthoLeft = -1.0f;
+		float orthoRight = 1.0f;
+		float orthoBottom = -1.0f;
+		float orthoTop = 1.0f;
+		float nearPlane = 0.1f;
+		float farPlane = 100.0f;
+
+		mutable glm::mat4 viewMatrix = glm::mat4(1.0f);
+		mutable glm::mat4 projectionMatrix = glm::mat4(1.0f);
+		mutable glm::mat4 viewProjectionMatrix = glm::mat4(1.0f);
+		mutable Frustum frustum;
+
+		mutable bool viewDirty = true;
+		mutable bool projectionDirty = true;
+		mutable bool viewProjectionDirty = true;
 	};
 }
 
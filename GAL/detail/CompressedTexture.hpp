@@ -0,0 +1,324 @@
+#ifndef GAL_COMPRESSED_TEXTURE_HPP
+#define GAL_COMPRESSED_TEXTURE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "attributes.hpp"
+#include "BCnEncoder.hpp"
+#include "enums.hpp"
+#include "GALException.hpp"
+#include "MappedFile.hpp"
+#include "MipGenerator.hpp"
+#include "Texture.hpp"
+
+namespace gal
+{
+	namespace detail
+	{
+		/// @brief How one compressed format is identified by OpenGL, KTX2 (by VkFormat) and DDS (by DXGI_FORMAT).
+		struct CompressedFormatInfo
+		{
+			BCFormat format;
+			bool srgb;
+			GLenum internalFormat;
+			uint32_t vkFormat;
+			uint32_t dxgiFormat;
+		};
+
+		GAL_INLINE const CompressedFormatInfo compressedFormats[] = {
+			{ BCFormat::BC1, false, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, 131, 71 },
+			{ BCFormat::BC1, true, GL_COMPRESSED_SRGB_S3TC_DXT1_EXT, 132, 72 },
+			{ BCFormat::BC3, false, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 137, 77 },
+			{ BCFormat::BC3, true, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, 138, 78 },
+			{ BCFormat::BC4, false, GL_COMPRESSED_RED_RGTC1, 139, 80 },
+			{ BCFormat::BC5, false, GL_COMPRESSED_RG_RGTC2, 141, 83 },
+			{ BCFormat::BC7, false, GL_COMPRESSED_RGBA_BPTC_UNORM, 145, 98 },
+			{ BCFormat::BC7, true, GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM, 146, 99 },
+		};
+
+		template<typename Predicate>
+		GAL_NODISCARD GAL_INLINE const CompressedFormatInfo* findCompressedFormat(Predicate predicate) noexcept
+		{
+			for (const CompressedFormatInfo& info : compressedFormats)
+			{
+				if (predicate(info))
+					return &info;
+			}
+
+			return nullptr;
+		}
+
+		GAL_INLINE const unsigned char ktx2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+		template<typename T>
+		GAL_NODISCARD GAL_INLINE T readLittleEndian(const unsigned char* data) noexcept
+		{
+			T value;
+			std::memcpy(&value, data, sizeof(T));
+			return value;
+		}
+
+		template<typename T>
+		GAL_INLINE void appendLittleEndian(std::vector<unsigned char>& out, T value)
+		{
+			const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+			out.insert(out.end(), bytes, bytes + sizeof(T));
+		}
+
+		/// @brief Build the KTX2 basic data format descriptor for a block compressed format.
+		GAL_NODISCARD GAL_INLINE std::vector<uint32_t> buildKTX2Descriptor(BCFormat format, bool srgb)
+		{
+			struct Sample
+			{
+				uint32_t channel;
+				uint32_t bitOffset;
+				uint32_t bitLength;
+			};
+
+			uint32_t colorModel = 0;
+			std::vector<Sample> samples;
+
+			switch (format)
+			{
+				case BCFormat::BC1: colorModel = 128; samples = { { 0, 0, 64 } }; break;
+				case BCFormat::BC3: colorModel = 130; samples = { { 15, 0, 64 }, { 0, 64, 64 } }; break;
+				case BCFormat::BC4: colorModel = 131; samples = { { 0, 0, 64 } }; break;
+				case BCFormat::BC5: colorModel = 132; samples = { { 0, 0, 64 }, { 1, 64, 64 } }; break;
+				case BCFormat::BC7: colorModel = 134; samples = { { 0, 0, 128 } }; break;
+			}
+
+			const uint32_t blockSize = 24 + 16 * static_cast<uint32_t>(samples.size());
+			const uint32_t transfer = srgb ? 2 : 1;
+
+			std::vector<uint32_t> words = {
+				4 + blockSize, // Total size, including this word.
+				0, // Khronos vendor, basic descriptor type.
+				2 | blockSize << 16, // Version, block size.
+				colorModel | 1 << 8 | transfer << 16, // BT.709 primaries, straight alpha.
+				3 | 3 << 8, // 4x4x1x1 texel blocks, stored minus one.
+				static_cast<uint32_t>(bcBlockSize(format)), // Bytes in plane 0.
+				0
+			};
+
+			for (const Sample& sample : samples)
+			{
+				words.push_back(sample.bitOffset | (sample.bitLength - 1) << 16 | sample.channel << 24);
+				words.push_back(0); // Sample position.
+				words.push_back(0); // Lower.
+				words.push_back(0xFFFFFFFFu); // Upper.
+			}
+
+			return words;
+		}
+	}
+
+	/// @brief Compress an image into a KTX2 file with a full mip chain. Use for offline texture cooking.
+	/// Mip levels are generated from the uncompressed image with generateMipLevels(), so nothing needs generating at load time.
+	/// @param srgb: Mark the texture as sRGB encoded. Ignored for BC4 and BC5, which have no sRGB variant.
+	/// @param threadCount: Number of threads to encode each level with. 0 uses every hardware thread.
+	GAL_INLINE void cookKTX2(const std::string& path, const DecodedImage& image, BCFormat format, bool srgb = true,
+		bool mipmaps = true, unsigned threadCount = 0)
+	{
+		srgb = srgb && format != BCFormat::BC4 && format != BCFormat::BC5;
+		const detail::CompressedFormatInfo* info = detail::findCompressedFormat(
+			[&](const detail::CompressedFormatInfo& info) { return info.format == format && info.srgb == srgb; });
+
+		std::vector<std::vector<unsigned char>> levels;
+		levels.push_back(compressBCn(format, image.pixels.data(), image.width, image.height, threadCount));
+
+		if (mipmaps)
+		{
+			// BC4 and BC5 usually hold data rather than color, so their channels are filtered independently.
+			MipSettings settings;
+			settings.srgb = srgb;
+			settings.alphaMode = format == BCFormat::BC4 || format == BCFormat::BC5 ? MipAlphaMode::Independent : MipAlphaMode::Straight;
+			settings.threadCount = threadCount;
+
+			for (const DecodedImage& level : generateMipLevels(image, settings))
+				levels.push_back(compressBCn(format, level.pixels.data(), level.width, level.height, threadCount));
+		}
+
+		const std::vector<uint32_t> descriptor = detail::buildKTX2Descriptor(format, srgb);
+		const uint32_t levelCount = static_cast<uint32_t>(levels.size());
+		const uint32_t descriptorOffset = 80 + 24 * levelCount;
+		const uint32_t descriptorSize = static_cast<uint32_t>(descriptor.size() * sizeof(uint32_t));
+		const size_t alignment = bcBlockSize(format);
+
+		// Level data is stored smallest first, each level aligned to the block size.
+		std::vector<uint64_t> levelOffsets(levels.size());
+		uint64_t offset = descriptorOffset + descriptorSize;
+		for (size_t i = levels.size(); i-- > 0;)
+		{
+			offset = (offset + alignment - 1) / alignment * alignment;
+			levelOffsets[i] = offset;
+			offset += levels[i].size();
+		}
+
+		std::vector<unsigned char> header(detail::ktx2Identifier, detail::ktx2Identifier + 12);
+		detail::appendLittleEndian<uint32_t>(header, info->vkFormat);
+		detail::appendLittleEndian<uint32_t>(header, 1); // Type size.
+		detail::appendLittleEndian<uint32_t>(header, static_cast<uint32_t>(image.width));
+		detail::appendLittleEndian<uint32_t>(header, static_cast<uint32_t>(image.height));
+		detail::appendLittleEndian<uint32_t>(header, 0); // Depth.
+		detail::appendLittleEndian<uint32_t>(header, 0); // Layers.
+		detail::appendLittleEndian<uint32_t>(header, 1); // Faces.
+		detail::appendLittleEndian<uint32_t>(header, levelCount);
+		detail::appendLittleEndian<uint32_t>(header, 0); // No supercompression.
+
+		detail::appendLittleEndian<uint32_t>(header, descriptorOffset);
+		detail::appendLittleEndian<uint32_t>(header, descriptorSize);
+		detail::appendLittleEndian<uint32_t>(header, 0); // No key/value data.
+		detail::appendLittleEndian<uint32_t>(header, 0);
+		detail::appendLittleEndian<uint64_t>(header, 0); // No supercompression global data.
+		detail::appendLittleEndian<uint64_t>(header, 0);
+
+		for (size_t i = 0; i < levels.size(); ++i)
+		{
+			detail::appendLittleEndian<uint64_t>(header, levelOffsets[i]);
+			detail::appendLittleEndian<uint64_t>(header, levels[i].size());
+			detail::appendLittleEndian<uint64_t>(header, levels[i].size());
+		}
+
+		for (uint32_t word : descriptor)
+			detail::appendLittleEndian<uint32_t>(header, word);
+
+		std::ofstream file(path, std::ios::binary);
+		if (!file)
+			detail::throwErr(ErrCode::TextureFileWriteFailed, "Could not open KTX2 file for writing.");
+
+		file.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+
+		size_t written = header.size();
+		for (size_t i = levels.size(); i-- > 0;)
+		{
+			static const char zeros[16] = {};
+			file.write(zeros, static_cast<std::streamsize>(levelOffsets[i] - written));
+			file.write(reinterpret_cast<const char*>(levels[i].data()), static_cast<std::streamsize>(levels[i].size()));
+			written = static_cast<size_t>(levelOffsets[i]) + levels[i].size();
+		}
+
+		if (!file)
+			detail::throwErr(ErrCode::TextureFileWriteFailed, "Failed writing KTX2 file.");
+	}
+
+	/// @brief Load a block compressed texture from a KTX2 or DDS file as a TextureType::TwoD texture.
+	/// The file is memory mapped and each level is handed straight to glCompressedTextureSubImage2D, so nothing is
+	/// decoded or copied on the CPU. Supports BC1, BC3, BC4, BC5 and BC7, with or without sRGB where the format has it.
+	/// @param skipLevels: Number of the most detailed levels to leave out, e.g. to load at reduced resolution.
+	/// At least one level is always loaded.
+	/// @return The texture, on the heap so that its GL object survives being passed around.
+	GAL_NODISCARD GAL_INLINE std::unique_ptr<Texture> loadCompressedTexture(const std::string& path, GLint skipLevels = 0)
+	{
+		const detail::MappedFile file(path);
+		const unsigned char* data = file.getData();
+		const size_t size = file.getSize();
+
+		const detail::CompressedFormatInfo* info = nullptr;
+		GLsizei width = 0, height = 0;
+		std::vector<std::pair<uint64_t, uint64_t>> levels; // Offset and size of each level, level 0 first.
+
+		if (size >= 80 && std::memcmp(data, detail::ktx2Identifier, 12) == 0)
+		{
+			const uint32_t vkFormat = detail::readLittleEndian<uint32_t>(data + 12);
+			width = static_cast<GLsizei>(detail::readLittleEndian<uint32_t>(data + 20));
+			height = static_cast<GLsizei>(detail::readLittleEndian<uint32_t>(data + 24));
+			const uint32_t depth = detail::readLittleEndian<uint32_t>(data + 28);
+			const uint32_t layers = detail::readLittleEndian<uint32_t>(data + 32);
+			const uint32_t faces = detail::readLittleEndian<uint32_t>(data + 36);
+			const uint32_t levelCount = std::max(detail::readLittleEndian<uint32_t>(data + 40), 1u);
+			const uint32_t supercompression = detail::readLittleEndian<uint32_t>(data + 44);
+
+			if (depth > 1 || layers > 1 || faces != 1 || supercompression != 0 || size < 80 + 24 * static_cast<size_t>(levelCount))
+				detail::throwErr(ErrCode::UnsupportedTextureFile, "Only uncompressed, single 2D image KTX2 files are supported.");
+
+			info = detail::findCompressedFormat([&](const detail::CompressedFormatInfo& info) { return info.vkFormat == vkFormat; });
+
+			for (uint32_t i = 0; i < levelCount; ++i)
+			{
+				const unsigned char* entry = data + 80 + 24 * static_cast<size_t>(i);
+				levels.emplace_back(detail::readLittleEndian<uint64_t>(entry), detail::readLittleEndian<uint64_t>(entry + 8));
+			}
+		}
+		else if (size >= 128 && std::memcmp(data, "DDS ", 4) == 0)
+		{
+			height = static_cast<GLsizei>(detail::readLittleEndian<uint32_t>(data + 12));
+			width = static_cast<GLsizei>(detail::readLittleEndian<uint32_t>(data + 16));
+			const uint32_t levelCount = std::max(detail::readLittleEndian<uint32_t>(data + 28), 1u);
+			const unsigned char* fourCC = data + 84;
+
+			uint64_t offset = 128;
+			if (std::memcmp(fourCC, "DX10", 4) == 0 && size >= 148)
+			{
+				const uint32_t dxgiFormat = detail::readLittleEndian<uint32_t>(data + 128);
+				info = detail::findCompressedFormat([&](const detail::CompressedFormatInfo& info) { return info.dxgiFormat == dxgiFormat; });
+				offset = 148;
+			}
+			else
+			{
+				BCFormat format;
+				bool known = true;
+
+				if (std::memcmp(fourCC, "DXT1", 4) == 0)
+					format = BCFormat::BC1;
+				else if (std::memcmp(fourCC, "DXT5", 4) == 0)
+					format = BCFormat::BC3;
+				else if (std::memcmp(fourCC, "ATI1", 4) == 0 || std::memcmp(fourCC, "BC4U", 4) == 0)
+					format = BCFormat::BC4;
+				else if (std::memcmp(fourCC, "ATI2", 4) == 0 || std::memcmp(fourCC, "BC5U", 4) == 0)
+					format = BCFormat::BC5;
+				else
+					known = false;
+
+				if (known)
+					info = detail::findCompressedFormat([&](const detail::CompressedFormatInfo& info) { return info.format == format && !info.srgb; });
+			}
+
+			// DDS stores levels back to back, largest first.
+			for (uint32_t i = 0; i < levelCount && info != nullptr; ++i)
+			{
+				const uint64_t levelSize = bcImageSize(info->format, std::max(width >> i, 1), std::max(height >> i, 1));
+				levels.emplace_back(offset, levelSize);
+				offset += levelSize;
+			}
+		}
+		else
+		{
+			detail::throwErr(ErrCode::UnsupportedTextureFile, "Texture file is neither KTX2 nor DDS.");
+		}
+
+		if (info == nullptr)
+			detail::throwErr(ErrCode::UnsupportedTextureFile, "Texture file uses a format GAL can't load.");
+
+		for (const auto& [offset, levelSize] : levels)
+		{
+			if (offset + levelSize > size)
+				detail::throwErr(ErrCode::UnsupportedTextureFile, "Texture file is truncated.");
+		}
+
+		skipLevels = std::clamp(skipLevels, 0, static_cast<GLint>(levels.size()) - 1);
+		const GLint levelCount = static_cast<GLint>(levels.size()) - skipLevels;
+
+		auto texture = std::make_unique<Texture>(TextureType::TwoD);
+		texture->storage(levelCount, info->internalFormat, std::max(width >> skipLevels, 1), std::max(height >> skipLevels, 1));
+
+		for (GLint level = 0; level < levelCount; ++level)
+		{
+			const auto& [offset, levelSize] = levels[level + skipLevels];
+			texture->compressedSubImage(level, info->internalFormat, data + offset, static_cast<GLsizei>(levelSize),
+				std::max(width >> (level + skipLevels), 1), std::max(height >> (level + skipLevels), 1));
+		}
+
+		texture->setParameter(GL_TEXTURE_MIN_FILTER, levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		texture->setParameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		return texture;
+	}
+}
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef GAL_COMPUTE_PROGRAM_HPP
+#define GAL_COMPUTE_PROGRAM_HPP
+
+#include <string>
+#include <utility>
+
+#include "attributes.hpp"
+#include "barrier.hpp"
+#include "Buffer.hpp"
+#include "enums.hpp"
+#include "GALException.hpp"
+#include "ShaderProgram.hpp"
+
+namespace gal
+{
+	/// @brief GAL compute program class. Wraps a ShaderProgram holding a single compute shader.
+	/// Add the compute shader, link, then dispatch. The work group size declared in the shader (local_size_x etc.)
+	/// is queried on linking, so dispatchFor() can work out how many groups are needed to cover some number of elements.
+	class ComputeProgram
+	{
+	public:
+		GAL_INLINE ComputeProgram() = default;
+
+		// Forbid copying.
+		GAL_INLINE ComputeProgram(const ComputeProgram&) = delete;
+		GAL_INLINE ComputeProgram& operator=(const ComputeProgram&) = delete;
+
+		// Allow moving.
+		GAL_INLINE ComputeProgram(ComputeProgram&&) noexcept = default;
+		GAL_INLINE ComputeProgram& operator=(ComputeProgram&&) noexcept = default;
+
+		/// @brief Add the compute shader to the program, reading the source code from the given filepath.
+		GAL_INLINE ComputeProgram& addShaderFromFile(const std::string& path)
+		{
+			program.addShaderFromFile(path, ShaderType::Compute);
+			return *this;
+		}
+
+		/// @brief Add the compute shader to the program from the given source code string.
+		GAL_INLINE ComputeProgram& addShaderFromSource(const std::string& source)
+		{
+			program.addShaderFromSource(source, ShaderType::Compute);
+			return *this;
+		}
+
+		/// @brief Link the program and query its work group size.
+		GAL_INLINE void link()
+		{
+			program.link();
+
+			GLint size[3];
+			glGetProgramiv(program.getID(), GL_COMPUTE_WORK_GROUP_SIZE, size);
+			workGroupSize = glm::uvec3(size[0], size[1], size[2]);
+		}
+
+		GAL_NODISCARD GAL_INLINE type::GALShaderProgramID getID() const noexcept { return program.getID(); }
+
+		/// @brief Get the underlying shader program, e.g. to pass it to functions taking a ShaderProgram.
+		GAL_NODISCARD GAL_INLINE const ShaderProgram& getProgram() const noexcept { return program; }
+
+		GAL_NODISCARD GAL_INLINE bool isLinked() const noexcept { return program.isLinked(); }
+
+		/// @brief Get the work group size declared in the shader. Zero in all dimensions until linked.
+		GAL_NODISCARD GAL_INLINE glm::uvec3 getWorkGroupSize() const noexcept { return workGroupSize; }
+
+		/// @brief Use the program so that subsequent dispatches will use it.
+		GAL_INLINE void use() const { program.use(); }
+
+		/// @brief Set a uniform in the program. Takes the same arguments as ShaderProgram::setUniform().
+		template<typename... Args>
+		GAL_INLINE const ComputeProgram& setUniform(const std::string& name, Args&&... args) const
+		{
+			program.setUniform(name, std::forward<Args>(args)...);
+			return *this;
+		}
+
+		/// @brief Use this program and dispatch the given number of work groups.
+		GAL_INLINE void dispatchAB(GLuint groupsX, GLuint groupsY = 1, GLuint groupsZ = 1) const
+		{
+			use();
+			dispatchNB(groupsX, groupsY, groupsZ);
+		}
+
+		/// @brief Dispatch the given number of work groups. Assumes this program is in use.
+		GAL_INLINE void dispatchNB(GLuint groupsX, GLuint groupsY = 1, GLuint groupsZ = 1) const
+		{
+			throwIfUnlinked();
+			glDispatchCompute(groupsX, groupsY, groupsZ);
+		}
+
+		/// @brief Use this program and dispatch enough work groups to cover the given number of invocations
+		/// in each dimension, rounding up to whole groups. Shaders should bounds check against the element count.
+		GAL_INLINE void dispatchForAB(GLuint elementsX, GLuint elementsY = 1, GLuint elementsZ = 1) const
+		{
+			use();
+			dispatchForNB(elementsX, elementsY, elementsZ);
+		}
+
+		/// @brief Dispatch enough work groups to cover the given number of invocations in each dimension,
+		/// rounding up to whole groups. Assumes this program is in use.
+		GAL_INLINE void dispatchForNB(GLuint elementsX, GLuint elementsY = 1, GLuint elementsZ = 1) const
+		{
+			throwIfUnlinked();
+			glDispatchCompute(groupCount(elementsX, workGroupSize.x), groupCount(elementsY, workGroupSize.y),
+				groupCount(elementsZ, workGroupSize.z));
+		}
+
+		/// @brief Use this program and dispatch with group counts read from the buffer at the given offset,
+		/// laid out as three GLuints (num_groups_x, num_groups_y, num_groups_z).
+		/// Binds the buffer to GL_DISPATCH_INDIRECT_BUFFER regardless of its own buffer type.
+		GAL_INLINE void dispatchIndirectAB(const Buffer& buffer, GLintptr offset = 0) const
+		{
+			use();
+			dispatchIndirectNB(buffer, offset);
+		}
+
+		/// @brief Dispatch with group counts read from the buffer at the given offset. Assumes this program is in use.
+		/// Binds the buffer to GL_DISPATCH_INDIRECT_BUFFER regardless of its own buffer type.
+		GAL_INLINE void dispatchIndirectNB(const Buffer& buffer, GLintptr offset = 0) const
+		{
+			throwIfUnlinked();
+			glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, buffer.getID());
+			glDispatchComputeIndirect(offset);
+		}
+
+	private:
+		ShaderProgram program;
+		glm::uvec3 workGroupSize = glm::uvec3(0);
+
+		GAL_STATIC GAL_INLINE GLuint groupCount(GLuint elements, GLuint groupSize) noexcept
+		{
+			return (elements + groupSize - 1) / groupSize;
+		}
+
+		GAL_INLINE void throwIfUnlinked() const
+		{
+			if (!program.isLinked())
+				detail::throwErr(ErrCode::ComputeDispatchBeforeLinking, "Attempted to dispatch a compute program before linking it.");
+		}
+	};
+}
+
+#endif
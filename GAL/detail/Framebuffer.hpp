@@ -0,0 +1,234 @@
+#ifndef GAL_FRAMEBUFFER_HPP
+#define GAL_FRAMEBUFFER_HPP
+
+#include <algorithm>
+#include <vector>
+
+#include "attributes.hpp"
+#include "ResourceTracker.hpp"
+#include "Texture.hpp"
+#include "types.hpp"
+
+namespace gal
+{
+	namespace detail
+	{
+		GAL_INLINE void deleteFramebuffer(type::GALFramebufferID id)
+		{
+			glDeleteFramebuffers(1, &id);
+		}
+
+		GAL_INLINE ResourceTracker<type::GALFramebufferID, deleteFramebuffer> framebufferTracker;
+
+		/// @brief The attachment point a texture of the given internal format belongs at if it isn't a color format,
+		/// e.g. GL_DEPTH_STENCIL_ATTACHMENT for GL_DEPTH24_STENCIL8. Returns GL_NONE for color formats.
+		GAL_NODISCARD GAL_INLINE GLenum nonColorAttachmentPoint(GLenum internalFormat) noexcept
+		{
+			switch (internalFormat)
+			{
+				case GL_DEPTH_COMPONENT: case GL_DEPTH_COMPONENT16: case GL_DEPTH_COMPONENT24: case GL_DEPTH_COMPONENT32:
+				case GL_DEPTH_COMPONENT32F:
+					return GL_DEPTH_ATTACHMENT;
+
+				case GL_DEPTH_STENCIL: case GL_DEPTH24_STENCIL8: case GL_DEPTH32F_STENCIL8:
+					return GL_DEPTH_STENCIL_ATTACHMENT;
+
+				case GL_STENCIL_INDEX: case GL_STENCIL_INDEX8:
+					return GL_STENCIL_ATTACHMENT;
+
+				default:
+					return GL_NONE;
+			}
+		}
+	}
+
+	/// @brief A framebuffer object rendering into textures, created and modified with direct state access.
+	class Framebuffer
+	{
+	public:
+		GAL_INLINE Framebuffer()
+		{
+			glCreateFramebuffers(1, &framebufferID);
+			detail::framebufferTracker.add(framebufferID);
+		}
+
+		// Forbid copying.
+		GAL_INLINE Framebuffer(const Framebuffer&) = delete;
+		GAL_INLINE Framebuffer& operator=(const Framebuffer&) = delete;
+
+		// Allow moving.
+		GAL_INLINE Framebuffer(Framebuffer&&) noexcept = default;
+		GAL_INLINE Framebuffer& operator=(Framebuffer&&) noexcept = default;
+
+		GAL_INLINE ~Framebuffer()
+		{
+			detail::framebufferTracker.remove(framebufferID);
+		}
+
+		GAL_NODISCARD GAL_INLINE type::GALFramebufferID getID() const noexcept { return framebufferID; }
+
+		/// @brief Bind this framebuffer for both drawing and reading.
+		GAL_INLINE void bind() const noexcept
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, framebufferID);
+		}
+
+		GAL_INLINE void bindDraw() const noexcept
+		{
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebufferID);
+		}
+
+		GAL_INLINE void bindRead() const noexcept
+		{
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, framebufferID);
+		}
+
+		/// @brief Bind the default framebuffer (the window's) for both drawing and reading.
+		GAL_STATIC GAL_INLINE void bindDefault() noexcept
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		}
+
+		/// @brief Attach a mipmap level of a texture to the given attachment point (GL_COLOR_ATTACHMENT0 etc.). Array,
+		/// cube map and 3D textures are attached whole for layered rendering; see attachTextureLayer() for one layer.
+		GAL_INLINE void attachTexture(GLenum attachment, const Texture& texture, GLint level = 0)
+		{
+			glNamedFramebufferTexture(framebufferID, attachment, texture.getID(), level);
+			addAttachment(attachment);
+		}
+
+		/// @brief Attach a single layer of an array, cube map or 3D texture.
+		GAL_INLINE void attachTextureLayer(GLenum attachment, const Texture& texture, GLint layer, GLint level = 0)
+		{
+			glNamedFramebufferTextureLayer(framebufferID, attachment, texture.getID(), level, layer);
+			addAttachment(attachment);
+		}
+
+		/// @brief Attach a texture to GL_COLOR_ATTACHMENT0 + index.
+		GAL_INLINE void attachColor(GLuint index, const Texture& texture, GLint level = 0)
+		{
+			attachTexture(GL_COLOR_ATTACHMENT0 + index, texture, level);
+		}
+
+		/// @brief Attach a depth, depth-stencil or stencil texture at the attachment point matching its internal format.
+		GAL_INLINE void attachDepth(const Texture& texture, GLint level = 0)
+		{
+			const GLenum attachment = detail::nonColorAttachmentPoint(texture.getInternalFormat());
+			attachTexture(attachment == GL_NONE ? GL_DEPTH_ATTACHMENT : attachment, texture, level);
+		}
+
+		/// @brief Remove whatever is attached at the given attachment point.
+		GAL_INLINE void detach(GLenum attachment)
+		{
+			glNamedFramebufferTexture(framebufferID, attachment, 0, 0);
+			attachments.erase(std::remove(attachments.begin(), attachments.end(), attachment), attachments.end());
+		}
+
+		/// @brief Attachment points with something attached.
+		GAL_NODISCARD GAL_INLINE const std::vector<GLenum>& getAttachments() const noexcept { return attachments; }
+
+		/// @brief Set which color attachments fragment shader outputs 0, 1, ... are written to. GL_NONE discards an output.
+		GAL_INLINE void setDrawBuffers(const std::vector<GLenum>& buffers) noexcept
+		{
+			glNamedFramebufferDrawBuffers(framebufferID, static_cast<GLsizei>(buffers.size()), buffers.data());
+		}
+
+		/// @brief Set a single draw buffer, e.g. GL_NONE for a depth-only framebuffer.
+		GAL_INLINE void setDrawBuffer(GLenum buffer) noexcept
+		{
+			glNamedFramebufferDrawBuffer(framebufferID, buffer);
+		}
+
+		GAL_INLINE void setReadBuffer(GLenum buffer) noexcept
+		{
+			glNamedFramebufferReadBuffer(framebufferID, buffer);
+		}
+
+		/// @brief Get the completeness status of the framebuffer, e.g. GL_FRAMEBUFFER_COMPLETE.
+		GAL_NODISCARD GAL_INLINE GLenum getStatus() const noexcept
+		{
+			return glCheckNamedFramebufferStatus(framebufferID, GL_FRAMEBUFFER);
+		}
+
+		GAL_NODISCARD GAL_INLINE bool isComplete() const noexcept
+		{
+			return getStatus() == GL_FRAMEBUFFER_COMPLETE;
+		}
+
+		/// @brief Clear a color draw buffer (an index into the buffers given to setDrawBuffers()) to a value.
+		GAL_INLINE void clearColor(GLint drawBuffer, const glm::vec4& color) noexcept
+		{
+			glClearNamedFramebufferfv(framebufferID, GL_COLOR, drawBuffer, &color.x);
+		}
+
+		/// @brief Clear an unsigned integer color draw buffer to a value.
+		GAL_INLINE void clearColor(GLint drawBuffer, const glm::uvec4& color) noexcept
+		{
+			glClearNamedFramebufferuiv(framebufferID, GL_COLOR, drawBuffer, &color.x);
+		}
+
+		/// @brief Clear the depth attachment. Respects the depth write mask.
+		GAL_INLINE void clearDepth(float depth = 1.0f) noexcept
+		{
+			glClearNamedFramebufferfv(framebufferID, GL_DEPTH, 0, &depth);
+		}
+
+		GAL_INLINE void clearStencil(GLint stencil = 0) noexcept
+		{
+			glClearNamedFramebufferiv(framebufferID, GL_STENCIL, 0, &stencil);
+		}
+
+		GAL_INLINE void clearDepthStencil(float depth = 1.0f, GLint stencil = 0) noexcept
+		{
+			glClearNamedFramebufferfi(framebufferID, GL_DEPTH_STENCIL, 0, depth, stencil);
+		}
+
+		/// @brief Tell the driver the contents of the given attachments are no longer needed, so it can skip writing them
+		/// back to memory, e.g. a depth buffer once the pass using it is done.
+		GAL_INLINE void invalidate(const std::vector<GLenum>& invalidAttachments) noexcept
+		{
+			glInvalidateNamedFramebufferData(framebufferID, static_cast<GLsizei>(invalidAttachments.size()), invalidAttachments.data());
+		}
+
+		/// @brief Invalidate every attachment. See Framebuffer::invalidate.
+		GAL_INLINE void invalidateAll() noexcept
+		{
+			invalidate(attachments);
+		}
+
+		/// @brief Invalidate a region of the given attachments. See Framebuffer::invalidate.
+		GAL_INLINE void invalidateSub(const std::vector<GLenum>& invalidAttachments, GLint x, GLint y, GLsizei width, GLsizei height) noexcept
+		{
+			glInvalidateNamedFramebufferSubData(framebufferID, static_cast<GLsizei>(invalidAttachments.size()),
+				invalidAttachments.data(), x, y, width, height);
+		}
+
+		/// @brief Copy a region of this framebuffer's read buffer to another framebuffer, scaling if the sizes differ.
+		/// @param mask: Which buffers to copy, e.g. GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT.
+		/// @param filter: GL_NEAREST or GL_LINEAR. Must be GL_NEAREST when copying depth or stencil.
+		GAL_INLINE void blitTo(const Framebuffer& destination, GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1,
+			GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask = GL_COLOR_BUFFER_BIT, GLenum filter = GL_NEAREST) const noexcept
+		{
+			glBlitNamedFramebuffer(framebufferID, destination.framebufferID, srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+		}
+
+		/// @brief Same as Framebuffer::blitTo, but to the default framebuffer.
+		GAL_INLINE void blitToDefault(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1,
+			GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask = GL_COLOR_BUFFER_BIT, GLenum filter = GL_NEAREST) const noexcept
+		{
+			glBlitNamedFramebuffer(framebufferID, 0, srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+		}
+
+	private:
+		type::GALFramebufferID framebufferID;
+		std::vector<GLenum> attachments;
+
+		GAL_INLINE void addAttachment(GLenum attachment)
+		{
+			if (std::find(attachments.begin(), attachments.end(), attachment) == attachments.end())
+				attachments.push_back(attachment);
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,187 @@
+#ifndef GAL_FRUSTUM_HPP
+#define GAL_FRUSTUM_HPP
+
+#include <array>
+#include <cstdint>
+
+#include "attributes.hpp"
+#include "simd.hpp"
+
+namespace gal
+{
+	namespace detail
+	{
+		/// @brief Extract the six normalized frustum planes (left, right, bottom, top, near, far) from a view-projection
+		/// matrix. Each plane is stored as (normal, distance) with normals pointing into the frustum.
+		GAL_INLINE void extractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4* planes) noexcept
+		{
+			for (int i = 0; i < 3; ++i)
+			{
+				for (int side = 0; side < 2; ++side)
+				{
+					glm::vec4& plane = planes[i * 2 + side];
+					const float sign = side == 0 ? 1.0f : -1.0f;
+
+					for (int col = 0; col < 4; ++col)
+						plane[col] = viewProjection[col][3] + sign * viewProjection[col][i];
+
+					plane /= glm::length(glm::vec3(plane));
+				}
+			}
+		}
+	}
+
+	/// @brief The six planes of a view frustum, for testing bounding volumes against it on the CPU.
+	///
+	/// The batch functions take bounds as separate arrays per component and test 8 (AVX2) or 4 (SSE2) of them at a time,
+	/// writing out the indices of the ones that are at least partially inside. Bounds are in the same space as the matrix
+	/// the frustum was made from, so use a view-projection matrix for world space bounds. Tests are conservative: a
+	/// volume just outside a corner of the frustum may be reported visible.
+	struct Frustum
+	{
+	public:
+		/// @brief Planes (normal, distance) with normals pointing inwards, in the order left, right, bottom, top, near, far.
+		std::array<glm::vec4, 6> planes;
+
+		/// @brief Initialize with planes that contain everything.
+		GAL_INLINE Frustum() noexcept
+		{
+			planes.fill(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+		}
+
+		/// @brief Initialize with the frustum of a (view-)projection matrix.
+		GAL_EXPLICIT GAL_INLINE Frustum(const glm::mat4& viewProjection) noexcept
+		{
+			detail::extractFrustumPlanes(viewProjection, planes.data());
+		}
+
+		GAL_NODISCARD GAL_INLINE bool intersectsSphere(const glm::vec3& center, float radius) const noexcept
+		{
+			for (const glm::vec4& plane : planes)
+			{
+				if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+					return false;
+			}
+
+			return true;
+		}
+
+		GAL_NODISCARD GAL_INLINE bool intersectsAABB(const glm::vec3& min, const glm::vec3& max) const noexcept
+		{
+			for (const glm::vec4& plane : planes)
+			{
+				// The corner furthest along the plane's normal is outside only if the whole box is.
+				const glm::vec3 corner(plane.x >= 0.0f ? max.x : min.x, plane.y >= 0.0f ? max.y : min.y, plane.z >= 0.0f ? max.z : min.z);
+				if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+					return false;
+			}
+
+			return true;
+		}
+
+		/// @brief Test count spheres and write the indices of the visible ones to visibleIndices, which must have room for
+		/// count indices. Returns how many were visible.
+		GAL_INLINE size_t cullSpheres(const float* centerX, const float* centerY, const float* centerZ, const float* radius,
+			size_t count, uint32_t* visibleIndices) const noexcept
+		{
+			size_t visibleCount = 0;
+			const size_t done = cullSpheresRange<detail::WideFloatLanes>(0, count, centerX, centerY, centerZ, radius, visibleIndices, visibleCount);
+			cullSpheresRange<detail::FloatLanes1>(done, count, centerX, centerY, centerZ, radius, visibleIndices, visibleCount);
+
+			return visibleCount;
+		}
+
+		/// @brief Test count axis aligned boxes and write the indices of the visible ones to visibleIndices, which must
+		/// have room for count indices. Returns how many were visible.
+		GAL_INLINE size_t cullAABBs(const float* minX, const float* minY, const float* minZ,
+			const float* maxX, const float* maxY, const float* maxZ, size_t count, uint32_t* visibleIndices) const noexcept
+		{
+			// Per plane, which of the min and max arrays hold the corner furthest along its normal.
+			std::array<std::array<const float*, 3>, 6> corners;
+			for (size_t p = 0; p < planes.size(); ++p)
+			{
+				corners[p][0] = planes[p].x >= 0.0f ? maxX : minX;
+				corners[p][1] = planes[p].y >= 0.0f ? maxY : minY;
+				corners[p][2] = planes[p].z >= 0.0f ? maxZ : minZ;
+			}
+
+			size_t visibleCount = 0;
+			const size_t done = cullAABBsRange<detail::WideFloatLanes>(0, count, corners, visibleIndices, visibleCount);
+			cullAABBsRange<detail::FloatLanes1>(done, count, corners, visibleIndices, visibleCount);
+
+			return visibleCount;
+		}
+
+	private:
+		/// @brief Append i + lane for every set bit of mask. Branchless: the write for a culled lane is overwritten by the
+		/// next visible one, and since visibleCount never exceeds i, no write goes past index i + lane.
+		template<typename Lanes>
+		GAL_STATIC GAL_INLINE void appendVisible(unsigned mask, size_t i, uint32_t* visibleIndices, size_t& visibleCount) noexcept
+		{
+			for (size_t lane = 0; lane < Lanes::Width; ++lane)
+			{
+				visibleIndices[visibleCount] = static_cast<uint32_t>(i + lane);
+				visibleCount += (mask >> lane) & 1u;
+			}
+		}
+
+		template<typename Lanes>
+		GAL_INLINE size_t cullSpheresRange(size_t begin, size_t end, const float* centerX, const float* centerY, const float* centerZ,
+			const float* radius, uint32_t* visibleIndices, size_t& visibleCount) const noexcept
+		{
+			using L = Lanes;
+			using V = typename L::Type;
+
+			size_t i = begin;
+			for (; i + L::Width <= end; i += L::Width)
+			{
+				const V x = L::load(centerX + i);
+				const V y = L::load(centerY + i);
+				const V z = L::load(centerZ + i);
+				const V r = L::load(radius + i);
+
+				// The smallest signed distance plus radius over all planes is negative only if the sphere is outside one.
+				V nearest = L::set1(0.0f);
+				for (size_t p = 0; p < planes.size(); ++p)
+				{
+					const V distance = L::add(L::add(L::mul(L::set1(planes[p].x), x), L::mul(L::set1(planes[p].y), y)),
+						L::add(L::mul(L::set1(planes[p].z), z), L::add(L::set1(planes[p].w), r)));
+
+					nearest = p == 0 ? distance : L::min(nearest, distance);
+				}
+
+				appendVisible<L>(L::nonNegativeMask(nearest), i, visibleIndices, visibleCount);
+			}
+
+			return i;
+		}
+
+		template<typename Lanes>
+		GAL_INLINE size_t cullAABBsRange(size_t begin, size_t end, const std::array<std::array<const float*, 3>, 6>& corners,
+			uint32_t* visibleIndices, size_t& visibleCount) const noexcept
+		{
+			using L = Lanes;
+			using V = typename L::Type;
+
+			size_t i = begin;
+			for (; i + L::Width <= end; i += L::Width)
+			{
+				V nearest = L::set1(0.0f);
+				for (size_t p = 0; p < planes.size(); ++p)
+				{
+					const V distance = L::add(L::add(L::mul(L::set1(planes[p].x), L::load(corners[p][0] + i)),
+						L::mul(L::set1(planes[p].y), L::load(corners[p][1] + i))),
+						L::add(L::mul(L::set1(planes[p].z), L::load(corners[p][2] + i)), L::set1(planes[p].w)));
+
+					nearest = p == 0 ? distance : L::min(nearest, distance);
+				}
+
+				appendVisible<L>(L::nonNegativeMask(nearest), i, visibleIndices, visibleCount);
+			}
+
+			return i;
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,291 @@
+#ifndef GAL_GPU_FRUSTUM_CULLER_HPP
+#define GAL_GPU_FRUSTUM_CULLER_HPP
+
+#include <algorithm>
+#include <vector>
+
+#include "attributes.hpp"
+#include "barrier.hpp"
+#include "Buffer.hpp"
+#include "ComputeProgram.hpp"
+#include "enums.hpp"
+#include "Frustum.hpp"
+#include "VertexArray.hpp"
+
+namespace gal
+{
+	/// @brief Per-instance input to GPUFrustumCuller, laid out to match the std430 struct in its compute shader.
+	struct alignas(16) CullInstance
+	{
+		glm::mat4 model;
+		glm::vec4 boundingSphere; // Center (xyz) and radius (w) in the mesh's local space.
+		GLuint drawCommand; // Index of the mesh (see GPUFrustumCuller::setMeshes()) this is an instance of.
+		GLuint padding[3];
+	};
+
+	/// @brief A mesh drawn by GPUFrustumCuller. Describes a range of the shared VAO's element buffer.
+	struct CullMesh
+	{
+		GLuint count; // Number of indices.
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint maxInstances; // Space for this many visible instances is reserved. Visible instances past it aren't drawn.
+	};
+
+	namespace detail
+	{
+		GAL_INLINE const char* const frustumCullShaderSource = R"(
+#version 450 core
+layout(local_size_x = 64) in;
+
+struct CullInstance
+{
+	mat4 model;
+	vec4 boundingSphere;
+	uint drawCommand;
+	uint padding0, padding1, padding2;
+};
+
+struct DrawElementsIndirectCommand
+{
+	uint count;
+	uint instanceCount;
+	uint firstIndex;
+	int baseVertex;
+	uint baseInstance;
+};
+
+layout(std430, binding = 0) readonly buffer Instances { CullInstance instances[]; };
+layout(std430, binding = 1) buffer Commands { DrawElementsIndirectCommand commands[]; };
+layout(std430, binding = 2) writeonly buffer VisibleInstances { uint visibleInstances[]; };
+layout(std430, binding = 3) readonly buffer Capacities { uint maxInstances[]; };
+
+uniform vec4 frustumPlanes[6];
+uniform uint instanceCount;
+
+void main()
+{
+	uint i = gl_GlobalInvocationID.x;
+	if (i >= instanceCount)
+		return;
+
+	mat4 model = instances[i].model;
+	vec4 sphere = instances[i].boundingSphere;
+
+	vec3 center = (model * vec4(sphere.xyz, 1.0)).xyz;
+	float scale = max(max(length(model[0].xyz), length(model[1].xyz)), length(model[2].xyz));
+	float radius = sphere.w * scale;
+
+	for (int p = 0; p < 6; ++p)
+	{
+		if (dot(frustumPlanes[p].xyz, center) + frustumPlanes[p].w < -radius)
+			return;
+	}
+
+	uint command = instances[i].drawCommand;
+	uint slot = atomicAdd(commands[command].instanceCount, 1u);
+
+	// Past the mesh's reserved range the write would land in the next mesh's. Drop the instance, and clamp the count
+	// back down: each overflowing add is followed by its own clamp, so the count ends at exactly maxInstances.
+	if (slot >= maxInstances[command])
+	{
+		atomicMin(commands[command].instanceCount, maxInstances[command]);
+		return;
+	}
+
+	visibleInstances[commands[command].baseInstance + slot] = i;
+}
+)";
+
+		// Packs the commands with at least one visible instance to the front of a second buffer and counts them, so an
+		// indirect count draw skips the empty ones. Their order is whatever order the atomic hands out slots in.
+		GAL_INLINE const char* const commandCompactShaderSource = R"(
+#version 450 core
+layout(local_size_x = 64) in;
+
+struct DrawElementsIndirectCommand
+{
+	uint count;
+	uint instanceCount;
+	uint firstIndex;
+	int baseVertex;
+	uint baseInstance;
+};
+
+layout(std430, binding = 0) readonly buffer Commands { DrawElementsIndirectCommand commands[]; };
+layout(std430, binding = 1) writeonly buffer CompactCommands { DrawElementsIndirectCommand compactCommands[]; };
+layout(std430, binding = 2) buffer DrawCount { uint drawCount; };
+
+uniform uint commandCount;
+
+void main()
+{
+	uint i = gl_GlobalInvocationID.x;
+	if (i >= commandCount || commands[i].instanceCount == 0u)
+		return;
+
+	compactCommands[atomicAdd(drawCount, 1u)] = commands[i];
+}
+)";
+	}
+
+	/// @brief Culls instances against the camera frustum in a compute shader and writes the survivors straight into
+	/// indirect draw commands, so the CPU submits the same single draw call however many instances there are.
+	///
+	/// All meshes must live in one VAO. The culler writes the index of each visible instance into
+	/// getVisibleInstanceBuffer(), grouped per mesh starting at each command's baseInstance. Bind that buffer to the VAO
+	/// as an instanced uint attribute (see VertexArray::newVertexAttributeI() and VertexArray::setBindingDivisor()) and
+	/// use it to look up per-instance data, e.g. the model matrix from getInstanceBuffer() bound as shader storage.
+	///
+	/// Where the draw count can be read from a buffer (see VertexArray::supportsIndirectDrawCount()), a second pass
+	/// packs the commands of meshes with visible instances together and counts them, so meshes that are entirely culled
+	/// cost no draw at all. Otherwise every command is drawn, with an instance count of 0 for culled meshes.
+	class GPUFrustumCuller
+	{
+	public:
+		/// @brief Compile the culling shader. Requires a current OpenGL context.
+		GAL_INLINE GPUFrustumCuller()
+		{
+			program.addShaderFromSource(detail::frustumCullShaderSource).link();
+			compactProgram.addShaderFromSource(detail::commandCompactShaderSource).link();
+		}
+
+		// Forbid copying.
+		GAL_INLINE GPUFrustumCuller(const GPUFrustumCuller&) = delete;
+		GAL_INLINE GPUFrustumCuller& operator=(const GPUFrustumCuller&) = delete;
+
+		// Allow moving.
+		GAL_INLINE GPUFrustumCuller(GPUFrustumCuller&&) noexcept = default;
+		GAL_INLINE GPUFrustumCuller& operator=(GPUFrustumCuller&&) noexcept = default;
+
+		/// @brief Set the meshes instances can be drawn with. One draw command is generated per mesh,
+		/// and CullInstance::drawCommand indexes into this list.
+		GAL_INLINE void setMeshes(const std::vector<CullMesh>& meshes)
+		{
+			std::vector<DrawElementsIndirectCommand> commands;
+			std::vector<GLuint> capacities;
+			commands.reserve(meshes.size());
+			capacities.reserve(meshes.size());
+
+			GLuint baseInstance = 0;
+			for (const CullMesh& mesh : meshes)
+			{
+				commands.push_back({ mesh.count, 0, mesh.firstIndex, mesh.baseVertex, baseInstance });
+				capacities.push_back(mesh.maxInstances);
+				baseInstance += mesh.maxInstances;
+			}
+
+			commandCount = static_cast<GLsizei>(commands.size());
+
+			// The template holds every command with zero instances and is copied over the live commands before each cull.
+			commandTemplateBuffer.allocateAndWrite(commands, BufferUsageHint::StaticCopy);
+			commandBuffer.allocateAndWrite(commands, BufferUsageHint::DynamicCopy);
+			compactCommandBuffer.allocateAndWrite(commands, BufferUsageHint::DynamicCopy);
+			capacityBuffer.allocateAndWrite(capacities, BufferUsageHint::StaticDraw);
+			visibleInstanceBuffer.allocate(sizeof(GLuint) * std::max<GLuint>(baseInstance, 1), BufferUsageHint::DynamicCopy);
+			drawCountBuffer.allocate(sizeof(GLuint), BufferUsageHint::DynamicCopy);
+		}
+
+		/// @brief Upload every instance to be culled, replacing the previous ones.
+		GAL_INLINE void setInstances(const std::vector<CullInstance>& instances)
+		{
+			instanceBuffer.allocateAndWrite(instances, BufferUsageHint::DynamicDraw);
+			instanceCount = static_cast<GLuint>(instances.size());
+		}
+
+		/// @brief Update a range of instances in place. The instance count stays the same.
+		GAL_INLINE void writeInstances(GLuint first, const CullInstance* instances, GLuint count)
+		{
+			instanceBuffer.writeSub(sizeof(CullInstance) * first, sizeof(CullInstance) * count, instances);
+		}
+
+		/// @brief Cull every instance against the frustum of the given view-projection matrix and rebuild the draw commands.
+		/// Leaves a compute program in use.
+		GAL_INLINE void cull(const glm::mat4& viewProjection)
+		{
+			glm::vec4 planes[6];
+			detail::extractFrustumPlanes(viewProjection, planes);
+
+			commandBuffer.copySub(commandTemplateBuffer, 0, 0, sizeof(DrawElementsIndirectCommand) * commandCount);
+
+			program.setUniform("frustumPlanes", planes, 6);
+			program.setUniform("instanceCount", instanceCount);
+
+			instanceBuffer.bindBase(BufferType::ShaderStorage, 0);
+			commandBuffer.bindBase(BufferType::ShaderStorage, 1);
+			visibleInstanceBuffer.bindBase(BufferType::ShaderStorage, 2);
+			capacityBuffer.bindBase(BufferType::ShaderStorage, 3);
+
+			if (instanceCount != 0)
+				program.dispatchForAB(instanceCount);
+
+#if defined(GL_VERSION_4_6) || defined(GL_ARB_indirect_parameters)
+			if (VertexArray::supportsIndirectDrawCount() && commandCount != 0)
+			{
+				memoryBarrier(MemoryBarrierBit::ShaderStorage);
+				drawCountBuffer.clearAll(GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT);
+
+				compactProgram.setUniform("commandCount", static_cast<GLuint>(commandCount));
+				commandBuffer.bindBase(BufferType::ShaderStorage, 0);
+				compactCommandBuffer.bindBase(BufferType::ShaderStorage, 1);
+				drawCountBuffer.bindBase(BufferType::ShaderStorage, 2);
+				compactProgram.dispatchForAB(static_cast<GLuint>(commandCount));
+			}
+#endif
+
+			// BufferUpdate orders the next cull's reset copies after this one's shader writes.
+			memoryBarrier(MemoryBarrierBit::Command | MemoryBarrierBit::VertexAttribArray | MemoryBarrierBit::ShaderStorage
+				| MemoryBarrierBit::BufferUpdate);
+		}
+
+		/// @brief Binds the VAO and draws every visible instance with the commands written by the last call to cull().
+		GAL_INLINE void drawAB(const VertexArray& vao, GLenum polygonMode = GL_TRIANGLES) const
+		{
+			vao.bind();
+			drawNB(vao, polygonMode);
+		}
+
+		/// @brief Draws every visible instance with the commands written by the last call to cull(). Assumes the VAO is bound.
+		GAL_INLINE void drawNB(const VertexArray& vao, GLenum polygonMode = GL_TRIANGLES) const
+		{
+#if defined(GL_VERSION_4_6) || defined(GL_ARB_indirect_parameters)
+			if (VertexArray::supportsIndirectDrawCount())
+			{
+				vao.multiDrawElementsIndirectCountNB(polygonMode, compactCommandBuffer, 0, drawCountBuffer, 0, commandCount);
+				return;
+			}
+#endif
+			vao.multiDrawElementsIndirectNB(polygonMode, commandBuffer, 0, commandCount);
+		}
+
+		GAL_NODISCARD GAL_INLINE GLuint getInstanceCount() const noexcept { return instanceCount; }
+		GAL_NODISCARD GAL_INLINE GLsizei getCommandCount() const noexcept { return commandCount; }
+
+		/// @brief Buffer of every CullInstance, for binding as shader storage when drawing.
+		GAL_NODISCARD GAL_INLINE const Buffer& getInstanceBuffer() const noexcept { return instanceBuffer; }
+
+		/// @brief Buffer of indices into the instance buffer, compacted per mesh. Source of the instanced attribute.
+		GAL_NODISCARD GAL_INLINE const Buffer& getVisibleInstanceBuffer() const noexcept { return visibleInstanceBuffer; }
+
+		/// @brief Buffer of DrawElementsIndirectCommands, one per mesh in the order given to setMeshes(), including the
+		/// culled ones.
+		GAL_NODISCARD GAL_INLINE const Buffer& getCommandBuffer() const noexcept { return commandBuffer; }
+
+	private:
+		ComputeProgram program;
+		ComputeProgram compactProgram;
+
+		Buffer instanceBuffer{ BufferType::ShaderStorage };
+		Buffer commandBuffer{ BufferType::DrawIndirect };
+		Buffer commandTemplateBuffer{ BufferType::CopyRead };
+		Buffer visibleInstanceBuffer{ BufferType::Array };
+		Buffer capacityBuffer{ BufferType::ShaderStorage };
+		Buffer compactCommandBuffer{ BufferType::DrawIndirect };
+		Buffer drawCountBuffer{ BufferType::ShaderStorage };
+
+		GLuint instanceCount = 0;
+		GLsizei commandCount = 0;
+	};
+}
+
+#endif
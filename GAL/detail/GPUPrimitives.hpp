@@ -0,0 +1,718 @@
+#ifndef GAL_GPU_PRIMITIVES_HPP
+#define GAL_GPU_PRIMITIVES_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "attributes.hpp"
+#include "barrier.hpp"
+#include "Buffer.hpp"
+#include "ComputeProgram.hpp"
+#include "enums.hpp"
+
+namespace gal
+{
+	/// @brief Operations supported by GPUPrimitives::reduce().
+	enum class ReduceOp : GLuint
+	{
+		Sum = 0,
+		Min = 1,
+		Max = 2
+	};
+
+	/// @brief Result of benchmarking a single primitive. See GPUPrimitives::benchmark().
+	struct GPUPrimitiveBenchmarkResult
+	{
+		const char* name;
+		double elementsPerSecond;
+		bool matchesReference; // Whether the GPU output matched the CPU reference implementation.
+	};
+
+	/// @brief Straightforward CPU implementations of the GPUPrimitives operations, for checking GPU results against.
+	namespace cpuReference
+	{
+		GAL_NODISCARD GAL_INLINE std::vector<GLuint> exclusiveScan(const std::vector<GLuint>& input)
+		{
+			std::vector<GLuint> output(input.size());
+			GLuint running = 0;
+
+			for (size_t i = 0; i < input.size(); ++i)
+			{
+				output[i] = running;
+				running += input[i];
+			}
+
+			return output;
+		}
+
+		GAL_NODISCARD GAL_INLINE std::vector<GLuint> inclusiveScan(const std::vector<GLuint>& input)
+		{
+			std::vector<GLuint> output(input.size());
+			std::partial_sum(input.begin(), input.end(), output.begin());
+			return output;
+		}
+
+		GAL_NODISCARD GAL_INLINE GLuint reduce(const std::vector<GLuint>& input, ReduceOp op)
+		{
+			switch (op)
+			{
+				case ReduceOp::Min: return input.empty() ? UINT32_MAX : *std::min_element(input.begin(), input.end());
+				case ReduceOp::Max: return input.empty() ? 0 : *std::max_element(input.begin(), input.end());
+				default: return std::accumulate(input.begin(), input.end(), GLuint(0));
+			}
+		}
+
+		/// @brief Keep the values whose flag is non-zero, preserving their order.
+		GAL_NODISCARD GAL_INLINE std::vector<GLuint> compact(const std::vector<GLuint>& input, const std::vector<GLuint>& flags)
+		{
+			std::vector<GLuint> output;
+
+			for (size_t i = 0; i < input.size(); ++i)
+			{
+				if (flags[i] != 0)
+					output.push_back(input[i]);
+			}
+
+			return output;
+		}
+
+		/// @brief Stable sort of keys, applying the same reordering to values (if not empty).
+		GAL_INLINE void radixSort(std::vector<GLuint>& keys, std::vector<GLuint>& values)
+		{
+			std::vector<size_t> order(keys.size());
+			std::iota(order.begin(), order.end(), size_t(0));
+			std::stable_sort(order.begin(), order.end(), [&keys](size_t a, size_t b) { return keys[a] < keys[b]; });
+
+			std::vector<GLuint> sortedKeys(keys.size());
+			std::vector<GLuint> sortedValues(values.size());
+
+			for (size_t i = 0; i < order.size(); ++i)
+			{
+				sortedKeys[i] = keys[order[i]];
+				if (!values.empty())
+					sortedValues[i] = values[order[i]];
+			}
+
+			keys = std::move(sortedKeys);
+			values = std::move(sortedValues);
+		}
+	}
+
+	namespace detail
+	{
+		// Every kernel uses 256 invocations per group, each handling 4 consecutive elements, so one group covers 1024.
+		GAL_CONSTEXPR GLuint primitiveBlockSize = 1024;
+
+		// Only 65535 work groups per dimension are guaranteed, so large dispatches spread their groups over rows of
+		// this many (see dispatchPrimitiveGroups()), and kernels number their group gl_WorkGroupID.y * gl_NumWorkGroups.x
+		// + gl_WorkGroupID.x. The last row may have groups past the end, which return straight away.
+		GAL_CONSTEXPR GLuint primitiveMaxGroupsX = 65535;
+
+		GAL_INLINE const char* const scanBlocksShaderSource = R"(
+#version 450 core
+layout(local_size_x = 256) in;
+
+layout(std430, binding = 0) readonly buffer Input { uint inputData[]; };
+layout(std430, binding = 1) writeonly buffer Output { uint outputData[]; };
+layout(std430, binding = 2) writeonly buffer BlockSums { uint blockSums[]; };
+
+uniform uint count;
+uniform bool inclusive;
+uniform bool writeBlockSums;
+
+shared uint sums[256];
+
+void main()
+{
+	uint group = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+	if (group * 1024u >= count)
+		return;
+
+	uint t = gl_LocalInvocationID.x;
+	uint base = group * 1024u + t * 4u;
+
+	uint v[4];
+	uint total = 0u;
+	for (uint j = 0u; j < 4u; ++j)
+	{
+		v[j] = base + j < count ? inputData[base + j] : 0u;
+		total += v[j];
+	}
+
+	sums[t] = total;
+	barrier();
+
+	for (uint offset = 1u; offset < 256u; offset <<= 1)
+	{
+		uint add = t >= offset ? sums[t - offset] : 0u;
+		barrier();
+		sums[t] += add;
+		barrier();
+	}
+
+	uint running = sums[t] - total;
+	for (uint j = 0u; j < 4u; ++j)
+	{
+		if (inclusive)
+			running += v[j];
+		if (base + j < count)
+			outputData[base + j] = running;
+		if (!inclusive)
+			running += v[j];
+	}
+
+	if (writeBlockSums && t == 255u)
+		blockSums[group] = sums[255];
+}
+)";
+
+		GAL_INLINE const char* const addBlockOffsetsShaderSource = R"(
+#version 450 core
+layout(local_size_x = 256) in;
+
+layout(std430, binding = 1) buffer Output { uint outputData[]; };
+layout(std430, binding = 2) readonly buffer BlockOffsets { uint blockOffsets[]; };
+
+uniform uint count;
+
+void main()
+{
+	uint i = (gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x) * 256u + gl_LocalInvocationID.x;
+	if (i < count)
+		outputData[i] += blockOffsets[i / 1024u];
+}
+)";
+
+		GAL_INLINE const char* const reduceShaderSource = R"(
+#version 450 core
+layout(local_size_x = 256) in;
+
+layout(std430, binding = 0) readonly buffer Input { uint inputData[]; };
+layout(std430, binding = 1) writeonly buffer Output { uint outputData[]; };
+
+uniform uint count;
+uniform uint operation;
+
+shared uint partial[256];
+
+uint combine(uint a, uint b)
+{
+	return operation == 0u ? a + b : (operation == 1u ? min(a, b) : max(a, b));
+}
+
+void main()
+{
+	// Group 0 always runs, so reducing nothing still writes the operation's identity.
+	uint group = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+	if (group != 0u && group * 1024u >= count)
+		return;
+
+	uint t = gl_LocalInvocationID.x;
+	uint base = group * 1024u + t * 4u;
+
+	uint acc = operation == 1u ? 0xFFFFFFFFu : 0u;
+	for (uint j = 0u; j < 4u; ++j)
+	{
+		if (base + j < count)
+			acc = combine(acc, inputData[base + j]);
+	}
+
+	partial[t] = acc;
+	barrier();
+
+	for (uint stride = 128u; stride > 0u; stride >>= 1)
+	{
+		if (t < stride)
+			partial[t] = combine(partial[t], partial[t + stride]);
+		barrier();
+	}
+
+	if (t == 0u)
+		outputData[group] = partial[0];
+}
+)";
+
+		GAL_INLINE const char* const compactScatterShaderSource = R"(
+#version 450 core
+layout(local_size_x = 256) in;
+
+layout(std430, binding = 0) readonly buffer Input { uint inputData[]; };
+layout(std430, binding = 1) readonly buffer Flags { uint flags[]; };
+layout(std430, binding = 2) readonly buffer Positions { uint positions[]; };
+layout(std430, binding = 3) writeonly buffer Output { uint outputData[]; };
+layout(std430, binding = 4) writeonly buffer Count { uint outputCount; };
+
+uniform uint count;
+
+void main()
+{
+	uint i = (gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x) * 256u + gl_LocalInvocationID.x;
+	if (i >= count)
+		return;
+
+	bool keep = flags[i] != 0u;
+	if (keep)
+		outputData[positions[i]] = inputData[i];
+
+	if (i == count - 1u)
+		outputCount = positions[i] + (keep ? 1u : 0u);
+}
+)";
+
+		GAL_INLINE const char* const radixHistogramShaderSource = R"(
+#version 450 core
+layout(local_size_x = 256) in;
+
+layout(std430, binding = 0) readonly buffer Keys { uint keys[]; };
+layout(std430, binding = 1) writeonly buffer BlockHistograms { uint blockHistograms[]; };
+
+uniform uint count;
+uniform uint shift;
+uniform uint blockCount;
+
+shared uint histogram[16];
+
+void main()
+{
+	uint group = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+	if (group >= blockCount)
+		return;
+
+	uint t = gl_LocalInvocationID.x;
+	if (t < 16u)
+		histogram[t] = 0u;
+	barrier();
+
+	uint base = group * 1024u + t * 4u;
+	for (uint j = 0u; j < 4u; ++j)
+	{
+		if (base + j < count)
+			atomicAdd(histogram[(keys[base + j] >> shift) & 15u], 1u);
+	}
+	barrier();
+
+	// Digit-major, so one exclusive scan over the whole array yields every block's output offset for every digit.
+	if (t < 16u)
+		blockHistograms[t * blockCount + group] = histogram[t];
+}
+)";
+
+		GAL_INLINE const char* const radixScatterShaderSource = R"(
+#version 450 core
+layout(local_size_x = 256) in;
+
+layout(std430, binding = 0) readonly buffer KeysIn { uint keysIn[]; };
+layout(std430, binding = 1) readonly buffer ValuesIn { uint valuesIn[]; };
+layout(std430, binding = 2) writeonly buffer KeysOut { uint keysOut[]; };
+layout(std430, binding = 3) writeonly buffer ValuesOut { uint valuesOut[]; };
+layout(std430, binding = 4) readonly buffer BlockOffsets { uint blockOffsets[]; };
+
+uniform uint count;
+uniform uint shift;
+uniform uint blockCount;
+uniform bool hasValues;
+
+shared uint digitCounts[16][256];
+
+void main()
+{
+	uint group = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+	if (group >= blockCount)
+		return;
+
+	uint t = gl_LocalInvocationID.x;
+	uint base = group * 1024u + t * 4u;
+
+	uint key[4];
+	uint digit[4];
+	uint local[16];
+
+	for (uint d = 0u; d < 16u; ++d)
+		local[d] = 0u;
+
+	for (uint j = 0u; j < 4u; ++j)
+	{
+		if (base + j < count)
+		{
+			key[j] = keysIn[base + j];
+			digit[j] = (key[j] >> shift) & 15u;
+			++local[digit[j]];
+		}
+	}
+
+	for (uint d = 0u; d < 16u; ++d)
+		digitCounts[d][t] = local[d];
+	barrier();
+
+	// Inclusive scan of every digit's counts across the group. Invocations own consecutive elements,
+	// so ranking elements by invocation order keeps the sort stable.
+	for (uint offset = 1u; offset < 256u; offset <<= 1)
+	{
+		uint add[16];
+		for (uint d = 0u; d < 16u; ++d)
+			add[d] = t >= offset ? digitCounts[d][t - offset] : 0u;
+		barrier();
+		for (uint d = 0u; d < 16u; ++d)
+			digitCounts[d][t] += add[d];
+		barrier();
+	}
+
+	for (uint d = 0u; d < 16u; ++d)
+		local[d] = digitCounts[d][t] - local[d];
+
+	for (uint j = 0u; j < 4u; ++j)
+	{
+		if (base + j < count)
+		{
+			uint d = digit[j];
+			uint position = blockOffsets[d * blockCount + group] + local[d]++;
+			keysOut[position] = key[j];
+			if (hasValues)
+				valuesOut[position] = valuesIn[base + j];
+		}
+	}
+}
+)";
+
+		GAL_NODISCARD GAL_CONSTEXPR GAL_INLINE GLuint primitiveBlockCount(GLuint count) noexcept
+		{
+			return (count + primitiveBlockSize - 1) / primitiveBlockSize;
+		}
+
+		/// @brief Use the program and dispatch groupCount work groups, in rows of primitiveMaxGroupsX.
+		GAL_INLINE void dispatchPrimitiveGroups(const ComputeProgram& program, GLuint groupCount)
+		{
+			const GLuint groupsX = std::min(std::max(groupCount, 1u), primitiveMaxGroupsX);
+			program.dispatchAB(groupsX, (std::max(groupCount, 1u) + groupsX - 1) / groupsX);
+		}
+
+		/// @brief Reallocate the buffer if it is smaller than the given size. Contents are lost when reallocating.
+		GAL_INLINE void ensureBufferSize(Buffer& buffer, GLsizeiptr size)
+		{
+			size = std::max<GLsizeiptr>(size, sizeof(GLuint));
+			if (!buffer.isAllocated() || buffer.getSize() < size)
+				buffer.allocate(size, BufferUsageHint::DynamicCopy);
+		}
+	}
+
+	/// @brief GPU building blocks operating directly on buffers of 32-bit unsigned integers:
+	/// prefix sums, reduction, stream compaction and key/value radix sort.
+	/// Every function inserts the memory barriers needed between its own passes and a shader storage barrier at the end,
+	/// so results can be used by subsequent shaders. Insert other barriers yourself (e.g. MemoryBarrierBit::Command
+	/// before using results as indirect commands). Functions leave an arbitrary program in use.
+	class GPUPrimitives
+	{
+	public:
+		/// @brief Compile every kernel. Requires a current OpenGL context.
+		GAL_INLINE GPUPrimitives()
+		{
+			scanBlocksProgram.addShaderFromSource(detail::scanBlocksShaderSource).link();
+			addBlockOffsetsProgram.addShaderFromSource(detail::addBlockOffsetsShaderSource).link();
+			reduceProgram.addShaderFromSource(detail::reduceShaderSource).link();
+			compactScatterProgram.addShaderFromSource(detail::compactScatterShaderSource).link();
+			radixHistogramProgram.addShaderFromSource(detail::radixHistogramShaderSource).link();
+			radixScatterProgram.addShaderFromSource(detail::radixScatterShaderSource).link();
+		}
+
+		// Forbid copying.
+		GAL_INLINE GPUPrimitives(const GPUPrimitives&) = delete;
+		GAL_INLINE GPUPrimitives& operator=(const GPUPrimitives&) = delete;
+
+		// Allow moving.
+		GAL_INLINE GPUPrimitives(GPUPrimitives&&) noexcept = default;
+		GAL_INLINE GPUPrimitives& operator=(GPUPrimitives&&) noexcept = default;
+
+		/// @brief Write the exclusive prefix sum of the first count elements of input to output.
+		/// input and output may be the same buffer.
+		GAL_INLINE void exclusiveScan(const Buffer& input, Buffer& output, GLuint count)
+		{
+			scan(input, output, count, false, 0);
+			memoryBarrier(MemoryBarrierBit::ShaderStorage);
+		}
+
+		/// @brief Write the inclusive prefix sum of the first count elements of input to output.
+		/// input and output may be the same buffer.
+		GAL_INLINE void inclusiveScan(const Buffer& input, Buffer& output, GLuint count)
+		{
+			scan(input, output, count, true, 0);
+			memoryBarrier(MemoryBarrierBit::ShaderStorage);
+		}
+
+		/// @brief Reduce the first count elements of input with the given operation, writing the single result
+		/// to output at the given byte offset.
+		GAL_INLINE void reduce(const Buffer& input, Buffer& output, GLuint count, ReduceOp op = ReduceOp::Sum,
+			GLintptr outputOffset = 0)
+		{
+			const Buffer* source = &input;
+			int target = 0;
+
+			// Ping-pong between the two temporary buffers until a single value is left.
+			do
+			{
+				const GLuint blocks = detail::primitiveBlockCount(count);
+				detail::ensureBufferSize(reduceBuffers[target], sizeof(GLuint) * blocks);
+
+				reduceProgram.setUniform("count", count).setUniform("operation", static_cast<GLuint>(op));
+				source->bindBase(BufferType::ShaderStorage, 0);
+				reduceBuffers[target].bindBase(BufferType::ShaderStorage, 1);
+				detail::dispatchPrimitiveGroups(reduceProgram, blocks);
+				memoryBarrier(MemoryBarrierBit::ShaderStorage);
+
+				source = &reduceBuffers[target];
+				target ^= 1;
+				count = blocks;
+			} while (count > 1);
+
+			memoryBarrier(MemoryBarrierBit::BufferUpdate);
+			output.copySub(*source, 0, outputOffset, sizeof(GLuint));
+		}
+
+		/// @brief Copy the elements of input whose flag is non-zero to the front of output, preserving their order.
+		/// Flags must be 0 or 1. The number of elements kept is written to countOutput at the given byte offset, which must be
+		/// a multiple of GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT.
+		GAL_INLINE void compact(const Buffer& input, const Buffer& flags, Buffer& output, GLuint count,
+			Buffer& countOutput, GLintptr countOffset = 0)
+		{
+			if (count == 0)
+				return;
+
+			detail::ensureBufferSize(compactPositionBuffer, sizeof(GLuint) * count);
+			scan(flags, compactPositionBuffer, count, false, 0);
+			memoryBarrier(MemoryBarrierBit::ShaderStorage);
+
+			compactScatterProgram.setUniform("count", count);
+			input.bindBase(BufferType::ShaderStorage, 0);
+			flags.bindBase(BufferType::ShaderStorage, 1);
+			compactPositionBuffer.bindBase(BufferType::ShaderStorage, 2);
+			output.bindBase(BufferType::ShaderStorage, 3);
+			countOutput.bindRange(BufferType::ShaderStorage, 4, countOffset, sizeof(GLuint));
+			detail::dispatchPrimitiveGroups(compactScatterProgram, (count - 1) / 256 + 1);
+			memoryBarrier(MemoryBarrierBit::ShaderStorage);
+		}
+
+		/// @brief Stably sort the first count keys in ascending order, applying the same reordering to values.
+		/// Pass the same buffer as keys for values to sort keys only.
+		/// Only the lowest keyBits bits of each key are considered, so limit it to speed up sorting small keys.
+		GAL_INLINE void radixSort(Buffer& keys, Buffer& values, GLuint count, GLuint keyBits = 32)
+		{
+			if (count == 0)
+				return;
+
+			const bool hasValues = keys.getID() != values.getID();
+			const GLuint blocks = detail::primitiveBlockCount(count);
+			const GLuint passes = (std::min<GLuint>(keyBits, 32) + 3) / 4;
+
+			detail::ensureBufferSize(radixKeyBuffer, sizeof(GLuint) * count);
+			detail::ensureBufferSize(radixValueBuffer, hasValues ? sizeof(GLuint) * count : 0);
+			detail::ensureBufferSize(radixHistogramBuffer, sizeof(GLuint) * 16 * blocks);
+
+			const Buffer* keysIn = &keys;
+			const Buffer* valuesIn = hasValues ? &values : &keys;
+			const Buffer* keysOut = &radixKeyBuffer;
+			const Buffer* valuesOut = hasValues ? &radixValueBuffer : &radixKeyBuffer;
+
+			for (GLuint pass = 0; pass < passes; ++pass)
+			{
+				const GLuint shift = pass * 4;
+
+				radixHistogramProgram.setUniform("count", count).setUniform("shift", shift).setUniform("blockCount", blocks);
+				keysIn->bindBase(BufferType::ShaderStorage, 0);
+				radixHistogramBuffer.bindBase(BufferType::ShaderStorage, 1);
+				detail::dispatchPrimitiveGroups(radixHistogramProgram, blocks);
+				memoryBarrier(MemoryBarrierBit::ShaderStorage);
+
+				scan(radixHistogramBuffer, radixHistogramBuffer, 16 * blocks, false, 0);
+				memoryBarrier(MemoryBarrierBit::ShaderStorage);
+
+				radixScatterProgram.setUniform("count", count).setUniform("shift", shift)
+					.setUniform("blockCount", blocks).setUniform("hasValues", hasValues);
+				keysIn->bindBase(BufferType::ShaderStorage, 0);
+				valuesIn->bindBase(BufferType::ShaderStorage, 1);
+				keysOut->bindBase(BufferType::ShaderStorage, 2);
+				valuesOut->bindBase(BufferType::ShaderStorage, 3);
+				radixHistogramBuffer.bindBase(BufferType::ShaderStorage, 4);
+				detail::dispatchPrimitiveGroups(radixScatterProgram, blocks);
+				memoryBarrier(MemoryBarrierBit::ShaderStorage);
+
+				std::swap(keysIn, keysOut);
+				std::swap(valuesIn, valuesOut);
+			}
+
+			// After an odd number of passes the result lives in the temporary buffers.
+			if (passes % 2 != 0)
+			{
+				memoryBarrier(MemoryBarrierBit::BufferUpdate);
+				keys.copySub(radixKeyBuffer, 0, 0, sizeof(GLuint) * count);
+				if (hasValues)
+					values.copySub(radixValueBuffer, 0, 0, sizeof(GLuint) * count);
+			}
+		}
+
+		/// @brief Run every primitive on elementCount random values, check the results against the CPU reference
+		/// implementations and measure throughput with GPU timer queries, averaged over the given number of iterations.
+		GAL_NODISCARD GAL_INLINE std::vector<GPUPrimitiveBenchmarkResult> benchmark(GLuint elementCount, int iterations = 10)
+		{
+			std::mt19937 rng(1234);
+			std::uniform_int_distribution<GLuint> smallValues(0, 15);
+			std::uniform_int_distribution<GLuint> flagValues(0, 1);
+
+			std::vector<GLuint> data(elementCount);
+			std::vector<GLuint> flags(elementCount);
+			std::vector<GLuint> keys(elementCount);
+			std::vector<GLuint> values(elementCount);
+
+			for (GLuint i = 0; i < elementCount; ++i)
+			{
+				data[i] = smallValues(rng);
+				flags[i] = flagValues(rng);
+				keys[i] = static_cast<GLuint>(rng());
+				values[i] = i;
+			}
+
+			Buffer dataBuffer(BufferType::ShaderStorage);
+			Buffer flagBuffer(BufferType::ShaderStorage);
+			Buffer outputBuffer(BufferType::ShaderStorage);
+			Buffer keyBuffer(BufferType::ShaderStorage);
+			Buffer valueBuffer(BufferType::ShaderStorage);
+			Buffer resultBuffer(BufferType::ShaderStorage);
+
+			dataBuffer.allocateAndWrite(data, BufferUsageHint::StaticDraw);
+			flagBuffer.allocateAndWrite(flags, BufferUsageHint::StaticDraw);
+			outputBuffer.allocate(sizeof(GLuint) * std::max<GLuint>(elementCount, 1), BufferUsageHint::DynamicCopy);
+			keyBuffer.allocate(sizeof(GLuint) * std::max<GLuint>(elementCount, 1), BufferUsageHint::DynamicCopy);
+			valueBuffer.allocate(sizeof(GLuint) * std::max<GLuint>(elementCount, 1), BufferUsageHint::DynamicCopy);
+			resultBuffer.allocate(sizeof(GLuint), BufferUsageHint::DynamicRead);
+
+			std::vector<GLuint> readback(elementCount);
+			auto readOutput = [&](const Buffer& buffer, GLuint count)
+			{
+				memoryBarrier(MemoryBarrierBit::BufferUpdate);
+				readback.resize(count);
+				if (count != 0)
+					buffer.readSub(0, sizeof(GLuint) * count, readback.data());
+				return readback;
+			};
+
+			auto readResult = [&]()
+			{
+				GLuint result = 0;
+				memoryBarrier(MemoryBarrierBit::BufferUpdate);
+				resultBuffer.readSub(0, sizeof(GLuint), &result);
+				return result;
+			};
+
+			std::vector<GPUPrimitiveBenchmarkResult> results;
+
+			exclusiveScan(dataBuffer, outputBuffer, elementCount);
+			results.push_back({ "exclusiveScan", 0.0, readOutput(outputBuffer, elementCount) == cpuReference::exclusiveScan(data) });
+			results.back().elementsPerSecond = measure(elementCount, iterations, [&] { exclusiveScan(dataBuffer, outputBuffer, elementCount); });
+
+			inclusiveScan(dataBuffer, outputBuffer, elementCount);
+			results.push_back({ "inclusiveScan", 0.0, readOutput(outputBuffer, elementCount) == cpuReference::inclusiveScan(data) });
+			results.back().elementsPerSecond = measure(elementCount, iterations, [&] { inclusiveScan(dataBuffer, outputBuffer, elementCount); });
+
+			reduce(dataBuffer, resultBuffer, elementCount, ReduceOp::Sum);
+			results.push_back({ "reduce", 0.0, readResult() == cpuReference::reduce(data, ReduceOp::Sum) });
+			results.back().elementsPerSecond = measure(elementCount, iterations, [&] { reduce(dataBuffer, resultBuffer, elementCount); });
+
+			compact(dataBuffer, flagBuffer, outputBuffer, elementCount, resultBuffer);
+			{
+				const std::vector<GLuint> expected = cpuReference::compact(data, flags);
+				const GLuint keptCount = elementCount == 0 ? 0 : readResult();
+				results.push_back({ "compact", 0.0, keptCount == expected.size() && readOutput(outputBuffer, keptCount) == expected });
+			}
+			results.back().elementsPerSecond = measure(elementCount, iterations,
+				[&] { compact(dataBuffer, flagBuffer, outputBuffer, elementCount, resultBuffer); });
+
+			keyBuffer.writeAll(keys);
+			valueBuffer.writeAll(values);
+			radixSort(keyBuffer, valueBuffer, elementCount);
+			{
+				std::vector<GLuint> expectedKeys = keys;
+				std::vector<GLuint> expectedValues = values;
+				cpuReference::radixSort(expectedKeys, expectedValues);
+
+				const bool keysMatch = readOutput(keyBuffer, elementCount) == expectedKeys;
+				results.push_back({ "radixSort", 0.0, keysMatch && readOutput(valueBuffer, elementCount) == expectedValues });
+			}
+			// Sorting already sorted keys costs the same as sorting random ones, so no need to re-upload between iterations.
+			results.back().elementsPerSecond = measure(elementCount, iterations, [&] { radixSort(keyBuffer, valueBuffer, elementCount); });
+
+			return results;
+		}
+
+	private:
+		ComputeProgram scanBlocksProgram;
+		ComputeProgram addBlockOffsetsProgram;
+		ComputeProgram reduceProgram;
+		ComputeProgram compactScatterProgram;
+		ComputeProgram radixHistogramProgram;
+		ComputeProgram radixScatterProgram;
+
+		// One per level of the scan hierarchy. Four levels of 1024 element blocks cover any 32-bit count.
+		Buffer scanBlockSumBuffers[4] = { Buffer(BufferType::ShaderStorage), Buffer(BufferType::ShaderStorage),
+			Buffer(BufferType::ShaderStorage), Buffer(BufferType::ShaderStorage) };
+		Buffer reduceBuffers[2] = { Buffer(BufferType::ShaderStorage), Buffer(BufferType::ShaderStorage) };
+		Buffer compactPositionBuffer{ BufferType::ShaderStorage };
+		Buffer radixKeyBuffer{ BufferType::ShaderStorage };
+		Buffer radixValueBuffer{ BufferType::ShaderStorage };
+		Buffer radixHistogramBuffer{ BufferType::ShaderStorage };
+
+		/// @brief Scan each 1024 element block, then recursively scan the block sums and add them back on.
+		GAL_INLINE void scan(const Buffer& input, const Buffer& output, GLuint count, bool inclusive, size_t level)
+		{
+			if (count == 0)
+				return;
+
+			const GLuint blocks = detail::primitiveBlockCount(count);
+
+			Buffer& blockSums = scanBlockSumBuffers[level];
+			detail::ensureBufferSize(blockSums, sizeof(GLuint) * blocks);
+
+			scanBlocksProgram.setUniform("count", count).setUniform("inclusive", inclusive).setUniform("writeBlockSums", blocks > 1);
+			input.bindBase(BufferType::ShaderStorage, 0);
+			output.bindBase(BufferType::ShaderStorage, 1);
+			blockSums.bindBase(BufferType::ShaderStorage, 2);
+			detail::dispatchPrimitiveGroups(scanBlocksProgram, blocks);
+
+			if (blocks == 1)
+				return;
+
+			memoryBarrier(MemoryBarrierBit::ShaderStorage);
+			scan(blockSums, blockSums, blocks, false, level + 1);
+			memoryBarrier(MemoryBarrierBit::ShaderStorage);
+
+			addBlockOffsetsProgram.setUniform("count", count);
+			output.bindBase(BufferType::ShaderStorage, 1);
+			blockSums.bindBase(BufferType::ShaderStorage, 2);
+			detail::dispatchPrimitiveGroups(addBlockOffsetsProgram, (count - 1) / 256 + 1);
+		}
+
+		/// @brief Time the given function with a GL_TIME_ELAPSED query and return the elements processed per second.
+		template<typename Func>
+		GAL_INLINE double measure(GLuint elementCount, int iterations, Func&& func)
+		{
+			GLuint query;
+			glCreateQueries(GL_TIME_ELAPSED, 1, &query);
+
+			glBeginQuery(GL_TIME_ELAPSED, query);
+			for (int i = 0; i < iterations; ++i)
+				func();
+			glEndQuery(GL_TIME_ELAPSED);
+
+			GLuint64 nanoseconds = 0;
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+			glDeleteQueries(1, &query);
+
+			if (nanoseconds == 0)
+				return 0.0;
+
+			return static_cast<double>(elementCount) * iterations / (static_cast<double>(nanoseconds) * 1e-9);
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,304 @@
+#ifndef GAL_HEADLESS_CONTEXT_HPP
+#define GAL_HEADLESS_CONTEXT_HPP
+
+// Define GAL_HEADLESS_EGL or GAL_HEADLESS_OSMESA before including GAL to enable HeadlessContext with that backend,
+// and link against libEGL or libOSMesa respectively.
+#if defined(GAL_HEADLESS_EGL) || defined(GAL_HEADLESS_OSMESA)
+
+#include <memory>
+
+#if defined(GAL_HEADLESS_EGL)
+#include <mutex>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+#else
+#include <GL/osmesa.h>
+#endif
+
+#include "attributes.hpp"
+#include "debug.hpp"
+#include "enums.hpp"
+#include "Framebuffer.hpp"
+#include "GALException.hpp"
+#include "glParams.hpp"
+#include "init.hpp"
+#include "Texture.hpp"
+
+namespace gal
+{
+#if defined(GAL_HEADLESS_EGL)
+	namespace detail
+	{
+		// The surfaceless EGL display is shared by the whole process, so it's only terminated with the last context.
+		GAL_INLINE std::mutex headlessDisplayMutex;
+		GAL_INLINE int headlessDisplayUsers = 0;
+	}
+#endif
+
+	/// @brief An OpenGL context with no window or display, rendering into a Framebuffer of its own, for batch rendering
+	/// on machines without a display server (e.g. Mesa llvmpipe on render nodes).
+	///
+	/// With GAL_HEADLESS_EGL the context comes from the Mesa surfaceless EGL platform (EGL_PLATFORM_SURFACELESS_MESA);
+	/// with GAL_HEADLESS_OSMESA, from OSMesa. Either way GLFW is never initialized, so don't call gal::init() or create
+	/// a Window, and many processes can render side by side. Set the OpenGL version with setOpenGLVersion() first, as
+	/// for a Window. The first context created runs the same post-context initialization a Window does.
+	class HeadlessContext
+	{
+	public:
+		/// @param debugContext: Request a debug context and attach the default debug message callback, as Window does.
+		/// @param colorFormat, depthFormat: Internal formats of the framebuffer's attachments. GL_NONE for no depth.
+		GAL_INLINE HeadlessContext(GLsizei width, GLsizei height, bool debugContext = false, GLenum colorFormat = GL_RGBA8,
+			GLenum depthFormat = GL_DEPTH24_STENCIL8)
+			: colorFormat(colorFormat), depthFormat(depthFormat)
+		{
+			if (detail::openGLVersionMajor == -1 || detail::openGLVersionMinor == -1)
+				detail::throwErr(ErrCode::OpenGLVersionUnset, "OpenGL Version left unset when creating a headless context.");
+
+			createContext(debugContext);
+
+			// The destructor won't run if construction fails, so let go of the context and display here instead.
+			try
+			{
+				makeCurrent();
+
+				if (!detail::postGLInitialized)
+					detail::postGLInit(loader());
+
+				if (debugContext && !(glParams::queryGLParamInt(GL_CONTEXT_FLAGS) & GL_CONTEXT_FLAG_DEBUG_BIT))
+					detail::throwErr(ErrCode::DebugContextCreationFailed, "Failed to create debug context.");
+			}
+			catch (...)
+			{
+				destroyContext();
+				throw;
+			}
+
+			if (debugContext)
+			{
+				glEnable(GL_DEBUG_OUTPUT);
+				glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+				glDebugMessageCallback(detail::defaultDebugMessageCallback, nullptr);
+				glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+			}
+
+			framebuffer = std::make_unique<Framebuffer>();
+			resize(width, height);
+
+			glEnable(GL_BLEND);
+			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			glEnable(GL_DEPTH_TEST);
+		}
+
+		// Forbid copying and moving, as the context owns GL objects that must be deleted while it's current.
+		GAL_INLINE HeadlessContext(const HeadlessContext&) = delete;
+		GAL_INLINE HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+		GAL_INLINE ~HeadlessContext()
+		{
+			// Nothing can be done about a failure here, and throwing from the destructor would terminate.
+			tryMakeCurrent();
+			framebuffer.reset();
+			color.reset();
+			depth.reset();
+
+			destroyContext();
+		}
+
+		/// @brief Make this context current on the calling thread.
+		GAL_INLINE void makeCurrent() const
+		{
+			if (!tryMakeCurrent())
+				detail::throwErr(ErrCode::HeadlessContextCreationFailed, "Failed to make headless context current.");
+		}
+
+		/// @brief Bind the framebuffer and set the viewport to cover it. Call before rendering.
+		GAL_INLINE void bind() const noexcept
+		{
+			framebuffer->bind();
+			glViewport(0, 0, width, height);
+		}
+
+		/// @brief Recreate the framebuffer's attachments at a new size. Their contents are lost.
+		GAL_INLINE void resize(GLsizei newWidth, GLsizei newHeight)
+		{
+			width = newWidth;
+			height = newHeight;
+
+			color = std::make_unique<Texture>(TextureType::TwoD);
+			color->storage(1, colorFormat, width, height);
+			framebuffer->attachColor(0, *color);
+			framebuffer->setDrawBuffer(GL_COLOR_ATTACHMENT0);
+			framebuffer->setReadBuffer(GL_COLOR_ATTACHMENT0);
+
+			if (depthFormat != GL_NONE)
+			{
+				depth = std::make_unique<Texture>(TextureType::TwoD);
+				depth->storage(1, depthFormat, width, height);
+				framebuffer->attachDepth(*depth);
+			}
+
+			bind();
+		}
+
+		/// @brief Copy the rendered image into data, bottom row first. data must hold width * height pixels of the
+		/// given format and type.
+		GAL_INLINE void readPixels(void* data, GLsizei bufferSize, GLenum format = GL_RGBA, GLenum type = GL_UNSIGNED_BYTE) const
+		{
+			GLint packAlignment;
+			glGetIntegerv(GL_PACK_ALIGNMENT, &packAlignment);
+			glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+			glGetTextureImage(color->getID(), 0, format, type, bufferSize, data);
+
+			glPixelStorei(GL_PACK_ALIGNMENT, packAlignment);
+		}
+
+		GAL_NODISCARD GAL_INLINE GLsizei getWidth() const noexcept { return width; }
+		GAL_NODISCARD GAL_INLINE GLsizei getHeight() const noexcept { return height; }
+
+		GAL_NODISCARD GAL_INLINE Framebuffer& getFramebuffer() noexcept { return *framebuffer; }
+		GAL_NODISCARD GAL_INLINE const Texture& getColorTexture() const noexcept { return *color; }
+
+		/// @brief Get the depth attachment, or nullptr if the context was created without one.
+		GAL_NODISCARD GAL_INLINE const Texture* getDepthTexture() const noexcept { return depth.get(); }
+
+	private:
+#if defined(GAL_HEADLESS_EGL)
+		EGLDisplay display = EGL_NO_DISPLAY;
+		EGLContext context = EGL_NO_CONTEXT;
+#else
+		OSMesaContext context = nullptr;
+		mutable unsigned int dummyBuffer = 0;
+#endif
+
+		GLenum colorFormat;
+		GLenum depthFormat;
+		GLsizei width = 0;
+		GLsizei height = 0;
+
+		std::unique_ptr<Framebuffer> framebuffer;
+		std::unique_ptr<Texture> color;
+		std::unique_ptr<Texture> depth;
+
+		GAL_INLINE bool tryMakeCurrent() const noexcept
+		{
+#if defined(GAL_HEADLESS_EGL)
+			return eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context) == EGL_TRUE;
+#else
+			// OSMesa needs a buffer to be current, but everything is drawn into the framebuffer object instead.
+			return OSMesaMakeCurrent(context, &dummyBuffer, GL_UNSIGNED_BYTE, 1, 1) == GL_TRUE;
+#endif
+		}
+
+		GAL_STATIC GAL_INLINE GLADloadproc loader() noexcept
+		{
+#if defined(GAL_HEADLESS_EGL)
+			return reinterpret_cast<GLADloadproc>(eglGetProcAddress);
+#else
+			return reinterpret_cast<GLADloadproc>(OSMesaGetProcAddress);
+#endif
+		}
+
+		GAL_INLINE void createContext(bool debugContext)
+		{
+#if defined(GAL_HEADLESS_EGL)
+			// eglGetPlatformDisplay is EGL 1.5. Older libraries only have the EXT version, which has to be looked up.
+			auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+			if (getPlatformDisplay != nullptr)
+				display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+
+			{
+				std::lock_guard<std::mutex> lock(detail::headlessDisplayMutex);
+
+				if (display == EGL_NO_DISPLAY || eglInitialize(display, nullptr, nullptr) != EGL_TRUE)
+				{
+					display = EGL_NO_DISPLAY;
+					detail::throwErr(ErrCode::HeadlessContextCreationFailed, "Failed to initialize the surfaceless EGL display.");
+				}
+
+				detail::headlessDisplayUsers++;
+			}
+
+			// No surface is ever created, and the surfaceless platform only offers pbuffer configs, while eglChooseConfig
+			// defaults to window configs.
+			const EGLint configAttributes[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+			EGLConfig config;
+			EGLint configCount = 0;
+
+			if (eglBindAPI(EGL_OPENGL_API) != EGL_TRUE
+				|| eglChooseConfig(display, configAttributes, &config, 1, &configCount) != EGL_TRUE || configCount == 0)
+			{
+				destroyContext();
+				detail::throwErr(ErrCode::HeadlessContextCreationFailed, "No EGL config supports desktop OpenGL.");
+			}
+
+			const EGLint contextAttributes[] = {
+				EGL_CONTEXT_MAJOR_VERSION, detail::openGLVersionMajor,
+				EGL_CONTEXT_MINOR_VERSION, detail::openGLVersionMinor,
+				EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+				EGL_CONTEXT_OPENGL_DEBUG, debugContext ? EGL_TRUE : EGL_FALSE,
+				EGL_NONE
+			};
+
+			context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+			if (context == EGL_NO_CONTEXT)
+			{
+				destroyContext();
+				detail::throwErr(ErrCode::HeadlessContextCreationFailed, "Failed to create EGL context.");
+			}
+#else
+			// OSMesa has no debug context attribute; the GL_CONTEXT_FLAGS check reports it if the driver lacks one.
+			(void)debugContext;
+
+			const int attributes[] = {
+				OSMESA_FORMAT, OSMESA_RGBA,
+				OSMESA_DEPTH_BITS, 0,
+				OSMESA_PROFILE, OSMESA_CORE_PROFILE,
+				OSMESA_CONTEXT_MAJOR_VERSION, detail::openGLVersionMajor,
+				OSMESA_CONTEXT_MINOR_VERSION, detail::openGLVersionMinor,
+				0
+			};
+
+			context = OSMesaCreateContextAttribs(attributes, nullptr);
+			if (context == nullptr)
+				detail::throwErr(ErrCode::HeadlessContextCreationFailed, "Failed to create OSMesa context.");
+#endif
+		}
+
+		/// @brief Destroy the context if there is one, and terminate the EGL display if no other context uses it.
+		GAL_INLINE void destroyContext() noexcept
+		{
+#if defined(GAL_HEADLESS_EGL)
+			if (display == EGL_NO_DISPLAY)
+				return;
+
+			if (context != EGL_NO_CONTEXT)
+			{
+				eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+				eglDestroyContext(display, context);
+				context = EGL_NO_CONTEXT;
+			}
+
+			std::lock_guard<std::mutex> lock(detail::headlessDisplayMutex);
+			if (--detail::headlessDisplayUsers == 0)
+				eglTerminate(display);
+
+			display = EGL_NO_DISPLAY;
+#else
+			if (context != nullptr)
+				OSMesaDestroyContext(context);
+
+			context = nullptr;
+#endif
+		}
+	};
+}
+
+#endif
+
+#endif
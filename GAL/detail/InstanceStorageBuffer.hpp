@@ -0,0 +1,89 @@
+#ifndef GAL_INSTANCE_STORAGE_BUFFER_HPP
+#define GAL_INSTANCE_STORAGE_BUFFER_HPP
+
+#include <algorithm>
+#include <cstddef>
+
+#include "attributes.hpp"
+#include "Buffer.hpp"
+#include "enums.hpp"
+#include "ShaderProgram.hpp"
+
+namespace gal
+{
+	namespace detail
+	{
+		/// @brief A shader storage buffer holding the same number of elements for each of up to maxInstances instances,
+		/// one instance's elements after another, read in GLSL at instance * count + element with the count in a uniform.
+		/// Shared by JointPalette and MorphWeights.
+		class InstanceStorageBuffer
+		{
+		public:
+			/// @brief Allocate room for maxInstances sets of countPerInstance elements of elementSize bytes. Requires a
+			/// current OpenGL context.
+			GAL_INLINE InstanceStorageBuffer(GLuint countPerInstance, GLuint maxInstances, GLsizeiptr elementSize, GLbitfield flags)
+				: buffer(BufferType::ShaderStorage), countPerInstance(countPerInstance), maxInstances(maxInstances),
+				elementSize(elementSize)
+			{
+				const GLsizeiptr size = static_cast<GLsizeiptr>(countPerInstance) * maxInstances * elementSize;
+				buffer.allocateImmutable(std::max(size, elementSize), flags);
+			}
+
+			// Forbid copying.
+			GAL_INLINE InstanceStorageBuffer(const InstanceStorageBuffer&) = delete;
+			GAL_INLINE InstanceStorageBuffer& operator=(const InstanceStorageBuffer&) = delete;
+
+			// Allow moving.
+			GAL_INLINE InstanceStorageBuffer(InstanceStorageBuffer&&) noexcept = default;
+			GAL_INLINE InstanceStorageBuffer& operator=(InstanceStorageBuffer&&) noexcept = default;
+
+			GAL_NODISCARD GAL_INLINE GLuint getCountPerInstance() const noexcept { return countPerInstance; }
+			GAL_NODISCARD GAL_INLINE GLuint getMaxInstances() const noexcept { return maxInstances; }
+			GAL_NODISCARD GAL_INLINE const Buffer& getBuffer() const noexcept { return buffer; }
+			GAL_NODISCARD GAL_INLINE Buffer& getBuffer() noexcept { return buffer; }
+
+			/// @brief Get how many whole instances elementCount elements make up.
+			GAL_NODISCARD GAL_INLINE GLuint getInstanceCount(size_t elementCount) const noexcept
+			{
+				return static_cast<GLuint>(elementCount / std::max(countPerInstance, 1u));
+			}
+
+			/// @brief Get how many elements writing instanceCount instances from firstInstance covers, dropping the
+			/// instances past maxInstances.
+			GAL_NODISCARD GAL_INLINE size_t getWriteCount(GLuint firstInstance, GLuint instanceCount) const noexcept
+			{
+				instanceCount = std::min(instanceCount, maxInstances - std::min(firstInstance, maxInstances));
+				return static_cast<size_t>(instanceCount) * countPerInstance;
+			}
+
+			/// @brief Get the byte offset of an instance's first element.
+			GAL_NODISCARD GAL_INLINE GLintptr getOffset(GLuint instance) const noexcept
+			{
+				return static_cast<GLintptr>(instance) * countPerInstance * elementSize;
+			}
+
+			/// @brief Copy instanceCount instances of elements laid out as in the buffer, starting at firstInstance.
+			GAL_INLINE void write(const void* elements, GLuint firstInstance, GLuint instanceCount)
+			{
+				const size_t elementCount = getWriteCount(firstInstance, instanceCount);
+				if (elementCount != 0)
+					buffer.writeSub(getOffset(firstInstance), static_cast<GLsizeiptr>(elementCount) * elementSize, elements);
+			}
+
+			/// @brief Bind the buffer and set the program's count uniform.
+			GAL_INLINE void bind(const ShaderProgram& program, const char* countUniform, GLuint binding) const
+			{
+				buffer.bindBase(BufferType::ShaderStorage, binding);
+				program.setUniform(countUniform, countPerInstance);
+			}
+
+		private:
+			Buffer buffer;
+			GLuint countPerInstance;
+			GLuint maxInstances;
+			GLsizeiptr elementSize;
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,275 @@
+#ifndef GAL_LOD_MESH_HPP
+#define GAL_LOD_MESH_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Camera.hpp"
+#include "enums.hpp"
+#include "GALException.hpp"
+#include "ShaderProgram.hpp"
+#include "Transform.hpp"
+#include "VertexArray.hpp"
+
+namespace gal
+{
+	/// @brief One level of detail of a LODMesh: a range of a VAO to draw and how large the mesh must appear on screen
+	/// for this level to be used.
+	struct LODLevel
+	{
+		const VertexArray* vao;
+		GLuint first; // First index, or first vertex if the VAO has no element buffer.
+		GLsizei count; // Number of indices, or vertices if the VAO has no element buffer.
+		float screenSize; // Smallest projected size, as a fraction of the viewport height, this level is used at.
+	};
+
+	/// @brief Settings for choosing levels of detail.
+	struct LODSettings
+	{
+		/// @brief How far, as a fraction of a level's screen size, the projected size must pass it before the level
+		/// changes. Stops objects near a threshold from flickering between two levels.
+		float hysteresis = 0.1f;
+
+		/// @brief Multiplies every projected size. Above 1 keeps finer levels further away, below 1 drops them sooner.
+		float bias = 1.0f;
+	};
+
+	/// @brief Get how large a world space bounding sphere (center xyz, radius w) appears through the camera, as the
+	/// fraction of the viewport height its diameter covers. Uses the distance to the sphere rather than its depth, so the
+	/// result doesn't change as the camera turns.
+	GAL_NODISCARD GAL_INLINE float getProjectedScreenSize(const Camera& camera, const glm::vec4& sphere) noexcept
+	{
+		// projection[1][1] is 1 / tan(fovY / 2) for perspective projections and 2 / (top - bottom) for orthographic ones.
+		const float scale = camera.getProjectionMatrix()[1][1];
+		if (camera.isOrthographic())
+			return sphere.w * scale;
+
+		const float distance = glm::length(glm::vec3(sphere) - camera.getPosition());
+		return sphere.w * scale / std::max(distance, sphere.w);
+	}
+
+	/// @brief A mesh with several levels of detail, ordered from the finest to the coarsest. Each level is drawn from
+	/// its own range of a VAO, so the levels can share one VAO with their indices packed into one element buffer, or use
+	/// different VAOs. Levels must share a VAO to be drawn together with getDrawCommand().
+	class LODMesh
+	{
+	public:
+		/// @brief Initialize with no levels and a bounding sphere (center xyz, radius w) in the mesh's local space, which
+		/// should contain every level.
+		GAL_EXPLICIT GAL_INLINE LODMesh(const glm::vec4& boundingSphere)
+			: boundingSphere(boundingSphere) { }
+
+		/// @brief Add the next coarser level. Its screen size must be smaller than the previous level's. The coarsest
+		/// level is also used below its screen size, so 0 is fine there.
+		GAL_INLINE void addLevel(const VertexArray& vao, GLuint first, GLsizei count, float screenSize)
+		{
+			if (!levels.empty() && screenSize >= levels.back().screenSize)
+				detail::throwErr(ErrCode::InvalidLODThreshold, "Added a level of detail whose screen size wasn't smaller than the previous level's.");
+
+			levels.push_back({ &vao, first, count, screenSize });
+		}
+
+		GAL_NODISCARD GAL_INLINE const LODLevel& getLevel(uint32_t level) const
+		{
+			if (level >= levels.size())
+				detail::throwErr(ErrCode::LODLevelOutOfRange, "Attempted to use a level of detail the mesh doesn't have.");
+
+			return levels[level];
+		}
+
+		GAL_NODISCARD GAL_INLINE uint32_t getLevelCount() const noexcept { return static_cast<uint32_t>(levels.size()); }
+
+		GAL_NODISCARD GAL_INLINE const glm::vec4& getBoundingSphere() const noexcept { return boundingSphere; }
+		GAL_INLINE void setBoundingSphere(const glm::vec4& boundingSphere) noexcept { this->boundingSphere = boundingSphere; }
+
+		/// @brief Get the finest level whose screen size the projected size reaches, ignoring hysteresis.
+		GAL_NODISCARD GAL_INLINE uint32_t getLevelForScreenSize(float screenSize) const noexcept
+		{
+			if (levels.empty())
+				return 0;
+
+			uint32_t level = 0;
+			while (level + 1 < levels.size() && screenSize < levels[level].screenSize)
+				++level;
+
+			return level;
+		}
+
+		/// @brief Choose the level to use at the given projected size, given the level used last time. The level only
+		/// gets coarser once the size drops below its screen size by the hysteresis fraction, and only gets finer once
+		/// the size passes the finer level's screen size by the same fraction.
+		GAL_NODISCARD GAL_INLINE uint32_t selectLevel(float screenSize, uint32_t currentLevel, float hysteresis) const noexcept
+		{
+			if (levels.empty())
+				return 0;
+
+			currentLevel = std::min(currentLevel, getLevelCount() - 1);
+
+			const uint32_t coarser = getLevelForScreenSize(screenSize / (1.0f - hysteresis));
+			if (coarser > currentLevel)
+				return coarser;
+
+			const uint32_t finer = getLevelForScreenSize(screenSize / (1.0f + hysteresis));
+			if (finer < currentLevel)
+				return finer;
+
+			return currentLevel;
+		}
+
+		/// @brief Get an indirect draw command drawing instanceCount instances of a level, for multiDrawElementsIndirect.
+		/// Requires the level's VAO to have an element buffer.
+		GAL_NODISCARD GAL_INLINE DrawElementsIndirectCommand getDrawCommand(uint32_t level, GLuint instanceCount, GLuint baseInstance) const
+		{
+			const LODLevel& lod = getLevel(level);
+			return { static_cast<GLuint>(lod.count), instanceCount, lod.first, 0, baseInstance };
+		}
+
+		/// @brief Bind the level's VAO and draw the level.
+		GAL_INLINE void drawAB(uint32_t level, GLenum polygonMode = GL_TRIANGLES) const
+		{
+			getLevel(level).vao->bind();
+			drawNB(level, polygonMode);
+		}
+
+		/// @brief Draw the level, assuming its VAO is bound.
+		GAL_INLINE void drawNB(uint32_t level, GLenum polygonMode = GL_TRIANGLES) const
+		{
+			const LODLevel& lod = getLevel(level);
+
+			if (lod.vao->getElementBuffer() != nullptr)
+			{
+				const GLintptr offset = static_cast<GLintptr>(lod.first) * getIndexSize(lod.vao->getElementBufferIndexType());
+				lod.vao->drawElementsNB(polygonMode, offset, lod.count);
+			}
+			else
+				lod.vao->drawArraysNB(polygonMode, static_cast<GLint>(lod.first), lod.count);
+		}
+
+	private:
+		std::vector<LODLevel> levels;
+		glm::vec4 boundingSphere;
+
+		GAL_NODISCARD GAL_STATIC GAL_INLINE GLintptr getIndexSize(GLenum indexType) noexcept
+		{
+			switch (indexType)
+			{
+			case GL_UNSIGNED_BYTE: return 1;
+			case GL_UNSIGNED_SHORT: return 2;
+			default: return 4;
+			}
+		}
+	};
+
+	/// @brief A single instance of a LODMesh. Remembers the level it was last drawn at so that level changes can lag
+	/// behind the projected size.
+	struct LODMeshInstance
+	{
+	public:
+		const LODMesh& mesh;
+		Transform transform;
+		uint32_t level = 0;
+
+		/// @brief Initialize an instance with the default transform.
+		GAL_INLINE LODMeshInstance(const LODMesh& mesh)
+			: mesh(mesh), transform() { }
+
+		/// @brief Initialize an instance with a given transform.
+		GAL_INLINE LODMeshInstance(const LODMesh& mesh, const Transform& transform)
+			: mesh(mesh), transform(transform) { }
+
+		/// @brief Get the mesh's bounding sphere moved into world space by the transform. Non-uniform scales grow the
+		/// radius by the largest scale factor.
+		GAL_NODISCARD GAL_INLINE glm::vec4 getWorldBoundingSphere() const noexcept
+		{
+			const glm::vec4& sphere = mesh.getBoundingSphere();
+			const glm::vec3 center = glm::vec3(transform.getModelMatrix() * glm::vec4(glm::vec3(sphere), 1.0f));
+			const glm::vec3 scale = transform.getScale();
+			const float maxScale = std::max(std::abs(scale.x), std::max(std::abs(scale.y), std::abs(scale.z)));
+
+			return glm::vec4(center, sphere.w * maxScale);
+		}
+
+		/// @brief Choose the level to draw at from how large the instance appears through the camera.
+		GAL_INLINE void updateLevel(const Camera& camera, const LODSettings& settings = LODSettings()) noexcept
+		{
+			const float screenSize = getProjectedScreenSize(camera, getWorldBoundingSphere()) * settings.bias;
+			level = mesh.selectLevel(screenSize, level, settings.hysteresis);
+		}
+
+		/// @brief Set the model matrix in the given shader and then bind the level's VAO and draw it.
+		GAL_INLINE void drawAB(const ShaderProgram& shader, const std::string& modelMatrixUniformName) const
+		{
+			shader.setUniform(modelMatrixUniformName, transform.getModelMatrix());
+			mesh.drawAB(level);
+		}
+
+		/// @brief Set the model matrix in the given shader and then draw the level, assuming its VAO is bound.
+		GAL_INLINE void drawNB(const ShaderProgram& shader, const std::string& modelMatrixUniformName) const
+		{
+			shader.setUniform(modelMatrixUniformName, transform.getModelMatrix());
+			mesh.drawNB(level);
+		}
+	};
+
+	/// @brief Update the level of count instances from how large they appear through the camera.
+	GAL_INLINE void selectLODs(const Camera& camera, LODMeshInstance* instances, size_t count, const LODSettings& settings = LODSettings())
+	{
+		for (size_t i = 0; i < count; ++i)
+			instances[i].updateLevel(camera, settings);
+	}
+
+	/// @brief Instances of one LODMesh grouped by level, ready to be drawn instanced with one indirect command per level.
+	struct LODBatch
+	{
+		/// @brief Instance indices ordered by level. Write per-instance data in this order so each command's instances
+		/// are contiguous.
+		std::vector<uint32_t> instanceIndices;
+
+		/// @brief Where each level's instances start in instanceIndices, plus the total count at the end.
+		std::vector<uint32_t> levelOffsets;
+
+		/// @brief One command per level with instances, with baseInstance pointing at its first entry in instanceIndices.
+		std::vector<DrawElementsIndirectCommand> commands;
+	};
+
+	/// @brief Group count instances of the mesh, given by index into instances (e.g. the visible ones after culling), by
+	/// their current level. Levels must share a VAO with an element buffer to draw the commands in one call.
+	GAL_INLINE void buildLODBatch(const LODMesh& mesh, const LODMeshInstance* instances, const uint32_t* indices, size_t count,
+		LODBatch& batch)
+	{
+		const uint32_t levelCount = mesh.getLevelCount();
+		batch.commands.clear();
+
+		if (levelCount == 0)
+		{
+			batch.instanceIndices.clear();
+			batch.levelOffsets.clear();
+			return;
+		}
+
+		// Counting sort: count each level, turn the counts into offsets, then place the indices.
+		batch.levelOffsets.assign(levelCount + 1, 0);
+		for (size_t i = 0; i < count; ++i)
+			batch.levelOffsets[std::min(instances[indices[i]].level, levelCount - 1) + 1]++;
+
+		for (uint32_t level = 0; level < levelCount; ++level)
+			batch.levelOffsets[level + 1] += batch.levelOffsets[level];
+
+		std::vector<uint32_t> next(batch.levelOffsets.begin(), batch.levelOffsets.end() - 1);
+		batch.instanceIndices.resize(count);
+		for (size_t i = 0; i < count; ++i)
+			batch.instanceIndices[next[std::min(instances[indices[i]].level, levelCount - 1)]++] = indices[i];
+
+		for (uint32_t level = 0; level < levelCount; ++level)
+		{
+			const uint32_t instanceCount = batch.levelOffsets[level + 1] - batch.levelOffsets[level];
+			if (instanceCount != 0)
+				batch.commands.push_back(mesh.getDrawCommand(level, instanceCount, batch.levelOffsets[level]));
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef GAL_MAPPED_FILE_HPP
+#define GAL_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "attributes.hpp"
+#include "enums.hpp"
+#include "GALException.hpp"
+
+#ifdef _WIN32
+// The few Win32 functions MappedFile needs, declared exactly as windows.h does so the two can be included together,
+// instead of including windows.h and its near, far, min, max and other macros into every file including GAL.
+struct _SECURITY_ATTRIBUTES;
+
+extern "C"
+{
+	__declspec(dllimport) void* __stdcall CreateFileA(const char* fileName, unsigned long desiredAccess, unsigned long shareMode,
+		_SECURITY_ATTRIBUTES* securityAttributes, unsigned long creationDisposition, unsigned long flagsAndAttributes, void* templateFile);
+	__declspec(dllimport) unsigned long __stdcall GetFileSize(void* file, unsigned long* fileSizeHigh);
+	__declspec(dllimport) void* __stdcall CreateFileMappingA(void* file, _SECURITY_ATTRIBUTES* attributes, unsigned long protect,
+		unsigned long maximumSizeHigh, unsigned long maximumSizeLow, const char* name);
+#ifdef _WIN64
+	__declspec(dllimport) void* __stdcall MapViewOfFile(void* fileMapping, unsigned long desiredAccess, unsigned long fileOffsetHigh,
+		unsigned long fileOffsetLow, unsigned long long numberOfBytesToMap);
+#else
+	__declspec(dllimport) void* __stdcall MapViewOfFile(void* fileMapping, unsigned long desiredAccess, unsigned long fileOffsetHigh,
+		unsigned long fileOffsetLow, unsigned long numberOfBytesToMap);
+#endif
+	__declspec(dllimport) int __stdcall UnmapViewOfFile(const void* baseAddress);
+	__declspec(dllimport) int __stdcall CloseHandle(void* object);
+}
+#endif
+
+namespace gal
+{
+	namespace detail
+	{
+		/// @brief A whole file mapped read-only into memory. Pages are read from disk on first touch, so large files can be
+		/// handed straight to OpenGL without being copied into a buffer first.
+		class MappedFile
+		{
+		public:
+			/// @brief Map the file at the given path. Throws ErrCode::TextureFileReadFailed if it can't be opened or mapped.
+			GAL_EXPLICIT GAL_INLINE MappedFile(const std::string& path)
+			{
+#ifdef _WIN32
+				file = ::CreateFileA(path.c_str(), GenericRead, FileShareRead, nullptr, OpenExisting,
+					FileAttributeNormal | FileFlagSequentialScan, nullptr);
+				if (file == invalidHandle())
+					throwErr(ErrCode::TextureFileReadFailed, "Could not open file for mapping.");
+
+				unsigned long sizeHigh = 0;
+				const unsigned long sizeLow = ::GetFileSize(file, &sizeHigh);
+				const unsigned long long fileSize = static_cast<unsigned long long>(sizeHigh) << 32 | sizeLow;
+				size = static_cast<size_t>(fileSize);
+
+				// A file too large for the address space can't be mapped whole.
+				if (size != 0 && size == fileSize)
+				{
+					mapping = ::CreateFileMappingA(file, nullptr, PageReadOnly, 0, 0, nullptr);
+					if (mapping != nullptr)
+						data = static_cast<const unsigned char*>(::MapViewOfFile(mapping, FileMapRead, 0, 0, 0));
+				}
+#else
+				fd = open(path.c_str(), O_RDONLY);
+				if (fd < 0)
+					throwErr(ErrCode::TextureFileReadFailed, "Could not open file for mapping.");
+
+				struct stat status;
+				fstat(fd, &status);
+				size = static_cast<size_t>(status.st_size);
+
+				if (size != 0)
+				{
+					void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+					if (mapped != MAP_FAILED)
+						data = static_cast<const unsigned char*>(mapped);
+				}
+#endif
+				if (data == nullptr)
+				{
+					close();
+					throwErr(ErrCode::TextureFileReadFailed, "Could not map file into memory.");
+				}
+			}
+
+			// Forbid copying.
+			GAL_INLINE MappedFile(const MappedFile&) = delete;
+			GAL_INLINE MappedFile& operator=(const MappedFile&) = delete;
+
+			GAL_INLINE ~MappedFile() { close(); }
+
+			GAL_NODISCARD GAL_INLINE const unsigned char* getData() const noexcept { return data; }
+			GAL_NODISCARD GAL_INLINE size_t getSize() const noexcept { return size; }
+
+		private:
+			const unsigned char* data = nullptr;
+			size_t size = 0;
+
+#ifdef _WIN32
+			// The values of the windows.h macros of the same names.
+			GAL_STATIC GAL_CONSTEXPR unsigned long GenericRead = 0x80000000ul;
+			GAL_STATIC GAL_CONSTEXPR unsigned long FileShareRead = 0x1;
+			GAL_STATIC GAL_CONSTEXPR unsigned long OpenExisting = 3;
+			GAL_STATIC GAL_CONSTEXPR unsigned long FileAttributeNormal = 0x80;
+			GAL_STATIC GAL_CONSTEXPR unsigned long FileFlagSequentialScan = 0x08000000;
+			GAL_STATIC GAL_CONSTEXPR unsigned long PageReadOnly = 0x2;
+			GAL_STATIC GAL_CONSTEXPR unsigned long FileMapRead = 0x4;
+
+			void* file = invalidHandle();
+			void* mapping = nullptr;
+
+			GAL_NODISCARD GAL_STATIC GAL_INLINE void* invalidHandle() noexcept { return reinterpret_cast<void*>(~std::uintptr_t(0)); }
+#else
+			int fd = -1;
+#endif
+
+			GAL_INLINE void close() noexcept
+			{
+#ifdef _WIN32
+				if (data != nullptr)
+					::UnmapViewOfFile(data);
+				if (mapping != nullptr)
+					::CloseHandle(mapping);
+				if (file != invalidHandle())
+					::CloseHandle(file);
+#else
+				if (data != nullptr)
+					munmap(const_cast<unsigned char*>(data), size);
+				if (fd >= 0)
+					::close(fd);
+#endif
+				data = nullptr;
+			}
+		};
+	}
+}
+
+#endif
@@ -1,6 +1,13 @@
 #ifndef GAL_MESH_INSTANCE_HPP
 #define GAL_MESH_INSTANCE_HPP
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "Frustum.hpp"
 #include "ShaderProgram.hpp"
 #include "Transform.hpp"
 #include "VertexArray.hpp"
@@ -13,14 +20,30 @@ namespace gal
 	public:
 		const VertexArray& vao;
 		Transform transform;
+		glm::vec4 boundingSphere; // Center (xyz) and radius (w) in the mesh's local space. A negative radius is never culled.
 
 		/// @brief Initialize a mesh instance with the default transform. 
 		GAL_INLINE MeshInstance(const VertexArray& vao)
-			: vao(vao), transform() { }
+			: vao(vao), transform(), boundingSphere(0.0f, 0.0f, 0.0f, -1.0f) { }
 
 		/// @brief Initialize a mesh instance with a given transform.
 		GAL_INLINE MeshInstance(const VertexArray& vao, const Transform& transform)
-			: vao(vao), transform(transform) { }
+			: vao(vao), transform(transform), boundingSphere(0.0f, 0.0f, 0.0f, -1.0f) { }
+
+		/// @brief Initialize a mesh instance with a given transform and a bounding sphere for culling.
+		GAL_INLINE MeshInstance(const VertexArray& vao, const Transform& transform, const glm::vec4& boundingSphere)
+			: vao(vao), transform(transform), boundingSphere(boundingSphere) { }
+
+		/// @brief Get the bounding sphere moved into world space by the transform. Non-uniform scales grow the radius by
+		/// the largest scale factor.
+		GAL_NODISCARD GAL_INLINE glm::vec4 getWorldBoundingSphere() const noexcept
+		{
+			const glm::vec3 center = glm::vec3(transform.getModelMatrix() * glm::vec4(glm::vec3(boundingSphere), 1.0f));
+			const glm::vec3 scale = transform.getScale();
+			const float maxScale = std::max(std::abs(scale.x), std::max(std::abs(scale.y), std::abs(scale.z)));
+
+			return glm::vec4(center, boundingSphere.w * maxScale);
+		}
 
 		/// @brief Set the model matrix in the given shader and then bind and draw the VAO.
 		GAL_INLINE void drawAB(const ShaderProgram& shader, const std::string& modelMatrixUniformName) const
@@ -36,6 +59,33 @@ namespace gal
 			vao.drawNB();
 		}
 	};
+
+	/// @brief Write the indices of the instances whose world space bounding sphere intersects the frustum into
+	/// visibleIndices, replacing its contents, so only those are drawn. Instances without a bounding sphere are always
+	/// visible.
+	GAL_INLINE void cullMeshInstances(const Frustum& frustum, const MeshInstance* instances, size_t count,
+		std::vector<uint32_t>& visibleIndices)
+	{
+		std::vector<float> spheres(count * 4);
+		float* const centerX = spheres.data();
+		float* const centerY = centerX + count;
+		float* const centerZ = centerY + count;
+		float* const radius = centerZ + count;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const glm::vec4 sphere = instances[i].getWorldBoundingSphere();
+			centerX[i] = sphere.x;
+			centerY[i] = sphere.y;
+			centerZ[i] = sphere.z;
+
+			// An unbounded instance becomes a sphere no plane can reject.
+			radius[i] = sphere.w < 0.0f ? std::numeric_limits<float>::infinity() : sphere.w;
+		}
+
+		visibleIndices.resize(count);
+		visibleIndices.resize(frustum.cullSpheres(centerX, centerY, centerZ, radius, count, visibleIndices.data()));
+	}
 }
 
 #endif
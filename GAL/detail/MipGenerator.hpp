@@ -0,0 +1,375 @@
+#ifndef GAL_MIP_GENERATOR_HPP
+#define GAL_MIP_GENERATOR_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "attributes.hpp"
+#include "parallel.hpp"
+#include "simd.hpp"
+#include "Texture.hpp"
+
+namespace gal
+{
+	/// @brief Tightly packed 8-bit RGBA pixels, e.g. as produced by a TextureStreamer decoder or one mip level.
+	struct DecodedImage
+	{
+		int width = 0;
+		int height = 0;
+		std::vector<unsigned char> pixels; // width * height * 4 bytes, first row first.
+	};
+
+	/// @brief Filter used to build each mip level from the one above it.
+	enum class MipFilter
+	{
+		Box, // Average of the texels each output texel covers. Fast and never rings.
+		Kaiser // Kaiser windowed sinc. Sharper, at the cost of slight ringing, which is clamped away.
+	};
+
+	/// @brief How the alpha channel of the images passed to generateMipLevels() is treated.
+	enum class MipAlphaMode
+	{
+		Straight, // Color is weighted by alpha while filtering so transparent texels don't bleed into opaque ones.
+		Premultiplied, // Color is already premultiplied by alpha and is filtered as is.
+		Independent // Alpha is filtered like any other channel, e.g. when it holds unrelated data.
+	};
+
+	/// @brief Settings for generateMipLevels().
+	struct MipSettings
+	{
+		MipFilter filter = MipFilter::Box;
+		MipAlphaMode alphaMode = MipAlphaMode::Straight;
+		bool srgb = true; // RGB is sRGB encoded, so filter in linear space. Alpha is always linear.
+		unsigned threadCount = 0; // 0 uses every hardware thread.
+	};
+
+	namespace detail
+	{
+		/// @brief A float RGBA image in linear space, used between mip levels so no precision is lost to rounding.
+		struct LinearImage
+		{
+			int width = 0;
+			int height = 0;
+			std::vector<float> texels; // width * height * 4.
+		};
+
+		/// @brief Source texel indices and weights for each output texel of a 1D resampling pass.
+		struct FilterTaps
+		{
+			int tapCount = 0; // Taps per output texel. Unused taps have zero weight.
+			std::vector<int> indices; // Already clamped to the source.
+			std::vector<float> weights; // Normalized to sum to 1.
+		};
+
+		GAL_NODISCARD GAL_INLINE float besselI0(float x) noexcept
+		{
+			float sum = 1.0f, term = 1.0f;
+			for (int k = 1; k < 16; ++k)
+			{
+				term *= (x / (2.0f * k)) * (x / (2.0f * k));
+				sum += term;
+			}
+
+			return sum;
+		}
+
+		GAL_NODISCARD GAL_INLINE FilterTaps buildFilterTaps(MipFilter filter, int sourceSize, int destinationSize)
+		{
+			constexpr float kaiserRadius = 2.0f; // In destination texels.
+			constexpr float kaiserAlpha = 4.0f;
+
+			const float scale = static_cast<float>(sourceSize) / destinationSize;
+			const float radius = filter == MipFilter::Box ? scale * 0.5f : kaiserRadius * scale;
+
+			FilterTaps taps;
+			taps.tapCount = static_cast<int>(std::ceil(radius * 2.0f)) + 1;
+			taps.indices.assign(static_cast<size_t>(taps.tapCount) * destinationSize, 0);
+			taps.weights.assign(taps.indices.size(), 0.0f);
+
+			for (int i = 0; i < destinationSize; ++i)
+			{
+				const float start = i * scale;
+				const float end = start + scale;
+				const float center = (i + 0.5f) * scale;
+				const int first = static_cast<int>(std::floor(center - radius));
+
+				float total = 0.0f;
+				for (int t = 0; t < taps.tapCount; ++t)
+				{
+					const int j = first + t;
+					float weight;
+
+					if (filter == MipFilter::Box)
+					{
+						// Overlap of source texel [j, j + 1) with the output texel's footprint, which handles NPOT sizes.
+						weight = std::max(0.0f, std::min(j + 1.0f, end) - std::max(static_cast<float>(j), start));
+					}
+					else
+					{
+						const float x = (j + 0.5f - center) / scale;
+						if (std::abs(x) >= kaiserRadius)
+						{
+							weight = 0.0f;
+						}
+						else
+						{
+							const float pix = 3.14159265f * x;
+							const float sinc = x == 0.0f ? 1.0f : std::sin(pix) / pix;
+							const float window = x / kaiserRadius;
+							weight = sinc * besselI0(kaiserAlpha * std::sqrt(1.0f - window * window)) / besselI0(kaiserAlpha);
+						}
+					}
+
+					const size_t slot = static_cast<size_t>(i) * taps.tapCount + t;
+					taps.indices[slot] = std::clamp(j, 0, sourceSize - 1);
+					taps.weights[slot] = weight;
+					total += weight;
+				}
+
+				for (int t = 0; t < taps.tapCount; ++t)
+					taps.weights[static_cast<size_t>(i) * taps.tapCount + t] /= total;
+			}
+
+			return taps;
+		}
+
+		/// @brief Resample each row of the source to the given width.
+		GAL_INLINE void filterRows(const LinearImage& source, LinearImage& destination, const FilterTaps& taps, unsigned threadCount)
+		{
+			parallelFor(static_cast<size_t>(source.height), threadCount, [&](size_t begin, size_t end)
+			{
+				for (size_t y = begin; y < end; ++y)
+				{
+					const float* sourceRow = source.texels.data() + y * source.width * 4;
+					float* destinationRow = destination.texels.data() + y * destination.width * 4;
+
+					for (int x = 0; x < destination.width; ++x)
+					{
+						const int* indices = taps.indices.data() + static_cast<size_t>(x) * taps.tapCount;
+						const float* weights = taps.weights.data() + static_cast<size_t>(x) * taps.tapCount;
+
+#ifdef GAL_SIMD_SSE2
+						// One RGBA texel per register.
+						__m128 sum = _mm_setzero_ps();
+						for (int t = 0; t < taps.tapCount; ++t)
+							sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[t]), _mm_loadu_ps(sourceRow + indices[t] * 4)));
+
+						_mm_storeu_ps(destinationRow + x * 4, sum);
+#else
+						float sum[4] = {};
+						for (int t = 0; t < taps.tapCount; ++t)
+						{
+							for (int c = 0; c < 4; ++c)
+								sum[c] += weights[t] * sourceRow[indices[t] * 4 + c];
+						}
+
+						std::copy(sum, sum + 4, destinationRow + x * 4);
+#endif
+					}
+				}
+			}, 4);
+		}
+
+		/// @brief Resample the columns of the source to the given height. Rows are blended whole, so this vectorizes
+		/// across the row regardless of channel layout.
+		GAL_INLINE void filterColumns(const LinearImage& source, LinearImage& destination, const FilterTaps& taps, unsigned threadCount)
+		{
+			const size_t rowFloats = static_cast<size_t>(source.width) * 4;
+
+			parallelFor(static_cast<size_t>(destination.height), threadCount, [&](size_t begin, size_t end)
+			{
+				for (size_t y = begin; y < end; ++y)
+				{
+					const int* indices = taps.indices.data() + y * taps.tapCount;
+					const float* weights = taps.weights.data() + y * taps.tapCount;
+					float* destinationRow = destination.texels.data() + y * rowFloats;
+
+					size_t i = 0;
+#if defined(GAL_SIMD_AVX2)
+					for (; i + 8 <= rowFloats; i += 8)
+					{
+						__m256 sum = _mm256_setzero_ps();
+						for (int t = 0; t < taps.tapCount; ++t)
+						{
+							const __m256 texels = _mm256_loadu_ps(source.texels.data() + indices[t] * rowFloats + i);
+							sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(weights[t]), texels));
+						}
+
+						_mm256_storeu_ps(destinationRow + i, sum);
+					}
+#elif defined(GAL_SIMD_SSE2)
+					for (; i + 4 <= rowFloats; i += 4)
+					{
+						__m128 sum = _mm_setzero_ps();
+						for (int t = 0; t < taps.tapCount; ++t)
+						{
+							const __m128 texels = _mm_loadu_ps(source.texels.data() + indices[t] * rowFloats + i);
+							sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[t]), texels));
+						}
+
+						_mm_storeu_ps(destinationRow + i, sum);
+					}
+#endif
+					for (; i < rowFloats; ++i)
+					{
+						float sum = 0.0f;
+						for (int t = 0; t < taps.tapCount; ++t)
+							sum += weights[t] * source.texels[indices[t] * rowFloats + i];
+
+						destinationRow[i] = sum;
+					}
+				}
+			}, 4);
+		}
+
+		/// @brief sRGB to linear lookup for every 8-bit value.
+		GAL_NODISCARD GAL_INLINE const float* srgbToLinearTable() noexcept
+		{
+			static const std::vector<float> table = []
+			{
+				std::vector<float> values(256);
+				for (int i = 0; i < 256; ++i)
+				{
+					const float c = i / 255.0f;
+					values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+				}
+				return values;
+			}();
+
+			return table.data();
+		}
+
+		constexpr int linearToSrgbTableSize = 4096;
+
+		/// @brief Linear to 8-bit sRGB lookup, indexed by the linear value scaled to [0, linearToSrgbTableSize - 1].
+		GAL_NODISCARD GAL_INLINE const unsigned char* linearToSrgbTable() noexcept
+		{
+			static const std::vector<unsigned char> table = []
+			{
+				std::vector<unsigned char> values(linearToSrgbTableSize);
+				for (int i = 0; i < linearToSrgbTableSize; ++i)
+				{
+					const float l = static_cast<float>(i) / (linearToSrgbTableSize - 1);
+					const float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+					values[i] = static_cast<unsigned char>(std::clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f);
+				}
+				return values;
+			}();
+
+			return table.data();
+		}
+
+		GAL_NODISCARD GAL_INLINE LinearImage toLinearImage(const DecodedImage& image, const MipSettings& settings)
+		{
+			LinearImage linear;
+			linear.width = image.width;
+			linear.height = image.height;
+			linear.texels.resize(image.pixels.size());
+
+			const float* toLinear = srgbToLinearTable();
+			const bool weightByAlpha = settings.alphaMode == MipAlphaMode::Straight;
+
+			parallelFor(static_cast<size_t>(image.width) * image.height, settings.threadCount, [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					const unsigned char* pixel = image.pixels.data() + i * 4;
+					float* texel = linear.texels.data() + i * 4;
+
+					const float alpha = pixel[3] / 255.0f;
+					const float weight = weightByAlpha ? alpha : 1.0f;
+
+					for (int c = 0; c < 3; ++c)
+						texel[c] = (settings.srgb ? toLinear[pixel[c]] : pixel[c] / 255.0f) * weight;
+					texel[3] = alpha;
+				}
+			}, 4096);
+
+			return linear;
+		}
+
+		GAL_NODISCARD GAL_INLINE DecodedImage toDecodedImage(const LinearImage& linear, const MipSettings& settings)
+		{
+			DecodedImage image;
+			image.width = linear.width;
+			image.height = linear.height;
+			image.pixels.resize(linear.texels.size());
+
+			const unsigned char* toSrgb = linearToSrgbTable();
+			const bool weightedByAlpha = settings.alphaMode == MipAlphaMode::Straight;
+
+			parallelFor(static_cast<size_t>(linear.width) * linear.height, settings.threadCount, [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					const float* texel = linear.texels.data() + i * 4;
+					unsigned char* pixel = image.pixels.data() + i * 4;
+
+					const float alpha = std::clamp(texel[3], 0.0f, 1.0f);
+					const float unweight = weightedByAlpha && alpha > 0.0f ? 1.0f / alpha : 1.0f;
+
+					for (int c = 0; c < 3; ++c)
+					{
+						const float value = std::clamp(texel[c] * unweight, 0.0f, 1.0f);
+						pixel[c] = settings.srgb ? toSrgb[static_cast<int>(value * (linearToSrgbTableSize - 1) + 0.5f)]
+							: static_cast<unsigned char>(value * 255.0f + 0.5f);
+					}
+					pixel[3] = static_cast<unsigned char>(alpha * 255.0f + 0.5f);
+				}
+			}, 4096);
+
+			return image;
+		}
+	}
+
+	/// @brief Build every mip level below the given image on the CPU, down to 1x1.
+	/// Each level is filtered from the float result of the one above, so rounding doesn't accumulate. Sizes follow
+	/// OpenGL's rule of halving and rounding down, and non-power-of-two sizes are filtered by texel coverage rather than
+	/// dropping rows and columns. Filtering is separable, vectorized with SSE2/AVX2 where available, and split across
+	/// threads, so it can run at load time off the render thread or offline before caching to disk.
+	/// @return Levels 1 onwards, largest first. Pair with uploadMipChain().
+	GAL_NODISCARD GAL_INLINE std::vector<DecodedImage> generateMipLevels(const DecodedImage& base, const MipSettings& settings = {})
+	{
+		std::vector<DecodedImage> levels;
+		detail::LinearImage current = detail::toLinearImage(base, settings);
+
+		while (current.width > 1 || current.height > 1)
+		{
+			const int width = std::max(current.width / 2, 1);
+			const int height = std::max(current.height / 2, 1);
+
+			detail::LinearImage rows;
+			rows.width = width;
+			rows.height = current.height;
+			rows.texels.resize(static_cast<size_t>(width) * current.height * 4);
+			detail::filterRows(current, rows, detail::buildFilterTaps(settings.filter, current.width, width), settings.threadCount);
+
+			detail::LinearImage next;
+			next.width = width;
+			next.height = height;
+			next.texels.resize(static_cast<size_t>(width) * height * 4);
+			detail::filterColumns(rows, next, detail::buildFilterTaps(settings.filter, current.height, height), settings.threadCount);
+
+			levels.push_back(detail::toDecodedImage(next, settings));
+			current = std::move(next);
+		}
+
+		return levels;
+	}
+
+	/// @brief Allocate immutable storage for the base level and its mips and upload them all.
+	/// @param texture: A TextureType::TwoD texture with no storage yet.
+	/// @param internalFormat: Usually GL_SRGB8_ALPHA8 or GL_RGBA8, matching MipSettings::srgb.
+	GAL_INLINE void uploadMipChain(Texture& texture, const DecodedImage& base, const std::vector<DecodedImage>& mips,
+		GLenum internalFormat = GL_SRGB8_ALPHA8)
+	{
+		texture.storage(static_cast<GLint>(mips.size()) + 1, internalFormat, base.width, base.height);
+		texture.subImage(0, GL_RGBA, GL_UNSIGNED_BYTE, base.pixels.data(), base.width, base.height);
+
+		for (size_t i = 0; i < mips.size(); ++i)
+			texture.subImage(static_cast<GLint>(i) + 1, GL_RGBA, GL_UNSIGNED_BYTE, mips[i].pixels.data(), mips[i].width, mips[i].height);
+	}
+}
+
+#endif
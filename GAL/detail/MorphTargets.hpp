@@ -0,0 +1,226 @@
+#ifndef GAL_MORPH_TARGETS_HPP
+#define GAL_MORPH_TARGETS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "attributes.hpp"
+#include "Buffer.hpp"
+#include "enums.hpp"
+#include "GALException.hpp"
+#include "InstanceStorageBuffer.hpp"
+#include "PixelConversion.hpp"
+#include "ShaderPreprocessor.hpp"
+#include "ShaderProgram.hpp"
+
+namespace gal
+{
+	/// @brief GLSL morph target evaluation against a MorphTargetSet and MorphWeights, included as
+	/// <gal/morph_targets.glsl> (see addShaderIncludeSource()).
+	///
+	/// galApplyMorphTargets(vertex, instance, position, normal) adds the weighted deltas of every target moving the
+	/// vertex. Pass gl_VertexID as the vertex and gl_InstanceID as the instance. When drawing with a base vertex or base
+	/// instance, subtract gl_BaseVertex from the vertex and add gl_BaseInstance to the instance, which needs GLSL 4.60 or
+	/// ARB_shader_draw_parameters. Apply morph targets before skinning.
+	GAL_INLINE const char* const morphTargetShaderSource = R"(
+#ifndef GAL_MORPH_TARGET_BINDING
+#define GAL_MORPH_TARGET_BINDING 5
+#endif
+#ifndef GAL_MORPH_WEIGHT_BINDING
+#define GAL_MORPH_WEIGHT_BINDING 6
+#endif
+
+// vertexCount + 1 offsets to each vertex's first delta, then 4 uints per delta: the target and 6 half float components.
+layout(std430, binding = GAL_MORPH_TARGET_BINDING) readonly buffer GALMorphTargets { uint galMorphData[]; };
+
+// Every target's weight for one instance after another.
+layout(std430, binding = GAL_MORPH_WEIGHT_BINDING) readonly buffer GALMorphWeights { float galMorphWeights[]; };
+
+uniform uint galMorphTargetCount;
+
+void galApplyMorphTargets(uint vertex, uint instance, inout vec3 position, inout vec3 normal)
+{
+	uint firstWeight = instance * galMorphTargetCount;
+	uint end = galMorphData[vertex + 1];
+
+	for (uint i = galMorphData[vertex]; i < end; i += 4)
+	{
+		float weight = galMorphWeights[firstWeight + galMorphData[i]];
+		if (weight == 0.0)
+			continue;
+
+		vec2 positionXY = unpackHalf2x16(galMorphData[i + 1]);
+		vec2 positionZNormalX = unpackHalf2x16(galMorphData[i + 2]);
+		vec2 normalYZ = unpackHalf2x16(galMorphData[i + 3]);
+		position += vec3(positionXY, positionZNormalX.x) * weight;
+		normal += vec3(positionZNormalX.y, normalYZ) * weight;
+	}
+}
+)";
+
+	/// @brief How far one morph target moves one vertex's position and normal.
+	struct MorphTargetDelta
+	{
+		uint32_t vertex;
+		glm::vec3 position;
+		glm::vec3 normal;
+	};
+
+	/// @brief Get the sparse deltas of a morph target from a delta per vertex, dropping vertices it moves by no more than
+	/// epsilon in any component. normalDeltas may be null if the target doesn't change normals.
+	GAL_NODISCARD GAL_INLINE std::vector<MorphTargetDelta> makeSparseMorphTarget(const glm::vec3* positionDeltas,
+		const glm::vec3* normalDeltas, size_t vertexCount, float epsilon = 1e-6f)
+	{
+		std::vector<MorphTargetDelta> deltas;
+
+		for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+		{
+			const glm::vec3 position = positionDeltas[vertex];
+			const glm::vec3 normal = normalDeltas != nullptr ? normalDeltas[vertex] : glm::vec3(0.0f);
+
+			bool moved = false;
+			for (int i = 0; i < 3; ++i)
+				moved = moved || std::abs(position[i]) > epsilon || std::abs(normal[i]) > epsilon;
+
+			if (moved)
+				deltas.push_back({ static_cast<uint32_t>(vertex), position, normal });
+		}
+
+		return deltas;
+	}
+
+	/// @brief The morph targets (blend shapes) of one mesh, stored sparsely in a shader storage buffer laid out for
+	/// morphTargetShaderSource. Deltas are grouped by vertex so each vertex only visits the targets that move it, and are
+	/// stored as half floats. The buffer never changes after construction: animate with MorphWeights.
+	class MorphTargetSet
+	{
+	public:
+		/// @brief The binding morphTargetShaderSource reads the deltas from unless GAL_MORPH_TARGET_BINDING is defined.
+		GAL_STATIC GAL_CONSTEXPR GLuint DefaultBinding = 5;
+
+		/// @brief Upload the sparse deltas of each target of a mesh with vertexCount vertices. Requires a current OpenGL
+		/// context.
+		GAL_INLINE MorphTargetSet(GLuint vertexCount, const std::vector<std::vector<MorphTargetDelta>>& targets)
+			: buffer(BufferType::ShaderStorage), vertexCount(vertexCount), targetCount(static_cast<GLuint>(targets.size())),
+			deltaCount(0)
+		{
+			// Counting sort by vertex: count each vertex's deltas, turn the counts into offsets, then place the deltas.
+			std::vector<uint32_t> data(static_cast<size_t>(vertexCount) + 1, 0);
+			for (const std::vector<MorphTargetDelta>& target : targets)
+			{
+				for (const MorphTargetDelta& delta : target)
+				{
+					if (delta.vertex >= vertexCount)
+						detail::throwErr(ErrCode::InvalidMorphTarget, "A morph target moved a vertex the mesh doesn't have.");
+
+					data[delta.vertex + 1]++;
+					deltaCount++;
+				}
+			}
+
+			// Offsets index galMorphData directly, so they start after the offsets themselves and step 4 per delta.
+			data[0] = vertexCount + 1;
+			for (GLuint vertex = 0; vertex < vertexCount; ++vertex)
+				data[vertex + 1] = data[vertex] + data[vertex + 1] * 4;
+
+			std::vector<uint32_t> next(data.begin(), data.end() - 1);
+			data.resize(data.size() + static_cast<size_t>(deltaCount) * 4);
+
+			for (GLuint target = 0; target < targetCount; ++target)
+			{
+				for (const MorphTargetDelta& delta : targets[target])
+				{
+					uint32_t* packed = data.data() + next[delta.vertex];
+					next[delta.vertex] += 4;
+
+					packed[0] = target;
+					packed[1] = packHalf2(delta.position.x, delta.position.y);
+					packed[2] = packHalf2(delta.position.z, delta.normal.x);
+					packed[3] = packHalf2(delta.normal.y, delta.normal.z);
+				}
+			}
+
+			buffer.allocateImmutable(static_cast<GLsizeiptr>(data.size() * sizeof(uint32_t)), data.data(), 0);
+		}
+
+		// Forbid copying.
+		GAL_INLINE MorphTargetSet(const MorphTargetSet&) = delete;
+		GAL_INLINE MorphTargetSet& operator=(const MorphTargetSet&) = delete;
+
+		// Allow moving.
+		GAL_INLINE MorphTargetSet(MorphTargetSet&&) noexcept = default;
+		GAL_INLINE MorphTargetSet& operator=(MorphTargetSet&&) noexcept = default;
+
+		GAL_NODISCARD GAL_INLINE GLuint getVertexCount() const noexcept { return vertexCount; }
+		GAL_NODISCARD GAL_INLINE GLuint getTargetCount() const noexcept { return targetCount; }
+		GAL_NODISCARD GAL_INLINE GLuint getDeltaCount() const noexcept { return deltaCount; }
+		GAL_NODISCARD GAL_INLINE const Buffer& getBuffer() const noexcept { return buffer; }
+
+		GAL_INLINE void bind(GLuint binding = DefaultBinding) const noexcept
+		{
+			buffer.bindBase(BufferType::ShaderStorage, binding);
+		}
+
+	private:
+		Buffer buffer;
+		GLuint vertexCount;
+		GLuint targetCount;
+		GLuint deltaCount;
+
+		GAL_NODISCARD GAL_STATIC GAL_INLINE uint32_t packHalf2(float low, float high) noexcept
+		{
+			return static_cast<uint32_t>(detail::floatToHalf(low)) | static_cast<uint32_t>(detail::floatToHalf(high)) << 16;
+		}
+	};
+
+	/// @brief Morph target weights for up to maxInstances instances of a mesh, in a shader storage buffer laid out for
+	/// morphTargetShaderSource. This is all that needs uploading each frame. Targets with a weight of exactly 0 are
+	/// skipped by the shader.
+	class MorphWeights
+	{
+	public:
+		/// @brief The binding morphTargetShaderSource reads the weights from unless GAL_MORPH_WEIGHT_BINDING is defined.
+		GAL_STATIC GAL_CONSTEXPR GLuint DefaultBinding = 6;
+
+		/// @brief Allocate room for maxInstances sets of targetCount weights. Requires a current OpenGL context.
+		GAL_INLINE MorphWeights(GLuint targetCount, GLuint maxInstances = 1)
+			: storage(targetCount, maxInstances, sizeof(float), GL_DYNAMIC_STORAGE_BIT) { }
+
+		// Forbid copying.
+		GAL_INLINE MorphWeights(const MorphWeights&) = delete;
+		GAL_INLINE MorphWeights& operator=(const MorphWeights&) = delete;
+
+		// Allow moving.
+		GAL_INLINE MorphWeights(MorphWeights&&) noexcept = default;
+		GAL_INLINE MorphWeights& operator=(MorphWeights&&) noexcept = default;
+
+		GAL_NODISCARD GAL_INLINE GLuint getTargetCount() const noexcept { return storage.getCountPerInstance(); }
+		GAL_NODISCARD GAL_INLINE GLuint getMaxInstances() const noexcept { return storage.getMaxInstances(); }
+		GAL_NODISCARD GAL_INLINE const Buffer& getBuffer() const noexcept { return storage.getBuffer(); }
+
+		/// @brief Write instanceCount sets of weights, one instance's targets after another, starting at instance
+		/// firstInstance.
+		GAL_INLINE void write(const float* weights, GLuint firstInstance = 0, GLuint instanceCount = 1)
+		{
+			storage.write(weights, firstInstance, instanceCount);
+		}
+
+		GAL_INLINE void write(const std::vector<float>& weights, GLuint firstInstance = 0)
+		{
+			write(weights.data(), firstInstance, storage.getInstanceCount(weights.size()));
+		}
+
+		/// @brief Bind the weights for morphTargetShaderSource and set the program's galMorphTargetCount uniform.
+		GAL_INLINE void bind(const ShaderProgram& program, GLuint binding = DefaultBinding) const
+		{
+			storage.bind(program, "galMorphTargetCount", binding);
+		}
+
+	private:
+		detail::InstanceStorageBuffer storage;
+	};
+}
+
+#endif
@@ -0,0 +1,442 @@
+#ifndef GAL_OCCLUSION_CULLER_HPP
+#define GAL_OCCLUSION_CULLER_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "attributes.hpp"
+#include "Camera.hpp"
+#include "enums.hpp"
+#include "GALException.hpp"
+#include "MeshInstance.hpp"
+#include "parallel.hpp"
+#include "simd.hpp"
+
+namespace gal
+{
+	/// @brief Software occlusion culling: rasterizes a few low-poly occluder meshes into a small depth buffer on the CPU,
+	/// then tests bounding boxes against it, so hidden instances are dropped in the same frame without GPU queries.
+	///
+	/// Each frame, call beginFrame(), add the occluders with addOccluder(), call rasterize() and then test bounds. The
+	/// depth buffer is split into tiles that are rasterized in parallel, 8 (AVX2) or 4 (SSE2) pixels at a time. Occluders
+	/// must lie inside the geometry they stand in for, as they're drawn as solid; tests are conservative otherwise.
+	class OcclusionCuller
+	{
+	public:
+		/// @brief Size in pixels of the tiles the depth buffer is rasterized in. Each tile is one task for rasterize().
+		GAL_STATIC GAL_CONSTEXPR uint32_t TileWidth = 32;
+		GAL_STATIC GAL_CONSTEXPR uint32_t TileHeight = 16;
+
+		/// @brief Initialize with a depth buffer of the given size in pixels. Something around 256x128 is usually
+		/// plenty: larger buffers catch smaller gaps between occluders but take longer to rasterize.
+		GAL_INLINE OcclusionCuller(uint32_t width, uint32_t height)
+			: width(std::max(width, 1u)), height(std::max(height, 1u)),
+			tilesX((this->width + TileWidth - 1) / TileWidth), tilesY((this->height + TileHeight - 1) / TileHeight),
+			depth(static_cast<size_t>(tilesX) * TileWidth * tilesY * TileHeight, Far), tileMaxDepth(static_cast<size_t>(tilesX) * tilesY, Far),
+			bins(static_cast<size_t>(tilesX) * tilesY), viewProjection(1.0f) { }
+
+		GAL_NODISCARD GAL_INLINE uint32_t getWidth() const noexcept { return width; }
+		GAL_NODISCARD GAL_INLINE uint32_t getHeight() const noexcept { return height; }
+
+		/// @brief Get the rasterized depth (NDC z, infinity where no occluder was drawn) of a pixel, with (0, 0) at the
+		/// bottom left. Useful for debugging occluders.
+		GAL_NODISCARD GAL_INLINE float getDepth(uint32_t x, uint32_t y) const noexcept
+		{
+			return depth[static_cast<size_t>(y) * getPitch() + x];
+		}
+
+		/// @brief Remove every occluder and start testing against the camera's view.
+		GAL_INLINE void beginFrame(const Camera& camera)
+		{
+			beginFrame(camera.getViewProjectionMatrix());
+		}
+
+		/// @brief Remove every occluder and start testing against the view of a view-projection matrix.
+		GAL_INLINE void beginFrame(const glm::mat4& viewProjection)
+		{
+			this->viewProjection = viewProjection;
+			triangles.clear();
+
+			for (std::vector<uint32_t>& bin : bins)
+				bin.clear();
+		}
+
+		/// @brief Add an indexed triangle mesh, placed in the world by modelMatrix, to be rasterized as an occluder.
+		/// Triangles are drawn whichever way they face, so single-sided walls and floors work too.
+		GAL_INLINE void addOccluder(const glm::vec3* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount,
+			const glm::mat4& modelMatrix = glm::mat4(1.0f))
+		{
+			indexCount -= indexCount % 3;
+			if (indexCount != 0 && *std::max_element(indices, indices + indexCount) >= vertexCount)
+				detail::throwErr(ErrCode::OccluderIndexOutOfRange, "An occluder index referred to a vertex the occluder doesn't have.");
+
+			const glm::mat4 transform = viewProjection * modelMatrix;
+			clipVertices.resize(vertexCount);
+			for (size_t i = 0; i < vertexCount; ++i)
+				clipVertices[i] = transform * glm::vec4(vertices[i], 1.0f);
+
+			for (size_t i = 0; i < indexCount; i += 3)
+				addClipTriangle(clipVertices[indices[i]], clipVertices[indices[i + 1]], clipVertices[indices[i + 2]]);
+		}
+
+		GAL_INLINE void addOccluder(const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices,
+			const glm::mat4& modelMatrix = glm::mat4(1.0f))
+		{
+			addOccluder(vertices.data(), vertices.size(), indices.data(), indices.size(), modelMatrix);
+		}
+
+		/// @brief Rasterize every occluder added since beginFrame() into the depth buffer.
+		/// @param threadCount: Threads to split the tiles across. 0 uses every hardware thread.
+		GAL_INLINE void rasterize(unsigned threadCount = 1)
+		{
+			detail::parallelFor(bins.size(), threadCount, [this](size_t begin, size_t end)
+				{
+					for (size_t tile = begin; tile < end; ++tile)
+						rasterizeTile<detail::WideFloatLanes>(tile);
+				}, 1);
+		}
+
+		/// @brief Test whether any part of a world space box may be visible past the occluders. Boxes crossing the near
+		/// plane are always visible, and boxes entirely outside the viewport never are.
+		GAL_NODISCARD GAL_INLINE bool isAABBVisible(const glm::vec3& min, const glm::vec3& max) const noexcept
+		{
+			float minX = std::numeric_limits<float>::infinity(), minY = minX, nearest = minX;
+			float maxX = -minX, maxY = -minX;
+
+			for (int corner = 0; corner < 8; ++corner)
+			{
+				const glm::vec4 p = viewProjection * glm::vec4(corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y,
+					corner & 4 ? max.z : min.z, 1.0f);
+
+				if (p.w <= 0.0f || p.z < -p.w)
+					return true;
+
+				const float invW = 1.0f / p.w;
+				const float x = (p.x * invW * 0.5f + 0.5f) * width;
+				const float y = (p.y * invW * 0.5f + 0.5f) * height;
+				minX = std::min(minX, x);
+				minY = std::min(minY, y);
+				maxX = std::max(maxX, x);
+				maxY = std::max(maxY, y);
+				nearest = std::min(nearest, p.z * invW);
+			}
+
+			return isRectVisible(minX, minY, maxX, maxY, nearest);
+		}
+
+		/// @brief Test count world space boxes and write the indices of the ones that may be visible to visibleIndices,
+		/// which must have room for count indices. Returns how many were visible.
+		/// @param threadCount: Threads to split the boxes across. 0 uses every hardware thread.
+		GAL_INLINE size_t cullAABBs(const float* minX, const float* minY, const float* minZ,
+			const float* maxX, const float* maxY, const float* maxZ, size_t count, uint32_t* visibleIndices, unsigned threadCount = 1) const
+		{
+			std::vector<uint8_t> visible(count);
+			detail::parallelFor(count, threadCount, [&](size_t begin, size_t end)
+				{
+					for (size_t i = begin; i < end; ++i)
+						visible[i] = isAABBVisible(glm::vec3(minX[i], minY[i], minZ[i]), glm::vec3(maxX[i], maxY[i], maxZ[i]));
+				}, 64);
+
+			size_t visibleCount = 0;
+			for (size_t i = 0; i < count; ++i)
+			{
+				if (visible[i])
+					visibleIndices[visibleCount++] = static_cast<uint32_t>(i);
+			}
+
+			return visibleCount;
+		}
+
+	private:
+		/// @brief Depth of pixels no occluder covers, so nothing is ever hidden behind them.
+		GAL_STATIC GAL_CONSTEXPR float Far = std::numeric_limits<float>::infinity();
+
+		/// @brief A screen space triangle with positive area, its depth plane and the pixels its bounds cover.
+		struct OccluderTriangle
+		{
+			float x[3];
+			float y[3];
+			float z0, zdx, zdy; // Depth at vertex 0, and its change per pixel along x and y.
+			uint32_t minX, minY, maxX, maxY; // Pixels whose centers may be covered, max exclusive.
+		};
+
+		uint32_t width;
+		uint32_t height;
+		uint32_t tilesX;
+		uint32_t tilesY;
+
+		std::vector<float, detail::AlignedAllocator<float>> depth;
+		std::vector<float> tileMaxDepth;
+
+		std::vector<OccluderTriangle> triangles;
+		std::vector<std::vector<uint32_t>> bins; // Indices into triangles of the ones overlapping each tile.
+		std::vector<glm::vec4> clipVertices;
+
+		glm::mat4 viewProjection;
+
+		GAL_NODISCARD GAL_INLINE size_t getPitch() const noexcept { return static_cast<size_t>(tilesX) * TileWidth; }
+
+		GAL_INLINE void addClipTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c)
+		{
+			const glm::vec4 in[3] = { a, b, c };
+
+			// Skip triangles entirely past one side of the frustum. Triangles past the far plane can't hide anything.
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				for (float sign = -1.0f; sign <= 1.0f; sign += 2.0f)
+				{
+					if (axis == 2 && sign < 0.0f)
+						continue;
+
+					if (sign * a[axis] > a.w && sign * b[axis] > b.w && sign * c[axis] > c.w)
+						return;
+				}
+			}
+
+			// Clip against the near plane (z >= -w), which turns the triangle into a polygon of up to 4 vertices.
+			glm::vec4 polygon[4];
+			int count = 0;
+			for (int i = 0; i < 3; ++i)
+			{
+				const glm::vec4& p = in[i];
+				const glm::vec4& q = in[(i + 1) % 3];
+				const float dp = p.z + p.w;
+				const float dq = q.z + q.w;
+
+				if (dp >= 0.0f)
+					polygon[count++] = p;
+				if ((dp >= 0.0f) != (dq >= 0.0f))
+					polygon[count++] = p + (q - p) * (dp / (dp - dq));
+			}
+
+			for (int i = 1; i + 1 < count; ++i)
+				addScreenTriangle(polygon[0], polygon[i], polygon[i + 1]);
+		}
+
+		GAL_INLINE void addScreenTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c)
+		{
+			OccluderTriangle tri;
+			float z[3];
+
+			const glm::vec4* const in[3] = { &a, &b, &c };
+			for (int i = 0; i < 3; ++i)
+			{
+				const float invW = 1.0f / in[i]->w;
+				tri.x[i] = (in[i]->x * invW * 0.5f + 0.5f) * width;
+				tri.y[i] = (in[i]->y * invW * 0.5f + 0.5f) * height;
+				z[i] = in[i]->z * invW;
+			}
+
+			float area = (tri.x[1] - tri.x[0]) * (tri.y[2] - tri.y[0]) - (tri.x[2] - tri.x[0]) * (tri.y[1] - tri.y[0]);
+			if (!(std::abs(area) > 1e-6f))
+				return;
+
+			// Wind every triangle the same way so the edge functions are non-negative inside.
+			if (area < 0.0f)
+			{
+				std::swap(tri.x[1], tri.x[2]);
+				std::swap(tri.y[1], tri.y[2]);
+				std::swap(z[1], z[2]);
+				area = -area;
+			}
+
+			tri.z0 = z[0];
+			tri.zdx = ((z[1] - z[0]) * (tri.y[2] - tri.y[0]) - (z[2] - z[0]) * (tri.y[1] - tri.y[0])) / area;
+			tri.zdy = ((tri.x[1] - tri.x[0]) * (z[2] - z[0]) - (tri.x[2] - tri.x[0]) * (z[1] - z[0])) / area;
+
+			const float w = static_cast<float>(width);
+			const float h = static_cast<float>(height);
+			tri.minX = static_cast<uint32_t>(std::clamp(std::floor(std::min({ tri.x[0], tri.x[1], tri.x[2] })), 0.0f, w));
+			tri.minY = static_cast<uint32_t>(std::clamp(std::floor(std::min({ tri.y[0], tri.y[1], tri.y[2] })), 0.0f, h));
+			tri.maxX = static_cast<uint32_t>(std::clamp(std::ceil(std::max({ tri.x[0], tri.x[1], tri.x[2] })), 0.0f, w));
+			tri.maxY = static_cast<uint32_t>(std::clamp(std::ceil(std::max({ tri.y[0], tri.y[1], tri.y[2] })), 0.0f, h));
+			if (tri.minX >= tri.maxX || tri.minY >= tri.maxY)
+				return;
+
+			const uint32_t index = static_cast<uint32_t>(triangles.size());
+			triangles.push_back(tri);
+
+			for (uint32_t tileY = tri.minY / TileHeight; tileY <= (tri.maxY - 1) / TileHeight; ++tileY)
+			{
+				for (uint32_t tileX = tri.minX / TileWidth; tileX <= (tri.maxX - 1) / TileWidth; ++tileX)
+					bins[static_cast<size_t>(tileY) * tilesX + tileX].push_back(index);
+			}
+		}
+
+		template<typename Lanes>
+		GAL_INLINE void rasterizeTile(size_t tile) noexcept
+		{
+			using L = Lanes;
+			using V = typename L::Type;
+
+			static const float laneOffsets[8] = { 0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f };
+			const V lanes = L::load(laneOffsets);
+
+			const uint32_t tileX = static_cast<uint32_t>(tile % tilesX) * TileWidth;
+			const uint32_t tileY = static_cast<uint32_t>(tile / tilesX) * TileHeight;
+			const size_t pitch = getPitch();
+			float* const tileDepth = depth.data() + tileY * pitch + tileX;
+
+			for (uint32_t y = 0; y < TileHeight; ++y)
+				std::fill(tileDepth + y * pitch, tileDepth + y * pitch + TileWidth, Far);
+
+			for (uint32_t index : bins[tile])
+			{
+				const OccluderTriangle& tri = triangles[index];
+
+				// The part of the triangle's bounds inside the tile, relative to the tile, widened to whole lanes.
+				uint32_t x0 = std::max(tri.minX, tileX) - tileX;
+				const uint32_t x1 = std::min(tri.maxX, tileX + TileWidth) - tileX;
+				const uint32_t y0 = std::max(tri.minY, tileY) - tileY;
+				const uint32_t y1 = std::min(tri.maxY, tileY + TileHeight) - tileY;
+				x0 -= x0 % L::Width;
+
+				// Edge functions and depth at the center of the first pixel, set up in double so triangles reaching far
+				// off screen stay accurate. Stepping from there only ever spans one tile.
+				const double originX = tileX + x0 + 0.5;
+				const double originY = tileY + y0 + 0.5;
+				float edge[3], edgeDX[3], edgeDY[3];
+				for (int i = 0; i < 3; ++i)
+				{
+					const int j = (i + 1) % 3;
+					edgeDX[i] = tri.y[i] - tri.y[j];
+					edgeDY[i] = tri.x[j] - tri.x[i];
+					edge[i] = static_cast<float>(static_cast<double>(edgeDY[i]) * (originY - tri.y[i])
+						+ static_cast<double>(edgeDX[i]) * (originX - tri.x[i]));
+				}
+
+				const float depthOrigin = static_cast<float>(tri.z0 + tri.zdx * (originX - tri.x[0]) + tri.zdy * (originY - tri.y[0]));
+
+				const V stepX = L::set1(static_cast<float>(L::Width));
+				const V edgeStep0 = L::mul(L::set1(edgeDX[0]), stepX);
+				const V edgeStep1 = L::mul(L::set1(edgeDX[1]), stepX);
+				const V edgeStep2 = L::mul(L::set1(edgeDX[2]), stepX);
+				const V depthStep = L::mul(L::set1(tri.zdx), stepX);
+
+				for (uint32_t y = y0; y < y1; ++y)
+				{
+					const float rowOffset = static_cast<float>(y - y0);
+					V e0 = L::add(L::set1(edge[0] + edgeDY[0] * rowOffset), L::mul(L::set1(edgeDX[0]), lanes));
+					V e1 = L::add(L::set1(edge[1] + edgeDY[1] * rowOffset), L::mul(L::set1(edgeDX[1]), lanes));
+					V e2 = L::add(L::set1(edge[2] + edgeDY[2] * rowOffset), L::mul(L::set1(edgeDX[2]), lanes));
+					V z = L::add(L::set1(depthOrigin + tri.zdy * rowOffset), L::mul(L::set1(tri.zdx), lanes));
+
+					float* const row = tileDepth + y * pitch;
+					for (uint32_t x = x0; x < x1; x += L::Width)
+					{
+						// Inside where no edge function is negative. Keep the nearest depth there.
+						const V inside = L::min(e0, L::min(e1, e2));
+						const V old = L::load(row + x);
+						L::store(row + x, L::selectNonNegative(inside, L::min(old, z), old));
+
+						e0 = L::add(e0, edgeStep0);
+						e1 = L::add(e1, edgeStep1);
+						e2 = L::add(e2, edgeStep2);
+						z = L::add(z, depthStep);
+					}
+				}
+			}
+
+			// Only pixels on screen count, as the padding past the right and top edges is never tested.
+			const uint32_t columns = std::min(TileWidth, width - tileX);
+			const uint32_t rows = std::min(TileHeight, height - tileY);
+			float maxDepth = -Far;
+			for (uint32_t y = 0; y < rows; ++y)
+				maxDepth = std::max(maxDepth, *std::max_element(tileDepth + y * pitch, tileDepth + y * pitch + columns));
+
+			tileMaxDepth[tile] = maxDepth;
+		}
+
+		/// @brief Test whether any pixel of a screen space rectangle is farther than nearest.
+		GAL_NODISCARD GAL_INLINE bool isRectVisible(float minX, float minY, float maxX, float maxY, float nearest) const noexcept
+		{
+			if (maxX < 0.0f || maxY < 0.0f || minX > width || minY > height)
+				return false;
+
+			const uint32_t x0 = std::min(static_cast<uint32_t>(std::max(std::floor(minX), 0.0f)), width - 1);
+			const uint32_t y0 = std::min(static_cast<uint32_t>(std::max(std::floor(minY), 0.0f)), height - 1);
+			const uint32_t x1 = std::max(static_cast<uint32_t>(std::min(std::ceil(maxX), static_cast<float>(width))), x0 + 1);
+			const uint32_t y1 = std::max(static_cast<uint32_t>(std::min(std::ceil(maxY), static_cast<float>(height))), y0 + 1);
+			const size_t pitch = getPitch();
+
+			for (uint32_t tileY = y0 / TileHeight; tileY <= (y1 - 1) / TileHeight; ++tileY)
+			{
+				for (uint32_t tileX = x0 / TileWidth; tileX <= (x1 - 1) / TileWidth; ++tileX)
+				{
+					// Every pixel of the tile is nearer than the box, so this part of it is hidden.
+					if (nearest > tileMaxDepth[static_cast<size_t>(tileY) * tilesX + tileX])
+						continue;
+
+					const uint32_t rowBegin = std::max(y0, tileY * TileHeight);
+					const uint32_t rowEnd = std::min(y1, (tileY + 1) * TileHeight);
+					const size_t begin = std::max(x0, tileX * TileWidth);
+					const size_t end = std::min(x1, (tileX + 1) * TileWidth);
+
+					for (uint32_t y = rowBegin; y < rowEnd; ++y)
+					{
+						const float* const row = depth.data() + y * pitch;
+						size_t x = begin;
+						if (anyFartherRange<detail::WideFloatLanes>(row, x, end, nearest) || anyFartherRange<detail::FloatLanes1>(row, x, end, nearest))
+							return true;
+					}
+				}
+			}
+
+			return false;
+		}
+
+		/// @brief Test row[x, end) for a depth at least nearest, advancing x past the whole lanes tested.
+		template<typename Lanes>
+		GAL_NODISCARD GAL_STATIC GAL_INLINE bool anyFartherRange(const float* row, size_t& x, size_t end, float nearest) noexcept
+		{
+			using L = Lanes;
+
+			const typename L::Type z = L::set1(nearest);
+			for (; x + L::Width <= end; x += L::Width)
+			{
+				if (L::nonNegativeMask(L::sub(L::load(row + x), z)) != 0)
+					return true;
+			}
+
+			return false;
+		}
+	};
+
+	/// @brief Remove the instances hidden behind the culler's occluders from visibleIndices, e.g. after
+	/// cullMeshInstances(). Instances are tested by the box around their world space bounding sphere, and instances
+	/// without a bounding sphere are always kept. Call after OcclusionCuller::rasterize().
+	/// @param threadCount: Threads to split the tests across. 0 uses every hardware thread.
+	GAL_INLINE void cullOccludedMeshInstances(const OcclusionCuller& culler, const MeshInstance* instances,
+		std::vector<uint32_t>& visibleIndices, unsigned threadCount = 1)
+	{
+		// Model matrices are cached on first use, so compute the bounds up front rather than on several threads.
+		std::vector<glm::vec4> spheres(visibleIndices.size());
+		for (size_t i = 0; i < visibleIndices.size(); ++i)
+			spheres[i] = instances[visibleIndices[i]].getWorldBoundingSphere();
+
+		std::vector<uint8_t> visible(visibleIndices.size());
+		detail::parallelFor(visibleIndices.size(), threadCount, [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					const glm::vec3 center(spheres[i]);
+					const glm::vec3 extent(spheres[i].w);
+					visible[i] = spheres[i].w < 0.0f || culler.isAABBVisible(center - extent, center + extent);
+				}
+			}, 64);
+
+		size_t visibleCount = 0;
+		for (size_t i = 0; i < visibleIndices.size(); ++i)
+		{
+			if (visible[i])
+				visibleIndices[visibleCount++] = visibleIndices[i];
+		}
+
+		visibleIndices.resize(visibleCount);
+	}
+}
+
+#endif
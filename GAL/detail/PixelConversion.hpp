@@ -0,0 +1,449 @@
+#ifndef GAL_PIXEL_CONVERSION_HPP
+#define GAL_PIXEL_CONVERSION_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "attributes.hpp"
+#include "MipGenerator.hpp"
+#include "parallel.hpp"
+#include "simd.hpp"
+#include "Texture.hpp"
+
+namespace gal
+{
+	/// @brief Channel layout of 8-bit pixel data handed to the conversion functions.
+	enum class PixelLayout
+	{
+		Grey, // 1 byte per pixel, expanded to (g, g, g, 255).
+		GreyAlpha, // 2 bytes per pixel, expanded to (g, g, g, a).
+		RGB,
+		RGBA,
+		BGR,
+		BGRA
+	};
+
+	/// @brief Get the layout stbi_load() and similar loaders use for the given channel count.
+	GAL_NODISCARD GAL_CONSTEXPR GAL_INLINE PixelLayout pixelLayoutFromChannels(int channels) noexcept
+	{
+		switch (channels)
+		{
+			case 1: return PixelLayout::Grey;
+			case 2: return PixelLayout::GreyAlpha;
+			case 3: return PixelLayout::RGB;
+			default: return PixelLayout::RGBA;
+		}
+	}
+
+	GAL_NODISCARD GAL_CONSTEXPR GAL_INLINE int pixelLayoutSize(PixelLayout layout) noexcept
+	{
+		switch (layout)
+		{
+			case PixelLayout::Grey: return 1;
+			case PixelLayout::GreyAlpha: return 2;
+			case PixelLayout::RGB: case PixelLayout::BGR: return 3;
+			default: return 4;
+		}
+	}
+
+	namespace detail
+	{
+		/// @brief Byte of the source pixel feeding each RGBA channel, or -1 for a constant 255 alpha.
+		GAL_INLINE void pixelLayoutSources(PixelLayout layout, int (&sources)[4]) noexcept
+		{
+			switch (layout)
+			{
+				case PixelLayout::Grey: sources[0] = 0; sources[1] = 0; sources[2] = 0; sources[3] = -1; break;
+				case PixelLayout::GreyAlpha: sources[0] = 0; sources[1] = 0; sources[2] = 0; sources[3] = 1; break;
+				case PixelLayout::RGB: sources[0] = 0; sources[1] = 1; sources[2] = 2; sources[3] = -1; break;
+				case PixelLayout::RGBA: sources[0] = 0; sources[1] = 1; sources[2] = 2; sources[3] = 3; break;
+				case PixelLayout::BGR: sources[0] = 2; sources[1] = 1; sources[2] = 0; sources[3] = -1; break;
+				case PixelLayout::BGRA: sources[0] = 2; sources[1] = 1; sources[2] = 0; sources[3] = 3; break;
+			}
+		}
+
+		/// @brief Convert a float to a half float, rounding to nearest.
+		GAL_NODISCARD GAL_INLINE uint16_t floatToHalf(float value) noexcept
+		{
+			uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+
+			const uint32_t sign = (bits >> 16) & 0x8000u;
+			const int exponent = static_cast<int>((bits >> 23) & 0xFF) - 127 + 15;
+			uint32_t mantissa = bits & 0x7FFFFFu;
+
+			if (exponent <= 0)
+			{
+				if (exponent < -10)
+					return static_cast<uint16_t>(sign);
+
+				mantissa |= 0x800000u;
+				const int shift = 14 - exponent;
+				uint32_t half = mantissa >> shift;
+				if ((mantissa >> (shift - 1)) & 1u)
+					++half;
+
+				return static_cast<uint16_t>(sign | half);
+			}
+
+			if (exponent >= 31)
+				return static_cast<uint16_t>(sign | 0x7C00u);
+
+			uint32_t half = sign | static_cast<uint32_t>(exponent) << 10 | mantissa >> 13;
+			if (mantissa & 0x1000u)
+				++half;
+
+			return static_cast<uint16_t>(half);
+		}
+	}
+
+	/// @brief Expand 8-bit pixels of any layout to 4 bytes per pixel, as RGBA or, with bgraOutput, BGRA.
+	/// in and out must not overlap. Uses one SSSE3 byte shuffle per 4 pixels when SSE4.1 is enabled.
+	GAL_INLINE void expandToRGBA8(const unsigned char* in, PixelLayout layout, unsigned char* out, size_t pixelCount,
+		bool bgraOutput = false) noexcept
+	{
+		int sources[4];
+		detail::pixelLayoutSources(layout, sources);
+		if (bgraOutput)
+			std::swap(sources[0], sources[2]);
+
+		const int inSize = pixelLayoutSize(layout);
+		size_t i = 0;
+
+#ifdef GAL_SIMD_SSE41
+		alignas(16) unsigned char mask[16];
+		alignas(16) unsigned char fill[16];
+		for (int p = 0; p < 4; ++p)
+		{
+			for (int c = 0; c < 4; ++c)
+			{
+				mask[p * 4 + c] = sources[c] < 0 ? 0x80 : static_cast<unsigned char>(p * inSize + sources[c]);
+				fill[p * 4 + c] = sources[c] < 0 ? 0xFF : 0;
+			}
+		}
+
+		const __m128i shuffle = _mm_load_si128(reinterpret_cast<const __m128i*>(mask));
+		const __m128i alpha = _mm_load_si128(reinterpret_cast<const __m128i*>(fill));
+
+		// Each step reads 16 bytes but only consumes 4 pixels' worth, so stop once a full load would overrun.
+		for (; i * inSize + 16 <= pixelCount * inSize; i += 4)
+		{
+			const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * inSize));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4), _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle), alpha));
+		}
+#endif
+		for (; i < pixelCount; ++i)
+		{
+			const unsigned char* pixel = in + i * inSize;
+			for (int c = 0; c < 4; ++c)
+				out[i * 4 + c] = sources[c] < 0 ? 255 : pixel[sources[c]];
+		}
+	}
+
+	/// @brief Swap the red and blue channels of 4 byte pixels in place, turning RGBA into BGRA and back.
+	GAL_INLINE void swizzleRedBlue(unsigned char* pixels, size_t pixelCount) noexcept
+	{
+		size_t i = 0;
+
+#if defined(GAL_SIMD_SSE41)
+		const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+		for (; i + 4 <= pixelCount; i += 4)
+		{
+			__m128i* block = reinterpret_cast<__m128i*>(pixels + i * 4);
+			_mm_storeu_si128(block, _mm_shuffle_epi8(_mm_loadu_si128(block), shuffle));
+		}
+#elif defined(GAL_SIMD_SSE2)
+		// Without a byte shuffle, swap red and blue with shifts: keep green and alpha, move bytes 0 and 2 across.
+		const __m128i keep = _mm_set1_epi32(static_cast<int>(0xFF00FF00u));
+		const __m128i low = _mm_set1_epi32(0x000000FF);
+		for (; i + 4 <= pixelCount; i += 4)
+		{
+			__m128i* block = reinterpret_cast<__m128i*>(pixels + i * 4);
+			const __m128i v = _mm_loadu_si128(block);
+			const __m128i red = _mm_slli_epi32(_mm_and_si128(v, low), 16);
+			const __m128i blue = _mm_and_si128(_mm_srli_epi32(v, 16), low);
+			_mm_storeu_si128(block, _mm_or_si128(_mm_and_si128(v, keep), _mm_or_si128(red, blue)));
+		}
+#endif
+		for (; i < pixelCount; ++i)
+			std::swap(pixels[i * 4], pixels[i * 4 + 2]);
+	}
+
+	/// @brief Multiply the color of 4 byte pixels by their alpha (the last byte) in place.
+	/// @param srgb: Color is sRGB encoded, so it's multiplied in linear space and re-encoded. Otherwise the product is
+	/// computed exactly in 16-bit integer lanes, 4 pixels at a time with SSE2.
+	GAL_INLINE void premultiplyAlpha(unsigned char* pixels, size_t pixelCount, bool srgb) noexcept
+	{
+		if (srgb)
+		{
+			const float* toLinear = detail::srgbToLinearTable();
+			const unsigned char* toSrgb = detail::linearToSrgbTable();
+			constexpr float scale = (detail::linearToSrgbTableSize - 1) / 255.0f;
+
+			for (size_t i = 0; i < pixelCount; ++i)
+			{
+				unsigned char* pixel = pixels + i * 4;
+				const float alpha = pixel[3] * scale;
+				for (int c = 0; c < 3; ++c)
+					pixel[c] = toSrgb[static_cast<int>(toLinear[pixel[c]] * alpha + 0.5f)];
+			}
+
+			return;
+		}
+
+		size_t i = 0;
+
+#ifdef GAL_SIMD_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i alphaLanes = _mm_setr_epi16(0, 0, 0, -1, 0, 0, 0, -1);
+		const __m128i full = _mm_and_si128(alphaLanes, _mm_set1_epi16(255));
+		const __m128i bias = _mm_set1_epi16(128);
+
+		// (x * a + 128 + ((x * a + 128) >> 8)) >> 8 is x * a / 255 rounded, and fits in 16 bits.
+		const auto multiply = [&](__m128i v)
+		{
+			__m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			alpha = _mm_or_si128(_mm_andnot_si128(alphaLanes, alpha), full); // Alpha itself is multiplied by 255.
+			const __m128i product = _mm_add_epi16(_mm_mullo_epi16(v, alpha), bias);
+			return _mm_srli_epi16(_mm_add_epi16(product, _mm_srli_epi16(product, 8)), 8);
+		};
+
+		for (; i + 4 <= pixelCount; i += 4)
+		{
+			__m128i* block = reinterpret_cast<__m128i*>(pixels + i * 4);
+			const __m128i v = _mm_loadu_si128(block);
+			const __m128i low = multiply(_mm_unpacklo_epi8(v, zero));
+			const __m128i high = multiply(_mm_unpackhi_epi8(v, zero));
+			_mm_storeu_si128(block, _mm_packus_epi16(low, high));
+		}
+#endif
+		for (; i < pixelCount; ++i)
+		{
+			unsigned char* pixel = pixels + i * 4;
+			for (int c = 0; c < 3; ++c)
+			{
+				const unsigned product = pixel[c] * pixel[3] + 128u;
+				pixel[c] = static_cast<unsigned char>((product + (product >> 8)) >> 8);
+			}
+		}
+	}
+
+	/// @brief Decode 8-bit sRGB values to linear floats. Uses AVX2 gathers from a lookup table where available.
+	GAL_INLINE void srgbToLinear(const unsigned char* in, float* out, size_t count) noexcept
+	{
+		const float* table = detail::srgbToLinearTable();
+		size_t i = 0;
+
+#ifdef GAL_SIMD_AVX2
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m256i indices = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i)));
+			_mm256_storeu_ps(out + i, _mm256_i32gather_ps(table, indices, 4));
+		}
+#endif
+		for (; i < count; ++i)
+			out[i] = table[in[i]];
+	}
+
+	/// @brief Encode linear floats to 8-bit sRGB values. Inputs are clamped to [0, 1].
+	GAL_INLINE void linearToSrgb(const float* in, unsigned char* out, size_t count) noexcept
+	{
+		const unsigned char* table = detail::linearToSrgbTable();
+		constexpr float scale = static_cast<float>(detail::linearToSrgbTableSize - 1);
+		size_t i = 0;
+
+#ifdef GAL_SIMD_SSE2
+		// Clamp, scale and round 4 values at a time, then look each one up.
+		alignas(16) int32_t indices[4];
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128 clamped = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), _mm_setzero_ps()), _mm_set1_ps(1.0f));
+			_mm_store_si128(reinterpret_cast<__m128i*>(indices), _mm_cvtps_epi32(_mm_mul_ps(clamped, _mm_set1_ps(scale))));
+
+			for (int j = 0; j < 4; ++j)
+				out[i + j] = table[indices[j]];
+		}
+#endif
+		for (; i < count; ++i)
+			out[i] = table[static_cast<int>(std::clamp(in[i], 0.0f, 1.0f) * scale + 0.5f)];
+	}
+
+	/// @brief Widen 8-bit unorm values to 16-bit unorm (x * 257), 16 at a time with SSE2.
+	GAL_INLINE void unorm8ToUnorm16(const unsigned char* in, uint16_t* out, size_t count) noexcept
+	{
+		size_t i = 0;
+
+#ifdef GAL_SIMD_SSE2
+		for (; i + 16 <= count; i += 16)
+		{
+			// Interleaving a byte with itself gives x | x << 8, which is x * 257.
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi8(v, v));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8), _mm_unpackhi_epi8(v, v));
+		}
+#endif
+		for (; i < count; ++i)
+			out[i] = static_cast<uint16_t>(in[i] * 257);
+	}
+
+	/// @brief Convert floats to half floats, 8 at a time with F16C where available.
+	GAL_INLINE void floatToHalf(const float* in, uint16_t* out, size_t count) noexcept
+	{
+		size_t i = 0;
+
+#ifdef GAL_SIMD_F16C
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m128i halves = _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), halves);
+		}
+#endif
+		for (; i < count; ++i)
+			out[i] = detail::floatToHalf(in[i]);
+	}
+
+	/// @brief Precision textures are stored at by ingestPixels().
+	enum class IngestPrecision
+	{
+		Unorm8, // GL_RGBA8 or GL_SRGB8_ALPHA8.
+		Unorm16, // GL_RGBA16. sRGB data is decoded to linear, since there is no 16-bit sRGB format.
+		Half // GL_RGBA16F. sRGB data is decoded to linear.
+	};
+
+	/// @brief Settings for ingestPixels().
+	struct IngestSettings
+	{
+		bool srgb = true; // The source color is sRGB encoded.
+		bool premultiplyAlpha = false;
+		IngestPrecision precision = IngestPrecision::Unorm8;
+		unsigned threadCount = 0; // 0 uses every hardware thread.
+	};
+
+	/// @brief Pixels converted to the layout the driver uploads without conversion, with the arguments to upload them.
+	struct TextureUpload
+	{
+		GLsizei width = 0;
+		GLsizei height = 0;
+		GLenum internalFormat = GL_RGBA8;
+		GLenum format = GL_RGBA;
+		GLenum type = GL_UNSIGNED_BYTE;
+		std::vector<unsigned char> data;
+	};
+
+	namespace detail
+	{
+		/// @brief Ask the driver which client format it prefers for 8-bit RGBA uploads. Drivers commonly store these
+		/// textures as BGRA internally, and uploading anything else makes them swizzle on the CPU.
+		/// Requires a current OpenGL context. The answer is cached per internal format.
+		GAL_NODISCARD GAL_INLINE bool driverPrefersBGRA(GLenum internalFormat)
+		{
+			static std::vector<std::pair<GLenum, bool>> cache;
+			for (const auto& [cachedFormat, bgra] : cache)
+			{
+				if (cachedFormat == internalFormat)
+					return bgra;
+			}
+
+			GLint format = GL_RGBA;
+			glGetInternalformativ(GL_TEXTURE_2D, internalFormat, GL_TEXTURE_IMAGE_FORMAT, 1, &format);
+
+			cache.emplace_back(internalFormat, format == GL_BGRA);
+			return format == GL_BGRA;
+		}
+	}
+
+	/// @brief Convert decoded 8-bit pixels of any layout into the format the driver takes without a conversion pass of
+	/// its own: 4 channels, in BGRA order if the driver prefers it, at the requested precision. Requires a current
+	/// OpenGL context to query the driver's preference. Feed the result to uploadTexture().
+	/// @param pixels: Rows of width pixels in the given layout, tightly packed.
+	GAL_NODISCARD GAL_INLINE TextureUpload ingestPixels(const unsigned char* pixels, GLsizei width, GLsizei height,
+		PixelLayout layout, const IngestSettings& settings = {})
+	{
+		TextureUpload upload;
+		upload.width = width;
+		upload.height = height;
+
+		const size_t pixelCount = static_cast<size_t>(width) * height;
+		const size_t inSize = static_cast<size_t>(pixelLayoutSize(layout));
+
+		if (settings.precision == IngestPrecision::Unorm8)
+		{
+			upload.internalFormat = settings.srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+
+			const bool bgra = detail::driverPrefersBGRA(upload.internalFormat);
+			upload.format = bgra ? GL_BGRA : GL_RGBA;
+			upload.type = bgra ? GL_UNSIGNED_INT_8_8_8_8_REV : GL_UNSIGNED_BYTE;
+			upload.data.resize(pixelCount * 4);
+
+			detail::parallelFor(pixelCount, settings.threadCount, [&](size_t begin, size_t end)
+			{
+				unsigned char* out = upload.data.data() + begin * 4;
+				expandToRGBA8(pixels + begin * inSize, layout, out, end - begin, bgra);
+
+				if (settings.premultiplyAlpha)
+					premultiplyAlpha(out, end - begin, settings.srgb);
+			}, 16384);
+
+			return upload;
+		}
+
+		// Wider formats: expand to RGBA8, premultiply, then widen, one chunk at a time so the temporaries stay in cache.
+		upload.internalFormat = settings.precision == IngestPrecision::Unorm16 ? GL_RGBA16 : GL_RGBA16F;
+		upload.format = GL_RGBA;
+		upload.type = settings.precision == IngestPrecision::Unorm16 ? GL_UNSIGNED_SHORT : GL_HALF_FLOAT;
+		upload.data.resize(pixelCount * 8);
+
+		detail::parallelFor(pixelCount, settings.threadCount, [&](size_t begin, size_t end)
+		{
+			const size_t count = end - begin;
+			std::vector<unsigned char> rgba(count * 4);
+			std::vector<float> linear(count * 4);
+
+			expandToRGBA8(pixels + begin * inSize, layout, rgba.data(), count);
+			if (settings.premultiplyAlpha)
+				premultiplyAlpha(rgba.data(), count, settings.srgb);
+
+			uint16_t* out = reinterpret_cast<uint16_t*>(upload.data.data()) + begin * 4;
+
+			if (!settings.srgb && settings.precision == IngestPrecision::Unorm16)
+			{
+				unorm8ToUnorm16(rgba.data(), out, count * 4);
+				return;
+			}
+
+			if (settings.srgb)
+				srgbToLinear(rgba.data(), linear.data(), count * 4);
+			else
+				std::transform(rgba.begin(), rgba.end(), linear.begin(), [](unsigned char v) { return v / 255.0f; });
+
+			// Alpha is never sRGB encoded.
+			for (size_t i = 0; i < count; ++i)
+				linear[i * 4 + 3] = rgba[i * 4 + 3] / 255.0f;
+
+			if (settings.precision == IngestPrecision::Half)
+			{
+				floatToHalf(linear.data(), out, count * 4);
+			}
+			else
+			{
+				for (size_t i = 0; i < count * 4; ++i)
+					out[i] = static_cast<uint16_t>(linear[i] * 65535.0f + 0.5f);
+			}
+		}, 16384);
+
+		return upload;
+	}
+
+	/// @brief Allocate immutable storage for the converted pixels and upload them.
+	/// @param texture: A TextureType::TwoD texture with no storage yet.
+	/// @param mipmapLevels: Levels to allocate. Levels past the first are left for generateMipmapAB() or uploadMipChain().
+	GAL_INLINE void uploadTexture(Texture& texture, const TextureUpload& upload, GLint mipmapLevels = 1)
+	{
+		texture.storage(mipmapLevels, upload.internalFormat, upload.width, upload.height);
+		texture.subImage(0, upload.format, upload.type, upload.data.data(), upload.width, upload.height);
+	}
+}
+
+#endif
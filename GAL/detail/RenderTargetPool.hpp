@@ -0,0 +1,306 @@
+#ifndef GAL_RENDER_TARGET_POOL_HPP
+#define GAL_RENDER_TARGET_POOL_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "attributes.hpp"
+#include "enums.hpp"
+#include "Framebuffer.hpp"
+#include "logging.hpp"
+#include "Texture.hpp"
+
+namespace gal
+{
+	class RenderTargetPool;
+
+	/// @brief Snapshot of a RenderTargetPool's memory use.
+	struct RenderTargetPoolStats
+	{
+		size_t textureCount = 0;
+		size_t texturesInUse = 0;
+		size_t framebufferCount = 0;
+
+		size_t bytes = 0; // Of every texture the pool holds, in use or not.
+		size_t peakBytes = 0;
+
+		size_t acquiresLastFrame = 0;
+		size_t createdLastFrame = 0; // Acquires that couldn't reuse a texture.
+	};
+
+	/// @brief A texture borrowed from a RenderTargetPool. It goes back to the pool when this is destroyed or release()d,
+	/// after which its contents are undefined.
+	class TransientTarget
+	{
+	public:
+		/// @brief Create an empty target that holds no texture.
+		GAL_INLINE TransientTarget() noexcept = default;
+
+		// Forbid copying.
+		GAL_INLINE TransientTarget(const TransientTarget&) = delete;
+		GAL_INLINE TransientTarget& operator=(const TransientTarget&) = delete;
+
+		// Allow moving. The moved-from target is left empty, so the texture is only returned once.
+		GAL_INLINE TransientTarget(TransientTarget&& other) noexcept
+			: pool(other.pool), texture(other.texture)
+		{
+			other.pool = nullptr;
+			other.texture = nullptr;
+		}
+
+		GAL_INLINE TransientTarget& operator=(TransientTarget&& other) noexcept
+		{
+			if (this != &other)
+			{
+				release();
+				pool = other.pool;
+				texture = other.texture;
+				other.pool = nullptr;
+				other.texture = nullptr;
+			}
+
+			return *this;
+		}
+
+		GAL_INLINE ~TransientTarget()
+		{
+			release();
+		}
+
+		/// @brief Return the texture to the pool early. Does nothing if the target is empty.
+		GAL_INLINE void release() noexcept;
+
+		GAL_NODISCARD GAL_INLINE const Texture& get() const noexcept { return *texture; }
+		GAL_NODISCARD GAL_INLINE const Texture* operator->() const noexcept { return texture; }
+		GAL_NODISCARD GAL_INLINE explicit operator bool() const noexcept { return texture != nullptr; }
+
+	private:
+		friend class RenderTargetPool;
+
+		RenderTargetPool* pool = nullptr;
+		const Texture* texture = nullptr;
+
+		GAL_INLINE TransientTarget(RenderTargetPool* pool, const Texture* texture) noexcept
+			: pool(pool), texture(texture) {}
+	};
+
+	/// @brief Hands out render target textures for the duration of a pass and recycles them, so passes that run at
+	/// different times in a frame share the same video memory instead of each keeping its own targets.
+	///
+	/// acquire() returns a free texture with a matching internal format and size, creating one only if there is none.
+	/// Released textures are invalidated, since nothing may rely on their contents, and textures left unused for a few
+	/// frames are freed by endFrame(). Framebuffers for combinations of attachments are cached the same way.
+	class RenderTargetPool
+	{
+	public:
+		GAL_INLINE RenderTargetPool() = default;
+
+		// Forbid copying and moving, as outstanding TransientTargets hold a pointer to the pool.
+		GAL_INLINE RenderTargetPool(const RenderTargetPool&) = delete;
+		GAL_INLINE RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+		/// @brief Borrow a single level TwoD texture of the given internal format and size. Its contents are undefined.
+		/// Filtering is linear and wrapping clamps to the edge; bind a sampler object to sample it any other way.
+		GAL_NODISCARD GAL_INLINE TransientTarget acquire(GLenum internalFormat, GLsizei width, GLsizei height)
+		{
+			stats.acquiresLastFrame++;
+
+			for (Entry& entry : entries)
+			{
+				if (!entry.inUse && entry.internalFormat == internalFormat && entry.width == width && entry.height == height)
+				{
+					entry.inUse = true;
+					entry.lastUsedFrame = frame;
+					return TransientTarget(this, entry.texture.get());
+				}
+			}
+
+			auto texture = std::make_unique<Texture>(TextureType::TwoD);
+			texture->storage(1, internalFormat, width, height);
+			texture->setParameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			texture->setParameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			texture->setParameter(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			texture->setParameter(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+			bytes += texture->getByteSize();
+			stats.peakBytes = std::max(stats.peakBytes, bytes);
+			stats.createdLastFrame++;
+
+			entries.push_back({ std::move(texture), internalFormat, width, height, true, frame });
+			return TransientTarget(this, entries.back().texture.get());
+		}
+
+		/// @brief Get a framebuffer with the given textures attached to color attachments 0, 1, ... and the depth (or
+		/// depth-stencil) attachment, with draw buffers set to match. Framebuffers are cached per combination of textures,
+		/// so call this every time the pass runs rather than keeping the result.
+		GAL_NODISCARD GAL_INLINE Framebuffer& getFramebuffer(const std::vector<const Texture*>& colorAttachments,
+			const Texture* depthAttachment = nullptr)
+		{
+			std::vector<GLuint> key;
+			key.push_back(depthAttachment != nullptr ? depthAttachment->getID() : 0);
+			for (const Texture* texture : colorAttachments)
+				key.push_back(texture->getID());
+
+			CachedFramebuffer& cached = framebuffers[key];
+			cached.lastUsedFrame = frame;
+
+			if (cached.framebuffer == nullptr)
+			{
+				cached.framebuffer = std::make_unique<Framebuffer>();
+				std::vector<GLenum> drawBuffers;
+
+				for (GLuint i = 0; i < static_cast<GLuint>(colorAttachments.size()); ++i)
+				{
+					cached.framebuffer->attachColor(i, *colorAttachments[i]);
+					drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + i);
+				}
+
+				if (depthAttachment != nullptr)
+					cached.framebuffer->attachDepth(*depthAttachment);
+
+				if (drawBuffers.empty())
+					cached.framebuffer->setDrawBuffer(GL_NONE);
+				else
+					cached.framebuffer->setDrawBuffers(drawBuffers);
+
+				if (!cached.framebuffer->isComplete())
+					detail::logErr("RenderTargetPool created an incomplete framebuffer.");
+			}
+
+			return *cached.framebuffer;
+		}
+
+		/// @brief Free textures and framebuffers that have gone unused for longer than the idle limit, then start a new
+		/// frame. Call once per frame.
+		GAL_INLINE void endFrame()
+		{
+			for (auto it = entries.begin(); it != entries.end();)
+			{
+				if (!it->inUse && frame - it->lastUsedFrame >= maxIdleFrames)
+				{
+					forgetFramebuffers(it->texture->getID());
+					bytes -= it->texture->getByteSize();
+					it = entries.erase(it);
+				}
+				else
+				{
+					++it;
+				}
+			}
+
+			for (auto it = framebuffers.begin(); it != framebuffers.end();)
+			{
+				if (frame - it->second.lastUsedFrame >= maxIdleFrames)
+					it = framebuffers.erase(it);
+				else
+					++it;
+			}
+
+			++frame;
+			lastFrameStats = stats;
+			stats.acquiresLastFrame = 0;
+			stats.createdLastFrame = 0;
+		}
+
+		/// @brief Free every texture not currently borrowed, and every cached framebuffer.
+		GAL_INLINE void clear()
+		{
+			framebuffers.clear();
+
+			entries.erase(std::remove_if(entries.begin(), entries.end(), [this](const Entry& entry)
+				{
+					if (!entry.inUse)
+						bytes -= entry.texture->getByteSize();
+
+					return !entry.inUse;
+				}), entries.end());
+		}
+
+		/// @brief Set how many frames a texture or framebuffer may go unused before endFrame() frees it.
+		GAL_INLINE void setMaxIdleFrames(uint64_t frames) noexcept { maxIdleFrames = std::max<uint64_t>(frames, 1); }
+
+		GAL_NODISCARD GAL_INLINE RenderTargetPoolStats getStats() const noexcept
+		{
+			RenderTargetPoolStats result = lastFrameStats;
+			result.textureCount = entries.size();
+			result.texturesInUse = static_cast<size_t>(std::count_if(entries.begin(), entries.end(),
+				[](const Entry& entry) { return entry.inUse; }));
+			result.framebufferCount = framebuffers.size();
+			result.bytes = bytes;
+			result.peakBytes = stats.peakBytes;
+
+			return result;
+		}
+
+	private:
+		friend class TransientTarget;
+
+		struct Entry
+		{
+			std::unique_ptr<Texture> texture;
+			GLenum internalFormat;
+			GLsizei width;
+			GLsizei height;
+			bool inUse;
+			uint64_t lastUsedFrame;
+		};
+
+		struct CachedFramebuffer
+		{
+			std::unique_ptr<Framebuffer> framebuffer;
+			uint64_t lastUsedFrame = 0;
+		};
+
+		std::vector<Entry> entries;
+		std::map<std::vector<GLuint>, CachedFramebuffer> framebuffers; // Keyed by depth texture ID, then color texture IDs.
+
+		uint64_t frame = 0;
+		uint64_t maxIdleFrames = 3;
+		size_t bytes = 0;
+
+		RenderTargetPoolStats stats;
+		RenderTargetPoolStats lastFrameStats;
+
+		GAL_INLINE void release(const Texture* texture) noexcept
+		{
+			for (Entry& entry : entries)
+			{
+				if (entry.texture.get() == texture)
+				{
+					entry.inUse = false;
+					entry.lastUsedFrame = frame;
+
+					// Nothing may read what the last pass left behind, so the driver needn't preserve it.
+					glInvalidateTexImage(texture->getID(), 0);
+					return;
+				}
+			}
+		}
+
+		/// @brief Drop cached framebuffers with the given texture attached, before the texture is deleted and its ID reused.
+		GAL_INLINE void forgetFramebuffers(GLuint textureID)
+		{
+			for (auto it = framebuffers.begin(); it != framebuffers.end();)
+			{
+				if (std::find(it->first.begin(), it->first.end(), textureID) != it->first.end())
+					it = framebuffers.erase(it);
+				else
+					++it;
+			}
+		}
+	};
+
+	GAL_INLINE void TransientTarget::release() noexcept
+	{
+		if (pool != nullptr)
+			pool->release(texture);
+
+		pool = nullptr;
+		texture = nullptr;
+	}
+}
+
+#endif
@@ -0,0 +1,303 @@
+#ifndef GAL_SHADER_PREPROCESSOR_HPP
+#define GAL_SHADER_PREPROCESSOR_HPP
+
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "attributes.hpp"
+#include "enums.hpp"
+#include "GALException.hpp"
+#include "types.hpp"
+
+namespace gal
+{
+	namespace detail
+	{
+		/// @brief A shader source with all its #include directives resolved.
+		struct ExpandedShaderSource
+		{
+			std::string code;
+			std::vector<std::string> sourceNames; // Index i holds the file referred to by source string number i in #line directives.
+			std::vector<std::pair<std::filesystem::path, std::filesystem::file_time_type>> dependencies; // Every file read, with its mtime.
+		};
+
+		GAL_INLINE std::vector<std::filesystem::path> shaderIncludePaths;
+
+		// Sources added with addShaderIncludeSource(), keyed by the name they're included as.
+		GAL_INLINE std::unordered_map<std::string, std::string> shaderIncludeSources;
+
+		// Expanded sources, keyed by the canonical path of the root file.
+		GAL_INLINE std::unordered_map<std::string, ExpandedShaderSource> shaderSourceCache;
+
+		/// @brief A compiled shader object that can be shared between shader programs.
+		struct CachedShader
+		{
+			ShaderType type;
+			std::string source;
+			type::GALIDType shaderID;
+		};
+
+		// Compiled shader objects, keyed by the hash of their expanded source.
+		GAL_INLINE std::unordered_multimap<size_t, CachedShader> shaderObjectCache;
+
+		GAL_INLINE bool readShaderFile(const std::filesystem::path& path, std::string& out)
+		{
+			std::ifstream file(path);
+			if (!file.is_open())
+				return false;
+
+			std::stringstream buffer;
+			buffer << file.rdbuf();
+			out = buffer.str();
+
+			return true;
+		}
+
+		/// @brief Returns true if the line is a preprocessor directive with the given name, storing the rest of the line in rest.
+		GAL_INLINE bool matchDirective(std::string_view line, std::string_view name, std::string_view& rest)
+		{
+			size_t i = line.find_first_not_of(" \t");
+			if (i == std::string_view::npos || line[i] != '#')
+				return false;
+
+			i = line.find_first_not_of(" \t", i + 1);
+			if (i == std::string_view::npos || line.compare(i, name.size(), name) != 0)
+				return false;
+
+			rest = line.substr(i + name.size());
+			return rest.empty() || rest[0] == ' ' || rest[0] == '\t' || rest[0] == '"' || rest[0] == '<' || rest[0] == '\r';
+		}
+
+		/// @brief Resolve an include name to a file, searching the including file's directory first for "quoted" includes
+		/// and then every path added with addShaderIncludePath().
+		GAL_INLINE std::filesystem::path resolveShaderInclude(const std::string& name, const std::filesystem::path& includerDir, bool quoted)
+		{
+			if (quoted && !includerDir.empty() && std::filesystem::exists(includerDir / name))
+				return includerDir / name;
+
+			for (const std::filesystem::path& dir : shaderIncludePaths)
+			{
+				if (std::filesystem::exists(dir / name))
+					return dir / name;
+			}
+
+			return {};
+		}
+
+		GAL_INLINE void expandShaderFile(const std::filesystem::path& path, ExpandedShaderSource& out,
+			std::unordered_set<std::string>& included);
+
+		/// @brief Recursively append the expanded contents of a shader source to out. name is what the source is
+		/// listed as in out.sourceNames, and quoted includes are searched for in includerDir first.
+		GAL_INLINE void expandShaderSource(const std::string& contents, const std::string& name, const std::filesystem::path& includerDir,
+			ExpandedShaderSource& out, std::unordered_set<std::string>& included)
+		{
+			const size_t sourceNumber = out.sourceNames.size();
+			out.sourceNames.emplace_back(name);
+
+			// The root file keeps source string number 0, so it needs no #line of its own.
+			if (sourceNumber != 0)
+				out.code += "#line 1 " + std::to_string(sourceNumber) + '\n';
+
+			std::istringstream stream(contents);
+			std::string line;
+			size_t lineNumber = 0;
+
+			while (std::getline(stream, line))
+			{
+				++lineNumber;
+				std::string_view rest;
+
+				if (matchDirective(line, "include", rest))
+				{
+					const size_t open = rest.find_first_of("\"<");
+					const char closeChar = (open != std::string_view::npos && rest[open] == '<') ? '>' : '"';
+					const size_t close = open == std::string_view::npos ? open : rest.find(closeChar, open + 1);
+
+					if (close == std::string_view::npos)
+						detail::throwErr(ErrCode::ShaderIncludeFailed, "Malformed #include directive in shader file.");
+
+					const std::string includeName(rest.substr(open + 1, close - open - 1));
+
+					if (auto it = shaderIncludeSources.find(includeName); it != shaderIncludeSources.end())
+					{
+						if (included.insert(includeName).second)
+							expandShaderSource(it->second, includeName, {}, out, included);
+					}
+					else
+					{
+						const std::filesystem::path includePath = resolveShaderInclude(includeName, includerDir, closeChar == '"');
+
+						if (includePath.empty())
+							detail::throwErr(ErrCode::ShaderIncludeFailed, "Could not find file included by shader.");
+
+						expandShaderFile(includePath, out, included);
+					}
+
+					out.code += "#line " + std::to_string(lineNumber + 1) + ' ' + std::to_string(sourceNumber) + '\n';
+				}
+				else if (sourceNumber != 0 && matchDirective(line, "version", rest))
+				{
+					// Only the root file may declare a version. Keep the line so line numbers stay correct.
+					out.code += '\n';
+				}
+				else if (matchDirective(line, "pragma", rest) && rest.find("once") != std::string_view::npos)
+				{
+					out.code += '\n';
+				}
+				else
+				{
+					out.code += line;
+					out.code += '\n';
+				}
+			}
+		}
+
+		/// @brief Recursively append the expanded contents of a shader file to out.
+		/// Every file is included at most once per expansion, so headers don't need their own include guards
+		/// (although regular #ifndef guards still work, as the driver's preprocessor handles those).
+		GAL_INLINE void expandShaderFile(const std::filesystem::path& path, ExpandedShaderSource& out,
+			std::unordered_set<std::string>& included)
+		{
+			const std::filesystem::path canonicalPath = std::filesystem::weakly_canonical(path);
+			if (!included.insert(canonicalPath.string()).second)
+				return;
+
+			std::string contents;
+			if (!readShaderFile(canonicalPath, contents))
+				detail::throwErr(ErrCode::ShaderReadFailed, "Could not open shader file.");
+
+			out.dependencies.emplace_back(canonicalPath, std::filesystem::last_write_time(canonicalPath));
+			expandShaderSource(contents, canonicalPath.string(), canonicalPath.parent_path(), out, included);
+		}
+
+		/// @brief Get the expanded source of a shader file, re-expanding it only if it or any file it includes has been
+		/// modified since it was last expanded.
+		GAL_INLINE const ExpandedShaderSource& getExpandedShaderSource(const std::string& path)
+		{
+			std::error_code ec;
+			const std::string key = std::filesystem::weakly_canonical(path, ec).string();
+
+			if (ec)
+				detail::throwErr(ErrCode::ShaderReadFailed, "Could not open shader file.");
+
+			if (auto it = shaderSourceCache.find(key); it != shaderSourceCache.end())
+			{
+				bool upToDate = true;
+
+				for (const auto& [dependency, mtime] : it->second.dependencies)
+				{
+					if (std::filesystem::last_write_time(dependency, ec) != mtime || ec)
+					{
+						upToDate = false;
+						break;
+					}
+				}
+
+				if (upToDate)
+					return it->second;
+			}
+
+			ExpandedShaderSource expanded;
+			std::unordered_set<std::string> included;
+			expandShaderFile(key, expanded, included);
+
+			return shaderSourceCache[key] = std::move(expanded);
+		}
+
+		/// @brief Compile a shader object from the given source, throwing on failure.
+		/// sourceNames may be given to log which file each source string number in the error log refers to.
+		GAL_INLINE type::GALIDType compileShader(const std::string& source, ShaderType type,
+			const std::vector<std::string>* sourceNames = nullptr)
+		{
+			type::GALIDType shaderID = glCreateShader(static_cast<GLenum>(type));
+			const char* sourceCStr = source.c_str();
+			glShaderSource(shaderID, 1, &sourceCStr, nullptr);
+			glCompileShader(shaderID);
+
+			GLint success;
+			char infoLog[512];
+			glGetShaderiv(shaderID, GL_COMPILE_STATUS, &success);
+			if (!success)
+			{
+				glGetShaderInfoLog(shaderID, 512, nullptr, infoLog);
+				glDeleteShader(shaderID);
+				detail::logErr("Failed to compile shader. Error log from OpenGL to follow.");
+
+				if (sourceNames != nullptr && sourceNames->size() > 1)
+				{
+					detail::logErr("Source string numbers in the error log refer to the following files:");
+					for (size_t i = 0; i < sourceNames->size(); ++i)
+						detail::logErr(std::to_string(i) + ": " + (*sourceNames)[i]);
+				}
+
+				detail::throwErr(ErrCode::ShaderCompFailed, infoLog);
+			}
+
+			return shaderID;
+		}
+
+		/// @brief Get a compiled shader object for the given source, compiling it only if no shader with identical
+		/// source and type has been compiled before. The returned shader is owned by the cache and must not be deleted.
+		GAL_INLINE type::GALIDType acquireCachedShader(const std::string& source, ShaderType type,
+			const std::vector<std::string>* sourceNames = nullptr)
+		{
+			const size_t hash = std::hash<std::string>{}(source);
+
+			auto [begin, end] = shaderObjectCache.equal_range(hash);
+			for (auto it = begin; it != end; ++it)
+			{
+				// Compare the full source too so a hash collision can never hand out the wrong shader.
+				if (it->second.type == type && it->second.source == source)
+					return it->second.shaderID;
+			}
+
+			const type::GALIDType shaderID = compileShader(source, type, sourceNames);
+			shaderObjectCache.emplace(hash, CachedShader{ type, source, shaderID });
+
+			return shaderID;
+		}
+	}
+
+	/// @brief Add a directory to search when resolving #include directives in shader files.
+	/// "Quoted" includes are searched for relative to the including file first, <angled> includes only here.
+	GAL_INLINE void addShaderIncludePath(const std::string& directory)
+	{
+		detail::shaderIncludePaths.emplace_back(directory);
+	}
+
+	/// @brief Make a shader source includable under the given name, as if it were a file in an include path. Named
+	/// sources are checked before any file.
+	///
+	/// GAL's own GLSL modules, such as skinningShaderSource, are registered this way under the name their docs give,
+	/// e.g. addShaderIncludeSource("gal/skinning.glsl", skinningShaderSource), and included in vertex shader files. They
+	/// can also be pasted after the #version line of a shader source string. They need GLSL 4.30.
+	GAL_INLINE void addShaderIncludeSource(const std::string& name, const std::string& source)
+	{
+		detail::shaderIncludeSources[name] = source;
+
+		// Expanded sources only track files, so drop them all in case one included an older version of this source.
+		detail::shaderSourceCache.clear();
+	}
+
+	/// @brief Delete every cached shader object and expanded shader source. Shader programs that were already linked
+	/// are unaffected.
+	GAL_INLINE void clearShaderCache()
+	{
+		for (const auto& [hash, shader] : detail::shaderObjectCache)
+			glDeleteShader(shader.shaderID);
+
+		detail::shaderObjectCache.clear();
+		detail::shaderSourceCache.clear();
+	}
+}
+
+#endif
@@ -1,14 +1,13 @@
 #ifndef GAL_SHADER_PROGRAM_HPP
 #define GAL_SHADER_PROGRAM_HPP
 
-#include <fstream>
-#include <sstream>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "attributes.hpp"
 #include "ResourceTracker.hpp"
+#include "ShaderPreprocessor.hpp"
 #include "types.hpp"
 
 namespace gal
@@ -50,16 +49,19 @@ namespace gal
 			detail::shaderProgramTracker.remove(programID);
 		}
 
-		/// @brief Add a shader of the given type to the program, reading the source code from the given filepath. 
+		/// @brief Add a shader of the given type to the program, reading the source code from the given filepath.
+		/// #include directives in the file are resolved (see addShaderIncludePath()), and the compiled shader object
+		/// is shared with any other program that was given a file with identical expanded source.
 		GAL_INLINE ShaderProgram& addShaderFromFile(const std::string& path, ShaderType type)
 		{
-			std::ifstream file(path);
-			if (!file.is_open())
-				detail::throwErr(ErrCode::ShaderReadFailed, "Could not open shader file.");
+			if (linked)
+				detail::throwErr(ErrCode::AddShaderAfterLinking, "Attempted to add shader to program after the program had already been linked.");
 
-			std::stringstream buffer;
-			buffer << file.rdbuf();
-			addShaderFromSource(buffer.str(), type);
+			const detail::ExpandedShaderSource& source = detail::getExpandedShaderSource(path);
+			type::GALIDType shaderID = detail::acquireCachedShader(source.code, type, &source.sourceNames);
+
+			glAttachShader(programID, shaderID);
+			cachedShaderIDs.emplace_back(shaderID);
 
 			return *this;
 		}
@@ -70,20 +72,7 @@ namespace gal
 			if (linked)
 				detail::throwErr(ErrCode::AddShaderAfterLinking, "Attempted to add shader to program after the program had already been linked.");
 
-			type::GALIDType shaderID = glCreateShader(static_cast<GLenum>(type));
-			const char* sourceCStr = source.c_str();
-			glShaderSource(shaderID, 1, &sourceCStr, nullptr);
-			glCompileShader(shaderID);
-
-			GLint success;
-			char infoLog[512];
-			glGetShaderiv(shaderID, GL_COMPILE_STATUS, &success);
-			if (!success)
-			{
-				glGetShaderInfoLog(shaderID, 512, nullptr, infoLog);
-				detail::logErr("Failed to compile shader. Error log from OpenGL to follow.");
-				detail::throwErr(ErrCode::ShaderCompFailed, infoLog);
-			}
+			type::GALIDType shaderID = detail::compileShader(source, type);
 
 			glAttachShader(programID, shaderID);
 			shaderIDs.emplace_back(shaderID);
@@ -91,6 +80,26 @@ namespace gal
 			return *this;
 		}
 
+		/// @brief Set which vertex shader outputs are recorded into transform feedback buffers (see TransformFeedbackCapture).
+		/// Must be called before linking. bufferMode is GL_INTERLEAVED_ATTRIBS to write every varying into one buffer,
+		/// or GL_SEPARATE_ATTRIBS to write each varying into the buffer bound at its own index.
+		GAL_INLINE ShaderProgram& setTransformFeedbackVaryings(const std::vector<std::string>& varyings,
+			GLenum bufferMode = GL_INTERLEAVED_ATTRIBS)
+		{
+			if (linked)
+				detail::throwErr(ErrCode::TransformFeedbackVaryingsAfterLinking,
+					"Attempted to set transform feedback varyings after the program had already been linked.");
+
+			std::vector<const char*> names;
+			names.reserve(varyings.size());
+			for (const std::string& varying : varyings)
+				names.push_back(varying.c_str());
+
+			glTransformFeedbackVaryings(programID, static_cast<GLsizei>(names.size()), names.data(), bufferMode);
+
+			return *this;
+		}
+
 		GAL_NODISCARD GAL_INLINE type::GALShaderProgramID getID() const noexcept
 		{
 			return programID;
@@ -202,6 +211,12 @@ namespace gal
 			return *this;
 		}
 
+		GAL_INLINE const ShaderProgram& setUniform(const std::string& name, const glm::vec4* vecs, GLsizei count) const
+		{
+			glProgramUniform4fv(programID, getUniformLocation(name), count, glm::value_ptr(*vecs));
+			return *this;
+		}
+
 		// ========== int uniform setters ==========
 
 		GAL_INLINE const ShaderProgram& setUniform(const std::string& name, bool val) const
@@ -369,6 +384,7 @@ namespace gal
 		type::GALShaderProgramID programID;
 		bool linked = false;
 		std::vector<type::GALIDType> shaderIDs; // List of shader IDs that haven't been deleted yet.
+		std::vector<type::GALIDType> cachedShaderIDs; // List of attached shader IDs owned by the shader cache.
 		mutable std::unordered_map<std::string, int> uniformLocationss; // Cached locations of uniforms.
 
 		GAL_INLINE void deleteAllShaders()
@@ -380,6 +396,12 @@ namespace gal
 			}
 
 			shaderIDs.clear();
+
+			// Shared shaders stay alive in the cache for other programs to use.
+			for (type::GALIDType id : cachedShaderIDs)
+				glDetachShader(programID, id);
+
+			cachedShaderIDs.clear();
 		}
 
 		GAL_INLINE GLint getUniformLocation(const std::string& name) const
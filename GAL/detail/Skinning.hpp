@@ -0,0 +1,187 @@
+#ifndef GAL_SKINNING_HPP
+#define GAL_SKINNING_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "attributes.hpp"
+#include "Buffer.hpp"
+#include "enums.hpp"
+#include "GALException.hpp"
+#include "InstanceStorageBuffer.hpp"
+#include "ShaderPreprocessor.hpp"
+#include "ShaderProgram.hpp"
+#include "TransformArray.hpp"
+
+namespace gal
+{
+	/// @brief GLSL linear blend skinning against a JointPalette, included as <gal/skinning.glsl> (see
+	/// addShaderIncludeSource()).
+	///
+	/// galSkinningMatrix(joints, weights, instance) blends the instance's joint matrices, and galSkinPosition() and
+	/// galSkinDirection() apply the result. Pass gl_InstanceID as the instance, or 0 when drawing a single skinned mesh.
+	/// When drawing with a base instance, add gl_BaseInstance, which needs GLSL 4.60 or ARB_shader_draw_parameters.
+	GAL_INLINE const char* const skinningShaderSource = R"(
+#ifndef GAL_JOINT_PALETTE_BINDING
+#define GAL_JOINT_PALETTE_BINDING 4
+#endif
+
+// The top three rows of each skinning matrix, one instance's joints after another.
+layout(std430, binding = GAL_JOINT_PALETTE_BINDING) readonly buffer GALJointPalette { mat3x4 galJointPalette[]; };
+
+uniform uint galJointCount;
+
+mat3x4 galSkinningMatrix(uvec4 joints, vec4 weights, uint instance)
+{
+	uint first = instance * galJointCount;
+	return galJointPalette[first + joints.x] * weights.x
+		+ galJointPalette[first + joints.y] * weights.y
+		+ galJointPalette[first + joints.z] * weights.z
+		+ galJointPalette[first + joints.w] * weights.w;
+}
+
+vec3 galSkinPosition(mat3x4 skinning, vec3 position)
+{
+	return vec4(position, 1.0) * skinning;
+}
+
+// Exact for normals as long as the joints are only rotated and uniformly scaled. Normalize the result.
+vec3 galSkinDirection(mat3x4 skinning, vec3 direction)
+{
+	return vec4(direction, 0.0) * skinning;
+}
+)";
+
+	/// @brief The joint hierarchy of a skinned mesh: each joint's parent and the inverse of its model space bind pose.
+	class Skeleton
+	{
+	public:
+		/// @brief Joints must come after their parents. Roots have a parent of -1.
+		GAL_INLINE Skeleton(std::vector<int32_t> parents, std::vector<glm::mat4> inverseBindMatrices)
+			: parents(std::move(parents)), inverseBindMatrices(std::move(inverseBindMatrices))
+		{
+			if (this->parents.size() != this->inverseBindMatrices.size())
+				detail::throwErr(ErrCode::InvalidSkeleton, "A skeleton needs exactly one inverse bind matrix per joint.");
+
+			for (size_t joint = 0; joint < this->parents.size(); ++joint)
+			{
+				if (this->parents[joint] < -1 || this->parents[joint] >= static_cast<int32_t>(joint))
+					detail::throwErr(ErrCode::InvalidSkeleton, "A skeleton joint came before its parent or had an invalid parent.");
+			}
+		}
+
+		GAL_NODISCARD GAL_INLINE GLuint getJointCount() const noexcept { return static_cast<GLuint>(parents.size()); }
+		GAL_NODISCARD GAL_INLINE int32_t getParent(GLuint joint) const noexcept { return parents[joint]; }
+		GAL_NODISCARD GAL_INLINE const glm::mat4& getInverseBindMatrix(GLuint joint) const noexcept { return inverseBindMatrices[joint]; }
+
+		/// @brief Turn the local (relative to the parent) matrices of instanceCount poses of this skeleton, one pose's
+		/// joints after another, into skinning matrices in place.
+		GAL_INLINE void computeSkinningMatrices(glm::mat4* matrices, size_t instanceCount) const noexcept
+		{
+			const size_t jointCount = parents.size();
+
+			for (size_t instance = 0; instance < instanceCount; ++instance)
+			{
+				glm::mat4* pose = matrices + instance * jointCount;
+
+				// Parents come first, so each parent is already in model space when its children are reached.
+				for (size_t joint = 0; joint < jointCount; ++joint)
+				{
+					if (parents[joint] >= 0)
+						pose[joint] = pose[parents[joint]] * pose[joint];
+				}
+
+				for (size_t joint = 0; joint < jointCount; ++joint)
+					pose[joint] = pose[joint] * inverseBindMatrices[joint];
+			}
+		}
+
+		/// @brief Compute skinning matrices from local joint transforms, e.g. written by an AnimationSampler. poses holds
+		/// one pose's joints after another, so its size should be a multiple of the joint count.
+		GAL_INLINE void computeSkinningMatrices(const TransformArray& poses, std::vector<glm::mat4>& out, unsigned threadCount = 1) const
+		{
+			out.resize(poses.size());
+			poses.computeMatrices(out.data(), TransformMatrixLayout::Mat4, 0, TransformArray::All, threadCount);
+
+			if (!parents.empty())
+				computeSkinningMatrices(out.data(), out.size() / parents.size());
+		}
+
+	private:
+		std::vector<int32_t> parents;
+		std::vector<glm::mat4> inverseBindMatrices;
+	};
+
+	/// @brief Skinning matrices for up to maxInstances poses of a skeleton, in a shader storage buffer laid out for
+	/// skinningShaderSource. Uploading this every frame replaces re-uploading skinned vertices, and instances of one
+	/// mesh with different poses can be drawn in a single instanced draw.
+	class JointPalette
+	{
+	public:
+		/// @brief The binding skinningShaderSource reads the palette from unless GAL_JOINT_PALETTE_BINDING is defined.
+		GAL_STATIC GAL_CONSTEXPR GLuint DefaultBinding = 4;
+
+		/// @brief Allocate room for maxInstances poses of jointCount joints. Requires a current OpenGL context.
+		GAL_INLINE JointPalette(GLuint jointCount, GLuint maxInstances = 1)
+			: storage(jointCount, maxInstances, MatrixSize, GL_DYNAMIC_STORAGE_BIT | GL_MAP_WRITE_BIT) { }
+
+		// Forbid copying.
+		GAL_INLINE JointPalette(const JointPalette&) = delete;
+		GAL_INLINE JointPalette& operator=(const JointPalette&) = delete;
+
+		// Allow moving.
+		GAL_INLINE JointPalette(JointPalette&&) noexcept = default;
+		GAL_INLINE JointPalette& operator=(JointPalette&&) noexcept = default;
+
+		GAL_NODISCARD GAL_INLINE GLuint getJointCount() const noexcept { return storage.getCountPerInstance(); }
+		GAL_NODISCARD GAL_INLINE GLuint getMaxInstances() const noexcept { return storage.getMaxInstances(); }
+		GAL_NODISCARD GAL_INLINE const Buffer& getBuffer() const noexcept { return storage.getBuffer(); }
+
+		/// @brief Write instanceCount poses of skinning matrices, one pose's joints after another, starting at pose
+		/// firstInstance. Returns false if mapping failed or the data was lost while mapped.
+		GAL_INLINE bool write(const glm::mat4* skinningMatrices, GLuint firstInstance = 0, GLuint instanceCount = 1)
+		{
+			const size_t matrixCount = storage.getWriteCount(firstInstance, instanceCount);
+			if (matrixCount == 0)
+				return true;
+
+			Buffer& buffer = storage.getBuffer();
+			float* mapped = static_cast<float*>(buffer.mapRange(storage.getOffset(firstInstance),
+				static_cast<GLsizeiptr>(matrixCount * MatrixSize), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT));
+			if (mapped == nullptr)
+				return false;
+
+			// Rows of the 3x4 part, matching a GLSL mat3x4 applied as vec4(position, 1.0) * m.
+			for (size_t i = 0; i < matrixCount; ++i)
+			{
+				const glm::mat4& matrix = skinningMatrices[i];
+				for (int row = 0; row < 3; ++row)
+				{
+					for (int col = 0; col < 4; ++col)
+						mapped[i * 12 + row * 4 + col] = matrix[col][row];
+				}
+			}
+
+			return buffer.unmap();
+		}
+
+		GAL_INLINE bool write(const std::vector<glm::mat4>& skinningMatrices, GLuint firstInstance = 0)
+		{
+			return write(skinningMatrices.data(), firstInstance, storage.getInstanceCount(skinningMatrices.size()));
+		}
+
+		/// @brief Bind the palette for skinningShaderSource and set the program's galJointCount uniform.
+		GAL_INLINE void bind(const ShaderProgram& program, GLuint binding = DefaultBinding) const
+		{
+			storage.bind(program, "galJointCount", binding);
+		}
+
+	private:
+		GAL_STATIC GAL_CONSTEXPR GLsizeiptr MatrixSize = sizeof(float) * 12;
+
+		detail::InstanceStorageBuffer storage;
+	};
+}
+
+#endif
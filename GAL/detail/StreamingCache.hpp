@@ -0,0 +1,283 @@
+#ifndef GAL_STREAMING_CACHE_HPP
+#define GAL_STREAMING_CACHE_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "attributes.hpp"
+#include "logging.hpp"
+#include "Texture.hpp"
+
+namespace gal
+{
+	namespace detail
+	{
+		/// @brief The streaming shared by VirtualTexture and BrickedVolume: worker threads loading numbered items in
+		/// priority order, and a fixed number of slots holding the resident ones, evicting the least recently wanted.
+		/// The last item is the coarsest, which everything falls back to, so it's never evicted.
+		///
+		/// Everything but the loader runs on the render thread. The owner copies item data into its slots and keeps
+		/// its lookup texture up to date when items become resident or are evicted.
+		class StreamingCache
+		{
+		public:
+			/// @brief Load one item into out, which holds the item size given to the constructor. Returns false on failure.
+			/// Called from worker threads.
+			using Loader = std::function<bool(uint32_t item, unsigned char* out)>;
+
+			/// @brief No item, e.g. when a slot was free and nothing had to be evicted.
+			GAL_STATIC GAL_CONSTEXPR uint32_t NoItem = UINT32_MAX;
+
+			struct Stats
+			{
+				size_t uploadsLastUpdate = 0;
+				size_t evictionsLastUpdate = 0;
+
+				size_t totalUploads = 0;
+				size_t totalEvictions = 0;
+				size_t failedItems = 0; // Items the loader failed to load. They're never requested again.
+			};
+
+			GAL_INLINE StreamingCache(uint32_t itemCount, size_t slotCount, size_t itemBytes)
+				: itemSlots(itemCount, 0), slots(slotCount), itemBytes(itemBytes)
+			{
+				for (size_t slot = slots.size(); slot-- > 0;)
+					freeSlots.push_back(static_cast<uint32_t>(slot));
+			}
+
+			// Forbid copying and moving, as worker threads hold a pointer to the cache.
+			GAL_INLINE StreamingCache(const StreamingCache&) = delete;
+			GAL_INLINE StreamingCache& operator=(const StreamingCache&) = delete;
+
+			GAL_INLINE ~StreamingCache()
+			{
+				{
+					std::lock_guard<std::mutex> lock(jobMutex);
+					stopping = true;
+				}
+
+				jobCondition.notify_all();
+				for (std::thread& worker : workers)
+					worker.join();
+			}
+
+			/// @brief Start loading items with the given loader on workerCount threads, or one less than the number of
+			/// hardware threads for 0.
+			GAL_INLINE void start(Loader itemLoader, unsigned workerCount)
+			{
+				loader = std::move(itemLoader);
+
+				if (workerCount == 0)
+					workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+				for (unsigned i = 0; i < workerCount; ++i)
+					workers.emplace_back([this] { workerLoop(); });
+			}
+
+			/// @brief Start a new frame. Slots wanted from now on are kept over slots wanted before.
+			GAL_INLINE void beginFrame() noexcept
+			{
+				++frame;
+				stats.uploadsLastUpdate = 0;
+				stats.evictionsLastUpdate = 0;
+			}
+
+			/// @brief Get an item's slot + 1, or 0 if it isn't resident.
+			GAL_NODISCARD GAL_INLINE uint32_t getSlot(uint32_t item) const noexcept { return itemSlots[item]; }
+
+			/// @brief Keep a resident item's slot over ones not wanted this frame.
+			GAL_INLINE void markWanted(uint32_t item) noexcept { slots[itemSlots[item] - 1].lastWanted = frame; }
+
+			/// @brief Replace the queue with the given missing items, most important first, and wake the workers. Items no
+			/// longer wanted are dropped from the queue. Ones already being loaded finish anyway.
+			GAL_INLINE void request(const std::vector<uint32_t>& items)
+			{
+				{
+					std::lock_guard<std::mutex> lock(jobMutex);
+
+					for (uint32_t item : jobs)
+						pending.erase(item);
+
+					jobs.clear();
+					for (uint32_t item : items)
+					{
+						if (failed.count(item) == 0 && pending.insert(item).second)
+							jobs.push_back(item);
+					}
+				}
+
+				jobCondition.notify_all();
+			}
+
+			/// @brief Take a free slot for an item, or else evict the item least recently wanted before this frame.
+			/// @param evicted: Set to the evicted item, or NoItem.
+			/// @return Whether a slot could be found.
+			GAL_INLINE bool insert(uint32_t item, uint32_t& slot, uint32_t& evicted)
+			{
+				evicted = NoItem;
+
+				if (!freeSlots.empty())
+				{
+					slot = freeSlots.back();
+					freeSlots.pop_back();
+				}
+				else
+				{
+					const uint32_t pinnedItem = static_cast<uint32_t>(itemSlots.size()) - 1;
+					uint64_t oldest = frame;
+
+					for (uint32_t i = 0; i < static_cast<uint32_t>(slots.size()); ++i)
+					{
+						if (slots[i].item != pinnedItem && slots[i].lastWanted < oldest)
+						{
+							oldest = slots[i].lastWanted;
+							slot = i;
+							evicted = slots[i].item;
+						}
+					}
+
+					if (evicted == NoItem)
+						return false;
+
+					itemSlots[evicted] = 0;
+					stats.evictionsLastUpdate++;
+					stats.totalEvictions++;
+				}
+
+				slots[slot] = { item, frame };
+				itemSlots[item] = slot + 1;
+				return true;
+			}
+
+			/// @brief Hand up to maxUploads items the workers finished to upload(item, data), which puts them in a slot
+			/// with insert() and returns whether it could. Failures are logged with failureMessage and never retried.
+			template<typename Upload>
+			GAL_INLINE void uploadLoaded(int maxUploads, const char* failureMessage, Upload&& upload)
+			{
+				for (int uploads = 0; uploads < maxUploads; ++uploads)
+				{
+					LoadedItem loaded;
+
+					{
+						std::lock_guard<std::mutex> lock(resultMutex);
+						if (results.empty())
+							break;
+
+						loaded = std::move(results.front());
+						results.pop_front();
+					}
+
+					{
+						std::lock_guard<std::mutex> lock(jobMutex);
+						pending.erase(loaded.item);
+
+						if (!loaded.success)
+							failed.insert(loaded.item);
+					}
+
+					if (!loaded.success)
+					{
+						stats.failedItems++;
+						logErr(failureMessage);
+						continue;
+					}
+
+					// Dropped if every slot was wanted this frame. It'll be requested again.
+					if (itemSlots[loaded.item] == 0 && upload(loaded.item, loaded.data.data()))
+					{
+						stats.uploadsLastUpdate++;
+						stats.totalUploads++;
+					}
+				}
+			}
+
+			GAL_NODISCARD GAL_INLINE const Stats& getStats() const noexcept { return stats; }
+			GAL_NODISCARD GAL_INLINE size_t getSlotCount() const noexcept { return slots.size(); }
+			GAL_NODISCARD GAL_INLINE size_t getResidentCount() const noexcept { return slots.size() - freeSlots.size(); }
+
+			/// @brief Items queued for or being loaded by the workers, or loaded and waiting to be uploaded.
+			GAL_NODISCARD GAL_INLINE size_t getPendingCount()
+			{
+				std::lock_guard<std::mutex> lock(jobMutex);
+				return pending.size();
+			}
+
+		private:
+			struct Slot
+			{
+				uint32_t item = 0;
+				uint64_t lastWanted = 0;
+			};
+
+			struct LoadedItem
+			{
+				uint32_t item;
+				bool success;
+				std::vector<unsigned char> data;
+			};
+
+			Loader loader;
+			std::vector<uint32_t> itemSlots; // Per item, its slot + 1, or 0 if not resident.
+			std::vector<Slot> slots;
+			std::vector<uint32_t> freeSlots;
+			size_t itemBytes;
+			uint64_t frame = 0;
+
+			std::vector<std::thread> workers;
+			std::mutex jobMutex;
+			std::condition_variable jobCondition;
+			std::deque<uint32_t> jobs; // Most important first.
+			std::unordered_set<uint32_t> pending; // Queued, being loaded or loaded but not yet uploaded.
+			std::unordered_set<uint32_t> failed;
+			bool stopping = false;
+
+			std::mutex resultMutex;
+			std::deque<LoadedItem> results;
+
+			Stats stats;
+
+			GAL_INLINE void workerLoop()
+			{
+				std::vector<unsigned char> data(itemBytes);
+
+				while (true)
+				{
+					uint32_t item;
+
+					{
+						std::unique_lock<std::mutex> lock(jobMutex);
+						jobCondition.wait(lock, [this] { return stopping || !jobs.empty(); });
+
+						if (stopping)
+							return;
+
+						item = jobs.front();
+						jobs.pop_front();
+					}
+
+					const bool success = loader(item, data.data());
+
+					std::lock_guard<std::mutex> lock(resultMutex);
+					results.push_back({ item, success, success ? data : std::vector<unsigned char>() });
+				}
+			}
+		};
+
+		/// @brief Set up the filtering of an integer lookup texture. Integer textures are incomplete with linear
+		/// filtering, even though they're only read with texelFetch.
+		GAL_INLINE void setIntegerTextureFiltering(Texture& texture) noexcept
+		{
+			texture.setParameter(GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+			texture.setParameter(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		}
+	}
+}
+
+#endif
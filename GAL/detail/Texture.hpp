@@ -1,8 +1,25 @@
 #ifndef GAL_TEXTURE_HPP
 #define GAL_TEXTURE_HPP
 
+#include <algorithm>
+#include <cstdint>
+
 #include "attributes.hpp"
 
+// S3TC is an extension rather than core, so the loader may not have generated these.
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
 namespace gal
 {
 	namespace detail
@@ -13,6 +30,54 @@ namespace gal
 		}
 
 		GAL_INLINE ResourceTracker<type::GALTextureID, deleteTexture> textureTracker;
+
+		/// @brief Frame number recorded by Texture::bind() and Texture::bindTextureUnit(). Advanced by
+		/// TextureResidencyManager::update(), so textures that are bound can be told apart from ones that aren't.
+		GAL_INLINE uint64_t textureFrame = 0;
+
+		/// @brief Size in bytes of one width x height image of the given internal format as drivers typically store it.
+		/// Compressed formats are rounded up to whole 4x4 blocks, and 3 component formats are counted as padded to 4.
+		GAL_NODISCARD GAL_INLINE size_t imageByteSize(GLenum internalFormat, GLsizei width, GLsizei height) noexcept
+		{
+			const size_t blocks = static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4);
+			const size_t texels = static_cast<size_t>(width) * height;
+
+			switch (internalFormat)
+			{
+				case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+				case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+				case GL_COMPRESSED_RED_RGTC1:
+				case GL_COMPRESSED_SIGNED_RED_RGTC1:
+					return blocks * 8;
+
+				case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+				case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+				case GL_COMPRESSED_RG_RGTC2:
+				case GL_COMPRESSED_SIGNED_RG_RGTC2:
+				case GL_COMPRESSED_RGBA_BPTC_UNORM:
+				case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+				case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+				case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+					return blocks * 16;
+
+				case GL_RED: case GL_R8: case GL_R8_SNORM: case GL_R8UI: case GL_R8I: case GL_STENCIL_INDEX8:
+					return texels;
+
+				case GL_RG: case GL_RG8: case GL_RG8_SNORM: case GL_RG8UI: case GL_RG8I:
+				case GL_R16: case GL_R16_SNORM: case GL_R16F: case GL_R16UI: case GL_R16I: case GL_DEPTH_COMPONENT16:
+					return texels * 2;
+
+				case GL_RGBA16: case GL_RGBA16_SNORM: case GL_RGBA16F: case GL_RGBA16UI: case GL_RGBA16I:
+				case GL_RGB16: case GL_RGB16F: case GL_RG32F: case GL_RG32UI: case GL_RG32I: case GL_DEPTH32F_STENCIL8:
+					return texels * 8;
+
+				case GL_RGBA32F: case GL_RGBA32UI: case GL_RGBA32I: case GL_RGB32F: case GL_RGB32UI: case GL_RGB32I:
+					return texels * 16;
+
+				default: // RGBA8, SRGB8_ALPHA8, RGB8, RGB10_A2, R11F_G11F_B10F, R32F, DEPTH24_STENCIL8 etc.
+					return texels * 4;
+			}
+		}
 	}
 
 	class Texture
@@ -48,10 +113,18 @@ namespace gal
 		GAL_NODISCARD GAL_INLINE GLsizei getDepth() const noexcept { return depth; }
 
 		/// @brief Bind this texture for use. DSA is encouraged where possible. 
-		GAL_INLINE void bind() const noexcept { glBindTexture(type, textureID); }
+		GAL_INLINE void bind() const noexcept
+		{
+			glBindTexture(type, textureID);
+			lastUsedFrame = detail::textureFrame;
+		}
 
 		/// @brief Bind this texture to the given texture unit.
-		GAL_INLINE void bindTextureUnit(int unit) const noexcept { glBindTextureUnit(unit, textureID); }
+		GAL_INLINE void bindTextureUnit(int unit) const noexcept
+		{
+			glBindTextureUnit(unit, textureID);
+			lastUsedFrame = detail::textureFrame;
+		}
 
 		/// @brief Set a parameter of the texture. 
 		GAL_INLINE void setParameter(GLenum parameterName, float val) noexcept { glTextureParameterf(textureID, parameterName, val); }
@@ -72,6 +145,9 @@ namespace gal
 			this->width = width;
 			this->height = height;
 			this->depth = depth;
+			this->internalFormat = internalFormat;
+			this->mipmapLevels = mipmapLevels;
+			immutable = true;
 		}
 
 		/// @brief Bind this texture, then allocate and write to mutable storage for it. 
@@ -96,21 +172,90 @@ namespace gal
 			this->width = width;
 			this->height = height;
 			this->depth = depth;
+			this->internalFormat = internalFormat;
+			this->mipmapLevels = std::max(this->mipmapLevels, static_cast<GLint>(mipmapLevel) + 1);
+		}
+
+		/// @brief Write to a region of one mipmap level of this texture's storage. If a buffer is bound to
+		/// GL_PIXEL_UNPACK_BUFFER, data is a byte offset into that buffer instead of a pointer.
+		GAL_INLINE void subImage(GLint mipmapLevel, GLenum format, GLenum type, const void* data,
+			GLsizei width, GLsizei height = 0, GLsizei depth = 0, GLint xOffset = 0, GLint yOffset = 0, GLint zOffset = 0) noexcept
+		{
+			if (height == 0 && depth == 0)
+				glTextureSubImage1D(textureID, mipmapLevel, xOffset, width, format, type, data);
+			else if (depth == 0)
+				glTextureSubImage2D(textureID, mipmapLevel, xOffset, yOffset, width, height, format, type, data);
+			else
+				glTextureSubImage3D(textureID, mipmapLevel, xOffset, yOffset, zOffset, width, height, depth, format, type, data);
+		}
+
+		/// @brief Write already compressed blocks to a region of one mipmap level of this texture's storage.
+		/// The internal format must match the one passed to storage(). As with subImage(), data is a byte offset
+		/// if a buffer is bound to GL_PIXEL_UNPACK_BUFFER.
+		GAL_INLINE void compressedSubImage(GLint mipmapLevel, GLenum internalFormat, const void* data, GLsizei imageSize,
+			GLsizei width, GLsizei height = 0, GLsizei depth = 0, GLint xOffset = 0, GLint yOffset = 0, GLint zOffset = 0) noexcept
+		{
+			if (height == 0 && depth == 0)
+				glCompressedTextureSubImage1D(textureID, mipmapLevel, xOffset, width, internalFormat, imageSize, data);
+			else if (depth == 0)
+				glCompressedTextureSubImage2D(textureID, mipmapLevel, xOffset, yOffset, width, height, internalFormat, imageSize, data);
+			else
+				glCompressedTextureSubImage3D(textureID, mipmapLevel, xOffset, yOffset, zOffset, width, height, depth,
+					internalFormat, imageSize, data);
 		}
 
 		/// @brief Binds this texture and generates its mipmap. 
 		GAL_INLINE void generateMipmapAB() noexcept
 		{
 			bind();
-			glGenerateMipmap(type);
+			generateMipmapNB();
 		}
 
 		/// @brief Generates this texture's mipmap. 
 		GAL_INLINE void generateMipmapNB() noexcept
 		{
 			glGenerateMipmap(type);
+
+			// Mutable storage gains the rest of the chain, immutable storage keeps the levels it was given.
+			if (!immutable)
+			{
+				const GLsizei largest = std::max(width, std::max(height, type == GL_TEXTURE_3D ? depth : 0));
+				GLint levels = 1;
+				while (largest >> levels)
+					++levels;
+
+				mipmapLevels = levels;
+			}
 		}
 
+		GAL_NODISCARD GAL_INLINE GLenum getInternalFormat() const noexcept { return internalFormat; }
+		GAL_NODISCARD GAL_INLINE GLint getMipmapLevels() const noexcept { return mipmapLevels; }
+		GAL_NODISCARD GAL_INLINE bool hasImmutableStorage() const noexcept { return immutable; }
+
+		/// @brief Estimate the video memory used by this texture's storage across all its mipmap levels.
+		GAL_NODISCARD GAL_INLINE size_t getByteSize() const noexcept
+		{
+			size_t total = 0;
+			for (GLint level = 0; level < mipmapLevels; ++level)
+			{
+				const GLsizei levelWidth = std::max(width >> level, 1);
+				const GLsizei levelHeight = height == 0 ? 1 : std::max(height >> level, 1);
+
+				// Array layers aren't mipmapped, the depth of 3D textures is.
+				GLsizei levelDepth = std::max(depth, 1);
+				if (type == GL_TEXTURE_3D)
+					levelDepth = std::max(depth >> level, 1);
+
+				total += detail::imageByteSize(internalFormat, levelWidth, levelHeight) * levelDepth;
+			}
+
+			return type == GL_TEXTURE_CUBE_MAP ? total * 6 : total;
+		}
+
+		/// @brief Get the value of the texture frame counter when this texture was last bound.
+		/// See TextureResidencyManager.
+		GAL_NODISCARD GAL_INLINE uint64_t getLastUsedFrame() const noexcept { return lastUsedFrame; }
+
 	private:
 		type::GALTextureID textureID;
 		GLenum type;
@@ -118,6 +263,11 @@ namespace gal
 		GLsizei width = 0;
 		GLsizei height = 0;
 		GLsizei depth = 0;
+		GLenum internalFormat = 0;
+		GLint mipmapLevels = 0;
+		bool immutable = false;
+
+		mutable uint64_t lastUsedFrame = 0;
 	};
 }
 
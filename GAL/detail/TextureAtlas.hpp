@@ -0,0 +1,358 @@
+#ifndef GAL_TEXTURE_ATLAS_HPP
+#define GAL_TEXTURE_ATLAS_HPP
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include "attributes.hpp"
+#include "enums.hpp"
+#include "GALException.hpp"
+#include "Texture.hpp"
+
+namespace gal
+{
+	/// @brief Packs rectangles into a fixed size bin with the skyline bottom-left heuristic.
+	/// The bin is described by its skyline (the top edge of everything placed so far), so inserting is cheap and
+	/// never moves existing rectangles. Space under overhangs is wasted, which is a good trade for incremental use.
+	class SkylinePacker
+	{
+	public:
+		GAL_INLINE SkylinePacker(GLsizei width, GLsizei height)
+			: width(width), height(height)
+		{
+			clear();
+		}
+
+		/// @brief Find space for a width x height rectangle and reserve it.
+		/// @return The bottom-left corner of the reserved space, or nothing if it doesn't fit.
+		GAL_NODISCARD GAL_INLINE std::optional<glm::ivec2> insert(GLsizei rectWidth, GLsizei rectHeight)
+		{
+			size_t bestIndex = nodes.size();
+			GLsizei bestTop = std::numeric_limits<GLsizei>::max();
+			GLsizei bestWidth = std::numeric_limits<GLsizei>::max();
+			GLsizei bestY = 0;
+
+			for (size_t i = 0; i < nodes.size(); ++i)
+			{
+				GLsizei y;
+				if (!fits(i, rectWidth, rectHeight, y))
+					continue;
+
+				// Lowest top edge first, then the narrowest skyline segment to keep wide gaps free.
+				const GLsizei top = y + rectHeight;
+				if (top < bestTop || (top == bestTop && nodes[i].width < bestWidth))
+				{
+					bestIndex = i;
+					bestTop = top;
+					bestWidth = nodes[i].width;
+					bestY = y;
+				}
+			}
+
+			if (bestIndex == nodes.size())
+				return std::nullopt;
+
+			const GLsizei x = nodes[bestIndex].x;
+			addNode(bestIndex, x, bestY + rectHeight, rectWidth);
+			usedArea += static_cast<size_t>(rectWidth) * rectHeight;
+
+			return glm::ivec2(x, bestY);
+		}
+
+		/// @brief Forget every rectangle, making the whole bin free again.
+		GAL_INLINE void clear()
+		{
+			nodes.assign(1, { 0, 0, width });
+			usedArea = 0;
+		}
+
+		GAL_NODISCARD GAL_INLINE GLsizei getWidth() const noexcept { return width; }
+		GAL_NODISCARD GAL_INLINE GLsizei getHeight() const noexcept { return height; }
+
+		/// @brief Fraction of the bin covered by inserted rectangles.
+		GAL_NODISCARD GAL_INLINE float getOccupancy() const noexcept
+		{
+			return static_cast<float>(usedArea) / (static_cast<float>(width) * height);
+		}
+
+	private:
+		struct Node
+		{
+			GLsizei x;
+			GLsizei y;
+			GLsizei width;
+		};
+
+		std::vector<Node> nodes; // Sorted by x and covering the whole bin width.
+		GLsizei width;
+		GLsizei height;
+		size_t usedArea = 0;
+
+		/// @brief Whether a rectangle whose left edge is at node i fits, and the height it would rest at.
+		GAL_INLINE bool fits(size_t i, GLsizei rectWidth, GLsizei rectHeight, GLsizei& y) const noexcept
+		{
+			if (nodes[i].x + rectWidth > width)
+				return false;
+
+			y = 0;
+			GLsizei remaining = rectWidth;
+
+			for (size_t j = i; remaining > 0; ++j)
+			{
+				y = std::max(y, nodes[j].y);
+				if (y + rectHeight > height)
+					return false;
+
+				remaining -= nodes[j].width;
+			}
+
+			return true;
+		}
+
+		/// @brief Raise the skyline to y over [x, x + rectWidth), starting at node i.
+		GAL_INLINE void addNode(size_t i, GLsizei x, GLsizei y, GLsizei rectWidth)
+		{
+			nodes.insert(nodes.begin() + i, { x, y, rectWidth });
+
+			// Shrink or remove the nodes now covered by the new one.
+			for (size_t j = i + 1; j < nodes.size();)
+			{
+				const GLsizei coveredEnd = x + rectWidth;
+				if (nodes[j].x >= coveredEnd)
+					break;
+
+				const GLsizei shrink = coveredEnd - nodes[j].x;
+				if (nodes[j].width <= shrink)
+				{
+					nodes.erase(nodes.begin() + j);
+					continue;
+				}
+
+				nodes[j].x += shrink;
+				nodes[j].width -= shrink;
+				break;
+			}
+
+			// Merge neighbours at the same height.
+			for (size_t j = 0; j + 1 < nodes.size();)
+			{
+				if (nodes[j].y == nodes[j + 1].y)
+				{
+					nodes[j].width += nodes[j + 1].width;
+					nodes.erase(nodes.begin() + j + 1);
+				}
+				else
+				{
+					++j;
+				}
+			}
+		}
+	};
+
+	/// @brief Where an image was placed in a TextureAtlas.
+	struct AtlasRegion
+	{
+		glm::ivec2 position; // Texel position of the image's bottom-left corner (first row, first column), excluding padding.
+		glm::ivec2 size; // Size of the image in texels.
+		glm::vec4 uvRect; // Texture coordinates of the image as (u0, v0, u1, v1).
+		GLint layer; // Array layer holding the image. Always 0 for TextureType::TwoD atlases.
+	};
+
+	/// @brief Settings for a TextureAtlas.
+	struct TextureAtlasSettings
+	{
+		GLsizei width = 2048;
+		GLsizei height = 2048;
+		GLsizei layers = 1; // Number of array layers to allocate. Must be 1 for TextureType::TwoD.
+
+		GLenum internalFormat = GL_RGBA8;
+		GLenum format = GL_RGBA; // Format of the pixel data passed to TextureAtlas::insert().
+		GLenum type = GL_UNSIGNED_BYTE; // Type of the pixel data passed to TextureAtlas::insert().
+		GLsizei bytesPerPixel = 4; // Size of one pixel of the data passed to TextureAtlas::insert().
+
+		GLint mipmapLevels = 1;
+
+		// Border around each image filled by repeating its edge texels, so bilinear filtering never reads a neighbour.
+		// At mip level n the border is padding >> n texels wide, so use at least 1 << (mipmapLevels - 1) when mipmapping.
+		GLsizei padding = 2;
+
+		// Largest alignment, in texels, of each image's cell when mipmapping. Cells are aligned to
+		// 1 << (mipmapLevels - 1) texels up to this, so levels past log2(maxAlignment) may blend neighbouring images.
+		// Without a cap a full mip chain would align every image to the whole atlas, fitting one per layer.
+		GLsizei maxAlignment = 16;
+	};
+
+	/// @brief Packs many small images into one texture so they can be drawn with a single texture binding.
+	///
+	/// The texture is either one large TextureType::TwoD atlas or a TextureType::TwoDArray whose layers are each packed
+	/// independently, with the layer index returned alongside the UVs. Images are placed with a SkylinePacker, so inserts
+	/// are incremental and never move existing images. When mipmapping, every image and its padding is placed in a cell
+	/// aligned to 1 << (mipmapLevels - 1) texels (capped at TextureAtlasSettings::maxAlignment), so that no texel of
+	/// those levels is shared between two images.
+	class TextureAtlas
+	{
+	public:
+		/// @brief Allocate the atlas texture. Requires a current OpenGL context.
+		/// @param type: TextureType::TwoD or TextureType::TwoDArray.
+		GAL_INLINE TextureAtlas(TextureType type, const TextureAtlasSettings& settings = {})
+			: texture(type), settings(settings)
+		{
+			if (type == TextureType::TwoDArray)
+				texture.storage(settings.mipmapLevels, settings.internalFormat, settings.width, settings.height, settings.layers);
+			else
+				texture.storage(settings.mipmapLevels, settings.internalFormat, settings.width, settings.height);
+
+			alignment = std::min(1 << std::min(std::max(settings.mipmapLevels, 1) - 1, 30), std::max(settings.maxAlignment, 1));
+
+			const GLsizei layerCount = type == TextureType::TwoDArray ? settings.layers : 1;
+			for (GLsizei i = 0; i < layerCount; ++i)
+				packers.emplace_back(settings.width / alignment, settings.height / alignment);
+
+			texture.setParameter(GL_TEXTURE_MIN_FILTER, settings.mipmapLevels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+			texture.setParameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			texture.setParameter(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			texture.setParameter(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		}
+
+		// Forbid copying.
+		GAL_INLINE TextureAtlas(const TextureAtlas&) = delete;
+		GAL_INLINE TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+		// Allow moving.
+		GAL_INLINE TextureAtlas(TextureAtlas&&) noexcept = default;
+		GAL_INLINE TextureAtlas& operator=(TextureAtlas&&) noexcept = default;
+
+		/// @brief Reserve space for a width x height image without uploading anything.
+		/// The image can be written later with Texture::subImage() at the region's position.
+		/// @return The region reserved, or nothing if no layer has room.
+		GAL_NODISCARD GAL_INLINE std::optional<AtlasRegion> allocate(GLsizei width, GLsizei height)
+		{
+			if (width <= 0 || height <= 0)
+				detail::throwErr(ErrCode::EmptyAtlasImage, "Attempted to add an image with no texels to a texture atlas.");
+
+			const GLsizei paddedWidth = alignUp(width + settings.padding * 2);
+			const GLsizei paddedHeight = alignUp(height + settings.padding * 2);
+
+			for (size_t layer = 0; layer < packers.size(); ++layer)
+			{
+				// The packer works in units of the alignment so every position it returns is aligned.
+				const std::optional<glm::ivec2> slot = packers[layer].insert(paddedWidth / alignment, paddedHeight / alignment);
+				if (!slot)
+					continue;
+
+				AtlasRegion region;
+				region.position = *slot * alignment + glm::ivec2(settings.padding);
+				region.size = glm::ivec2(width, height);
+				region.layer = static_cast<GLint>(layer);
+				region.uvRect = glm::vec4(
+					static_cast<float>(region.position.x) / settings.width,
+					static_cast<float>(region.position.y) / settings.height,
+					static_cast<float>(region.position.x + width) / settings.width,
+					static_cast<float>(region.position.y + height) / settings.height);
+
+				return region;
+			}
+
+			return std::nullopt;
+		}
+
+		/// @brief Place an image in the atlas and upload it to level 0, extruding its edges over the rest of its cell.
+		/// Mipmap levels are not touched; call generateMipmaps() after a batch of inserts.
+		/// @param pixels: Tightly packed rows in the settings' format and type, first row first.
+		/// @return The region the image was placed in, or nothing if no layer has room.
+		GAL_NODISCARD GAL_INLINE std::optional<AtlasRegion> insert(GLsizei width, GLsizei height, const void* pixels)
+		{
+			std::optional<AtlasRegion> region = allocate(width, height);
+			if (!region)
+				return std::nullopt;
+
+			// The whole aligned cell is written, not just the padding, so no texel the mipmaps average is left undefined.
+			const GLsizei padding = settings.padding;
+			const GLsizei cellWidth = alignUp(width + padding * 2);
+			const GLsizei cellHeight = alignUp(height + padding * 2);
+			const size_t pixelSize = static_cast<size_t>(settings.bytesPerPixel);
+
+			const unsigned char* source = static_cast<const unsigned char*>(pixels);
+			staging.resize(static_cast<size_t>(cellWidth) * cellHeight * pixelSize);
+
+			// Copy the image into the staging area after the padding and extrude its edges outwards to fill the cell.
+			for (GLsizei y = 0; y < cellHeight; ++y)
+			{
+				const GLsizei sourceY = std::clamp(y - padding, 0, height - 1);
+				const unsigned char* sourceRow = source + static_cast<size_t>(sourceY) * width * pixelSize;
+				unsigned char* row = staging.data() + static_cast<size_t>(y) * cellWidth * pixelSize;
+
+				for (GLsizei x = 0; x < padding; ++x)
+					std::memcpy(row + x * pixelSize, sourceRow, pixelSize);
+
+				for (GLsizei x = padding + width; x < cellWidth; ++x)
+					std::memcpy(row + x * pixelSize, sourceRow + (width - 1) * pixelSize, pixelSize);
+
+				std::memcpy(row + padding * pixelSize, sourceRow, width * pixelSize);
+			}
+
+			GLint unpackAlignment;
+			glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+			const GLint x = region->position.x - padding;
+			const GLint y = region->position.y - padding;
+
+			if (texture.getTextureType() == TextureType::TwoDArray)
+				texture.subImage(0, settings.format, settings.type, staging.data(), cellWidth, cellHeight, 1, x, y, region->layer);
+			else
+				texture.subImage(0, settings.format, settings.type, staging.data(), cellWidth, cellHeight, 0, x, y);
+
+			glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+
+			mipmapsDirty = settings.mipmapLevels > 1;
+			return region;
+		}
+
+		/// @brief Regenerate every mipmap level from level 0 if anything was inserted since the last call.
+		GAL_INLINE void generateMipmaps()
+		{
+			if (!mipmapsDirty)
+				return;
+
+			texture.generateMipmapAB();
+			mipmapsDirty = false;
+		}
+
+		/// @brief Forget every image so the atlas can be repacked from scratch. Texel contents are left as they are.
+		GAL_INLINE void clear()
+		{
+			for (SkylinePacker& packer : packers)
+				packer.clear();
+		}
+
+		/// @brief Bind the atlas texture to the given texture unit.
+		GAL_INLINE void bindTextureUnit(int unit) const noexcept { texture.bindTextureUnit(unit); }
+
+		GAL_NODISCARD GAL_INLINE const Texture& getTexture() const noexcept { return texture; }
+		GAL_NODISCARD GAL_INLINE const TextureAtlasSettings& getSettings() const noexcept { return settings; }
+		GAL_NODISCARD GAL_INLINE GLsizei getLayerCount() const noexcept { return static_cast<GLsizei>(packers.size()); }
+
+		/// @brief Fraction of the given layer covered by images, including their padding and alignment.
+		GAL_NODISCARD GAL_INLINE float getOccupancy(GLsizei layer = 0) const noexcept { return packers[layer].getOccupancy(); }
+
+	private:
+		Texture texture;
+		TextureAtlasSettings settings;
+		std::vector<SkylinePacker> packers; // One per layer, in units of alignment texels.
+		std::vector<unsigned char> staging;
+
+		GLsizei alignment = 1;
+		bool mipmapsDirty = false;
+
+		GAL_NODISCARD GAL_INLINE GLsizei alignUp(GLsizei size) const noexcept
+		{
+			return (size + alignment - 1) / alignment * alignment;
+		}
+	};
+}
+
+#endif
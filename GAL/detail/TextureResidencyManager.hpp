@@ -0,0 +1,409 @@
+#ifndef GAL_TEXTURE_RESIDENCY_MANAGER_HPP
+#define GAL_TEXTURE_RESIDENCY_MANAGER_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "attributes.hpp"
+#include "enums.hpp"
+#include "Texture.hpp"
+
+namespace gal
+{
+	/// @brief Snapshot of a TextureResidencyManager's memory use and how much it has had to move textures around.
+	struct TextureResidencyStats
+	{
+		size_t budget = 0; // Bytes.
+		size_t usage = 0; // Bytes of every resident texture.
+		size_t peakUsage = 0;
+
+		size_t textureCount = 0;
+		size_t demotedCount = 0; // Resident below full resolution.
+		size_t evictedCount = 0; // Not resident at all.
+
+		// Churn during the last call to update().
+		size_t demotionsLastUpdate = 0;
+		size_t evictionsLastUpdate = 0;
+		size_t restoresLastUpdate = 0;
+		size_t bytesFreedLastUpdate = 0;
+		size_t bytesLoadedLastUpdate = 0;
+
+		// Churn since the manager was created.
+		size_t totalDemotions = 0;
+		size_t totalEvictions = 0;
+		size_t totalRestores = 0;
+	};
+
+	/// @brief Keeps the textures it owns within a video memory budget.
+	///
+	/// Every texture's size is worked out from its format, dimensions and mipmap levels (see Texture::getByteSize()),
+	/// and Texture::bindTextureUnit() records the frame it was last used in. When update() finds the total over budget,
+	/// the least recently used textures are demoted by dropping their most detailed mipmap level, which is done on the
+	/// GPU by copying the remaining levels into smaller storage. Textures already at the minimum size are evicted.
+	/// Asking for a demoted or evicted texture with get() schedules it to be reloaded at full resolution. When a full
+	/// reload doesn't fit in what is left of the restore budget, the texture is reloaded with its most detailed levels
+	/// skipped instead and reaches full resolution over the following updates.
+	///
+	/// Demotion supports TextureType::TwoD textures only. Others are evicted whole.
+	class TextureResidencyManager
+	{
+	public:
+		/// @brief Handle identifying a texture added to this manager.
+		using Handle = GLuint;
+
+		/// @brief Creates the texture with its skipLevels most detailed mipmap levels left out, e.g. a lambda calling
+		/// loadCompressedTexture(path, skipLevels). Called with 0 when the texture is added, and with more when a restore
+		/// has to be spread over several updates.
+		using Loader = std::function<std::unique_ptr<Texture>(GLint skipLevels)>;
+
+		/// @param budget: Bytes of texture memory to stay within.
+		GAL_EXPLICIT GAL_INLINE TextureResidencyManager(size_t budget)
+			: budget(budget) {}
+
+		// Forbid copying.
+		GAL_INLINE TextureResidencyManager(const TextureResidencyManager&) = delete;
+		GAL_INLINE TextureResidencyManager& operator=(const TextureResidencyManager&) = delete;
+
+		// Allow moving.
+		GAL_INLINE TextureResidencyManager(TextureResidencyManager&&) noexcept = default;
+		GAL_INLINE TextureResidencyManager& operator=(TextureResidencyManager&&) noexcept = default;
+
+		/// @brief Load a texture at full resolution and take ownership of it. The budget is enforced on the next update().
+		GAL_INLINE Handle add(Loader loader)
+		{
+			const Handle handle = nextHandle++;
+			Entry& entry = entries[handle];
+			entry.loader = std::move(loader);
+			entry.lastUsedFrame = detail::textureFrame;
+
+			load(entry);
+			return handle;
+		}
+
+		/// @brief Free a texture and forget it.
+		GAL_INLINE void remove(Handle handle)
+		{
+			auto it = entries.find(handle);
+			if (it == entries.end())
+				return;
+
+			usage -= it->second.bytes;
+			entries.erase(it);
+		}
+
+		/// @brief Get a texture to bind. Counts as a use, and if the texture isn't at full resolution it's queued to be
+		/// restored by the next update().
+		/// @return The texture, possibly demoted, or nullptr if it's evicted or the handle is unknown.
+		GAL_NODISCARD GAL_INLINE const Texture* get(Handle handle)
+		{
+			auto it = entries.find(handle);
+			if (it == entries.end())
+				return nullptr;
+
+			Entry& entry = it->second;
+			entry.lastUsedFrame = detail::textureFrame;
+			if (entry.skipLevels != 0 || entry.texture == nullptr)
+				entry.wanted = true;
+
+			return entry.texture.get();
+		}
+
+		/// @brief Bind a texture to the given unit if it's resident. Same as get() followed by Texture::bindTextureUnit().
+		/// @return Whether anything was bound.
+		GAL_INLINE bool bindTextureUnit(Handle handle, int unit)
+		{
+			const Texture* texture = get(handle);
+			if (texture != nullptr)
+				texture->bindTextureUnit(unit);
+
+			return texture != nullptr;
+		}
+
+		/// @brief Restore wanted textures, then demote and evict until within budget. Call once per frame, before
+		/// drawing. Advances the frame counter Texture::bindTextureUnit() records.
+		GAL_INLINE void update()
+		{
+			stats.demotionsLastUpdate = 0;
+			stats.evictionsLastUpdate = 0;
+			stats.restoresLastUpdate = 0;
+			stats.bytesFreedLastUpdate = 0;
+			stats.bytesLoadedLastUpdate = 0;
+
+			const uint64_t frame = detail::textureFrame;
+
+			for (auto& [handle, entry] : entries)
+			{
+				if (entry.texture != nullptr)
+					entry.lastUsedFrame = std::max(entry.lastUsedFrame, entry.texture->getLastUsedFrame());
+			}
+
+			restoreWanted(frame);
+
+			// Textures used in the frame just drawn are off limits, so whatever is on screen is never degraded.
+			std::vector<Entry*> candidates;
+			for (auto& [handle, entry] : entries)
+			{
+				if (entry.texture != nullptr && entry.lastUsedFrame < frame)
+					candidates.push_back(&entry);
+			}
+
+			std::sort(candidates.begin(), candidates.end(),
+				[](const Entry* a, const Entry* b) { return a->lastUsedFrame < b->lastUsedFrame; });
+
+			// Drop one level from each candidate in turn, oldest first, before dropping a second from any of them.
+			bool demoted = true;
+			while (usage > budget && demoted)
+			{
+				demoted = false;
+				for (Entry* entry : candidates)
+				{
+					if (usage <= budget)
+						break;
+
+					demoted = demote(*entry) || demoted;
+				}
+			}
+
+			for (Entry* entry : candidates)
+			{
+				if (usage <= budget)
+					break;
+
+				evict(*entry);
+			}
+
+			stats.peakUsage = std::max(stats.peakUsage, usage);
+			++detail::textureFrame;
+		}
+
+		/// @brief Set the number of bytes of texture memory to stay within.
+		GAL_INLINE void setBudget(size_t bytes) noexcept { budget = bytes; }
+
+		/// @brief Set the most bytes restored by each call to update(), to spread reloading over several frames.
+		/// At least one texture is reloaded per update regardless, at reduced resolution if it doesn't fit.
+		GAL_INLINE void setRestoreBudget(size_t bytes) noexcept { restoreBudget = bytes; }
+
+		/// @brief Set the smallest width or height textures are demoted to before being evicted instead.
+		GAL_INLINE void setMinimumDimension(GLsizei size) noexcept { minimumDimension = std::max(size, 1); }
+
+		GAL_NODISCARD GAL_INLINE size_t getBudget() const noexcept { return budget; }
+		GAL_NODISCARD GAL_INLINE size_t getUsage() const noexcept { return usage; }
+
+		GAL_NODISCARD GAL_INLINE TextureResidencyStats getStats() const
+		{
+			TextureResidencyStats result = stats;
+			result.budget = budget;
+			result.usage = usage;
+			result.textureCount = entries.size();
+
+			for (const auto& [handle, entry] : entries)
+			{
+				if (entry.texture == nullptr)
+					result.evictedCount++;
+				else if (entry.skipLevels != 0)
+					result.demotedCount++;
+			}
+
+			return result;
+		}
+
+	private:
+		struct Entry
+		{
+			Loader loader;
+			std::unique_ptr<Texture> texture;
+			GLint skipLevels = 0;
+			GLint maxSkipLevels = 0; // Levels a reduced reload may leave out, from the texture at full resolution.
+			size_t bytes = 0;
+			size_t fullBytes = 0;
+			uint64_t lastUsedFrame = 0;
+			bool wanted = false;
+		};
+
+		std::unordered_map<Handle, Entry> entries;
+		Handle nextHandle = 1;
+
+		size_t budget;
+		size_t usage = 0;
+		size_t restoreBudget = 64 * 1024 * 1024;
+		GLsizei minimumDimension = 64;
+
+		TextureResidencyStats stats;
+
+		GAL_INLINE void setTexture(Entry& entry, std::unique_ptr<Texture> texture, GLint skipLevels)
+		{
+			usage -= entry.bytes;
+			entry.texture = std::move(texture);
+			entry.skipLevels = skipLevels;
+			entry.bytes = entry.texture != nullptr ? entry.texture->getByteSize() : 0;
+			usage += entry.bytes;
+		}
+
+		GAL_INLINE void load(Entry& entry, GLint skipLevels = 0)
+		{
+			setTexture(entry, entry.loader(skipLevels), skipLevels);
+			entry.wanted = skipLevels != 0;
+
+			if (skipLevels == 0 && entry.texture != nullptr)
+			{
+				const Texture& texture = *entry.texture;
+				entry.fullBytes = entry.bytes;
+				entry.maxSkipLevels = 0;
+
+				// Mirror demote(), so a reduced reload is never smaller than demotion would have made the texture.
+				if (texture.getTextureType() == TextureType::TwoD)
+				{
+					while (entry.maxSkipLevels + 1 < texture.getMipmapLevels()
+						&& std::min(texture.getWidth(), texture.getHeight()) >> (entry.maxSkipLevels + 1) >= minimumDimension)
+						entry.maxSkipLevels++;
+				}
+			}
+
+			stats.bytesLoadedLastUpdate += entry.bytes;
+		}
+
+		/// @brief Get the fewest levels to skip when reloading the texture so it grows by no more than the given bytes,
+		/// assuming each level is a quarter of the one above. Always at least one level fewer than are skipped now.
+		GAL_NODISCARD GAL_STATIC GAL_INLINE GLint restoreSkipLevels(const Entry& entry, size_t bytes) noexcept
+		{
+			GLint maxSkipLevels = entry.maxSkipLevels;
+			if (entry.texture != nullptr)
+				maxSkipLevels = std::min(maxSkipLevels, entry.skipLevels - 1);
+
+			GLint skipLevels = 0;
+			for (size_t size = entry.fullBytes; size - std::min(size, entry.bytes) > bytes && skipLevels < maxSkipLevels; size /= 4)
+				++skipLevels;
+
+			return std::max(skipLevels, 0);
+		}
+
+		GAL_INLINE void restoreWanted(uint64_t frame)
+		{
+			std::vector<Entry*> wanted;
+			for (auto& [handle, entry] : entries)
+			{
+				// Only restore what was asked for last frame. Anything older would just be demoted again.
+				if (entry.wanted && entry.lastUsedFrame < frame)
+					entry.wanted = false;
+
+				if (entry.wanted)
+					wanted.push_back(&entry);
+			}
+
+			// Most recently used first.
+			std::sort(wanted.begin(), wanted.end(),
+				[](const Entry* a, const Entry* b) { return a->lastUsedFrame > b->lastUsedFrame; });
+
+			size_t restored = 0;
+			for (Entry* entry : wanted)
+			{
+				if (restored != 0 && restored >= restoreBudget)
+					break;
+
+				const size_t before = entry->bytes;
+				load(*entry, restoreSkipLevels(*entry, restoreBudget - std::min(restored, restoreBudget)));
+				restored += entry->bytes - std::min(before, entry->bytes);
+
+				stats.restoresLastUpdate++;
+				stats.totalRestores++;
+			}
+		}
+
+		/// @brief Replace the texture with one missing its most detailed level, copying the rest on the GPU.
+		/// @return Whether the texture could be demoted.
+		GAL_INLINE bool demote(Entry& entry)
+		{
+			const Texture& old = *entry.texture;
+			if (old.getTextureType() != TextureType::TwoD || old.getMipmapLevels() <= 1
+				|| std::min(old.getWidth(), old.getHeight()) / 2 < minimumDimension)
+				return false;
+
+			const GLint levels = old.getMipmapLevels() - 1;
+			const GLsizei width = std::max(old.getWidth() / 2, 1);
+			const GLsizei height = std::max(old.getHeight() / 2, 1);
+
+			auto smaller = std::make_unique<Texture>(TextureType::TwoD);
+			smaller->storage(levels, old.getInternalFormat(), width, height);
+
+			for (GLint level = 0; level < levels; ++level)
+			{
+				glCopyImageSubData(old.getID(), GL_TEXTURE_2D, level + 1, 0, 0, 0, smaller->getID(), GL_TEXTURE_2D, level, 0, 0, 0,
+					std::max(width >> level, 1), std::max(height >> level, 1), 1);
+			}
+
+			copySamplingState(old, *smaller);
+
+			const size_t before = entry.bytes;
+			setTexture(entry, std::move(smaller), entry.skipLevels + 1);
+
+			stats.bytesFreedLastUpdate += before - entry.bytes;
+			stats.demotionsLastUpdate++;
+			stats.totalDemotions++;
+			return true;
+		}
+
+		/// @brief Copy the sampling state, which belongs to the texture object, to a texture missing the most detailed
+		/// level of the original.
+		GAL_STATIC GAL_INLINE void copySamplingState(const Texture& from, Texture& to) noexcept
+		{
+			for (GLenum parameter : { GL_TEXTURE_MIN_FILTER, GL_TEXTURE_MAG_FILTER, GL_TEXTURE_WRAP_S, GL_TEXTURE_WRAP_T,
+				GL_TEXTURE_WRAP_R, GL_TEXTURE_COMPARE_MODE, GL_TEXTURE_COMPARE_FUNC, GL_DEPTH_STENCIL_TEXTURE_MODE })
+			{
+				GLint value;
+				glGetTextureParameteriv(from.getID(), parameter, &value);
+				to.setParameter(parameter, value);
+			}
+
+			GLint swizzle[4];
+			glGetTextureParameteriv(from.getID(), GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+			to.setParameter(GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+
+			GLfloat borderColor[4];
+			glGetTextureParameterfv(from.getID(), GL_TEXTURE_BORDER_COLOR, borderColor);
+			to.setParameter(GL_TEXTURE_BORDER_COLOR, borderColor);
+
+			GLfloat lodBias;
+			glGetTextureParameterfv(from.getID(), GL_TEXTURE_LOD_BIAS, &lodBias);
+			to.setParameter(GL_TEXTURE_LOD_BIAS, lodBias);
+
+			// Level indices and level of detail are relative to the most detailed level, which is one fewer now.
+			for (GLenum parameter : { GL_TEXTURE_BASE_LEVEL, GL_TEXTURE_MAX_LEVEL })
+			{
+				GLint value;
+				glGetTextureParameteriv(from.getID(), parameter, &value);
+				to.setParameter(parameter, std::max(value - 1, 0));
+			}
+
+			for (GLenum parameter : { GL_TEXTURE_MIN_LOD, GL_TEXTURE_MAX_LOD })
+			{
+				GLfloat value;
+				glGetTextureParameterfv(from.getID(), parameter, &value);
+				to.setParameter(parameter, value - 1.0f);
+			}
+
+#ifdef GL_VERSION_4_6
+			if (GLAD_GL_VERSION_4_6)
+			{
+				GLfloat anisotropy;
+				glGetTextureParameterfv(from.getID(), GL_TEXTURE_MAX_ANISOTROPY, &anisotropy);
+				to.setParameter(GL_TEXTURE_MAX_ANISOTROPY, anisotropy);
+			}
+#endif
+		}
+
+		GAL_INLINE void evict(Entry& entry)
+		{
+			stats.bytesFreedLastUpdate += entry.bytes;
+			setTexture(entry, nullptr, 0);
+
+			stats.evictionsLastUpdate++;
+			stats.totalEvictions++;
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,396 @@
+#ifndef GAL_TEXTURE_STREAMER_HPP
+#define GAL_TEXTURE_STREAMER_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "attributes.hpp"
+#include "Buffer.hpp"
+#include "enums.hpp"
+#include "GALException.hpp"
+#include "logging.hpp"
+#include "MipGenerator.hpp"
+#include "Texture.hpp"
+
+namespace gal
+{
+	/// @brief Loads textures without stalling the render thread.
+	///
+	/// Worker threads decode images (with a decoder you supply, e.g. wrapping stbi_load) and build their mip chains.
+	/// Each frame, update() copies finished levels into a persistently mapped GL_PIXEL_UNPACK_BUFFER ring and uploads
+	/// them with glTextureSubImage2D, stopping once the frame's byte budget is used up. Levels are uploaded coarsest
+	/// first and GL_TEXTURE_BASE_LEVEL follows them down, so a texture can be sampled at low resolution as soon as
+	/// its smallest level is in.
+	class TextureStreamer
+	{
+	public:
+		/// @brief Handle identifying a texture requested from this streamer.
+		using Handle = GLuint;
+
+		/// @brief Decodes the image at the given path into 8-bit RGBA. Returns false on failure. Called from worker threads.
+		using Decoder = std::function<bool(const std::string& path, DecodedImage& out)>;
+
+		enum class State
+		{
+			Decoding, // Waiting for or being decoded by a worker thread. No texture exists yet.
+			Uploading, // Some levels are uploaded and the texture can be sampled at reduced resolution.
+			Resident, // Every level is uploaded.
+			Failed // The decoder failed.
+		};
+
+		/// @brief Create the streamer and its worker threads. Requires a current OpenGL context.
+		/// @param ringSize: Size in bytes of the persistently mapped upload ring. Levels larger than this are uploaded
+		/// straight from client memory instead.
+		/// @param workerCount: Number of decoding threads. 0 picks one less than the number of hardware threads.
+		GAL_INLINE TextureStreamer(Decoder decoder, GLsizeiptr ringSize = 32 * 1024 * 1024, unsigned workerCount = 0)
+			: decoder(std::move(decoder)), ringSize(ringSize)
+		{
+			const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			ring.allocateImmutable(ringSize, flags);
+			ringMemory = static_cast<unsigned char*>(ring.mapRange(0, ringSize, flags));
+
+			if (workerCount == 0)
+				workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+			for (unsigned i = 0; i < workerCount; ++i)
+				workers.emplace_back([this] { workerLoop(); });
+		}
+
+		// Forbid copying and moving, as worker threads hold a pointer to the streamer.
+		GAL_INLINE TextureStreamer(const TextureStreamer&) = delete;
+		GAL_INLINE TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+		GAL_INLINE ~TextureStreamer()
+		{
+			{
+				std::lock_guard<std::mutex> lock(jobMutex);
+				stopping = true;
+			}
+
+			jobCondition.notify_all();
+			for (std::thread& worker : workers)
+				worker.join();
+
+			for (const auto& [fence, refs] : fenceRefs)
+				glDeleteSync(fence);
+
+			ring.unmap();
+		}
+
+		/// @brief Queue the image at the given path for decoding and upload.
+		/// @param srgb: Store the texture as GL_SRGB8_ALPHA8 rather than GL_RGBA8.
+		GAL_INLINE Handle request(const std::string& path, bool srgb = true)
+		{
+			const Handle handle = nextHandle++;
+			entries[handle].srgb = srgb;
+
+			{
+				std::lock_guard<std::mutex> lock(jobMutex);
+				jobs.push_back({ handle, path, srgb });
+			}
+
+			jobCondition.notify_one();
+			return handle;
+		}
+
+		/// @brief Set the maximum number of bytes uploaded by each call to update().
+		/// At least one level is always uploaded per call, however large, so nothing starves.
+		GAL_INLINE void setFrameBudget(GLsizeiptr bytes) noexcept { frameBudget = bytes; }
+
+		/// @brief Upload decoded levels within the frame budget. Call once per frame on the render thread.
+		GAL_INLINE void update()
+		{
+			takeDecodedImages();
+			retireFences();
+
+			GLsizeiptr uploaded = 0;
+			bool usedRing = false;
+
+			while (!uploadQueue.empty())
+			{
+				Entry& entry = entries[uploadQueue.front()];
+				const int level = entry.nextLevel;
+				const DecodedImage& image = entry.levels[level];
+				const GLsizeiptr bytes = static_cast<GLsizeiptr>(image.pixels.size());
+
+				if (uploaded != 0 && uploaded + bytes > frameBudget)
+					break;
+
+				if (bytes <= ringSize)
+				{
+					GLintptr offset;
+					if (!allocateRing(bytes, offset))
+						break;  // Ring full of data the GPU hasn't consumed yet. Try again next frame.
+
+					std::memcpy(ringMemory + offset, image.pixels.data(), image.pixels.size());
+
+					ring.bind();
+					entry.texture->subImage(level, GL_RGBA, GL_UNSIGNED_BYTE, reinterpret_cast<const void*>(offset),
+						image.width, image.height);
+					glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+					usedRing = true;
+				}
+				else
+				{
+					entry.texture->subImage(level, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels.data(), image.width, image.height);
+				}
+
+				entry.texture->setParameter(GL_TEXTURE_BASE_LEVEL, level);
+				uploaded += bytes;
+				totalUploaded += bytes;
+
+				entry.levels.pop_back();
+				entry.nextLevel--;
+
+				if (entry.nextLevel < 0)
+				{
+					entry.state = State::Resident;
+					entry.levels.clear();
+					entry.levels.shrink_to_fit();
+					uploadQueue.pop_front();
+				}
+				else
+				{
+					entry.state = State::Uploading;
+				}
+			}
+
+			if (usedRing)
+			{
+				// One fence covers every range written this frame.
+				GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+				for (InFlightRange& range : inFlight)
+				{
+					if (range.fence == nullptr)
+						range.fence = fence;
+				}
+				fenceRefs[fence] = std::count_if(inFlight.begin(), inFlight.end(),
+					[fence](const InFlightRange& range) { return range.fence == fence; });
+			}
+
+			lastFrameUploaded = uploaded;
+		}
+
+		GAL_NODISCARD GAL_INLINE State getState(Handle handle) const
+		{
+			auto it = entries.find(handle);
+			return it == entries.end() ? State::Failed : it->second.state;
+		}
+
+		/// @brief Get the texture for the given handle, or nullptr if none of its levels have been uploaded yet.
+		GAL_NODISCARD GAL_INLINE const Texture* getTexture(Handle handle) const
+		{
+			auto it = entries.find(handle);
+			if (it == entries.end() || it->second.state == State::Decoding || it->second.state == State::Failed)
+				return nullptr;
+
+			return it->second.texture.get();
+		}
+
+		/// @brief Free the texture for the given handle. Its handle becomes invalid.
+		GAL_INLINE void release(Handle handle)
+		{
+			uploadQueue.erase(std::remove(uploadQueue.begin(), uploadQueue.end(), handle), uploadQueue.end());
+			entries.erase(handle);
+		}
+
+		/// @brief Bytes uploaded by the last call to update().
+		GAL_NODISCARD GAL_INLINE GLsizeiptr getLastFrameUploadedBytes() const noexcept { return lastFrameUploaded; }
+
+		/// @brief Bytes uploaded since the streamer was created.
+		GAL_NODISCARD GAL_INLINE GLsizeiptr getTotalUploadedBytes() const noexcept { return totalUploaded; }
+
+	private:
+		struct Job
+		{
+			Handle handle;
+			std::string path;
+			bool srgb;
+		};
+
+		struct DecodeResult
+		{
+			Handle handle;
+			bool success;
+			std::vector<DecodedImage> levels; // Level 0 first.
+		};
+
+		struct Entry
+		{
+			State state = State::Decoding;
+			bool srgb = true;
+			std::unique_ptr<Texture> texture;
+			std::vector<DecodedImage> levels; // Levels still to upload, level 0 first, so the next one is at the back.
+			int nextLevel = -1;
+		};
+
+		struct InFlightRange
+		{
+			GLintptr begin;
+			GLintptr end;
+			GLsync fence; // nullptr until the end of the frame that wrote it.
+		};
+
+		Decoder decoder;
+
+		std::vector<std::thread> workers;
+		std::mutex jobMutex;
+		std::condition_variable jobCondition;
+		std::deque<Job> jobs;
+		bool stopping = false;
+
+		std::mutex resultMutex;
+		std::vector<DecodeResult> results;
+
+		std::unordered_map<Handle, Entry> entries;
+		std::deque<Handle> uploadQueue;
+		Handle nextHandle = 1;
+
+		Buffer ring{ BufferType::PixelUnpack };
+		GLsizeiptr ringSize;
+		unsigned char* ringMemory = nullptr;
+		GLintptr ringHead = 0;
+		std::deque<InFlightRange> inFlight;
+		std::unordered_map<GLsync, std::ptrdiff_t> fenceRefs;
+
+		GLsizeiptr frameBudget = 4 * 1024 * 1024;
+		GLsizeiptr lastFrameUploaded = 0;
+		GLsizeiptr totalUploaded = 0;
+
+		GAL_INLINE void workerLoop()
+		{
+			while (true)
+			{
+				Job job;
+
+				{
+					std::unique_lock<std::mutex> lock(jobMutex);
+					jobCondition.wait(lock, [this] { return stopping || !jobs.empty(); });
+
+					if (stopping)
+						return;
+
+					job = std::move(jobs.front());
+					jobs.pop_front();
+				}
+
+				DecodeResult result{ job.handle, false, {} };
+				DecodedImage image;
+
+				if (decoder(job.path, image) && image.width > 0 && image.height > 0)
+				{
+					// Each worker already has its own image, so mips are generated single threaded.
+					MipSettings settings;
+					settings.srgb = job.srgb;
+					settings.threadCount = 1;
+
+					std::vector<DecodedImage> mips = generateMipLevels(image, settings);
+
+					result.success = true;
+					result.levels.push_back(std::move(image));
+					std::move(mips.begin(), mips.end(), std::back_inserter(result.levels));
+				}
+
+				std::lock_guard<std::mutex> lock(resultMutex);
+				results.push_back(std::move(result));
+			}
+		}
+
+		/// @brief Create textures for images the workers have finished with and queue their levels for upload.
+		GAL_INLINE void takeDecodedImages()
+		{
+			std::vector<DecodeResult> finished;
+
+			{
+				std::lock_guard<std::mutex> lock(resultMutex);
+				finished.swap(results);
+			}
+
+			for (DecodeResult& result : finished)
+			{
+				auto it = entries.find(result.handle);
+				if (it == entries.end())
+					continue;  // Released before it finished decoding.
+
+				Entry& entry = it->second;
+
+				if (!result.success)
+				{
+					entry.state = State::Failed;
+					detail::logErr("TextureStreamer failed to decode an image.");
+					continue;
+				}
+
+				const GLsizei levelCount = static_cast<GLsizei>(result.levels.size());
+				const DecodedImage& base = result.levels.front();
+
+				entry.texture = std::make_unique<Texture>(TextureType::TwoD);
+				entry.texture->storage(levelCount, entry.srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8, base.width, base.height);
+				entry.texture->setParameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+				entry.texture->setParameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+				entry.texture->setParameter(GL_TEXTURE_BASE_LEVEL, levelCount - 1);
+
+				entry.levels = std::move(result.levels);
+				entry.nextLevel = levelCount - 1;
+				uploadQueue.push_back(result.handle);
+			}
+		}
+
+		/// @brief Drop in-flight ranges whose fence the GPU has passed.
+		GAL_INLINE void retireFences()
+		{
+			while (!inFlight.empty() && inFlight.front().fence != nullptr)
+			{
+				GLsync fence = inFlight.front().fence;
+				const GLenum status = glClientWaitSync(fence, 0, 0);
+
+				if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+					break;
+
+				inFlight.pop_front();
+
+				if (--fenceRefs[fence] == 0)
+				{
+					fenceRefs.erase(fence);
+					glDeleteSync(fence);
+				}
+			}
+		}
+
+		/// @brief Reserve bytes in the ring, wrapping to the start if needed. Fails if the space is still in use by the GPU.
+		GAL_INLINE bool allocateRing(GLsizeiptr bytes, GLintptr& offset)
+		{
+			GLintptr begin = ringHead;
+			if (begin + bytes > ringSize)
+				begin = 0;
+
+			const GLintptr end = begin + bytes;
+
+			for (const InFlightRange& range : inFlight)
+			{
+				if (range.begin < end && begin < range.end)
+					return false;
+			}
+
+			// Keep offsets 4-byte aligned, matching the default GL_UNPACK_ALIGNMENT.
+			ringHead = (end + 3) & ~GLintptr(3);
+			inFlight.push_back({ begin, end, nullptr });
+			offset = begin;
+
+			return true;
+		}
+	};
+}
+
+#endif
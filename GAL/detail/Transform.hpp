@@ -5,13 +5,11 @@
 
 namespace gal
 {
-	/// @brief Transform struct with model matrix caching.
+	/// @brief Transform struct with model matrix caching. The model matrix is only rebuilt by getModelMatrix() after
+	/// the transform has changed, so unmoving objects cost nothing per frame.
 	struct Transform
 	{
-		glm::vec3 position;
-		Rotation rotation;
-		glm::vec3 scale;
-
+	public:
 		/// @brief Initialize with given transformation. 
 		GAL_INLINE Transform(const glm::vec3& position = glm::vec3(0.0f), const Rotation& rotation = Rotation(),
 			const glm::vec3& scale = glm::vec3(1.0f))
@@ -23,6 +21,7 @@ namespace gal
 			this->position = position;
 			this->rotation = rotation;
 			this->scale = scale;
+			dirty = true;
 		}
 
 		/// @brief Reset entire transform to default values. 
@@ -31,30 +30,54 @@ namespace gal
 			position = glm::vec3(0.0f);
 			rotation = Rotation();
 			scale = glm::vec3(1.0f);
+			dirty = true;
 		}
 
-		GAL_INLINE void setPosition(const glm::vec3& position) noexcept { this->position = position; }
-		GAL_INLINE void setRotation(const Rotation& rotation) noexcept { this->rotation = rotation; }
-		GAL_INLINE void setScale(const glm::vec3& scale) noexcept { this->scale = scale; }
+		GAL_INLINE void setPosition(const glm::vec3& position) noexcept { this->position = position; dirty = true; }
+		GAL_INLINE void setRotation(const Rotation& rotation) noexcept { this->rotation = rotation; dirty = true; }
+		GAL_INLINE void setScale(const glm::vec3& scale) noexcept { this->scale = scale; dirty = true; }
  
-		GAL_INLINE void applyTranslationGlobal(const glm::vec3& delta) noexcept { position += delta; }
-		GAL_INLINE void applyRotationGlobal(const Rotation& rotation) noexcept { this->rotation.rotateGlobal(rotation); }
-		GAL_INLINE void applyScale(const glm::vec3& scaleFactors) noexcept { scale *= scaleFactors; }
+		GAL_INLINE void applyTranslationGlobal(const glm::vec3& delta) noexcept { position += delta; dirty = true; }
+		GAL_INLINE void applyRotationGlobal(const Rotation& rotation) noexcept { this->rotation.rotateGlobal(rotation); dirty = true; }
+		GAL_INLINE void applyScale(const glm::vec3& scaleFactors) noexcept { scale *= scaleFactors; dirty = true; }
 
-		GAL_INLINE void applyTranslationLocal(const glm::vec3& delta) noexcept { position += rotation.rotate(delta); }
-		GAL_INLINE void applyRotationLocal(const Rotation& rotation) noexcept { this->rotation.rotateLocal(rotation); }
+		GAL_INLINE void applyTranslationLocal(const glm::vec3& delta) noexcept { position += rotation.rotate(delta); dirty = true; }
+		GAL_INLINE void applyRotationLocal(const Rotation& rotation) noexcept { this->rotation.rotateLocal(rotation); dirty = true; }
 
 		GAL_NODISCARD GAL_INLINE glm::vec3 getPosition() const noexcept { return position; }
 		GAL_NODISCARD GAL_INLINE Rotation getRotation() const noexcept { return rotation; }
 		GAL_NODISCARD GAL_INLINE glm::vec3 getScale() const noexcept { return scale; }
 
-		/// @brief Get the model matrix represented by this Transform.
-		GAL_NODISCARD GAL_INLINE glm::mat4 getModelMatrix() const noexcept
+		/// @brief Get the model matrix represented by this Transform, i.e. translation * rotation * scale.
+		GAL_NODISCARD GAL_INLINE const glm::mat4& getModelMatrix() const noexcept
 		{
-			return glm::translate(glm::mat4(1.0f), position)
-				* rotation.asMat4()
-				* glm::scale(glm::mat4(1.0f), scale);
+			if (dirty)
+			{
+				// Closed form of translate * mat4_cast(quat) * scale: the rotation matrix's columns scaled per axis, with
+				// the position as the last column.
+				const glm::quat q = rotation.asQuat();
+				const float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+				const float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+				const float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+				modelMatrix[0] = glm::vec4(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f) * scale.x;
+				modelMatrix[1] = glm::vec4(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f) * scale.y;
+				modelMatrix[2] = glm::vec4(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f) * scale.z;
+				modelMatrix[3] = glm::vec4(position, 1.0f);
+
+				dirty = false;
+			}
+
+			return modelMatrix;
 		}
+
+	private:
+		glm::vec3 position;
+		Rotation rotation;
+		glm::vec3 scale;
+
+		mutable glm::mat4 modelMatrix = glm::mat4(1.0f);
+		mutable bool dirty = true;
 	};
 }
 
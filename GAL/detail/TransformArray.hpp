@@ -0,0 +1,383 @@
+#ifndef GAL_TRANSFORM_ARRAY_HPP
+#define GAL_TRANSFORM_ARRAY_HPP
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include "attributes.hpp"
+#include "Buffer.hpp"
+#include "parallel.hpp"
+#include "simd.hpp"
+#include "Transform.hpp"
+
+namespace gal
+{
+	/// @brief How TransformArray writes model matrices.
+	enum class TransformMatrixLayout
+	{
+		Mat4, // Column major mat4, 64 bytes. Matches glm::mat4 and a GLSL mat4.
+		Mat3x4, // The top three rows of the matrix, each a vec4 of (row of the 3x3 part, translation), 48 bytes.
+				// In GLSL, read it as a mat3x4 and transform with (vec4(position, 1.0) * m).
+	};
+
+	/// @brief Many Transforms stored as a structure of arrays, with positions, rotation quaternions and scales each split
+	/// into one aligned float array per component.
+	///
+	/// Model matrices for a whole range of transforms are computed by SIMD kernels (AVX2 or SSE2, whichever the compiler
+	/// targets; see simd.hpp) and can be written straight into a mapped instance buffer. Translations and rotations can
+	/// be applied to whole ranges the same way. Use this instead of a vector of Transforms when thousands of instances
+	/// move every frame.
+	class TransformArray
+	{
+	public:
+		/// @brief Pass as a count to mean every transform from first to the end.
+		GAL_STATIC GAL_CONSTEXPR size_t All = static_cast<size_t>(-1);
+
+		GAL_INLINE TransformArray() = default;
+
+		GAL_EXPLICIT GAL_INLINE TransformArray(const std::vector<Transform>& transforms)
+		{
+			reserve(transforms.size());
+			for (const Transform& transform : transforms)
+				add(transform);
+		}
+
+		/// @brief Append a transform. Returns its index.
+		GAL_INLINE size_t add(const Transform& transform)
+		{
+			const glm::vec3 position = transform.getPosition();
+			const glm::quat rotation = transform.getRotation().asQuat();
+			const glm::vec3 scale = transform.getScale();
+
+			const std::array<float, ComponentCount> values = {
+				position.x, position.y, position.z,
+				rotation.x, rotation.y, rotation.z, rotation.w,
+				scale.x, scale.y, scale.z
+			};
+
+			for (size_t c = 0; c < ComponentCount; ++c)
+				components[c].push_back(values[c]);
+
+			return size() - 1;
+		}
+
+		/// @brief Remove a transform by moving the last one into its place, so the last transform's index changes to index.
+		GAL_INLINE void removeSwap(size_t index)
+		{
+			for (AlignedFloats& component : components)
+			{
+				component[index] = component.back();
+				component.pop_back();
+			}
+		}
+
+		GAL_INLINE void reserve(size_t count)
+		{
+			for (AlignedFloats& component : components)
+				component.reserve(count);
+		}
+
+		GAL_INLINE void clear() noexcept
+		{
+			for (AlignedFloats& component : components)
+				component.clear();
+		}
+
+		GAL_NODISCARD GAL_INLINE size_t size() const noexcept { return components[PX].size(); }
+
+		GAL_INLINE void set(size_t index, const Transform& transform) noexcept
+		{
+			setPosition(index, transform.getPosition());
+			setRotation(index, transform.getRotation());
+			setScale(index, transform.getScale());
+		}
+
+		GAL_INLINE void setPosition(size_t index, const glm::vec3& position) noexcept
+		{
+			components[PX][index] = position.x;
+			components[PY][index] = position.y;
+			components[PZ][index] = position.z;
+		}
+
+		GAL_INLINE void setRotation(size_t index, const Rotation& rotation) noexcept
+		{
+			const glm::quat quat = rotation.asQuat();
+			components[QX][index] = quat.x;
+			components[QY][index] = quat.y;
+			components[QZ][index] = quat.z;
+			components[QW][index] = quat.w;
+		}
+
+		GAL_INLINE void setScale(size_t index, const glm::vec3& scale) noexcept
+		{
+			components[SX][index] = scale.x;
+			components[SY][index] = scale.y;
+			components[SZ][index] = scale.z;
+		}
+
+		GAL_NODISCARD GAL_INLINE Transform get(size_t index) const noexcept
+		{
+			return Transform(getPosition(index), getRotation(index), getScale(index));
+		}
+
+		GAL_NODISCARD GAL_INLINE glm::vec3 getPosition(size_t index) const noexcept
+		{
+			return glm::vec3(components[PX][index], components[PY][index], components[PZ][index]);
+		}
+
+		GAL_NODISCARD GAL_INLINE Rotation getRotation(size_t index) const noexcept
+		{
+			return Rotation(glm::quat(components[QW][index], components[QX][index], components[QY][index], components[QZ][index]));
+		}
+
+		GAL_NODISCARD GAL_INLINE glm::vec3 getScale(size_t index) const noexcept
+		{
+			return glm::vec3(components[SX][index], components[SY][index], components[SZ][index]);
+		}
+
+		/// @brief Move every transform in the range by delta in world space.
+		GAL_INLINE void applyTranslationGlobal(const glm::vec3& delta, size_t first = 0, size_t count = All) noexcept
+		{
+			const size_t end = rangeEnd(first, count);
+			for (size_t i = first; i < end; ++i)
+			{
+				components[PX][i] += delta.x;
+				components[PY][i] += delta.y;
+				components[PZ][i] += delta.z;
+			}
+		}
+
+		/// @brief Move every transform in the range by delta along its own axes, e.g. to move a swarm forward.
+		GAL_INLINE void applyTranslationLocal(const glm::vec3& delta, size_t first = 0, size_t count = All) noexcept
+		{
+			const size_t end = rangeEnd(first, count);
+			const size_t done = translateLocalRange<detail::WideFloatLanes>(first, end, delta);
+			translateLocalRange<detail::FloatLanes1>(done, end, delta);
+		}
+
+		/// @brief Rotate every transform in the range in world space. Same as Transform::applyRotationGlobal.
+		GAL_INLINE void applyRotationGlobal(const Rotation& delta, size_t first = 0, size_t count = All) noexcept
+		{
+			const size_t end = rangeEnd(first, count);
+			const size_t done = rotateRange<detail::WideFloatLanes, true>(first, end, delta.asQuat());
+			rotateRange<detail::FloatLanes1, true>(done, end, delta.asQuat());
+		}
+
+		/// @brief Rotate every transform in the range in its own space. Same as Transform::applyRotationLocal.
+		GAL_INLINE void applyRotationLocal(const Rotation& delta, size_t first = 0, size_t count = All) noexcept
+		{
+			const size_t end = rangeEnd(first, count);
+			const size_t done = rotateRange<detail::WideFloatLanes, false>(first, end, delta.asQuat());
+			rotateRange<detail::FloatLanes1, false>(done, end, delta.asQuat());
+		}
+
+		/// @brief Size in bytes of one matrix in the given layout.
+		GAL_NODISCARD GAL_STATIC GAL_CONSTEXPR GAL_INLINE size_t matrixSize(TransformMatrixLayout layout) noexcept
+		{
+			return layout == TransformMatrixLayout::Mat4 ? 16 * sizeof(float) : 12 * sizeof(float);
+		}
+
+		/// @brief Write the model matrices of a range of transforms to out, one after another, out[0] being the matrix of
+		/// transform first. out must have room for count * matrixSize(layout) bytes, and may be mapped buffer memory, as
+		/// every matrix is written front to back exactly once.
+		/// @param threadCount: Threads to split large ranges across. 0 uses every hardware thread.
+		GAL_INLINE void computeMatrices(void* out, TransformMatrixLayout layout = TransformMatrixLayout::Mat4, size_t first = 0,
+			size_t count = All, unsigned threadCount = 1) const
+		{
+			const size_t end = rangeEnd(first, count);
+			const size_t floatsPerMatrix = matrixSize(layout) / sizeof(float);
+			float* matrices = static_cast<float*>(out);
+
+			detail::parallelFor(end - first, threadCount, [&](size_t begin, size_t chunkEnd)
+				{
+					float* chunkOut = matrices + begin * floatsPerMatrix;
+					const size_t done = matricesRange<detail::WideFloatLanes>(first + begin, first + chunkEnd, chunkOut, layout);
+					matricesRange<detail::FloatLanes1>(done, first + chunkEnd, chunkOut + (done - first - begin) * floatsPerMatrix, layout);
+				}, 1024);
+		}
+
+		/// @brief Map a range of buffer and write the model matrices of a range of transforms into it, starting at byte
+		/// offset. The buffer must be large enough and mappable for writing. Returns false if mapping failed or the data
+		/// was lost while mapped.
+		GAL_INLINE bool writeMatrices(Buffer& buffer, GLintptr offset = 0, TransformMatrixLayout layout = TransformMatrixLayout::Mat4,
+			size_t first = 0, size_t count = All, unsigned threadCount = 1) const
+		{
+			const size_t end = rangeEnd(first, count);
+			if (end == first)
+				return true;
+
+			const GLsizeiptr length = static_cast<GLsizeiptr>((end - first) * matrixSize(layout));
+			void* mapped = buffer.mapRange(offset, length, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+			if (mapped == nullptr)
+				return false;
+
+			computeMatrices(mapped, layout, first, end - first, threadCount);
+			return buffer.unmap();
+		}
+
+		/// @brief The raw component arrays, e.g. to fill positions from a simulation without going through set().
+		GAL_NODISCARD GAL_INLINE float* positionsX() noexcept { return components[PX].data(); }
+		GAL_NODISCARD GAL_INLINE float* positionsY() noexcept { return components[PY].data(); }
+		GAL_NODISCARD GAL_INLINE float* positionsZ() noexcept { return components[PZ].data(); }
+		GAL_NODISCARD GAL_INLINE float* rotationsX() noexcept { return components[QX].data(); }
+		GAL_NODISCARD GAL_INLINE float* rotationsY() noexcept { return components[QY].data(); }
+		GAL_NODISCARD GAL_INLINE float* rotationsZ() noexcept { return components[QZ].data(); }
+		GAL_NODISCARD GAL_INLINE float* rotationsW() noexcept { return components[QW].data(); }
+		GAL_NODISCARD GAL_INLINE float* scalesX() noexcept { return components[SX].data(); }
+		GAL_NODISCARD GAL_INLINE float* scalesY() noexcept { return components[SY].data(); }
+		GAL_NODISCARD GAL_INLINE float* scalesZ() noexcept { return components[SZ].data(); }
+
+	private:
+		using AlignedFloats = std::vector<float, detail::AlignedAllocator<float>>;
+
+		enum Component { PX, PY, PZ, QX, QY, QZ, QW, SX, SY, SZ, ComponentCount };
+
+		std::array<AlignedFloats, ComponentCount> components;
+
+		GAL_NODISCARD GAL_INLINE size_t rangeEnd(size_t first, size_t count) const noexcept
+		{
+			first = std::min(first, size());
+			return first + std::min(count, size() - first);
+		}
+
+		/// @brief Write matrices for [begin, end) in steps of Lanes::Width, stopping before a partial step. Returns where
+		/// it stopped.
+		template<typename Lanes>
+		GAL_INLINE size_t matricesRange(size_t begin, size_t end, float* out, TransformMatrixLayout layout) const noexcept
+		{
+			using L = Lanes;
+			using V = typename L::Type;
+
+			const V zero = L::set1(0.0f);
+			const V one = L::set1(1.0f);
+			const V two = L::set1(2.0f);
+
+			size_t i = begin;
+			for (; i + L::Width <= end; i += L::Width)
+			{
+				const V x = L::load(&components[QX][i]);
+				const V y = L::load(&components[QY][i]);
+				const V z = L::load(&components[QZ][i]);
+				const V w = L::load(&components[QW][i]);
+
+				const V xx = L::mul(x, x), yy = L::mul(y, y), zz = L::mul(z, z);
+				const V xy = L::mul(x, y), xz = L::mul(x, z), yz = L::mul(y, z);
+				const V wx = L::mul(w, x), wy = L::mul(w, y), wz = L::mul(w, z);
+
+				// Same closed form as Transform::getModelMatrix.
+				const V sx = L::load(&components[SX][i]);
+				const V sy = L::load(&components[SY][i]);
+				const V sz = L::load(&components[SZ][i]);
+
+				const V m00 = L::mul(L::sub(one, L::mul(two, L::add(yy, zz))), sx);
+				const V m10 = L::mul(L::mul(two, L::add(xy, wz)), sx);
+				const V m20 = L::mul(L::mul(two, L::sub(xz, wy)), sx);
+
+				const V m01 = L::mul(L::mul(two, L::sub(xy, wz)), sy);
+				const V m11 = L::mul(L::sub(one, L::mul(two, L::add(xx, zz))), sy);
+				const V m21 = L::mul(L::mul(two, L::add(yz, wx)), sy);
+
+				const V m02 = L::mul(L::mul(two, L::add(xz, wy)), sz);
+				const V m12 = L::mul(L::mul(two, L::sub(yz, wx)), sz);
+				const V m22 = L::mul(L::sub(one, L::mul(two, L::add(xx, yy))), sz);
+
+				const V px = L::load(&components[PX][i]);
+				const V py = L::load(&components[PY][i]);
+				const V pz = L::load(&components[PZ][i]);
+
+				float* matrix = out + (i - begin) * (matrixSize(layout) / sizeof(float));
+
+				if (layout == TransformMatrixLayout::Mat4)
+				{
+					L::storeTransposed(matrix, 16, m00, m10, m20, zero);
+					L::storeTransposed(matrix + 4, 16, m01, m11, m21, zero);
+					L::storeTransposed(matrix + 8, 16, m02, m12, m22, zero);
+					L::storeTransposed(matrix + 12, 16, px, py, pz, one);
+				}
+				else
+				{
+					L::storeTransposed(matrix, 12, m00, m01, m02, px);
+					L::storeTransposed(matrix + 4, 12, m10, m11, m12, py);
+					L::storeTransposed(matrix + 8, 12, m20, m21, m22, pz);
+				}
+			}
+
+			return i;
+		}
+
+		template<typename Lanes>
+		GAL_INLINE size_t translateLocalRange(size_t begin, size_t end, const glm::vec3& delta) noexcept
+		{
+			using L = Lanes;
+			using V = typename L::Type;
+
+			const V two = L::set1(2.0f);
+			const V vx = L::set1(delta.x), vy = L::set1(delta.y), vz = L::set1(delta.z);
+
+			size_t i = begin;
+			for (; i + L::Width <= end; i += L::Width)
+			{
+				const V x = L::load(&components[QX][i]);
+				const V y = L::load(&components[QY][i]);
+				const V z = L::load(&components[QZ][i]);
+				const V w = L::load(&components[QW][i]);
+
+				// v + w * t + cross(q.xyz, t), with t = 2 * cross(q.xyz, v).
+				const V tx = L::mul(two, L::sub(L::mul(y, vz), L::mul(z, vy)));
+				const V ty = L::mul(two, L::sub(L::mul(z, vx), L::mul(x, vz)));
+				const V tz = L::mul(two, L::sub(L::mul(x, vy), L::mul(y, vx)));
+
+				const V rx = L::add(L::add(vx, L::mul(w, tx)), L::sub(L::mul(y, tz), L::mul(z, ty)));
+				const V ry = L::add(L::add(vy, L::mul(w, ty)), L::sub(L::mul(z, tx), L::mul(x, tz)));
+				const V rz = L::add(L::add(vz, L::mul(w, tz)), L::sub(L::mul(x, ty), L::mul(y, tx)));
+
+				L::store(&components[PX][i], L::add(L::load(&components[PX][i]), rx));
+				L::store(&components[PY][i], L::add(L::load(&components[PY][i]), ry));
+				L::store(&components[PZ][i], L::add(L::load(&components[PZ][i]), rz));
+			}
+
+			return i;
+		}
+
+		/// @brief q = normalize(delta * q) when Global, q = normalize(q * delta) otherwise.
+		template<typename Lanes, bool Global>
+		GAL_INLINE size_t rotateRange(size_t begin, size_t end, const glm::quat& delta) noexcept
+		{
+			using L = Lanes;
+			using V = typename L::Type;
+
+			const V one = L::set1(1.0f);
+			const V dx = L::set1(delta.x), dy = L::set1(delta.y), dz = L::set1(delta.z), dw = L::set1(delta.w);
+
+			size_t i = begin;
+			for (; i + L::Width <= end; i += L::Width)
+			{
+				const V qx = L::load(&components[QX][i]);
+				const V qy = L::load(&components[QY][i]);
+				const V qz = L::load(&components[QZ][i]);
+				const V qw = L::load(&components[QW][i]);
+
+				const V ax = Global ? dx : qx, ay = Global ? dy : qy, az = Global ? dz : qz, aw = Global ? dw : qw;
+				const V bx = Global ? qx : dx, by = Global ? qy : dy, bz = Global ? qz : dz, bw = Global ? qw : dw;
+
+				const V x = L::add(L::add(L::mul(aw, bx), L::mul(ax, bw)), L::sub(L::mul(ay, bz), L::mul(az, by)));
+				const V y = L::add(L::sub(L::mul(aw, by), L::mul(ax, bz)), L::add(L::mul(ay, bw), L::mul(az, bx)));
+				const V z = L::add(L::add(L::mul(aw, bz), L::mul(ax, by)), L::sub(L::mul(az, bw), L::mul(ay, bx)));
+				const V w = L::sub(L::sub(L::mul(aw, bw), L::mul(ax, bx)), L::add(L::mul(ay, by), L::mul(az, bz)));
+
+				const V length = L::sqrt(L::add(L::add(L::mul(x, x), L::mul(y, y)), L::add(L::mul(z, z), L::mul(w, w))));
+				const V inverseLength = L::div(one, length);
+
+				L::store(&components[QX][i], L::mul(x, inverseLength));
+				L::store(&components[QY][i], L::mul(y, inverseLength));
+				L::store(&components[QZ][i], L::mul(z, inverseLength));
+				L::store(&components[QW][i], L::mul(w, inverseLength));
+			}
+
+			return i;
+		}
+	};
+}
+
+#endif
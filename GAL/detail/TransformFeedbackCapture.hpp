@@ -0,0 +1,151 @@
+#ifndef GAL_TRANSFORM_FEEDBACK_CAPTURE_HPP
+#define GAL_TRANSFORM_FEEDBACK_CAPTURE_HPP
+
+#include "attributes.hpp"
+#include "Buffer.hpp"
+#include "ResourceTracker.hpp"
+#include "types.hpp"
+#include "VertexArray.hpp"
+
+namespace gal
+{
+	namespace detail
+	{
+		GAL_INLINE void deleteTransformFeedback(type::GALTransformFeedbackID id)
+		{
+			glDeleteTransformFeedbacks(1, &id);
+		}
+
+		GAL_INLINE ResourceTracker<type::GALTransformFeedbackID, deleteTransformFeedback> transformFeedbackTracker;
+	}
+
+	/// @brief Records vertex shader output into buffers so that expensive vertex processing (skinning, deformation, etc.)
+	/// can be done once and the result drawn by several passes.
+	///
+	/// Usage: call ShaderProgram::setTransformFeedbackVaryings() before linking the capturing program, bind the buffers
+	/// to record into with bindBuffer(), then wrap the capturing draw in beginAB() and end(). Later passes draw the
+	/// recorded vertices with a VAO reading from those buffers via drawAB()/drawNB(), which use the vertex count recorded
+	/// by the GPU, so nothing needs to be read back.
+	class TransformFeedbackCapture
+	{
+	public:
+		GAL_INLINE TransformFeedbackCapture()
+		{
+			glCreateTransformFeedbacks(1, &transformFeedbackID);
+			detail::transformFeedbackTracker.add(transformFeedbackID);
+		}
+
+		// Forbid copying.
+		GAL_INLINE TransformFeedbackCapture(const TransformFeedbackCapture&) = delete;
+		GAL_INLINE TransformFeedbackCapture& operator=(const TransformFeedbackCapture&) = delete;
+
+		// Allow moving.
+		GAL_INLINE TransformFeedbackCapture(TransformFeedbackCapture&&) noexcept = default;
+		GAL_INLINE TransformFeedbackCapture& operator=(TransformFeedbackCapture&&) noexcept = default;
+
+		GAL_INLINE ~TransformFeedbackCapture()
+		{
+			detail::transformFeedbackTracker.remove(transformFeedbackID);
+		}
+
+		GAL_NODISCARD GAL_INLINE type::GALTransformFeedbackID getID() const noexcept { return transformFeedbackID; }
+
+		/// @brief Query whether a capture is currently active (between begin and end).
+		GAL_NODISCARD GAL_INLINE bool isCapturing() const noexcept { return capturing; }
+
+		/// @brief Record into the whole of the given buffer at the given binding index.
+		/// With GL_INTERLEAVED_ATTRIBS only index 0 is used.
+		GAL_INLINE void bindBuffer(const Buffer& buffer, GLuint index = 0) noexcept
+		{
+			glTransformFeedbackBufferBase(transformFeedbackID, index, buffer.getID());
+		}
+
+		/// @brief Record into a subsection of the given buffer at the given binding index.
+		/// offset must be a multiple of 4.
+		GAL_INLINE void bindBufferRange(const Buffer& buffer, GLuint index, GLintptr offset, GLsizeiptr size) noexcept
+		{
+			glTransformFeedbackBufferRange(transformFeedbackID, index, buffer.getID(), offset, size);
+		}
+
+		/// @brief Bind this transform feedback object for use. DSA is encouraged where possible.
+		GAL_INLINE void bind() const noexcept
+		{
+			glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, transformFeedbackID);
+		}
+
+		/// @brief Bind this object and start recording. Subsequent draws with the capturing program write into the bound buffers.
+		/// @param primitiveMode: GL_POINTS, GL_LINES or GL_TRIANGLES. Draws must use a compatible mode. Strips and fans
+		/// are recorded as separate primitives, and indexed draws are recorded unindexed.
+		/// @param discardRasterization: Enables GL_RASTERIZER_DISCARD until end(), for passes that only capture.
+		GAL_INLINE void beginAB(GLenum primitiveMode, bool discardRasterization = false) noexcept
+		{
+			bind();
+			beginNB(primitiveMode, discardRasterization);
+		}
+
+		/// @brief Same as beginAB(), but assumes this object is already bound.
+		GAL_INLINE void beginNB(GLenum primitiveMode, bool discardRasterization = false) noexcept
+		{
+			if (discardRasterization)
+				glEnable(GL_RASTERIZER_DISCARD);
+
+			glBeginTransformFeedback(primitiveMode);
+
+			discarding = discardRasterization;
+			capturing = true;
+		}
+
+		/// @brief Stop recording. The number of vertices written is kept for drawAB()/drawNB().
+		GAL_INLINE void end() noexcept
+		{
+			glEndTransformFeedback();
+
+			if (discarding)
+				glDisable(GL_RASTERIZER_DISCARD);
+
+			discarding = false;
+			capturing = false;
+		}
+
+		/// @brief Temporarily stop recording, e.g. to draw something else with a different program mid-capture.
+		GAL_INLINE void pause() const noexcept { glPauseTransformFeedback(); }
+
+		/// @brief Resume recording after pause().
+		GAL_INLINE void resume() const noexcept { glResumeTransformFeedback(); }
+
+		/// @brief Binds the VAO and draws the vertices recorded by the last capture.
+		/// The VAO should source its vertex attributes from the buffers this object recorded into.
+		GAL_INLINE void drawAB(const VertexArray& vao, GLenum polygonMode) const noexcept
+		{
+			vao.bind();
+			drawNB(polygonMode);
+		}
+
+		/// @brief Draws the vertices recorded by the last capture. Assumes the VAO reading them is bound.
+		GAL_INLINE void drawNB(GLenum polygonMode) const noexcept
+		{
+			glDrawTransformFeedback(polygonMode, transformFeedbackID);
+		}
+
+		/// @brief Binds the VAO and draws the vertices recorded by the last capture instanceCount times.
+		GAL_INLINE void drawInstancedAB(const VertexArray& vao, GLenum polygonMode, GLsizei instanceCount) const noexcept
+		{
+			vao.bind();
+			drawInstancedNB(polygonMode, instanceCount);
+		}
+
+		/// @brief Draws the vertices recorded by the last capture instanceCount times. Assumes the VAO reading them is bound.
+		GAL_INLINE void drawInstancedNB(GLenum polygonMode, GLsizei instanceCount) const noexcept
+		{
+			glDrawTransformFeedbackInstanced(polygonMode, transformFeedbackID, instanceCount);
+		}
+
+	private:
+		type::GALTransformFeedbackID transformFeedbackID;
+
+		bool capturing = false;
+		bool discarding = false;
+	};
+}
+
+#endif
@@ -0,0 +1,368 @@
+#ifndef GAL_TRANSFORM_HIERARCHY_HPP
+#define GAL_TRANSFORM_HIERARCHY_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "attributes.hpp"
+#include "enums.hpp"
+#include "GALException.hpp"
+#include "Transform.hpp"
+
+namespace gal
+{
+	/// @brief Identifies a node of a TransformHierarchy. Stays the same while the hierarchy reorders its nodes.
+	using TransformHandle = uint32_t;
+
+	/// @brief A forest of Transforms, each relative to its parent, that computes every node's world matrix.
+	///
+	/// Nodes are stored in contiguous arrays in depth first order, so a parent always comes before its children and a
+	/// subtree is one contiguous range. update() only recomputes the subtrees under nodes whose local transform changed,
+	/// walking each range front to back, so its cost grows with how much of the scene moved rather than its size.
+	/// Creating a node under a parent whose subtree isn't at the back, or re-parenting, defers a reorder to the next
+	/// update(), so building or restructuring many nodes at once costs a single pass.
+	class TransformHierarchy
+	{
+	public:
+		GAL_STATIC GAL_CONSTEXPR TransformHandle NullHandle = UINT32_MAX;
+
+		GAL_INLINE TransformHierarchy() = default;
+
+		/// @brief Add a node with the given local transform, as a root or as the last child of parent.
+		GAL_NODISCARD GAL_INLINE TransformHandle create(const Transform& local = Transform(), TransformHandle parent = NullHandle)
+		{
+			const uint32_t parentIndex = parent == NullHandle ? NoIndex : indexOf(parent);
+			const uint32_t index = static_cast<uint32_t>(handles.size());
+
+			TransformHandle handle;
+			if (!freeHandles.empty())
+			{
+				handle = freeHandles.back();
+				freeHandles.pop_back();
+			}
+			else
+			{
+				handle = static_cast<TransformHandle>(handleToIndex.size());
+				handleToIndex.push_back(NoIndex);
+			}
+
+			// Appending keeps the depth first order as long as the parent's subtree ends at the back, which is always the
+			// case for roots and when building depth first.
+			if (orderValid && parentIndex != NoIndex && parentIndex + subtreeSizes[parentIndex] != index)
+				orderValid = false;
+
+			parents.push_back(parentIndex);
+			subtreeSizes.push_back(1);
+			locals.push_back(local);
+			worldMatrices.push_back(glm::mat4(1.0f));
+			handles.push_back(handle);
+			dirtyFlags.push_back(1);
+
+			handleToIndex[handle] = index;
+			dirtyHandles.push_back(handle);
+
+			if (orderValid)
+			{
+				for (uint32_t ancestor = parentIndex; ancestor != NoIndex; ancestor = parents[ancestor])
+					subtreeSizes[ancestor]++;
+			}
+
+			return handle;
+		}
+
+		/// @brief Remove a node along with all of its descendants. Their handles may be reused by later nodes.
+		GAL_INLINE void destroy(TransformHandle handle)
+		{
+			if (!orderValid)
+				rebuildOrder();
+
+			const uint32_t first = indexOf(handle);
+			const uint32_t count = subtreeSizes[first];
+			const uint32_t last = first + count;
+
+			for (uint32_t ancestor = parents[first]; ancestor != NoIndex; ancestor = parents[ancestor])
+				subtreeSizes[ancestor] -= count;
+
+			for (uint32_t i = first; i < last; ++i)
+			{
+				handleToIndex[handles[i]] = NoIndex;
+				freeHandles.push_back(handles[i]);
+			}
+
+			eraseRange(parents, first, last);
+			eraseRange(subtreeSizes, first, last);
+			eraseRange(locals, first, last);
+			eraseRange(worldMatrices, first, last);
+			eraseRange(handles, first, last);
+			eraseRange(dirtyFlags, first, last);
+
+			// Nothing outside the removed range was parented inside it, so later indices just shift down.
+			for (uint32_t i = first; i < static_cast<uint32_t>(handles.size()); ++i)
+			{
+				if (parents[i] != NoIndex && parents[i] >= last)
+					parents[i] -= count;
+
+				handleToIndex[handles[i]] = i;
+			}
+		}
+
+		/// @brief Move a node, along with its descendants, under a new parent, or make it a root with NullHandle. Its local
+		/// transform is kept, so its world transform changes unless the old and new parents' world matrices match.
+		GAL_INLINE void setParent(TransformHandle handle, TransformHandle parent)
+		{
+			const uint32_t index = indexOf(handle);
+			const uint32_t parentIndex = parent == NullHandle ? NoIndex : indexOf(parent);
+
+			for (uint32_t ancestor = parentIndex; ancestor != NoIndex; ancestor = parents[ancestor])
+			{
+				if (ancestor == index)
+					detail::throwErr(ErrCode::TransformHierarchyCycle, "Attempted to parent a transform hierarchy node to itself or one of its descendants.");
+			}
+
+			if (parents[index] == parentIndex)
+				return;
+
+			parents[index] = parentIndex;
+			orderValid = false;
+			markDirty(index);
+		}
+
+		/// @brief Get a node's parent, or NullHandle for a root.
+		GAL_NODISCARD GAL_INLINE TransformHandle getParent(TransformHandle handle) const
+		{
+			const uint32_t parentIndex = parents[indexOf(handle)];
+			return parentIndex == NoIndex ? NullHandle : handles[parentIndex];
+		}
+
+		GAL_NODISCARD GAL_INLINE const Transform& getLocal(TransformHandle handle) const
+		{
+			return locals[indexOf(handle)];
+		}
+
+		GAL_INLINE void setLocal(TransformHandle handle, const Transform& local)
+		{
+			const uint32_t index = indexOf(handle);
+			locals[index] = local;
+			markDirty(index);
+		}
+
+		/// @brief Mark a node as changed and get its local transform to modify in place, e.g.
+		/// hierarchy.modifyLocal(wheel).applyRotationLocal(spin). Don't keep the reference past the next create() or update().
+		GAL_NODISCARD GAL_INLINE Transform& modifyLocal(TransformHandle handle)
+		{
+			const uint32_t index = indexOf(handle);
+			markDirty(index);
+			return locals[index];
+		}
+
+		/// @brief Recompute the world matrices of every changed node and its descendants. Call once per frame after
+		/// modifying local transforms. Returns the number of world matrices recomputed.
+		GAL_INLINE size_t update()
+		{
+			if (!orderValid)
+				rebuildOrder();
+
+			dirtyIndices.clear();
+			for (TransformHandle handle : dirtyHandles)
+			{
+				if (handle < handleToIndex.size() && handleToIndex[handle] != NoIndex)
+					dirtyIndices.push_back(handleToIndex[handle]);
+			}
+			dirtyHandles.clear();
+
+			std::sort(dirtyIndices.begin(), dirtyIndices.end());
+
+			size_t recomputed = 0;
+			uint32_t coveredEnd = 0;
+
+			for (uint32_t first : dirtyIndices)
+			{
+				// Already recomputed as part of a dirty ancestor's subtree.
+				if (first < coveredEnd)
+					continue;
+
+				const uint32_t last = first + subtreeSizes[first];
+				for (uint32_t i = first; i < last; ++i)
+				{
+					const glm::mat4& local = locals[i].getModelMatrix();
+					worldMatrices[i] = parents[i] == NoIndex ? local : worldMatrices[parents[i]] * local;
+					dirtyFlags[i] = 0;
+				}
+
+				recomputed += last - first;
+				coveredEnd = last;
+			}
+
+			return recomputed;
+		}
+
+		/// @brief Get a node's world matrix as of the last update().
+		GAL_NODISCARD GAL_INLINE const glm::mat4& getWorldMatrix(TransformHandle handle) const
+		{
+			return worldMatrices[indexOf(handle)];
+		}
+
+		/// @brief Every node's world matrix as of the last update(), in the same order as getHandles(), e.g. to upload
+		/// to a Buffer in one go.
+		GAL_NODISCARD GAL_INLINE const std::vector<glm::mat4>& getWorldMatrices() const noexcept { return worldMatrices; }
+
+		/// @brief The handle of each node, in storage order. Only meaningful right after update().
+		GAL_NODISCARD GAL_INLINE const std::vector<TransformHandle>& getHandles() const noexcept { return handles; }
+
+		GAL_NODISCARD GAL_INLINE bool contains(TransformHandle handle) const noexcept
+		{
+			return handle < handleToIndex.size() && handleToIndex[handle] != NoIndex;
+		}
+
+		GAL_NODISCARD GAL_INLINE size_t size() const noexcept { return handles.size(); }
+
+		/// @brief Remove every node.
+		GAL_INLINE void clear() noexcept
+		{
+			parents.clear();
+			subtreeSizes.clear();
+			locals.clear();
+			worldMatrices.clear();
+			handles.clear();
+			dirtyFlags.clear();
+			handleToIndex.clear();
+			freeHandles.clear();
+			dirtyHandles.clear();
+			orderValid = true;
+		}
+
+	private:
+		GAL_STATIC GAL_CONSTEXPR uint32_t NoIndex = UINT32_MAX;
+
+		// Per node, in depth first order.
+		std::vector<uint32_t> parents; // Index of the parent, or NoIndex for roots.
+		std::vector<uint32_t> subtreeSizes; // Including the node itself. Only up to date while orderValid.
+		std::vector<Transform> locals;
+		std::vector<glm::mat4> worldMatrices;
+		std::vector<TransformHandle> handles;
+		std::vector<uint8_t> dirtyFlags; // Whether the node is already in dirtyHandles.
+
+		std::vector<uint32_t> handleToIndex;
+		std::vector<TransformHandle> freeHandles;
+
+		std::vector<TransformHandle> dirtyHandles; // Handles rather than indices, since a reorder may happen before update().
+		std::vector<uint32_t> dirtyIndices;
+
+		bool orderValid = true;
+
+		GAL_NODISCARD GAL_INLINE uint32_t indexOf(TransformHandle handle) const
+		{
+			if (!contains(handle))
+				detail::throwErr(ErrCode::InvalidTransformHandle, "Used a transform hierarchy handle that was never created or has been destroyed.");
+
+			return handleToIndex[handle];
+		}
+
+		GAL_INLINE void markDirty(uint32_t index)
+		{
+			if (!dirtyFlags[index])
+			{
+				dirtyFlags[index] = 1;
+				dirtyHandles.push_back(handles[index]);
+			}
+		}
+
+		template<typename T>
+		GAL_STATIC GAL_INLINE void eraseRange(std::vector<T>& values, uint32_t first, uint32_t last)
+		{
+			values.erase(values.begin() + first, values.begin() + last);
+		}
+
+		/// @brief Restore the depth first order after nodes were added out of order or re-parented. Siblings keep their
+		/// relative order.
+		GAL_INLINE void rebuildOrder()
+		{
+			const uint32_t count = static_cast<uint32_t>(handles.size());
+
+			// Children of each node as ranges of one array.
+			std::vector<uint32_t> childStarts(count + 1, 0);
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				if (parents[i] != NoIndex)
+					childStarts[parents[i] + 1]++;
+			}
+
+			for (uint32_t i = 0; i < count; ++i)
+				childStarts[i + 1] += childStarts[i];
+
+			std::vector<uint32_t> children(childStarts.back());
+			std::vector<uint32_t> cursors(childStarts.begin(), childStarts.end() - 1);
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				if (parents[i] != NoIndex)
+					children[cursors[parents[i]]++] = i;
+			}
+
+			std::vector<uint32_t> order;
+			order.reserve(count);
+			std::vector<uint32_t> stack;
+
+			for (uint32_t root = 0; root < count; ++root)
+			{
+				if (parents[root] != NoIndex)
+					continue;
+
+				stack.push_back(root);
+				while (!stack.empty())
+				{
+					const uint32_t node = stack.back();
+					stack.pop_back();
+					order.push_back(node);
+
+					for (uint32_t child = childStarts[node + 1]; child > childStarts[node]; --child)
+						stack.push_back(children[child - 1]);
+				}
+			}
+
+			std::vector<uint32_t> newIndices(count);
+			for (uint32_t i = 0; i < count; ++i)
+				newIndices[order[i]] = i;
+
+			std::vector<uint32_t> newParents(count);
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				const uint32_t oldParent = parents[order[i]];
+				newParents[i] = oldParent == NoIndex ? NoIndex : newIndices[oldParent];
+			}
+			parents.swap(newParents);
+
+			permute(locals, order);
+			permute(worldMatrices, order);
+			permute(handles, order);
+			permute(dirtyFlags, order);
+
+			// Parents come before their children, so summing back to front finishes each subtree before its parent reads it.
+			subtreeSizes.assign(count, 1);
+			for (uint32_t i = count; i-- > 0;)
+			{
+				if (parents[i] != NoIndex)
+					subtreeSizes[parents[i]] += subtreeSizes[i];
+			}
+
+			for (uint32_t i = 0; i < count; ++i)
+				handleToIndex[handles[i]] = i;
+
+			orderValid = true;
+		}
+
+		template<typename T>
+		GAL_STATIC GAL_INLINE void permute(std::vector<T>& values, const std::vector<uint32_t>& order)
+		{
+			std::vector<T> permuted;
+			permuted.reserve(values.size());
+
+			for (uint32_t index : order)
+				permuted.push_back(std::move(values[index]));
+
+			values.swap(permuted);
+		}
+	};
+}
+
+#endif
@@ -1,8 +1,36 @@
 #ifndef GAL_VERTEX_ARRAY_HPP
 #define GAL_VERTEX_ARRAY_HPP
 
+#include <vector>
+
+#include "attributes.hpp"
+#include "Buffer.hpp"
+#include "enums.hpp"
+#include "GALException.hpp"
+#include "glParams.hpp"
+#include "ResourceTracker.hpp"
+
 namespace gal
 {
+	/// @brief Layout of a single command in a buffer used for indirect indexed drawing (see glDrawElementsIndirect).
+	struct DrawElementsIndirectCommand
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	/// @brief Layout of a single command in a buffer used for indirect non-indexed drawing (see glDrawArraysIndirect).
+	struct DrawArraysIndirectCommand
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint first;
+		GLuint baseInstance;
+	};
+
 	namespace detail
 	{
 		GAL_INLINE void deleteVertexArray(type::GALVertexArrayID id)
@@ -169,6 +197,26 @@ namespace gal
 			glVertexArrayAttribBinding(vertexArrayID, attributeIndex, bindingIndex);
 		}
 
+		/// @brief Define a new integer vertex attribute using data from the VBO at bindingIndex.
+		/// Unlike newVertexAttribute(), the data is not converted to floats, so use this for ivec/uvec shader inputs.
+		GAL_INLINE void newVertexAttributeI(GLuint attributeIndex, GLuint bindingIndex, GLint size, GLenum type, GLuint relativeOffset)
+		{
+			checkAttributeIndex(attributeIndex);
+
+			glEnableVertexArrayAttrib(vertexArrayID, attributeIndex);
+			glVertexArrayAttribIFormat(vertexArrayID, attributeIndex, size, type, relativeOffset);
+			glVertexArrayAttribBinding(vertexArrayID, attributeIndex, bindingIndex);
+		}
+
+		/// @brief Set how often attributes sourced from the given binding index advance.
+		/// 0 advances once per vertex, N advances once every N instances.
+		GAL_INLINE void setBindingDivisor(GLuint bindingIndex, GLuint divisor)
+		{
+			checkBindingIndex(bindingIndex);
+
+			glVertexArrayBindingDivisor(vertexArrayID, bindingIndex, divisor);
+		}
+
 		// TODO: Instanced draw and such.
 
 		/// @brief Set the settings that will be used for drawing when calling drawAB() or drawNB().
@@ -233,6 +281,76 @@ namespace gal
 			glDrawElements(polygonMode, count, elementBufferIndexType, reinterpret_cast<void*>(offset));
 		}
 
+		/// @brief Binds this VAO and draws it using drawCount DrawElementsIndirectCommands read from the command buffer,
+		/// starting at the given offset. The command buffer is bound to GL_DRAW_INDIRECT_BUFFER regardless of its own type.
+		GAL_INLINE void multiDrawElementsIndirectAB(GLenum polygonMode, const Buffer& commandBuffer, GLintptr offset,
+			GLsizei drawCount, GLsizei stride = 0) const noexcept
+		{
+			bind();
+			multiDrawElementsIndirectNB(polygonMode, commandBuffer, offset, drawCount, stride);
+		}
+
+		/// @brief Draws this VAO using drawCount DrawElementsIndirectCommands read from the command buffer,
+		/// starting at the given offset. The command buffer is bound to GL_DRAW_INDIRECT_BUFFER regardless of its own type.
+		GAL_INLINE void multiDrawElementsIndirectNB(GLenum polygonMode, const Buffer& commandBuffer, GLintptr offset,
+			GLsizei drawCount, GLsizei stride = 0) const noexcept
+		{
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer.getID());
+			glMultiDrawElementsIndirect(polygonMode, elementBufferIndexType, reinterpret_cast<void*>(offset), drawCount, stride);
+		}
+
+		/// @brief Whether the current context can read the draw count of multiDrawElementsIndirectCountAB/NB() from a
+		/// buffer, through OpenGL 4.6 or ARB_indirect_parameters. Checked at run time, as the loader header only says which
+		/// functions it declares, not which ones the driver provides.
+		GAL_NODISCARD GAL_STATIC GAL_INLINE bool supportsIndirectDrawCount() noexcept
+		{
+#ifdef GL_VERSION_4_6
+			if (GLAD_GL_VERSION_4_6)
+				return true;
+#endif
+#ifdef GL_ARB_indirect_parameters
+			if (GLAD_GL_ARB_indirect_parameters)
+				return true;
+#endif
+			return false;
+		}
+
+#if defined(GL_VERSION_4_6) || defined(GL_ARB_indirect_parameters)
+		/// @brief Binds this VAO and draws it using DrawElementsIndirectCommands read from the command buffer, with the
+		/// number of commands read as a GLsizei from the parameter buffer at drawCountOffset (capped at maxDrawCount).
+		/// Requires supportsIndirectDrawCount().
+		GAL_INLINE void multiDrawElementsIndirectCountAB(GLenum polygonMode, const Buffer& commandBuffer, GLintptr offset,
+			const Buffer& parameterBuffer, GLintptr drawCountOffset, GLsizei maxDrawCount, GLsizei stride = 0) const noexcept
+		{
+			bind();
+			multiDrawElementsIndirectCountNB(polygonMode, commandBuffer, offset, parameterBuffer, drawCountOffset, maxDrawCount, stride);
+		}
+
+		/// @brief Draws this VAO using DrawElementsIndirectCommands read from the command buffer, with the
+		/// number of commands read as a GLsizei from the parameter buffer at drawCountOffset (capped at maxDrawCount).
+		/// Requires supportsIndirectDrawCount().
+		GAL_INLINE void multiDrawElementsIndirectCountNB(GLenum polygonMode, const Buffer& commandBuffer, GLintptr offset,
+			const Buffer& parameterBuffer, GLintptr drawCountOffset, GLsizei maxDrawCount, GLsizei stride = 0) const noexcept
+		{
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer.getID());
+
+#ifdef GL_VERSION_4_6
+			if (GLAD_GL_VERSION_4_6)
+			{
+				glBindBuffer(GL_PARAMETER_BUFFER, parameterBuffer.getID());
+				glMultiDrawElementsIndirectCount(polygonMode, elementBufferIndexType, reinterpret_cast<void*>(offset),
+					drawCountOffset, maxDrawCount, stride);
+				return;
+			}
+#endif
+#ifdef GL_ARB_indirect_parameters
+			glBindBuffer(GL_PARAMETER_BUFFER_ARB, parameterBuffer.getID());
+			glMultiDrawElementsIndirectCountARB(polygonMode, elementBufferIndexType, reinterpret_cast<void*>(offset),
+				drawCountOffset, maxDrawCount, stride);
+#endif
+		}
+#endif
+
 	private:
 		type::GALVertexArrayID vertexArrayID;
 		std::vector<Buffer*> vertexBuffers{ detail::maxVertexAttribBindings, nullptr };
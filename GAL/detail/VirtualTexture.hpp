@@ -0,0 +1,597 @@
+#ifndef GAL_VIRTUAL_TEXTURE_HPP
+#define GAL_VIRTUAL_TEXTURE_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "attributes.hpp"
+#include "barrier.hpp"
+#include "Buffer.hpp"
+#include "enums.hpp"
+#include "Framebuffer.hpp"
+#include "GALException.hpp"
+#include "logging.hpp"
+#include "StreamingCache.hpp"
+#include "Texture.hpp"
+
+namespace gal
+{
+	/// @brief Settings for a VirtualTexture.
+	struct VirtualTextureSettings
+	{
+		GLsizei virtualSize = 65536; // Width and height of the virtual texture in texels. Must be a power of two number of pages.
+		GLsizei pageSize = 128; // Width and height of a page in texels, excluding its border.
+		GLsizei border = 4; // Texels around every page copied from its neighbors, so filtering never reads another page's texels.
+
+		// Page slots in the physical page cache. At most 256 in each direction.
+		GLsizei physicalPagesX = 32;
+		GLsizei physicalPagesY = 32;
+		GLenum internalFormat = GL_SRGB8_ALPHA8; // Of the physical page cache. Pages are always loaded as 8-bit RGBA.
+
+		// Resolution of the feedback pass. Far lower than the screen's, since neighboring pixels mostly want the same pages.
+		GLsizei feedbackWidth = 160;
+		GLsizei feedbackHeight = 90;
+
+		int maxUploadsPerFrame = 16; // Pages copied into the page cache by each call to update().
+		unsigned workerCount = 0; // Page loading threads. 0 picks one less than the number of hardware threads.
+
+		// Binding points used by the shader code from VirtualTexture::getShaderSource().
+		GLuint pageTableUnit = 14;
+		GLuint physicalUnit = 15;
+		GLuint uniformBinding = 14;
+		GLuint requestBinding = 14;
+	};
+
+	/// @brief Snapshot of what a VirtualTexture has resident and how busy its streaming is.
+	struct VirtualTextureStats
+	{
+		size_t residentPages = 0;
+		size_t physicalPages = 0;
+		size_t pendingPages = 0; // Queued for or being loaded by the workers, or loaded and waiting to be uploaded.
+
+		size_t requestedLastFeedback = 0; // Distinct pages seen by the last feedback pass read back.
+		size_t uploadsLastUpdate = 0;
+		size_t evictionsLastUpdate = 0;
+
+		size_t totalUploads = 0;
+		size_t totalEvictions = 0;
+		size_t skippedReadbacks = 0; // Feedback passes not read back because every readback buffer was still in flight.
+		size_t failedPages = 0; // Pages the loader failed to load. They're never requested again.
+	};
+
+	namespace detail
+	{
+		/// @brief Uniform block shared by the sampling and feedback shader code, laid out to match it under std140.
+		struct alignas(16) VirtualTextureParams
+		{
+			float pagesPerSide;
+			float pageSize;
+			float border;
+			float maxLevel;
+			glm::vec2 physicalSize;
+			float lodBias;
+			float padding;
+			glm::uvec4 levelOffsets[4];
+		};
+
+		GAL_INLINE const char* const virtualTextureShaderSource = R"(
+layout(std140, binding = VT_UNIFORM_BINDING) uniform VirtualTextureParams
+{
+	float vtPagesPerSide;
+	float vtPageSize;
+	float vtBorder;
+	float vtMaxLevel;
+	vec2 vtPhysicalSize;
+	float vtLodBias;
+	float vtPadding;
+	uvec4 vtLevelOffsets[4];
+};
+
+layout(binding = VT_PAGE_TABLE_UNIT) uniform usampler2D vtPageTable;
+layout(binding = VT_PHYSICAL_UNIT) uniform sampler2D vtPhysical;
+
+// Mip level of the virtual texture wanted at this pixel, from the screen space derivatives of its texel coordinates.
+float vtMipLevel(vec2 uv)
+{
+	vec2 texel = uv * (vtPagesPerSide * vtPageSize);
+	vec2 dx = dFdx(texel);
+	vec2 dy = dFdy(texel);
+	float rho = max(dot(dx, dx), dot(dy, dy));
+
+	return clamp(0.5 * log2(max(rho, 1e-8)) + vtLodBias, 0.0, vtMaxLevel);
+}
+
+// Page containing uv at the given level (xy) and the number of pages across that level (z).
+ivec3 vtPageAt(vec2 uv, int level)
+{
+	int pages = int(vtPagesPerSide) >> level;
+	return ivec3(clamp(ivec2(uv * float(pages)), ivec2(0), ivec2(pages - 1)), pages);
+}
+
+// Sample the virtual texture at uv, which is clamped to [0, 1]. Pages that aren't resident yet fall back to their
+// most detailed resident ancestor, so the result is blurrier but never missing.
+vec4 vtSample(vec2 uv)
+{
+	int level = int(vtMipLevel(uv));
+	uv = clamp(uv, 0.0, 1.0);
+
+	uvec4 entry = texelFetch(vtPageTable, vtPageAt(uv, level).xy, level);
+	ivec3 page = vtPageAt(uv, int(entry.b));
+	vec2 inPage = uv * float(page.z) - vec2(page.xy);
+
+	vec2 texel = vec2(entry.rg) * (vtPageSize + 2.0 * vtBorder) + vtBorder + inPage * vtPageSize;
+	return textureLod(vtPhysical, texel / vtPhysicalSize, 0.0);
+}
+
+#ifdef VT_FEEDBACK_PASS
+// Side effects would otherwise disable early depth testing, and hidden surfaces would request pages too.
+layout(early_fragment_tests) in;
+
+layout(std430, binding = VT_REQUEST_BINDING) buffer VirtualTextureRequests
+{
+	uint vtRequests[];
+};
+
+// Record that the page under uv is wanted. Call from the fragment shader of the feedback pass.
+void vtFeedback(vec2 uv)
+{
+	int level = int(vtMipLevel(uv));
+	ivec3 page = vtPageAt(clamp(uv, 0.0, 1.0), level);
+	uint index = vtLevelOffsets[level >> 2][level & 3] + uint(page.y * page.z + page.x);
+
+	atomicOr(vtRequests[index >> 5], 1u << (index & 31u));
+}
+#endif
+)";
+	}
+
+	/// @brief A texture far larger than video memory, streamed in page by page as the camera needs it, using only core
+	/// OpenGL 4.5 (no sparse textures).
+	///
+	/// The virtual texture is split into square pages at every mip level. Resident pages live in slots of a fixed size
+	/// physical page cache, and an integer page table texture, with one texel per page and a mip level per virtual mip
+	/// level, maps each page to its slot. Missing pages point at their nearest resident ancestor instead; the single page
+	/// of the coarsest level is loaded up front and never evicted, so every lookup finds something.
+	///
+	/// To find out which pages are needed, render the scene each frame between beginFeedbackPass() and
+	/// endFeedbackPass() with a fragment shader that calls vtFeedback(). That pass runs at a low resolution into an
+	/// internal depth-only framebuffer and sets one bit per wanted page in a storage buffer, which is copied into a
+	/// persistently mapped readback buffer and fenced. update() reads it back a frame or two later, without stalling,
+	/// queues missing pages coarsest first for the worker threads to load with your loader, and uploads finished pages
+	/// into the least recently wanted slots.
+	///
+	/// Sampling is bilinear within the selected level, there's no blending between levels.
+	class VirtualTexture
+	{
+	public:
+		/// @brief Load one page into out, which holds (pageSize + 2 * border)^2 8-bit RGBA texels, the row at the
+		/// lowest y first.
+		/// The page covers texels [x * pageSize - border, (x + 1) * pageSize + border) of the given mip level, so the border
+		/// repeats its neighbors' edges (pages are usually cut like this offline). Returns false on failure.
+		/// Called from worker threads, and once from the constructor for the coarsest level.
+		using PageLoader = std::function<bool(GLint level, GLint x, GLint y, unsigned char* out)>;
+
+		/// @brief Create the page cache, page table and feedback resources, load the coarsest page and start the workers.
+		/// Requires a current OpenGL context.
+		GAL_INLINE VirtualTexture(PageLoader loader, const VirtualTextureSettings& settings = {})
+			: loader(std::move(loader)), settings(settings)
+		{
+			pagesPerSide = settings.pageSize > 0 ? settings.virtualSize / settings.pageSize : 0;
+
+			if (pagesPerSide <= 0 || pagesPerSide > 16384 || settings.virtualSize % settings.pageSize != 0
+				|| (pagesPerSide & (pagesPerSide - 1)) != 0 || settings.border < 0
+				|| settings.physicalPagesX < 1 || settings.physicalPagesX > 256
+				|| settings.physicalPagesY < 1 || settings.physicalPagesY > 256)
+			{
+				detail::throwErr(ErrCode::InvalidVirtualTextureSettings,
+					"Virtual textures need a power of two number of pages per side and at most 256 physical pages per side.");
+			}
+
+			while ((pagesPerSide >> levelCount) != 0)
+				++levelCount;
+
+			totalPages = 0;
+			for (GLint level = 0; level < levelCount; ++level)
+			{
+				levelOffsets[level] = totalPages;
+				totalPages += static_cast<uint32_t>(pageCount(level)) * pageCount(level);
+			}
+
+			slotSize = settings.pageSize + 2 * settings.border;
+			pageBytes = static_cast<size_t>(slotSize) * slotSize * 4;
+
+			physical.storage(1, settings.internalFormat, slotSize * settings.physicalPagesX, slotSize * settings.physicalPagesY);
+			physical.setParameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			physical.setParameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			physical.setParameter(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			physical.setParameter(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+			pageTable.storage(levelCount, GL_RGBA8UI, pagesPerSide, pagesPerSide);
+			detail::setIntegerTextureFiltering(pageTable);
+
+			tableEntries.assign(totalPages, 0);
+			dirtyRows.assign(levelCount, { pagesPerSide, -1 });
+
+			streaming = std::make_unique<detail::StreamingCache>(totalPages,
+				static_cast<size_t>(settings.physicalPagesX) * settings.physicalPagesY, pageBytes);
+
+			detail::VirtualTextureParams params{};
+			params.pagesPerSide = static_cast<float>(pagesPerSide);
+			params.pageSize = static_cast<float>(settings.pageSize);
+			params.border = static_cast<float>(settings.border);
+			params.maxLevel = static_cast<float>(levelCount - 1);
+			params.physicalSize = glm::vec2(physical.getWidth(), physical.getHeight());
+			for (GLint level = 0; level < levelCount; ++level)
+				params.levelOffsets[level / 4][level % 4] = levelOffsets[level];
+
+			uniformBuffer.allocateImmutable(sizeof(params), &params, GL_DYNAMIC_STORAGE_BIT);
+
+			// One bit per page.
+			requestBytes = static_cast<GLsizeiptr>((totalPages + 31) / 32) * 4;
+			requestBuffer.allocateImmutable(requestBytes, 0);
+
+			const GLbitfield readFlags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			for (Readback& readback : readbacks)
+			{
+				readback.buffer.allocateImmutable(requestBytes, readFlags);
+				readback.words = static_cast<const uint32_t*>(readback.buffer.mapRange(0, requestBytes, readFlags));
+			}
+
+			feedbackDepth.storage(1, GL_DEPTH_COMPONENT32F, settings.feedbackWidth, settings.feedbackHeight);
+			feedbackFramebuffer.attachDepth(feedbackDepth);
+			feedbackFramebuffer.setDrawBuffer(GL_NONE);
+
+			// The coarsest page is the fallback for everything, so it's loaded synchronously and pinned.
+			std::vector<unsigned char> pixels(pageBytes, 0);
+			if (!this->loader(levelCount - 1, 0, 0, pixels.data()))
+			{
+				detail::logErr("VirtualTexture failed to load its coarsest page.");
+				std::fill(pixels.begin(), pixels.end(), static_cast<unsigned char>(0));
+			}
+
+			mapPage(totalPages - 1, pixels.data());
+			uploadPageTable();
+
+			streaming->start([this](uint32_t page, unsigned char* out)
+				{
+					GLint level, x, y;
+					decodePage(page, level, x, y);
+					return this->loader(level, x, y, out);
+				}, settings.workerCount);
+		}
+
+		// Forbid copying and moving, as the loading threads call back into the virtual texture.
+		GAL_INLINE VirtualTexture(const VirtualTexture&) = delete;
+		GAL_INLINE VirtualTexture& operator=(const VirtualTexture&) = delete;
+
+		GAL_INLINE ~VirtualTexture()
+		{
+			// Stop the loading threads before anything they use goes away.
+			streaming.reset();
+
+			for (Readback& readback : readbacks)
+			{
+				if (readback.fence != nullptr)
+					glDeleteSync(readback.fence);
+
+				readback.buffer.unmap();
+			}
+		}
+
+		/// @brief Shader code declaring vtSample(uv), and with feedbackPass vtFeedback(uv), set up for this virtual
+		/// texture's bindings. Insert it after the #version directive (4.50 or later) of the fragment shader.
+		GAL_NODISCARD GAL_INLINE std::string getShaderSource(bool feedbackPass = false) const
+		{
+			std::string source;
+			source += "#define VT_PAGE_TABLE_UNIT " + std::to_string(settings.pageTableUnit) + '\n';
+			source += "#define VT_PHYSICAL_UNIT " + std::to_string(settings.physicalUnit) + '\n';
+			source += "#define VT_UNIFORM_BINDING " + std::to_string(settings.uniformBinding) + '\n';
+			source += "#define VT_REQUEST_BINDING " + std::to_string(settings.requestBinding) + '\n';
+
+			if (feedbackPass)
+				source += "#define VT_FEEDBACK_PASS\n";
+
+			return source + detail::virtualTextureShaderSource;
+		}
+
+		/// @brief Bind the page table, page cache and uniform block for shaders using vtSample() or vtFeedback().
+		GAL_INLINE void bind() const noexcept
+		{
+			pageTable.bindTextureUnit(static_cast<int>(settings.pageTableUnit));
+			physical.bindTextureUnit(static_cast<int>(settings.physicalUnit));
+			uniformBuffer.bindBase(BufferType::Uniform, settings.uniformBinding);
+		}
+
+		/// @brief Start the feedback pass: clears the page requests, binds everything (as bind() does) and switches to
+		/// the internal low resolution depth-only framebuffer, clearing its depth. Draw the scene with a fragment shader
+		/// calling vtFeedback() (color writes go nowhere), then call endFeedbackPass(). Depth writes must be enabled.
+		GAL_INLINE void beginFeedbackPass()
+		{
+			glGetIntegerv(GL_VIEWPORT, savedViewport.data());
+			glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &savedDrawFramebuffer);
+			glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &savedReadFramebuffer);
+
+			requestBuffer.clearAll(GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT);
+			requestBuffer.bindBase(BufferType::ShaderStorage, settings.requestBinding);
+
+			// Derivatives are larger at the lower resolution, so bias the mip level back to what the screen will want.
+			const float lodBias = std::log2(static_cast<float>(settings.feedbackWidth) / std::max(savedViewport[2], 1));
+			writeLodBias(lodBias);
+			bind();
+
+			feedbackFramebuffer.bind();
+			glViewport(0, 0, settings.feedbackWidth, settings.feedbackHeight);
+			feedbackFramebuffer.clearDepth();
+		}
+
+		/// @brief End the feedback pass, restoring the previous draw and read framebuffers and viewport, and start reading
+		/// the page requests back. If every readback buffer is still in flight this pass's requests are dropped.
+		GAL_INLINE void endFeedbackPass()
+		{
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, static_cast<GLuint>(savedDrawFramebuffer));
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(savedReadFramebuffer));
+			glViewport(savedViewport[0], savedViewport[1], savedViewport[2], savedViewport[3]);
+			writeLodBias(0.0f);
+			feedbackFramebuffer.invalidateAll();
+
+			Readback& readback = readbacks[nextReadback];
+			if (readback.fence != nullptr)
+			{
+				stats.skippedReadbacks++;
+				return;
+			}
+
+			memoryBarrier(MemoryBarrierBit::BufferUpdate);
+			readback.buffer.copySub(requestBuffer, 0, 0, requestBytes);
+			readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			readbackOrder.push_back(nextReadback);
+
+			nextReadback = (nextReadback + 1) % readbacks.size();
+		}
+
+		/// @brief Read back finished feedback passes, queue the pages they want for loading, and upload loaded pages
+		/// into the page cache. Call once per frame on the render thread, before drawing with vtSample().
+		GAL_INLINE void update()
+		{
+			streaming->beginFrame();
+
+			while (!readbackOrder.empty())
+			{
+				Readback& readback = readbacks[readbackOrder.front()];
+				const GLenum status = glClientWaitSync(readback.fence, 0, 0);
+
+				if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+					break;
+
+				processFeedback(readback.words);
+
+				glDeleteSync(readback.fence);
+				readback.fence = nullptr;
+				readbackOrder.pop_front();
+			}
+
+			streaming->uploadLoaded(settings.maxUploadsPerFrame, "VirtualTexture failed to load a page.",
+				[this](uint32_t page, const unsigned char* pixels) { return mapPage(page, pixels); });
+			uploadPageTable();
+		}
+
+		GAL_NODISCARD GAL_INLINE const Texture& getPageTable() const noexcept { return pageTable; }
+		GAL_NODISCARD GAL_INLINE const Texture& getPhysicalTexture() const noexcept { return physical; }
+		GAL_NODISCARD GAL_INLINE const VirtualTextureSettings& getSettings() const noexcept { return settings; }
+
+		/// @brief Number of mip levels of the virtual texture, down to a single page.
+		GAL_NODISCARD GAL_INLINE GLint getLevelCount() const noexcept { return levelCount; }
+
+		GAL_NODISCARD GAL_INLINE VirtualTextureStats getStats()
+		{
+			const detail::StreamingCache::Stats& streamingStats = streaming->getStats();
+
+			VirtualTextureStats result = stats;
+			result.physicalPages = streaming->getSlotCount();
+			result.residentPages = streaming->getResidentCount();
+			result.pendingPages = streaming->getPendingCount();
+			result.uploadsLastUpdate = streamingStats.uploadsLastUpdate;
+			result.evictionsLastUpdate = streamingStats.evictionsLastUpdate;
+			result.totalUploads = streamingStats.totalUploads;
+			result.totalEvictions = streamingStats.totalEvictions;
+			result.failedPages = streamingStats.failedItems;
+
+			return result;
+		}
+
+	private:
+		struct Readback
+		{
+			Buffer buffer{ BufferType::CopyWrite };
+			const uint32_t* words = nullptr;
+			GLsync fence = nullptr;
+		};
+
+		PageLoader loader;
+		VirtualTextureSettings settings;
+
+		GLsizei pagesPerSide = 0;
+		GLint levelCount = 0;
+		std::array<uint32_t, 16> levelOffsets{}; // Index of each level's first page. Pages are numbered row by row.
+		uint32_t totalPages = 0;
+		GLsizei slotSize = 0;
+		size_t pageBytes = 0;
+
+		Texture physical{ TextureType::TwoD };
+		Texture pageTable{ TextureType::TwoD };
+		Buffer uniformBuffer{ BufferType::Uniform };
+
+		std::vector<uint32_t> tableEntries; // Per page, its page table texel packed as RGBA8.
+		std::vector<std::pair<GLsizei, GLsizei>> dirtyRows; // Per level, the range of page table rows to upload.
+		Buffer requestBuffer{ BufferType::ShaderStorage };
+		GLsizeiptr requestBytes = 0;
+		std::array<Readback, 3> readbacks;
+		std::deque<size_t> readbackOrder; // Readbacks in flight, oldest first.
+		size_t nextReadback = 0;
+
+		Framebuffer feedbackFramebuffer;
+		Texture feedbackDepth{ TextureType::TwoD };
+		std::array<GLint, 4> savedViewport{};
+		GLint savedDrawFramebuffer = 0;
+		GLint savedReadFramebuffer = 0;
+
+		std::unique_ptr<detail::StreamingCache> streaming;
+		VirtualTextureStats stats;
+
+		GAL_NODISCARD GAL_INLINE GLsizei pageCount(GLint level) const noexcept { return pagesPerSide >> level; }
+
+		GAL_INLINE void decodePage(uint32_t page, GLint& level, GLint& x, GLint& y) const noexcept
+		{
+			level = static_cast<GLint>(std::upper_bound(levelOffsets.begin(), levelOffsets.begin() + levelCount, page)
+				- levelOffsets.begin()) - 1;
+
+			const uint32_t local = page - levelOffsets[level];
+			x = static_cast<GLint>(local % pageCount(level));
+			y = static_cast<GLint>(local / pageCount(level));
+		}
+
+		GAL_NODISCARD GAL_INLINE uint32_t encodePage(GLint level, GLint x, GLint y) const noexcept
+		{
+			return levelOffsets[level] + static_cast<uint32_t>(y) * pageCount(level) + static_cast<uint32_t>(x);
+		}
+
+		GAL_INLINE void writeLodBias(float lodBias)
+		{
+			uniformBuffer.writeSub(offsetof(detail::VirtualTextureParams, lodBias), sizeof(float), &lodBias);
+		}
+
+		/// @brief Mark the pages a feedback pass wanted as recently used, and replace the job queue with the ones missing.
+		GAL_INLINE void processFeedback(const uint32_t* words)
+		{
+			std::vector<uint32_t> missing;
+			size_t requested = 0;
+
+			for (uint32_t word = 0; word < static_cast<uint32_t>(requestBytes / 4); ++word)
+			{
+				for (uint32_t bits = words[word]; bits != 0; bits &= bits - 1)
+				{
+					uint32_t page = word * 32 + static_cast<uint32_t>(countTrailingZeros(bits));
+					requested++;
+
+					// Queue the missing ancestors too, so the image sharpens a level at a time rather than waiting on the finest.
+					while (streaming->getSlot(page) == 0)
+					{
+						missing.push_back(page);
+
+						GLint level, x, y;
+						decodePage(page, level, x, y);
+						page = encodePage(level + 1, x / 2, y / 2);
+					}
+
+					streaming->markWanted(page);
+				}
+			}
+
+			stats.requestedLastFeedback = requested;
+
+			// Coarsest first: they cover the most screen and are what missing finer pages fall back to.
+			std::sort(missing.begin(), missing.end(), std::greater<uint32_t>());
+			missing.erase(std::unique(missing.begin(), missing.end()), missing.end());
+
+			streaming->request(missing);
+		}
+
+		GAL_NODISCARD GAL_STATIC GAL_INLINE int countTrailingZeros(uint32_t bits) noexcept
+		{
+			int count = 0;
+			while ((bits & 1u) == 0)
+			{
+				bits >>= 1;
+				++count;
+			}
+
+			return count;
+		}
+
+		/// @brief Copy a page into a free or evicted slot and point the page table at it.
+		/// @return Whether a slot could be found.
+		GAL_INLINE bool mapPage(uint32_t page, const unsigned char* pixels)
+		{
+			uint32_t slot, evicted;
+			if (!streaming->insert(page, slot, evicted))
+				return false;
+
+			if (evicted != detail::StreamingCache::NoItem)
+				refreshPageTable(evicted);
+
+			const GLint slotX = static_cast<GLint>(slot % settings.physicalPagesX);
+			const GLint slotY = static_cast<GLint>(slot / settings.physicalPagesX);
+
+			physical.subImage(0, GL_RGBA, GL_UNSIGNED_BYTE, pixels, slotSize, slotSize, 0, slotX * slotSize, slotY * slotSize);
+
+			refreshPageTable(page);
+
+			return true;
+		}
+
+		/// @brief Recompute the page table entries of a page and every page under it at finer levels, after it became
+		/// resident or was evicted. Non-resident entries copy their parent's, which is already up to date.
+		GAL_INLINE void refreshPageTable(uint32_t page)
+		{
+			GLint pageLevel, pageX, pageY;
+			decodePage(page, pageLevel, pageX, pageY);
+
+			for (GLint level = pageLevel; level >= 0; --level)
+			{
+				const GLint span = 1 << (pageLevel - level);
+				const GLint x0 = pageX * span;
+				const GLint y0 = pageY * span;
+
+				for (GLint y = y0; y < y0 + span; ++y)
+				{
+					for (GLint x = x0; x < x0 + span; ++x)
+					{
+						const uint32_t index = encodePage(level, x, y);
+
+						if (streaming->getSlot(index) != 0)
+						{
+							const uint32_t slot = streaming->getSlot(index) - 1;
+							tableEntries[index] = (slot % settings.physicalPagesX) | ((slot / settings.physicalPagesX) << 8)
+								| (static_cast<uint32_t>(level) << 16) | (255u << 24);
+						}
+						else
+						{
+							tableEntries[index] = tableEntries[encodePage(level + 1, x / 2, y / 2)];
+						}
+					}
+				}
+
+				dirtyRows[level].first = std::min(dirtyRows[level].first, y0);
+				dirtyRows[level].second = std::max(dirtyRows[level].second, y0 + span - 1);
+			}
+		}
+
+		/// @brief Upload the rows of each page table level changed since the last upload.
+		GAL_INLINE void uploadPageTable()
+		{
+			for (GLint level = 0; level < levelCount; ++level)
+			{
+				auto& [first, last] = dirtyRows[level];
+				if (first > last)
+					continue;
+
+				const GLsizei width = pageCount(level);
+				pageTable.subImage(level, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, &tableEntries[encodePage(level, 0, first)],
+					width, last - first + 1, 0, 0, first);
+
+				first = pagesPerSide;
+				last = -1;
+			}
+		}
+	};
+}
+
+#endif
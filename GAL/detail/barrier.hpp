@@ -0,0 +1,24 @@
+#ifndef GAL_BARRIER_HPP
+#define GAL_BARRIER_HPP
+
+#include "attributes.hpp"
+#include "enums.hpp"
+
+namespace gal
+{
+	/// @brief Insert a memory barrier so that incoherent writes made by shaders (image stores, SSBO writes, atomic counters)
+	/// are visible to the subsequent operations described by the given bits. See glMemoryBarrier().
+	GAL_INLINE void memoryBarrier(MemoryBarrierBit bits) noexcept
+	{
+		glMemoryBarrier(static_cast<GLbitfield>(bits));
+	}
+
+	/// @brief Same as memoryBarrier(), but only orders fragment shader accesses to the same framebuffer region,
+	/// which can be cheaper. Only a subset of the bits is allowed here. See glMemoryBarrierByRegion().
+	GAL_INLINE void memoryBarrierByRegion(MemoryBarrierBit bits) noexcept
+	{
+		glMemoryBarrierByRegion(static_cast<GLbitfield>(bits));
+	}
+}
+
+#endif
@@ -17,6 +17,7 @@ namespace gal
 		OpenGLVersionUnset, // OpenGL Version left unset when creating a window.
 		DebugContextCreationFailed, // Failed to create debug context.
 		UserPointerNull, // The user pointer used to update gal::Window state was null.
+		HeadlessContextCreationFailed, // Failed to create a headless (EGL or OSMesa) context.
 
 		// Shader.
 		ShaderReadFailed, // Failed to read shader file.
@@ -27,6 +28,8 @@ namespace gal
 		UniformSetBeforeLinking, // Attempted to set a shader uniform before linking the shader program.
 		AddShaderAfterLinking, // Attempted to add a shader to a shader program after linking it.
 		ShaderProgramDoubleLink, // Attempted to link a shader even though it was already linked.
+		ShaderIncludeFailed, // Failed to resolve an #include directive in a shader file.
+		TransformFeedbackVaryingsAfterLinking, // Attempted to set transform feedback varyings after linking the shader program.
 
 		// Buffer.
 		BufferUseBeforeAllocation,
@@ -36,6 +39,40 @@ namespace gal
 		VertexAttributeIndexOutOfRange, // Attempted to add a vertex attribute with an index that was out of range (> GL_MAX_VERTEX_ATTRIBS - 1).
 		GotNullBuffer, // Attempted to get a null buffer.
 		DrawSettingsUnset, // Attempted to do an operation with draw settings unset
+
+		// Texture.
+		TextureFileReadFailed, // Failed to open or map a texture file.
+		TextureFileWriteFailed, // Failed to write a texture file.
+		UnsupportedTextureFile, // A texture file was malformed or used a format GAL can't load.
+		InvalidVirtualTextureSettings, // A virtual texture's size, page size or page cache didn't fit the page table layout.
+		InvalidBrickedVolumeSettings, // A bricked volume's size, brick size or brick pool didn't fit the indirection layout.
+		EmptyAtlasImage, // Attempted to add an image with no texels to a texture atlas.
+
+		// Compute.
+		ComputeDispatchBeforeLinking, // Attempted to dispatch a compute program before linking it.
+
+		// Transform.
+		InvalidTransformHandle, // Used a transform hierarchy handle that was never created or has been destroyed.
+		TransformHierarchyCycle, // Attempted to parent a transform hierarchy node to itself or one of its descendants.
+
+		// Spatial.
+		InvalidBVHHandle, // Used a BVH handle that was never inserted or has been removed.
+
+		// Level of detail.
+		LODLevelOutOfRange, // Attempted to use a level of detail a mesh doesn't have.
+		InvalidLODThreshold, // Added a level of detail whose screen size wasn't smaller than the previous level's.
+
+		// Animation.
+		InvalidAnimationKeys, // Animation keys weren't sorted by time, lay outside the clip's duration, or the duration wasn't positive.
+
+		// Skinning.
+		InvalidSkeleton, // A skeleton's joint came before its parent, or it didn't have one inverse bind matrix per joint.
+
+		// Morph targets.
+		InvalidMorphTarget, // A morph target moved a vertex the mesh doesn't have.
+
+		// Occlusion culling.
+		OccluderIndexOutOfRange, // An occluder index referred to a vertex the occluder doesn't have.
 	};
 
     /// @brief Convert a GAL error code to a string.
@@ -52,6 +89,7 @@ namespace gal
 			case ErrCode::OpenGLVersionUnset: return "OpenGLVersionUnset";
 			case ErrCode::DebugContextCreationFailed: return "DebugContextCreationFailed";
 			case ErrCode::UserPointerNull: return "UserPointerNull";
+			case ErrCode::HeadlessContextCreationFailed: return "HeadlessContextCreationFailed";
 
 			case ErrCode::ShaderReadFailed: return "ShaderReadFailed";
 			case ErrCode::ShaderCompFailed: return "ShaderCompFailed";
@@ -61,6 +99,8 @@ namespace gal
 			case ErrCode::UniformSetBeforeLinking: return "UniformSetBeforeLinking";
 			case ErrCode::AddShaderAfterLinking: return "AddShaderAfterLinking";
 			case ErrCode::ShaderProgramDoubleLink: return "ShaderProgramDoubleLink";
+			case ErrCode::ShaderIncludeFailed: return "ShaderIncludeFailed";
+			case ErrCode::TransformFeedbackVaryingsAfterLinking: return "TransformFeedbackVaryingsAfterLinking";
 
 			case ErrCode::BufferUseBeforeAllocation: return "BufferUseBeforeAllocation";
 
@@ -69,6 +109,31 @@ namespace gal
 			case ErrCode::GotNullBuffer: return "GotNullBuffer";
 			case ErrCode::DrawSettingsUnset: return "DrawSettingsUnset";
 
+			case ErrCode::TextureFileReadFailed: return "TextureFileReadFailed";
+			case ErrCode::TextureFileWriteFailed: return "TextureFileWriteFailed";
+			case ErrCode::UnsupportedTextureFile: return "UnsupportedTextureFile";
+			case ErrCode::InvalidVirtualTextureSettings: return "InvalidVirtualTextureSettings";
+			case ErrCode::InvalidBrickedVolumeSettings: return "InvalidBrickedVolumeSettings";
+			case ErrCode::EmptyAtlasImage: return "EmptyAtlasImage";
+
+			case ErrCode::ComputeDispatchBeforeLinking: return "ComputeDispatchBeforeLinking";
+
+			case ErrCode::InvalidTransformHandle: return "InvalidTransformHandle";
+			case ErrCode::TransformHierarchyCycle: return "TransformHierarchyCycle";
+
+			case ErrCode::InvalidBVHHandle: return "InvalidBVHHandle";
+
+			case ErrCode::LODLevelOutOfRange: return "LODLevelOutOfRange";
+			case ErrCode::InvalidLODThreshold: return "InvalidLODThreshold";
+
+			case ErrCode::InvalidAnimationKeys: return "InvalidAnimationKeys";
+
+			case ErrCode::InvalidSkeleton: return "InvalidSkeleton";
+
+			case ErrCode::InvalidMorphTarget: return "InvalidMorphTarget";
+
+			case ErrCode::OccluderIndexOutOfRange: return "OccluderIndexOutOfRange";
+
 			default: return "Unknown";
 		}
     }
@@ -149,6 +214,33 @@ namespace gal
 		TwoDMultisample      = GL_TEXTURE_2D_MULTISAMPLE,
 		TwoDMultisampleArray = GL_TEXTURE_2D_MULTISAMPLE_ARRAY,
 	};
+
+	/// @brief Enum of all possible memory barrier bits. Combine them with operator|.
+	/// Values align with GLenums of same names.
+	enum class MemoryBarrierBit : GLbitfield
+	{
+		VertexAttribArray  = GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT,
+		ElementArray       = GL_ELEMENT_ARRAY_BARRIER_BIT,
+		Uniform            = GL_UNIFORM_BARRIER_BIT,
+		TextureFetch       = GL_TEXTURE_FETCH_BARRIER_BIT,
+		ShaderImageAccess  = GL_SHADER_IMAGE_ACCESS_BARRIER_BIT,
+		Command            = GL_COMMAND_BARRIER_BIT,
+		PixelBuffer        = GL_PIXEL_BUFFER_BARRIER_BIT,
+		TextureUpdate      = GL_TEXTURE_UPDATE_BARRIER_BIT,
+		BufferUpdate       = GL_BUFFER_UPDATE_BARRIER_BIT,
+		ClientMappedBuffer = GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT,
+		Framebuffer        = GL_FRAMEBUFFER_BARRIER_BIT,
+		TransformFeedback  = GL_TRANSFORM_FEEDBACK_BARRIER_BIT,
+		AtomicCounter      = GL_ATOMIC_COUNTER_BARRIER_BIT,
+		ShaderStorage      = GL_SHADER_STORAGE_BARRIER_BIT,
+		QueryBuffer        = GL_QUERY_BUFFER_BARRIER_BIT,
+		All                = GL_ALL_BARRIER_BITS
+	};
+
+	GAL_NODISCARD GAL_CONSTEXPR GAL_INLINE MemoryBarrierBit operator|(MemoryBarrierBit a, MemoryBarrierBit b) noexcept
+	{
+		return static_cast<MemoryBarrierBit>(static_cast<GLbitfield>(a) | static_cast<GLbitfield>(b));
+	}
 }
 
 #endif
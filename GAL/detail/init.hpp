@@ -3,7 +3,9 @@
 
 #include "attributes.hpp"
 #include "GALException.hpp"
+#include "ShaderPreprocessor.hpp"
 #include "ShaderProgram.hpp"
+#include "TransformFeedbackCapture.hpp"
 #include "VertexArray.hpp"
 #include "window.hpp"
 
@@ -12,9 +14,10 @@ namespace gal
 	namespace detail
 	{
 		/// @brief Initialization that can only be done after an OpenGL context has been created. 
-		GAL_INLINE void postGLInit()
+		/// @param loader: Function looking up OpenGL functions for the current context, e.g. glfwGetProcAddress.
+		GAL_INLINE void postGLInit(GLADloadproc loader)
 		{
-			if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+			if (!gladLoadGLLoader(loader))
 				detail::throwErr(ErrCode::GLADInitFailed, "Failed to initialize GLAD.");
 
 			detail::initCommonGLParams();
@@ -42,8 +45,11 @@ namespace gal
 
 		detail::windowTracker.clear();
 		detail::shaderProgramTracker.clear();
+		clearShaderCache();
 		detail::bufferTracker.clear();
 		detail::vertexArrayTracker.clear();
+		detail::transformFeedbackTracker.clear();
+		detail::framebufferTracker.clear();
 
 		glfwTerminate();
 	}
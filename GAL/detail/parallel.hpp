@@ -0,0 +1,173 @@
+#ifndef GAL_PARALLEL_HPP
+#define GAL_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "attributes.hpp"
+
+namespace gal
+{
+	namespace detail
+	{
+		/// @brief Worker threads shared by every parallelFor(), started on first use and kept until exit, so kernels
+		/// called every frame or several times per mip level don't pay for creating and joining threads each time.
+		class ThreadPool
+		{
+		public:
+			/// @brief One parallelFor() call. Lives on the caller's stack until every worker that joined it has left.
+			struct Job
+			{
+				void (*call)(void* func, size_t begin, size_t end);
+				void* func;
+				size_t count;
+				size_t chunkSize;
+				size_t chunkCount;
+				std::atomic<size_t> nextChunk{ 0 };
+				unsigned helpersWanted; // Workers still to join, guarded by the pool's mutex.
+				unsigned helpersActive = 0; // Workers currently running chunks, guarded by the pool's mutex.
+
+				GAL_INLINE void runChunks() noexcept
+				{
+					for (size_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++)
+						call(func, chunk * chunkSize, std::min(count, (chunk + 1) * chunkSize));
+				}
+			};
+
+			GAL_NODISCARD GAL_STATIC GAL_INLINE ThreadPool& get()
+			{
+				static ThreadPool pool;
+				return pool;
+			}
+
+			/// @brief Whether the calling thread is one of the pool's workers.
+			GAL_NODISCARD GAL_STATIC GAL_INLINE bool& isWorkerThread() noexcept
+			{
+				thread_local bool worker = false;
+				return worker;
+			}
+
+			GAL_NODISCARD GAL_INLINE unsigned getWorkerCount() const noexcept { return static_cast<unsigned>(workers.size()); }
+
+			/// @brief Run the job on up to job.helpersWanted workers plus the calling thread, and wait for all of them.
+			GAL_INLINE void run(Job& job)
+			{
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					jobs.push_back(&job);
+				}
+				wake.notify_all();
+
+				job.runChunks();
+
+				// Stop more workers joining, then wait for the ones still running a chunk.
+				std::unique_lock<std::mutex> lock(mutex);
+				const auto it = std::find(jobs.begin(), jobs.end(), &job);
+				if (it != jobs.end())
+					jobs.erase(it);
+
+				finished.wait(lock, [&job] { return job.helpersActive == 0; });
+			}
+
+			// Forbid copying and moving, as the workers hold a pointer to the pool.
+			GAL_INLINE ThreadPool(const ThreadPool&) = delete;
+			GAL_INLINE ThreadPool& operator=(const ThreadPool&) = delete;
+			GAL_INLINE ThreadPool(ThreadPool&&) = delete;
+			GAL_INLINE ThreadPool& operator=(ThreadPool&&) = delete;
+
+		private:
+			std::mutex mutex;
+			std::condition_variable wake;
+			std::condition_variable finished;
+			std::deque<Job*> jobs;
+			std::vector<std::thread> workers;
+			bool stopping = false;
+
+			GAL_INLINE ThreadPool()
+			{
+				// The calling thread always works too, so one fewer worker than there are hardware threads.
+				const unsigned workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+				for (unsigned i = 0; i < workerCount; ++i)
+					workers.emplace_back([this] { workerLoop(); });
+			}
+
+			GAL_INLINE ~ThreadPool()
+			{
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					stopping = true;
+				}
+				wake.notify_all();
+
+				for (std::thread& worker : workers)
+					worker.join();
+			}
+
+			GAL_INLINE void workerLoop()
+			{
+				isWorkerThread() = true;
+				std::unique_lock<std::mutex> lock(mutex);
+
+				while (true)
+				{
+					wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+					if (stopping)
+						return;
+
+					Job& job = *jobs.front();
+					if (--job.helpersWanted == 0)
+						jobs.pop_front();
+					++job.helpersActive;
+
+					lock.unlock();
+					job.runChunks();
+					lock.lock();
+
+					if (--job.helpersActive == 0)
+						finished.notify_all();
+				}
+			}
+		};
+
+		/// @brief Call func(begin, end) over [0, count) in chunks spread across threadCount threads, including the calling
+		/// thread, and wait for all of them. 0 threads uses every hardware thread. Threads come from a pool shared by
+		/// every call, and calls from inside another parallelFor() run on the calling thread alone.
+		template<typename Func>
+		GAL_INLINE void parallelFor(size_t count, unsigned threadCount, Func&& func, size_t chunkSize = 16)
+		{
+			if (threadCount == 0)
+				threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+			const size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+			threadCount = static_cast<unsigned>(std::min<size_t>(threadCount, chunkCount));
+
+			if (threadCount <= 1 || ThreadPool::isWorkerThread())
+			{
+				if (count != 0)
+					func(size_t(0), count);
+				return;
+			}
+
+			ThreadPool& pool = ThreadPool::get();
+
+			using FuncType = std::remove_reference_t<Func>;
+			ThreadPool::Job job;
+			job.call = [](void* f, size_t begin, size_t end) { (*static_cast<FuncType*>(f))(begin, end); };
+			job.func = const_cast<void*>(static_cast<const void*>(&func));
+			job.count = count;
+			job.chunkSize = chunkSize;
+			job.chunkCount = chunkCount;
+			job.helpersWanted = std::min(threadCount - 1, std::max(pool.getWorkerCount(), 1u));
+
+			pool.run(job);
+		}
+	}
+}
+
+#endif
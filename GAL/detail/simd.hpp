@@ -0,0 +1,219 @@
+#ifndef GAL_SIMD_HPP
+#define GAL_SIMD_HPP
+
+// Compile time SIMD selection for GAL's CPU-side kernels. Every kernel also has a scalar path, so nothing here is required.
+// AVX2 is only used when the compiler targets it (/arch:AVX2 on MSVC, -mavx2 or -march=native elsewhere).
+// Define GAL_NO_SIMD to force the scalar paths, e.g. to compare results.
+
+#ifndef GAL_NO_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GAL_SIMD_SSE2
+#endif
+#if defined(__SSE4_1__) || defined(__AVX__)
+#define GAL_SIMD_SSE41
+#endif
+#if defined(__AVX2__)
+#define GAL_SIMD_AVX2
+#endif
+#if defined(__F16C__) || (defined(__AVX2__) && defined(_MSC_VER))
+#define GAL_SIMD_F16C
+#endif
+#endif
+
+#if defined(GAL_SIMD_AVX2) || defined(GAL_SIMD_F16C)
+#include <immintrin.h>
+#elif defined(GAL_SIMD_SSE41)
+#include <smmintrin.h>
+#elif defined(GAL_SIMD_SSE2)
+#include <emmintrin.h>
+#endif
+
+#include <cmath>
+#include <cstddef>
+#include <new>
+
+#include "attributes.hpp"
+
+namespace gal
+{
+	namespace detail
+	{
+		/// @brief Allocator for std::vector returning memory aligned to Alignment bytes, so SIMD kernels over the vector's
+		/// data never straddle a cache line needlessly.
+		template<typename T, size_t Alignment = 32>
+		struct AlignedAllocator
+		{
+			using value_type = T;
+
+			template<typename U>
+			struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+			GAL_INLINE AlignedAllocator() noexcept = default;
+
+			template<typename U>
+			GAL_INLINE AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+			GAL_NODISCARD GAL_INLINE T* allocate(size_t count)
+			{
+				return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(Alignment)));
+			}
+
+			GAL_INLINE void deallocate(T* pointer, size_t) noexcept
+			{
+				::operator delete(pointer, std::align_val_t(Alignment));
+			}
+
+			template<typename U>
+			GAL_NODISCARD GAL_INLINE bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept { return true; }
+
+			template<typename U>
+			GAL_NODISCARD GAL_INLINE bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept { return false; }
+		};
+
+		// Float lanes let one kernel template run at every SIMD width: write it against FloatLanes::Type and the static
+		// functions below, then run it with WideFloatLanes over the bulk of the data and FloatLanes1 over the remainder.
+
+		/// @brief One float at a time, for remainders and the scalar fallback.
+		struct FloatLanes1
+		{
+			using Type = float;
+			GAL_STATIC GAL_CONSTEXPR size_t Width = 1;
+
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type load(const float* p) noexcept { return *p; }
+			GAL_STATIC GAL_INLINE void store(float* p, Type v) noexcept { *p = v; }
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type set1(float v) noexcept { return v; }
+
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type add(Type a, Type b) noexcept { return a + b; }
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type sub(Type a, Type b) noexcept { return a - b; }
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type mul(Type a, Type b) noexcept { return a * b; }
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type div(Type a, Type b) noexcept { return a / b; }
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type sqrt(Type a) noexcept { return std::sqrt(a); }
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type min(Type a, Type b) noexcept { return a < b ? a : b; }
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type max(Type a, Type b) noexcept { return a > b ? a : b; }
+
+			/// @brief a with its sign flipped in the lanes where s has its sign bit set.
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type flipSign(Type a, Type s) noexcept { return std::signbit(s) ? -a : a; }
+
+			/// @brief Bit i is set if lane i of a is >= 0. NaN lanes are clear.
+			GAL_NODISCARD GAL_STATIC GAL_INLINE unsigned nonNegativeMask(Type a) noexcept { return a >= 0.0f ? 1u : 0u; }
+
+			/// @brief a in the lanes where m is >= 0, b elsewhere, including NaN lanes of m.
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type selectNonNegative(Type m, Type a, Type b) noexcept { return m >= 0.0f ? a : b; }
+
+			/// @brief Store lane i of a, b, c and d as the four consecutive floats at out + i * stride.
+			GAL_STATIC GAL_INLINE void storeTransposed(float* out, size_t, Type a, Type b, Type c, Type d) noexcept
+			{
+				out[0] = a;
+				out[1] = b;
+				out[2] = c;
+				out[3] = d;
+			}
+		};
+
+#ifdef GAL_SIMD_SSE2
+		struct FloatLanes4
+		{
+			using Type = __m128;
+			GAL_STATIC GAL_CONSTEXPR size_t Width = 4;
+
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type load(const float* p) noexcept { return _mm_loadu_ps(p); }
+			GAL_STATIC GAL_INLINE void store(float* p, Type v) noexcept { _mm_storeu_ps(p, v); }
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type set1(float v) noexcept { return _mm_set1_ps(v); }
+
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type add(Type a, Type b) noexcept { return _mm_add_ps(a, b); }
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type sub(Type a, Type b) noexcept { return _mm_sub_ps(a, b); }
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type mul(Type a, Type b) noexcept { return _mm_mul_ps(a, b); }
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type div(Type a, Type b) noexcept { return _mm_div_ps(a, b); }
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type sqrt(Type a) noexcept { return _mm_sqrt_ps(a); }
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type min(Type a, Type b) noexcept { return _mm_min_ps(a, b); }
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type max(Type a, Type b) noexcept { return _mm_max_ps(a, b); }
+
+			/// @brief a with its sign flipped in the lanes where s has its sign bit set.
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type flipSign(Type a, Type s) noexcept
+			{
+				return _mm_xor_ps(a, _mm_and_ps(s, _mm_set1_ps(-0.0f)));
+			}
+
+			GAL_NODISCARD GAL_STATIC GAL_INLINE unsigned nonNegativeMask(Type a) noexcept
+			{
+				return static_cast<unsigned>(_mm_movemask_ps(_mm_cmpge_ps(a, _mm_setzero_ps())));
+			}
+
+			/// @brief a in the lanes where m is >= 0, b elsewhere, including NaN lanes of m.
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type selectNonNegative(Type m, Type a, Type b) noexcept
+			{
+				const Type mask = _mm_cmpge_ps(m, _mm_setzero_ps());
+#ifdef GAL_SIMD_SSE41
+				return _mm_blendv_ps(b, a, mask);
+#else
+				return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+#endif
+			}
+
+			/// @brief Store lane i of a, b, c and d as the four consecutive floats at out + i * stride.
+			GAL_STATIC GAL_INLINE void storeTransposed(float* out, size_t stride, Type a, Type b, Type c, Type d) noexcept
+			{
+				_MM_TRANSPOSE4_PS(a, b, c, d);
+				_mm_storeu_ps(out, a);
+				_mm_storeu_ps(out + stride, b);
+				_mm_storeu_ps(out + stride * 2, c);
+				_mm_storeu_ps(out + stride * 3, d);
+			}
+		};
+#endif
+
+#ifdef GAL_SIMD_AVX2
+		struct FloatLanes8
+		{
+			using Type = __m256;
+			GAL_STATIC GAL_CONSTEXPR size_t Width = 8;
+
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type load(const float* p) noexcept { return _mm256_loadu_ps(p); }
+			GAL_STATIC GAL_INLINE void store(float* p, Type v) noexcept { _mm256_storeu_ps(p, v); }
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type set1(float v) noexcept { return _mm256_set1_ps(v); }
+
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type add(Type a, Type b) noexcept { return _mm256_add_ps(a, b); }
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type sub(Type a, Type b) noexcept { return _mm256_sub_ps(a, b); }
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type mul(Type a, Type b) noexcept { return _mm256_mul_ps(a, b); }
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type div(Type a, Type b) noexcept { return _mm256_div_ps(a, b); }
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type sqrt(Type a) noexcept { return _mm256_sqrt_ps(a); }
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type min(Type a, Type b) noexcept { return _mm256_min_ps(a, b); }
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type max(Type a, Type b) noexcept { return _mm256_max_ps(a, b); }
+
+			/// @brief a with its sign flipped in the lanes where s has its sign bit set.
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type flipSign(Type a, Type s) noexcept
+			{
+				return _mm256_xor_ps(a, _mm256_and_ps(s, _mm256_set1_ps(-0.0f)));
+			}
+
+			GAL_NODISCARD GAL_STATIC GAL_INLINE unsigned nonNegativeMask(Type a) noexcept
+			{
+				return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(a, _mm256_setzero_ps(), _CMP_GE_OQ)));
+			}
+
+			/// @brief a in the lanes where m is >= 0, b elsewhere, including NaN lanes of m.
+			GAL_NODISCARD GAL_STATIC GAL_INLINE Type selectNonNegative(Type m, Type a, Type b) noexcept
+			{
+				return _mm256_blendv_ps(b, a, _mm256_cmp_ps(m, _mm256_setzero_ps(), _CMP_GE_OQ));
+			}
+
+			/// @brief Store lane i of a, b, c and d as the four consecutive floats at out + i * stride.
+			GAL_STATIC GAL_INLINE void storeTransposed(float* out, size_t stride, Type a, Type b, Type c, Type d) noexcept
+			{
+				FloatLanes4::storeTransposed(out, stride, _mm256_castps256_ps128(a), _mm256_castps256_ps128(b),
+					_mm256_castps256_ps128(c), _mm256_castps256_ps128(d));
+				FloatLanes4::storeTransposed(out + stride * 4, stride, _mm256_extractf128_ps(a, 1), _mm256_extractf128_ps(b, 1),
+					_mm256_extractf128_ps(c, 1), _mm256_extractf128_ps(d, 1));
+			}
+		};
+
+		using WideFloatLanes = FloatLanes8;
+#elif defined(GAL_SIMD_SSE2)
+		using WideFloatLanes = FloatLanes4;
+#else
+		using WideFloatLanes = FloatLanes1;
+#endif
+	}
+}
+
+#endif
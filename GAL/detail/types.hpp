@@ -19,6 +19,8 @@ namespace gal
 		using GALBufferID = GALIDType;
 		using GALVertexArrayID = GALIDType;
 		using GALTextureID = GALIDType;
+		using GALTransformFeedbackID = GALIDType;
+		using GALFramebufferID = GALIDType;
 
 		GAL_STATIC GAL_CONSTEXPR GLsizeiptr NullSize = static_cast<GLsizeiptr>(-1);
 	}
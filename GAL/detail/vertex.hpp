@@ -1,6 +1,8 @@
 #ifndef GAL_VERTEX_HPP
 #define GAL_VERTEX_HPP
 
+#include <cstdint>
+
 namespace gal
 {
 	/// @brief Simple built-in vertex struct.
@@ -221,6 +223,45 @@ namespace gal
 		float texCoords[2];
 	};
 
+	/// @brief Built-in vertex struct for skinning (see Skinning.hpp).
+	/// 3-component position.
+	/// 4 joint indices. Read them with newVertexAttributeI() as GL_UNSIGNED_SHORT into a uvec4.
+	/// 4 joint weights, which should add up to 1.
+	struct VertexP3J4W4
+	{
+		float position[3];
+		uint16_t joints[4];
+		float weights[4];
+	};
+
+	/// @brief Built-in vertex struct for skinning (see Skinning.hpp).
+	/// 3-component position.
+	/// 3-component normal.
+	/// 4 joint indices. Read them with newVertexAttributeI() as GL_UNSIGNED_SHORT into a uvec4.
+	/// 4 joint weights, which should add up to 1.
+	struct VertexP3N3J4W4
+	{
+		float position[3];
+		float normal[3];
+		uint16_t joints[4];
+		float weights[4];
+	};
+
+	/// @brief Built-in vertex struct for skinning (see Skinning.hpp).
+	/// 3-component position.
+	/// 3-component normal.
+	/// 2-component texture coordinates.
+	/// 4 joint indices. Read them with newVertexAttributeI() as GL_UNSIGNED_SHORT into a uvec4.
+	/// 4 joint weights, which should add up to 1.
+	struct VertexP3N3T2J4W4
+	{
+		float position[3];
+		float normal[3];
+		float texCoords[2];
+		uint16_t joints[4];
+		float weights[4];
+	};
+
 	/// @brief Simple built-in vertex struct.
 	/// 3-component normal.
 	struct VertexN3
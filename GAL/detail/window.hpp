@@ -7,7 +7,7 @@
 namespace gal::detail
 {
 	void updateKeyStates(GLFWwindow*);
-	void postGLInit();
+	void postGLInit(GLADloadproc);
 }
 
 namespace gal
@@ -78,7 +78,7 @@ namespace gal
 			glfwMakeContextCurrent(window);
 
 			if (!detail::postGLInitialized)
-				detail::postGLInit();
+				detail::postGLInit((GLADloadproc)glfwGetProcAddress);
 
 			if (debugContext)
 			{
@@ -11,22 +11,54 @@
 #include "detail/glmIncludes.hpp"
 #endif
 
+#include "detail/Animation.hpp"
+#include "detail/barrier.hpp"
+#include "detail/BCnEncoder.hpp"
+#include "detail/BrickedVolume.hpp"
 #include "detail/Buffer.hpp"
+#include "detail/BVH.hpp"
 #include "detail/Camera.hpp"
+#include "detail/CompressedTexture.hpp"
+#include "detail/ComputeProgram.hpp"
 #include "detail/debug.hpp"
 #include "detail/enums.hpp"
+#include "detail/Framebuffer.hpp"
+#include "detail/Frustum.hpp"
 #include "detail/GALException.hpp"
 #include "detail/glParams.hpp"
+#include "detail/GPUFrustumCuller.hpp"
+#include "detail/GPUPrimitives.hpp"
+#include "detail/HeadlessContext.hpp"
 #include "detail/init.hpp"
+#include "detail/InstanceStorageBuffer.hpp"
 #include "detail/keyboard.hpp"
+#include "detail/LODMesh.hpp"
+#include "detail/MappedFile.hpp"
 #include "detail/MeshInstance.hpp"
+#include "detail/MipGenerator.hpp"
+#include "detail/MorphTargets.hpp"
+#include "detail/OcclusionCuller.hpp"
+#include "detail/parallel.hpp"
+#include "detail/PixelConversion.hpp"
+#include "detail/RenderTargetPool.hpp"
 #include "detail/ResourceTracker.hpp"
+#include "detail/ShaderPreprocessor.hpp"
 #include "detail/ShaderProgram.hpp"
+#include "detail/simd.hpp"
+#include "detail/Skinning.hpp"
 #include "detail/state.hpp"
+#include "detail/StreamingCache.hpp"
 #include "detail/Texture.hpp"
+#include "detail/TextureAtlas.hpp"
+#include "detail/TextureResidencyManager.hpp"
+#include "detail/TextureStreamer.hpp"
 #include "detail/Transform.hpp"
+#include "detail/TransformArray.hpp"
+#include "detail/TransformFeedbackCapture.hpp"
+#include "detail/TransformHierarchy.hpp"
 #include "detail/vertex.hpp"
 #include "detail/VertexArray.hpp"
+#include "detail/VirtualTexture.hpp"
 #include "detail/Window.hpp"
 
 #endif
\ No newline at end of file